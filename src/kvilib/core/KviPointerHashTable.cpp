@@ -0,0 +1,44 @@
+//=============================================================================
+//
+//   File : KviPointerHashTable.cpp
+//   Creation date : Sun Oct 18 2026 09:14:26 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviPointerHashTable.h"
+
+#include <QDateTime>
+
+#include <chrono>
+
+static quint64 kvi_hash_random_seed()
+{
+	// Not cryptographic, just unpredictable enough from outside:
+	// the time, the clock ticks and the (randomized) addresses
+	quint64 uSeed = kvi_hash_mix(0, QDateTime::currentMSecsSinceEpoch());
+	uSeed = kvi_hash_mix(uSeed, (quint64)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+	uSeed = kvi_hash_mix(uSeed, (quintptr)&uSeed);
+	return kvi_hash_mix(uSeed, (quintptr)&kvi_hash_random_seed);
+}
+
+// The tables created before this is initialized (during the static
+// initialization) get a weaker seed, which is fine: each table keeps
+// the seed it was created with.
+quint64 g_uPointerHashTableSeed = kvi_hash_random_seed();
@@ -39,6 +39,51 @@
 
 #include <ctype.h>
 
+#include <utility>
+
+// Random, set at startup: combined with the address of each table
+// so the collisions can't be predicted (and forced) from outside
+extern KVILIB_API quint64 g_uPointerHashTableSeed;
+
+///
+/// Hash mixing helpers
+///
+
+/**
+* \brief Mixes a 64 bit word of key data into the hash state
+*/
+inline quint64 kvi_hash_mix(quint64 uHash, quint64 uWord)
+{
+	uHash ^= uWord;
+	uHash *= 0xbf58476d1ce4e5b9ULL;
+	uHash ^= uHash >> 31;
+	return uHash;
+}
+
+/**
+* \brief Finalizes the hash state so that all the bits depend on all the key bits
+*/
+inline unsigned int kvi_hash_finish(quint64 uHash, quint64 uLength)
+{
+	uHash ^= uLength;
+	uHash ^= uHash >> 33;
+	uHash *= 0xff51afd7ed558ccdULL;
+	uHash ^= uHash >> 33;
+	uHash *= 0xc4ceb9fe1a85ec53ULL;
+	uHash ^= uHash >> 33;
+	return (unsigned int)uHash;
+}
+
+/**
+* \brief Lowercases an UTF-16 code unit exactly as QChar::toLower() does, fast for ASCII
+*/
+inline ushort kvi_hash_fold(ushort uChar)
+{
+	if(uChar < 128)
+		return ((uChar >= 'A') && (uChar <= 'Z')) ? uChar + 32 : uChar;
+	return (ushort)QChar::toLower((uint)uChar);
+}
+
 ///
 /// Hash functions for various data types
 ///
@@ -46,26 +91,24 @@
 /**
 * \brief Hash function for the char * data type
 */
-inline unsigned int kvi_hash_hash(const char * szKey, bool bCaseSensitive)
+inline unsigned int kvi_hash_hash(const char * szKey, bool bCaseSensitive, quint64 uSeed = 0)
 {
-	unsigned int uResult = 0;
-	if(bCaseSensitive)
+	quint64 uHash = uSeed;
+	quint64 uWord = 0;
+	quint64 uLength = 0;
+	while(*szKey)
 	{
-		while(*szKey)
+		unsigned char c = *((const unsigned char *)szKey);
+		uWord = (uWord << 8) | (bCaseSensitive ? c : (unsigned char)tolower(c));
+		szKey++;
+		uLength++;
+		if((uLength & 7) == 0)
 		{
-			uResult += (unsigned char)(*(szKey));
-			szKey++;
+			uHash = kvi_hash_mix(uHash, uWord);
+			uWord = 0;
 		}
 	}
-	else
-	{
-		while(*szKey)
-		{
-			uResult += (unsigned char)tolower(*(szKey));
-			szKey++;
-		}
-	}
-	return uResult;
+	return kvi_hash_finish(kvi_hash_mix(uHash, uWord), uLength);
 }
 
 /**
@@ -144,27 +187,9 @@ inline const char *& kvi_hash_key_default(const char **)
 /**
 * \brief Hash function for the KviCString data type
 */
-inline unsigned int kvi_hash_hash(const KviCString & szKey, bool bCaseSensitive)
+inline unsigned int kvi_hash_hash(const KviCString & szKey, bool bCaseSensitive, quint64 uSeed = 0)
 {
-	unsigned int uResult = 0;
-	const char * p = szKey.ptr();
-	if(bCaseSensitive)
-	{
-		while(*p)
-		{
-			uResult += *((const unsigned char *)p);
-			p++;
-		}
-	}
-	else
-	{
-		while(*p)
-		{
-			uResult += tolower(*((const unsigned char *)p));
-			p++;
-		}
-	}
-	return uResult;
+	return kvi_hash_hash(szKey.ptr(), bCaseSensitive, uSeed);
 }
 
 /**
@@ -201,9 +226,9 @@ inline const KviCString & kvi_hash_key_default(KviCString *)
 /**
 * \brief Hash function for the int data type
 */
-inline unsigned int kvi_hash_hash(const int & iKey, bool)
+inline unsigned int kvi_hash_hash(const int & iKey, bool, quint64 uSeed = 0)
 {
-	return (unsigned int)iKey;
+	return kvi_hash_finish(kvi_hash_mix(uSeed, (unsigned int)iKey), sizeof(int));
 }
 
 /**
@@ -241,9 +266,9 @@ inline const int & kvi_hash_key_default(int *)
 /**
 * \brief Hash function for the unsigned short data type
 */
-inline unsigned int kvi_hash_hash(const unsigned short & iKey, bool)
+inline unsigned int kvi_hash_hash(const unsigned short & iKey, bool, quint64 uSeed = 0)
 {
-	return (unsigned int)iKey;
+	return kvi_hash_finish(kvi_hash_mix(uSeed, iKey), sizeof(unsigned short));
 }
 
 /**
@@ -281,17 +306,9 @@ inline const unsigned short & kvi_hash_key_default(unsigned short *)
 /**
 * \brief Hash function for the void * data type
 */
-inline unsigned int kvi_hash_hash(void * pKey, bool)
+inline unsigned int kvi_hash_hash(void * pKey, bool, quint64 uSeed = 0)
 {
-	unsigned char * pBytes = (unsigned char *)&(pKey);
-	unsigned char * pEnd = pBytes + sizeof(void *);
-	unsigned int uSum = 0;
-	while(pBytes < pEnd)
-	{
-		uSum += *pBytes;
-		pBytes++;
-	}
-	return uSum;
+	return kvi_hash_finish(kvi_hash_mix(uSeed, (quintptr)pKey), sizeof(void *));
 }
 
 /**
@@ -329,29 +346,27 @@ inline void *& kvi_hash_key_default(void *)
 /**
 * \brief Hash function for the QString data type
 */
-inline unsigned int kvi_hash_hash(const QString & szKey, bool bCaseSensitive)
+inline unsigned int kvi_hash_hash(const QString & szKey, bool bCaseSensitive, quint64 uSeed = 0)
 {
-	unsigned int uResult = 0;
-	const QChar * p = szKey.constData();
-	if(!p)
-		return 0;
+	// four UTF-16 code units per round
+	const ushort * p = (const ushort *)szKey.constData();
+	int iLen = szKey.length();
+	quint64 uHash = uSeed;
+	int i = 0;
 	if(bCaseSensitive)
 	{
-		while(p->unicode())
-		{
-			uResult += p->unicode();
-			p++;
-		}
+		for(; i + 4 <= iLen; i += 4)
+			uHash = kvi_hash_mix(uHash, p[i] | ((quint64)p[i + 1] << 16) | ((quint64)p[i + 2] << 32) | ((quint64)p[i + 3] << 48));
 	}
 	else
 	{
-		while(p->unicode())
-		{
-			uResult += p->toLower().unicode();
-			p++;
-		}
+		for(; i + 4 <= iLen; i += 4)
+			uHash = kvi_hash_mix(uHash, kvi_hash_fold(p[i]) | ((quint64)kvi_hash_fold(p[i + 1]) << 16) | ((quint64)kvi_hash_fold(p[i + 2]) << 32) | ((quint64)kvi_hash_fold(p[i + 3]) << 48));
 	}
-	return uResult;
+	quint64 uWord = 0;
+	for(; i < iLen; i++)
+		uWord = (uWord << 16) | (bCaseSensitive ? p[i] : kvi_hash_fold(p[i]));
+	return kvi_hash_finish(kvi_hash_mix(uHash, uWord), iLen);
 }
 
 /**
@@ -398,8 +413,9 @@ class KviPointerHashTableEntry
 	friend class KviPointerHashTable<Key, T>;
 
 protected:
-	T * pData;
+	T * pData; // NULL when the item has been removed
 	Key hKey;
+	unsigned int uHash; // the slot hash of the key
 
 public:
 	Key & key() { return hKey; };
@@ -416,7 +432,7 @@ public:
 * following functions:
 *
 * \verbatim
-* unsigned int kvi_hash_hash(const Key & hKey, bool bCaseSensitive);
+* unsigned int kvi_hash_hash(const Key & hKey, bool bCaseSensitive, quint64 uSeed);
 * bool kvi_hash_key_equal(const Key & hKey1, const Key & hKey2, bool
 * bCaseSensitive);
 * void kvi_hash_key_copy(const Key & hKeyFrom, Key & hKeyTo, bool bDeepCopy);
@@ -439,11 +455,21 @@ public:
 * meaning of deep copy the deep copying code will (hopefully) be optimized
 * out by the compiler.
 *
-* The hashtable maintains an array of KviPointerList based buckets.
-* The number of buckets may be specified by the application user and does NOT
-* need to be a prime number. Yet better to have it a power of two so the
-* memory allocation routines will feel better and are less likely to waste
-* space.
+* The items are stored inline in an array of entries, in insertion order.
+* A separate array of slots (open addressing with linear probing) maps the
+* key hashes to the entries: its size is a power of two, it is allocated at
+* the first insertion and doubles when three quarters of the slots are used.
+* The size passed to the constructor is just a hint.
+*
+* The iterations follow the entries, so their order is the insertion order:
+* it doesn't depend on the (random) hash seed and it is the same on every
+* run. Replacing the item of a key keeps its position. Growing the slots
+* doesn't move the entries, so the items can be inserted and removed while
+* iterating. An iteration doesn't visit the items inserted after it started.
+* The removed entries are reclaimed when the array of entries is full: the
+* iterators are moved along with the items, but the pointers returned by
+* firstEntry(), nextEntry() and the like are valid only until the next
+* insertion.
 */
 template <class Key, class T>
 class KviPointerHashTable
@@ -451,13 +477,265 @@ class KviPointerHashTable
 	friend class KviPointerHashTableIterator<Key, T>;
 
 protected:
-	KviPointerList<KviPointerHashTableEntry<Key, T>> ** m_pDataArray;
+	struct Slot
+	{
+		unsigned int uHash;  // the key hash, or one of the markers below
+		unsigned int uEntry; // valid when the slot is used
+	};
+
+	KviPointerHashTableEntry<Key, T> * m_pEntries; // the items in insertion order, the removed ones included
+	unsigned int m_uEntries;                       // entries used so far
+	unsigned int m_uEntriesSize;                   // entries allocated
+	Slot * m_pSlots;                               // m_uSize slots
 	bool m_bAutoDelete;
-	unsigned int m_uSize;
+	unsigned int m_uSize;     // number of slots: a power of two, 0 before the first insertion
+	unsigned int m_uSizeHint; // the expected number of items
 	unsigned int m_uCount;
+	unsigned int m_uRemoved; // slots with the removed marker
+	quint64 m_uSeed;
 	bool m_bCaseSensitive;
 	bool m_bDeepCopyKeys;
-	unsigned int m_uIteratorIdx;
+	unsigned int m_uIteratorIdx; // the entry of the internal iterator, NoEntry when not on an item
+	unsigned int m_uIteratorEnd; // the entries inserted after the internal iteration started are not visited
+	mutable KviPointerHashTableIterator<Key, T> * m_pIterators; // the external iterators, linked
+
+	enum SlotMarker
+	{
+		EmptySlot = 0,
+		RemovedSlot = 1,
+		FirstHash = 2 // the key hashes are moved above the markers
+	};
+
+	enum
+	{
+		NoEntry = 0xffffffff,
+		PinnedEntry = 1 // a removed entry where an iterator is, while compacting
+	};
+
+	unsigned int slotHash(const Key & hKey) const
+	{
+		unsigned int uHash = kvi_hash_hash(hKey, m_bCaseSensitive, m_uSeed);
+		return uHash < FirstHash ? uHash + FirstHash : uHash;
+	}
+
+	// Returns the slot that contains the key or m_uSize if not found
+	unsigned int lookup(const Key & hKey, unsigned int uHash) const
+	{
+		if(!m_uSize)
+			return 0;
+		unsigned int uMask = m_uSize - 1;
+		unsigned int i = uHash & uMask;
+		// there is always at least one empty slot
+		while(m_pSlots[i].uHash != EmptySlot)
+		{
+			if((m_pSlots[i].uHash == uHash) && kvi_hash_key_equal(m_pEntries[m_pSlots[i].uEntry].hKey, hKey, m_bCaseSensitive))
+				return i;
+			i = (i + 1) & uMask;
+		}
+		return m_uSize;
+	}
+
+	// Returns the slot of an entry in use
+	unsigned int slotOf(unsigned int uEntry) const
+	{
+		unsigned int uMask = m_uSize - 1;
+		unsigned int i = m_pEntries[uEntry].uHash & uMask;
+		while((m_pSlots[i].uHash < FirstHash) || (m_pSlots[i].uEntry != uEntry))
+			i = (i + 1) & uMask;
+		return i;
+	}
+
+	bool entryUsed(unsigned int i) const
+	{
+		return (i < m_uEntries) && m_pEntries[i].pData;
+	}
+
+	// Returns the first used entry starting at i and before uEnd, NoEntry if none
+	unsigned int nextUsedEntry(unsigned int i, unsigned int uEnd) const
+	{
+		if(uEnd > m_uEntries)
+			uEnd = m_uEntries;
+		while((i < uEnd) && !m_pEntries[i].pData)
+			i++;
+		return i < uEnd ? i : (unsigned int)NoEntry;
+	}
+
+	// Returns the last used entry ending at i, NoEntry if none
+	unsigned int prevUsedEntry(unsigned int i) const
+	{
+		if(i >= m_uEntries)
+			return NoEntry;
+		for(;;)
+		{
+			if(m_pEntries[i].pData)
+				return i;
+			if(i == 0)
+				return NoEntry;
+			i--;
+		}
+	}
+
+	// Rebuilds the slots from the entries: the entries don't move
+	void rehash(unsigned int uSize)
+	{
+		if(uSize != m_uSize)
+		{
+			delete[] m_pSlots;
+			m_pSlots = new Slot[uSize];
+			m_uSize = uSize;
+		}
+		KviMemory::set(m_pSlots, 0, uSize * sizeof(Slot));
+		m_uRemoved = 0;
+
+		unsigned int uMask = uSize - 1;
+		for(unsigned int u = 0; u < m_uEntries; u++)
+		{
+			if(!m_pEntries[u].pData)
+				continue;
+			unsigned int i = m_pEntries[u].uHash & uMask;
+			while(m_pSlots[i].uHash != EmptySlot)
+				i = (i + 1) & uMask;
+			m_pSlots[i].uHash = m_pEntries[u].uHash;
+			m_pSlots[i].uEntry = u;
+		}
+	}
+
+	// Makes room for one more key in the slots
+	void grow()
+	{
+		if(!m_uSize)
+		{
+			// The small hints are the defaults of tables that usually hold
+			// a few items: those start small and grow as needed.
+			unsigned int uSize = 8;
+			if(m_uSizeHint > 64)
+			{
+				while((uSize < 1024) && ((uSize * 3) < (m_uSizeHint * 4)))
+					uSize <<= 1;
+			}
+			rehash(uSize);
+			return;
+		}
+
+		if(((m_uCount + 1) * 2) > m_uSize)
+			rehash(m_uSize << 1);
+		else
+			rehash(m_uSize); // mostly removed markers: just drop them
+	}
+
+	// Moves an index of the entries to its place after a compaction
+	static unsigned int remapEntry(unsigned int i, const unsigned int * pRemap, unsigned int uOldEntries)
+	{
+		if(i == NoEntry)
+			return NoEntry;
+		return pRemap[i < uOldEntries ? i : uOldEntries];
+	}
+
+	void pinEntry(unsigned int i)
+	{
+		if((i < m_uEntries) && !m_pEntries[i].pData)
+			m_pEntries[i].uHash = PinnedEntry;
+	}
+
+	// Drops the removed entries, except the ones where the iterators are,
+	// and moves the iterators along with the other entries
+	void compact()
+	{
+		pinEntry(m_uIteratorIdx);
+		for(KviPointerHashTableIterator<Key, T> * it = m_pIterators; it; it = it->m_pNextIterator)
+			pinEntry(it->m_uEntryIndex);
+
+		// pRemap[i] is the number of entries kept before i
+		unsigned int * pRemap = new unsigned int[m_uEntries + 1];
+		unsigned int j = 0;
+		for(unsigned int i = 0; i < m_uEntries; i++)
+		{
+			pRemap[i] = j;
+			KviPointerHashTableEntry<Key, T> * e = m_pEntries + i;
+			if(!e->pData && (e->uHash != PinnedEntry))
+				continue;
+			if(i != j)
+			{
+				// the removed entries have an empty key
+				std::swap(m_pEntries[j].hKey, e->hKey);
+				m_pEntries[j].pData = e->pData;
+				m_pEntries[j].uHash = e->uHash;
+				e->pData = 0;
+			}
+			if(!m_pEntries[j].pData)
+				m_pEntries[j].uHash = 0;
+			j++;
+		}
+		pRemap[m_uEntries] = j;
+
+		m_uIteratorIdx = remapEntry(m_uIteratorIdx, pRemap, m_uEntries);
+		m_uIteratorEnd = remapEntry(m_uIteratorEnd, pRemap, m_uEntries);
+		for(KviPointerHashTableIterator<Key, T> * it = m_pIterators; it; it = it->m_pNextIterator)
+		{
+			it->m_uEntryIndex = remapEntry(it->m_uEntryIndex, pRemap, m_uEntries);
+			it->m_uEndIndex = remapEntry(it->m_uEndIndex, pRemap, m_uEntries);
+		}
+
+		delete[] pRemap;
+		m_uEntries = j;
+		rehash(m_uSize);
+	}
+
+	// Makes room for one more entry
+	void growEntries()
+	{
+		// reclaim the removed entries if they are at least a quarter
+		if(m_uEntries && (((m_uEntries - m_uCount) * 4) >= m_uEntries))
+		{
+			compact();
+			if(m_uEntries < m_uEntriesSize)
+				return;
+		}
+
+		unsigned int uSize = m_uEntriesSize ? (m_uEntriesSize << 1) : ((m_uSize * 3) / 4);
+		KviPointerHashTableEntry<Key, T> * pOldEntries = m_pEntries;
+		m_pEntries = new KviPointerHashTableEntry<Key, T>[uSize];
+		for(unsigned int i = 0; i < m_uEntries; i++)
+		{
+			// the deep copied keys just change owner
+			std::swap(m_pEntries[i].hKey, pOldEntries[i].hKey);
+			m_pEntries[i].pData = pOldEntries[i].pData;
+			m_pEntries[i].uHash = pOldEntries[i].uHash;
+		}
+		for(unsigned int i = m_uEntries; i < uSize; i++)
+		{
+			m_pEntries[i].pData = 0;
+			m_pEntries[i].uHash = 0;
+		}
+		delete[] pOldEntries;
+		m_uEntriesSize = uSize;
+	}
+
+	void removeSlot(unsigned int i)
+	{
+		KviPointerHashTableEntry<Key, T> * e = m_pEntries + m_pSlots[i].uEntry;
+		T * pData = e->pData;
+		kvi_hash_key_destroy(e->hKey, m_bDeepCopyKeys);
+		e->hKey = Key();
+		e->pData = 0;
+		e->uHash = 0;
+
+		// if the next slot is empty no key has been probed past this one
+		if(m_pSlots[(i + 1) & (m_uSize - 1)].uHash == EmptySlot)
+		{
+			m_pSlots[i].uHash = EmptySlot;
+		}
+		else
+		{
+			m_pSlots[i].uHash = RemovedSlot;
+			m_uRemoved++;
+		}
+		m_uCount--;
+
+		// the item is deleted last: its destructor may use the table
+		if(m_bAutoDelete)
+			delete pData;
+	}
 
 public:
 	/**
@@ -470,15 +748,15 @@ public:
 	*/
 	T * find(const Key & hKey)
 	{
-		m_uIteratorIdx = kvi_hash_hash(hKey, m_bCaseSensitive) % m_uSize;
-		if(!m_pDataArray[m_uIteratorIdx])
-			return 0;
-		for(KviPointerHashTableEntry<Key, T> * e = m_pDataArray[m_uIteratorIdx]->first(); e; e = m_pDataArray[m_uIteratorIdx]->next())
+		m_uIteratorEnd = m_uEntries;
+		unsigned int i = lookup(hKey, slotHash(hKey));
+		if(i >= m_uSize)
 		{
-			if(kvi_hash_key_equal(e->hKey, hKey, m_bCaseSensitive))
-				return (T *)e->pData;
+			m_uIteratorIdx = NoEntry;
+			return 0;
 		}
-		return 0;
+		m_uIteratorIdx = m_pSlots[i].uEntry;
+		return m_pEntries[m_uIteratorIdx].pData;
 	}
 
 	/**
@@ -516,9 +794,10 @@ public:
 	/**
 	* \brief Inserts the item pData at the position specified by the key hKey.
 	*
-	* Replaces any previous item with the same key
+	* Replaces any previous item with the same key: the replacement keeps
+	* its position. A new key goes after all the others.
 	* The replaced item is deleted if autodelete is enabled.
-	* The hash table iterator is placed at the newly inserted item.
+	* The hash table iterator doesn't move.
 	* \param hKey The key where to insert data
 	* \param pData The data to insert
 	* \return void
@@ -527,38 +806,54 @@ public:
 	{
 		if(!pData)
 			return;
-		unsigned int uEntry = kvi_hash_hash(hKey, m_bCaseSensitive) % m_uSize;
-		if(!m_pDataArray[uEntry])
-			m_pDataArray[uEntry] = new KviPointerList<KviPointerHashTableEntry<Key, T>>(true);
-		for(KviPointerHashTableEntry<Key, T> * e = m_pDataArray[uEntry]->first(); e; e = m_pDataArray[uEntry]->next())
+
+		unsigned int uHash = slotHash(hKey);
+		unsigned int i = lookup(hKey, uHash);
+		if(i < m_uSize)
 		{
-			if(kvi_hash_key_equal(e->hKey, hKey, m_bCaseSensitive))
+			KviPointerHashTableEntry<Key, T> * e = m_pEntries + m_pSlots[i].uEntry;
+			if(!m_bCaseSensitive)
 			{
-				if(!m_bCaseSensitive)
-				{
-					// must change the key too
-					kvi_hash_key_destroy(e->hKey, m_bDeepCopyKeys);
-					kvi_hash_key_copy(hKey, e->hKey, m_bDeepCopyKeys);
-				}
-				if(m_bAutoDelete)
-					delete e->pData;
-				e->pData = pData;
-				return;
+				// must change the key too
+				kvi_hash_key_destroy(e->hKey, m_bDeepCopyKeys);
+				kvi_hash_key_copy(hKey, e->hKey, m_bDeepCopyKeys);
 			}
+			T * pOld = e->pData;
+			e->pData = pData;
+			if(m_bAutoDelete && (pOld != pData))
+				delete pOld;
+			return;
 		}
-		KviPointerHashTableEntry<Key, T> * n = new KviPointerHashTableEntry<Key, T>;
-		kvi_hash_key_copy(hKey, n->hKey, m_bDeepCopyKeys);
-		n->pData = pData;
-		m_pDataArray[uEntry]->append(n);
+
+		// keep at least a quarter of the slots empty
+		if(((m_uCount + m_uRemoved + 1) * 4) > (m_uSize * 3))
+			grow();
+		if(m_uEntries == m_uEntriesSize)
+			growEntries();
+
+		unsigned int uMask = m_uSize - 1;
+		i = uHash & uMask;
+		while(m_pSlots[i].uHash >= FirstHash)
+			i = (i + 1) & uMask;
+		if(m_pSlots[i].uHash == RemovedSlot)
+			m_uRemoved--;
+
+		KviPointerHashTableEntry<Key, T> * e = m_pEntries + m_uEntries;
+		kvi_hash_key_copy(hKey, e->hKey, m_bDeepCopyKeys);
+		e->pData = pData;
+		e->uHash = uHash;
+		m_pSlots[i].uHash = uHash;
+		m_pSlots[i].uEntry = m_uEntries;
+		m_uEntries++;
 		m_uCount++;
 	}
 
 	/**
 	* \brief Inserts the item pData at the position specified by the key hKey.
 	*
-	* Replaces any previous item with the same key.
+	* Replaces any previous item with the same key
 	* The replaced item is deleted if autodelete is enabled.
-	* The hash table iterator is placed at the newly inserted item.
+	* The hash table iterator doesn't move.
 	* This is just an alias to insert() with a different name.
 	* \param hKey The key where to insert data
 	* \param pData The new data to insert
@@ -574,33 +869,17 @@ public:
 	*
 	* The item is deleted if autodeletion is enabled. Returns true if the
 	* item was found and removed and false if it wasn't found.
-	* Invalidates the hash table iterator.
+	* The other items do not move.
 	* \param hKey The key where to remove the pointer
 	* \return bool
 	*/
 	bool remove(const Key & hKey)
 	{
-		unsigned int uEntry = kvi_hash_hash(hKey, m_bCaseSensitive) % m_uSize;
-		if(!m_pDataArray[uEntry])
+		unsigned int i = lookup(hKey, slotHash(hKey));
+		if(i >= m_uSize)
 			return false;
-		for(KviPointerHashTableEntry<Key, T> * e = m_pDataArray[uEntry]->first(); e; e = m_pDataArray[uEntry]->next())
-		{
-			if(kvi_hash_key_equal(e->hKey, hKey, m_bCaseSensitive))
-			{
-				kvi_hash_key_destroy(e->hKey, m_bDeepCopyKeys);
-				if(m_bAutoDelete)
-					delete((T *)(e->pData));
-				m_pDataArray[uEntry]->removeRef(e);
-				if(m_pDataArray[uEntry]->isEmpty())
-				{
-					delete m_pDataArray[uEntry];
-					m_pDataArray[uEntry] = 0;
-				}
-				m_uCount--;
-				return true;
-			}
-		}
-		return false;
+		removeSlot(i);
+		return true;
 	}
 
 	/**
@@ -608,33 +887,20 @@ public:
 	*
 	* The item is deleted if autodeletion is enabled. Returns true if the
 	* pointer was found and false otherwise.
-	* Invalidates the hash table iterator.
+	* The other items do not move.
 	* \param pRef The pointer to remove the first occurrence
 	* \return bool
 	*/
 	bool removeRef(const T * pRef)
 	{
-		for(unsigned int i = 0; i < m_uSize; i++)
+		if(!pRef)
+			return false;
+		for(unsigned int i = 0; i < m_uEntries; i++)
 		{
-			if(m_pDataArray[i])
+			if(m_pEntries[i].pData == pRef)
 			{
-				for(KviPointerHashTableEntry<Key, T> * e = m_pDataArray[i]->first(); e; e = m_pDataArray[i]->next())
-				{
-					if(e->pData == pRef)
-					{
-						kvi_hash_key_destroy(e->hKey, m_bDeepCopyKeys);
-						if(m_bAutoDelete)
-							delete((T *)(e->pData));
-						m_pDataArray[i]->removeRef(e);
-						if(m_pDataArray[i]->isEmpty())
-						{
-							delete m_pDataArray[i];
-							m_pDataArray[i] = 0;
-						}
-						m_uCount--;
-						return true;
-					}
-				}
+				removeSlot(slotOf(i));
+				return true;
 			}
 		}
 		return false;
@@ -644,36 +910,37 @@ public:
 	* \brief Removes all the items from the hash table.
 	*
 	* The items are deleted if autodeletion is enabled.
+	* The items inserted by their destructors are removed as well.
 	* Invalidates the hash table iterator.
 	* \return void
 	*/
 	void clear()
 	{
-		for(unsigned int i = 0; i < m_uSize; i++)
 		{
-			if(!m_pDataArray[i])
-				continue;
-
-			while(KviPointerHashTableEntry<Key, T> * e = m_pDataArray[i]->takeFirst())
+			// an iterator follows the entries if a destructor inserts new items
+			KviPointerHashTableIterator<Key, T> it(*this);
+			while(m_uCount > 0)
 			{
-				kvi_hash_key_destroy(e->hKey, m_bDeepCopyKeys);
-
-				if(m_bAutoDelete)
-					delete((T *)(e->pData));
-
-				delete e;
-
-				if(!m_pDataArray[i])
-					break; // emptied in the meantime
+				while(it.onEntry())
+				{
+					// the other items must still be reachable: the destructors may look them up
+					removeSlot(slotOf(it.m_uEntryIndex));
+					it.moveNext();
+				}
+				it.moveFirst();
 			}
+		}
 
-			if(m_pDataArray[i])
-			{
-				delete m_pDataArray[i];
-				m_pDataArray[i] = 0;
-			}
+		m_uIteratorIdx = NoEntry;
+		m_uIteratorEnd = 0;
+		if(m_uSize)
+		{
+			KviMemory::set(m_pSlots, 0, m_uSize * sizeof(Slot));
+			m_uRemoved = 0;
 		}
-		m_uCount = 0;
+		// the iterators still alive keep their (removed) entries until the next compaction
+		if(!m_pIterators)
+			m_uEntries = 0;
 	}
 
 	/**
@@ -681,186 +948,112 @@ public:
 	*
 	* Returns its hash table entry, if found, and NULL otherwise.
 	* The hash table iterator is placed at the item found.
-	* \param pRef The pointer to search
-	* \return KviPointerHashTableEntry<Key,T> *
+	* \param pRef The pointer to find
+	* \return KviPointerHashTableEntry *
 	*/
 	KviPointerHashTableEntry<Key, T> * findRef(const T * pRef)
 	{
-		for(m_uIteratorIdx = 0; m_uIteratorIdx < m_uSize; m_uIteratorIdx++)
+		m_uIteratorEnd = m_uEntries;
+		if(pRef)
 		{
-			if(m_pDataArray[m_uIteratorIdx])
+			for(m_uIteratorIdx = 0; m_uIteratorIdx < m_uEntries; m_uIteratorIdx++)
 			{
-				for(KviPointerHashTableEntry<Key, T> * e = m_pDataArray[m_uIteratorIdx]->first(); e; e = m_pDataArray[m_uIteratorIdx]->next())
-				{
-					if(e->pData == pRef)
-						return e;
-				}
+				if(m_pEntries[m_uIteratorIdx].pData == pRef)
+					return m_pEntries + m_uIteratorIdx;
 			}
 		}
+		m_uIteratorIdx = NoEntry;
 		return 0;
 	}
 
 	/**
-	* \brief Returns the entry pointed by the hash table iterator.
-	*
-	* This function must be preceded by a call to firstEntry(), first()
-	* or findRef().
-	* \return KviPointerHashTableEntry<Key,T> *
+	* \brief Returns the entry pointed by the hash table iterator
+	* \return KviPointerHashTableEntry *
 	*/
 	KviPointerHashTableEntry<Key, T> * currentEntry()
 	{
-		if(m_uIteratorIdx >= m_uSize)
+		if(!entryUsed(m_uIteratorIdx))
 			return 0;
-		if(m_pDataArray[m_uIteratorIdx])
-			return m_pDataArray[m_uIteratorIdx]->current();
-		return 0;
+		return m_pEntries + m_uIteratorIdx;
 	}
 
 	/**
-	* \brief Places the hash table iterator at the first entry and returns it.
-	* \return KviPointerHashTableEntry<Key,T> *
+	* \brief Places the hash table iterator at the first entry
+	*
+	* Returns the first entry or NULL if the hash table is empty.
+	* \return KviPointerHashTableEntry *
 	*/
 	KviPointerHashTableEntry<Key, T> * firstEntry()
 	{
-		m_uIteratorIdx = 0;
-		while(m_uIteratorIdx < m_uSize && (!m_pDataArray[m_uIteratorIdx]))
-		{
-			m_uIteratorIdx++;
-		}
-		if(m_uIteratorIdx == m_uSize)
-			return 0;
-		return m_pDataArray[m_uIteratorIdx]->first();
+		m_uIteratorEnd = m_uEntries;
+		m_uIteratorIdx = nextUsedEntry(0, m_uIteratorEnd);
+		return currentEntry();
 	}
 
 	/**
-	* \brief Places the hash table iterator at the next entry and returns it.
+	* \brief Places the hash table iterator at the next entry
 	*
-	* This function must be preceded by a call to firstEntry(), first()
-	* or findRef().
-	* \return KviPointerHashTableEntry<Key,T> *
+	* Returns the next entry or NULL if the hash table iterator was
+	* already at the last entry.
+	* \return KviPointerHashTableEntry *
 	*/
 	KviPointerHashTableEntry<Key, T> * nextEntry()
 	{
-		if(m_uIteratorIdx >= m_uSize)
+		if(m_uIteratorIdx >= m_uIteratorEnd)
 			return 0;
-
-		if(m_uIteratorIdx < m_uSize)
-		{
-			KviPointerHashTableEntry<Key, T> * t = m_pDataArray[m_uIteratorIdx]->next();
-			if(t)
-				return t;
-		}
-
-		m_uIteratorIdx++;
-
-		while(m_uIteratorIdx < m_uSize && (!m_pDataArray[m_uIteratorIdx]))
-		{
-			m_uIteratorIdx++;
-		}
-
-		if(m_uIteratorIdx == m_uSize)
-			return 0;
-
-		return m_pDataArray[m_uIteratorIdx]->first();
+		m_uIteratorIdx = nextUsedEntry(m_uIteratorIdx + 1, m_uIteratorEnd);
+		return currentEntry();
 	}
 
 	/**
-	* \brief Returns the data value pointer pointed by the hash table iterator.
-	*
-	* This function must be preceded by a call to firstEntry(), first()
-	* or findRef().
+	* \brief Returns the data value pointer pointed by the hash table iterator
 	* \return T *
 	*/
 	T * current()
 	{
-		if(m_uIteratorIdx >= m_uSize)
+		if(!entryUsed(m_uIteratorIdx))
 			return 0;
-		if(m_pDataArray[m_uIteratorIdx])
-		{
-			KviPointerHashTableEntry<Key, T> * e = m_pDataArray[m_uIteratorIdx]->current();
-			if(!e)
-				return 0;
-			return e->data();
-		}
-		return 0;
+		return m_pEntries[m_uIteratorIdx].pData;
 	}
 
 	/**
-	* \brief Returns the key pointed by the hash table iterator.
-	*
-	* This function must be preceded by a call to firstEntry(), first()
-	* or findRef().
+	* \brief Returns the key pointed by the hash table iterator
 	* \return const Key &
 	*/
 	const Key & currentKey()
 	{
-		if(m_uIteratorIdx >= m_uSize)
+		if(!entryUsed(m_uIteratorIdx))
 			return kvi_hash_key_default(((Key *)NULL));
-		if(m_pDataArray[m_uIteratorIdx])
-		{
-			KviPointerHashTableEntry<Key, T> * e = m_pDataArray[m_uIteratorIdx]->current();
-			if(!e)
-				return kvi_hash_key_default(((Key *)NULL));
-			return e->key();
-		}
-		return kvi_hash_key_default(((Key *)NULL));
+		return m_pEntries[m_uIteratorIdx].hKey;
 	}
 
-	/** \brief Places the hash table iterator at the first entry
+	/**
+	* \brief Places the hash table iterator at the first element
 	*
-	* It returns the associated data value pointer.
+	* Returns the data value pointer of the first element or NULL if the
+	* hash table is empty.
 	* \return T *
 	*/
 	T * first()
 	{
-		m_uIteratorIdx = 0;
-		while(m_uIteratorIdx < m_uSize && (!m_pDataArray[m_uIteratorIdx]))
-		{
-			m_uIteratorIdx++;
-		}
-		if(m_uIteratorIdx == m_uSize)
-			return 0;
-		KviPointerHashTableEntry<Key, T> * e = m_pDataArray[m_uIteratorIdx]->first();
-		if(!e)
-			return 0;
-		return e->data();
+		m_uIteratorEnd = m_uEntries;
+		m_uIteratorIdx = nextUsedEntry(0, m_uIteratorEnd);
+		return current();
 	}
 
 	/**
-	* \brief Places the hash table iterator at the next entry and returns the associated data value pointer.
+	* \brief Places the hash table iterator at the next element
 	*
-	* This function must be preceded by a call to firstEntry(), first()
-	* or findRef().
+	* Returns the data value pointer of the next element or NULL if the
+	* hash table iterator was already at the last element.
 	* \return T *
 	*/
 	T * next()
 	{
-		if(m_uIteratorIdx >= m_uSize)
+		if(m_uIteratorIdx >= m_uIteratorEnd)
 			return 0;
-
-		if(m_uIteratorIdx < m_uSize)
-		{
-			KviPointerHashTableEntry<Key, T> * t = m_pDataArray[m_uIteratorIdx]->next();
-			if(t)
-			{
-				return t->data();
-			}
-		}
-
-		m_uIteratorIdx++;
-
-		while(m_uIteratorIdx < m_uSize && (!m_pDataArray[m_uIteratorIdx]))
-		{
-			m_uIteratorIdx++;
-		}
-
-		if(m_uIteratorIdx == m_uSize)
-			return 0;
-
-		KviPointerHashTableEntry<Key, T> * e = m_pDataArray[m_uIteratorIdx]->first();
-		if(!e)
-			return 0;
-		return e->data();
+		m_uIteratorIdx = nextUsedEntry(m_uIteratorIdx + 1, m_uIteratorEnd);
+		return current();
 	}
 
 	/**
@@ -868,9 +1061,8 @@ public:
 	*
 	* The removed items are deleted if autodeletion is enabled.
 	* The hash table iterator is invalidated.
-	* Does not change autodelete flag: make sure you don't delete the
-	* items twice :)
-	* \param t The data to copy
+	* Does not change autodelete flag: make sure you not delete the items twice :)
+	* \param t The hash table to copy from
 	* \return void
 	*/
 	void copyFrom(KviPointerHashTable<Key, T> & t)
@@ -884,7 +1076,8 @@ public:
 	* \brief Inserts a complete shallow copy of the data contained in t.
 	*
 	* The hash table iterator is invalidated.
-	* \param t The data to insert
+	* Does not change autodelete flag: make sure you not delete the items twice :)
+	* \param t The hash table to insert from
 	* \return void
 	*/
 	void insert(KviPointerHashTable<Key, T> & t)
@@ -897,7 +1090,7 @@ public:
 	* \brief Enables or disabled the autodeletion feature.
 	*
 	* Items are deleted upon removal when the feature is enabled.
-	* \param bAutoDelete Set the autodelete state
+	* \param bAutoDelete The state of the autodeletion feature
 	* \return void
 	*/
 	void setAutoDelete(bool bAutoDelete)
@@ -909,40 +1102,52 @@ public:
 	* \brief Creates an empty hash table.
 	*
 	* Automatic deletion is enabled.
-	* \param uSize The number of hash buckets: does NOT necesairly need to be prime
-	* \param bCaseSensitive Are the key comparisons case sensitive ?
-	* \param bDeepCopyKeys Do we need to maintain deep copies of keys ?
-	* \return KviPointerHashTable
+	* \param uSize The expected number of items: the table grows anyway
+	* \param bCaseSensitive This parameter is meaningful only if the key type is string-like. It specifies if key comparisons are case sensitive.
+	* \param bDeepCopyKeys This parameter is meaningful only if the key is a pointer type. It specifies if the hash table should keep a private copy of the keys.
 	*/
 	KviPointerHashTable(unsigned int uSize = 32, bool bCaseSensitive = true, bool bDeepCopyKeys = true)
 	{
+		m_pEntries = NULL;
+		m_uEntries = 0;
+		m_uEntriesSize = 0;
+		m_pSlots = NULL;
+		m_uSize = 0;
+		m_uSizeHint = uSize;
 		m_uCount = 0;
+		m_uRemoved = 0;
+		m_uSeed = kvi_hash_mix(g_uPointerHashTableSeed, (quintptr)this);
 		m_bCaseSensitive = bCaseSensitive;
 		m_bAutoDelete = true;
 		m_bDeepCopyKeys = bDeepCopyKeys;
-		m_uSize = uSize > 0 ? uSize : 32;
-		m_pDataArray = new KviPointerList<KviPointerHashTableEntry<Key, T>> *[m_uSize];
-		for(unsigned int i = 0; i < m_uSize; i++)
-			m_pDataArray[i] = NULL;
+		m_uIteratorIdx = NoEntry;
+		m_uIteratorEnd = 0;
+		m_pIterators = NULL;
 	}
 
 	/**
-	* \brief First creates an empty hash table and then inserts a copy of all the item pointers present in t.
+	* \brief Creates a hash table that is a copy of another one.
 	*
-	* The autodelete feature is automatically disabled (take care!).
-	* \param t The data to copy
-	* \return KviPointerHashTable
+	* The new hash table does not delete the items: they belong to t.
+	* \param t The hash table to copy from
 	*/
 	KviPointerHashTable(KviPointerHashTable<Key, T> & t)
 	{
+		m_pEntries = NULL;
+		m_uEntries = 0;
+		m_uEntriesSize = 0;
+		m_pSlots = NULL;
+		m_uSize = 0;
+		m_uSizeHint = t.m_uCount;
 		m_uCount = 0;
+		m_uRemoved = 0;
+		m_uSeed = kvi_hash_mix(g_uPointerHashTableSeed, (quintptr)this);
 		m_bAutoDelete = false;
 		m_bCaseSensitive = t.m_bCaseSensitive;
 		m_bDeepCopyKeys = t.m_bDeepCopyKeys;
-		m_uSize = t.m_uSize;
-		m_pDataArray = new KviPointerList<KviPointerHashTableEntry<Key, T>> *[m_uSize];
-		for(unsigned int i = 0; i < m_uSize; i++)
-			m_pDataArray[i] = NULL;
+		m_uIteratorIdx = NoEntry;
+		m_uIteratorEnd = 0;
+		m_pIterators = NULL;
 		copyFrom(t);
 	}
 
@@ -950,25 +1155,85 @@ public:
 	* \brief Destroys the hash table and all the items contained within.
 	*
 	* Items are deleted if autodeletion is enabled.
+	* The iterators still alive behave as if the hash table was empty.
 	*/
 	~KviPointerHashTable()
 	{
 		clear();
-		delete[] m_pDataArray;
+		while(m_pIterators)
+			m_pIterators->detach();
+		delete[] m_pEntries;
+		delete[] m_pSlots;
 	}
 };
 
 /**
 * \class KviPointerHashTableIterator
 * \brief A fast pointer hash table iterator implementation
+*
+* The iterator visits the items in insertion order. It stays valid when
+* items are removed (the current one included) and when new keys are
+* inserted: those are not visited. The iterators register themselves in
+* the hash table, so a hash table can't be iterated by several threads
+* at the same time.
 */
 template <typename Key, typename T>
 class KviPointerHashTableIterator
 {
+	friend class KviPointerHashTable<Key, T>;
+
 protected:
-	const KviPointerHashTable<Key, T> * m_pHashTable;
-	unsigned int m_uEntryIndex;
-	KviPointerListIterator<KviPointerHashTableEntry<Key, T>> * m_pIterator;
+	const KviPointerHashTable<Key, T> * m_pHashTable; // NULL when the hash table has been destroyed
+	unsigned int m_uEntryIndex;                        // NoEntry when not on an item
+	unsigned int m_uEndIndex;                          // the entries inserted after moveFirst() are not visited
+	KviPointerHashTableIterator<Key, T> * m_pPrevIterator;
+	KviPointerHashTableIterator<Key, T> * m_pNextIterator;
+
+	enum
+	{
+		NoEntry = 0xffffffff
+	};
+
+	void attach(const KviPointerHashTable<Key, T> * pHashTable)
+	{
+		m_pHashTable = pHashTable;
+		m_pPrevIterator = NULL;
+		m_pNextIterator = pHashTable->m_pIterators;
+		if(m_pNextIterator)
+			m_pNextIterator->m_pPrevIterator = this;
+		pHashTable->m_pIterators = this;
+	}
+
+	void detach()
+	{
+		if(!m_pHashTable)
+			return;
+		if(m_pPrevIterator)
+			m_pPrevIterator->m_pNextIterator = m_pNextIterator;
+		else
+			m_pHashTable->m_pIterators = m_pNextIterator;
+		if(m_pNextIterator)
+			m_pNextIterator->m_pPrevIterator = m_pPrevIterator;
+		m_pHashTable = NULL;
+		m_uEntryIndex = NoEntry;
+		m_uEndIndex = 0;
+	}
+
+	bool onEntry() const
+	{
+		return m_pHashTable && m_pHashTable->entryUsed(m_uEntryIndex);
+	}
+
+	bool moveTo(unsigned int uIndex)
+	{
+		if(uIndex >= m_uEndIndex)
+		{
+			m_uEntryIndex = NoEntry;
+			return false;
+		}
+		m_uEntryIndex = uIndex;
+		return true;
+	}
 
 public:
 	/**
@@ -980,12 +1245,16 @@ public:
 	*/
 	void operator=(const KviPointerHashTableIterator<Key, T> & src)
 	{
-		m_pHashTable = src.m_pHashTable;
+		if(&src == this)
+			return;
+		if(m_pHashTable != src.m_pHashTable)
+		{
+			detach();
+			if(src.m_pHashTable)
+				attach(src.m_pHashTable);
+		}
 		m_uEntryIndex = src.m_uEntryIndex;
-		if(src.m_pIterator)
-			m_pIterator = new KviPointerListIterator<KviPointerHashTableEntry<Key, T>>(*(src.m_pIterator));
-		else
-			m_pIterator = NULL;
+		m_uEndIndex = src.m_uEndIndex;
 	}
 
 	/**
@@ -996,29 +1265,10 @@ public:
 	*/
 	bool moveFirst()
 	{
-		if(m_pIterator)
-		{
-			delete m_pIterator;
-			m_pIterator = NULL;
-		}
-
-		m_uEntryIndex = 0;
-		while((m_uEntryIndex < m_pHashTable->m_uSize) && (!(m_pHashTable->m_pDataArray[m_uEntryIndex])))
-		{
-			m_uEntryIndex++;
-		}
-
-		if(m_uEntryIndex == m_pHashTable->m_uSize)
+		if(!m_pHashTable)
 			return false;
-
-		m_pIterator = new KviPointerListIterator<KviPointerHashTableEntry<Key, T>>(*(m_pHashTable->m_pDataArray[m_uEntryIndex]));
-		bool bRet = m_pIterator->moveFirst();
-		if(!bRet)
-		{
-			delete m_pIterator;
-			m_pIterator = NULL;
-		}
-		return bRet;
+		m_uEndIndex = m_pHashTable->m_uEntries;
+		return moveTo(m_pHashTable->nextUsedEntry(0, m_uEndIndex));
 	}
 
 	/**
@@ -1029,29 +1279,12 @@ public:
 	*/
 	bool moveLast()
 	{
-		if(m_pIterator)
-		{
-			delete m_pIterator;
-			m_pIterator = NULL;
-		}
-
-		m_uEntryIndex = m_pHashTable->m_uSize;
-		while(m_uEntryIndex > 0)
-		{
-			m_uEntryIndex--;
-			if(m_pHashTable->m_pDataArray[m_uEntryIndex])
-			{
-				m_pIterator = new KviPointerListIterator<KviPointerHashTableEntry<Key, T>>(*(m_pHashTable->m_pDataArray[m_uEntryIndex]));
-				bool bRet = m_pIterator->moveLast();
-				if(!bRet)
-				{
-					delete m_pIterator;
-					m_pIterator = NULL;
-				}
-				return bRet;
-			}
-		}
-		return false;
+		if(!m_pHashTable)
+			return false;
+		m_uEndIndex = m_pHashTable->m_uEntries;
+		if(!m_uEndIndex)
+			return moveTo(NoEntry);
+		return moveTo(m_pHashTable->prevUsedEntry(m_uEndIndex - 1));
 	}
 
 	/**
@@ -1063,38 +1296,17 @@ public:
 	*/
 	bool moveNext()
 	{
-		if(!m_pIterator)
-			return false;
-		if(m_pIterator->moveNext())
-			return true;
-		if(m_pIterator)
-		{
-			delete m_pIterator;
-			m_pIterator = NULL;
-		}
-		m_uEntryIndex++;
-		while((m_uEntryIndex < m_pHashTable->m_uSize) && (!(m_pHashTable->m_pDataArray[m_uEntryIndex])))
-		{
-			m_uEntryIndex++;
-		}
-		if(m_uEntryIndex == m_pHashTable->m_uSize)
-			return false;
-		m_pIterator = new KviPointerListIterator<KviPointerHashTableEntry<Key, T>>(*(m_pHashTable->m_pDataArray[m_uEntryIndex]));
-		bool bRet = m_pIterator->moveFirst();
-		if(!bRet)
-		{
-			delete m_pIterator;
-			m_pIterator = NULL;
-		}
-		return bRet;
+		if(m_uEntryIndex >= m_uEndIndex)
+			return moveTo(NoEntry);
+		return moveTo(m_pHashTable->nextUsedEntry(m_uEntryIndex + 1, m_uEndIndex));
 	}
 
 	/**
 	* \brief Moves the iterator to the next element of the hash table.
 	*
-	* The iterator must be actually valid for this function to work.
+	* The iterator must be actually valid for this operator to work.
 	* Returns true in case of success or false if there is no next item.
-	* This is just an alias to moveNext().
+	* This is just a convenient alias to moveNext().
 	* \return bool
 	*/
 	bool operator++()
@@ -1106,48 +1318,22 @@ public:
 	* \brief Moves the iterator to the previous element of the hash table.
 	*
 	* The iterator must be actually valid for this function to work.
-	* Returns true in case of success or false if there is no previous
-	* item.
+	* Returns true in case of success or false if there is no previous item.
 	* \return bool
 	*/
 	bool movePrev()
 	{
-		if(!m_pIterator)
-			return false;
-		if(m_pIterator->movePrev())
-			return true;
-		if(m_pIterator)
-		{
-			delete m_pIterator;
-			m_pIterator = NULL;
-		}
-		if(m_uEntryIndex >= m_pHashTable->m_uSize)
-			return false;
-		while(m_uEntryIndex > 0)
-		{
-			m_uEntryIndex--;
-			if(m_pHashTable->m_pDataArray[m_uEntryIndex])
-			{
-				m_pIterator = new KviPointerListIterator<KviPointerHashTableEntry<Key, T>>(*(m_pHashTable->m_pDataArray[m_uEntryIndex]));
-				bool bRet = m_pIterator->moveLast();
-				if(!bRet)
-				{
-					delete m_pIterator;
-					m_pIterator = NULL;
-				}
-				return bRet;
-			}
-		}
-		return false;
+		if((m_uEntryIndex >= m_uEndIndex) || (m_uEntryIndex == 0))
+			return moveTo(NoEntry);
+		return moveTo(m_pHashTable->prevUsedEntry(m_uEntryIndex - 1));
 	}
 
 	/**
 	* \brief Moves the iterator to the previous element of the hash table.
 	*
-	* The iterator must be actually valid for this function to work.
-	* Returns true in case of success or false if there is no previous
-	* item.
-	* This is just an alias to movePrev() with a different name.
+	* The iterator must be actually valid for this operator to work.
+	* Returns true in case of success or false if there is no previous item.
+	* This is just a convenient alias to movePrev() with a different name.
 	* \return bool
 	*/
 	bool operator--()
@@ -1158,37 +1344,36 @@ public:
 	/**
 	* \brief Returs the value pointed by the iterator
 	*
-	* If the iterator is not valid it returns a default constructed value
-	* This is an alias to operator *() with just a different name.
+	* ...or NULL if the iterator is not valid.
 	* \return T *
 	*/
 	T * current() const
 	{
-		return m_pIterator ? m_pIterator->current()->data() : NULL;
+		return onEntry() ? m_pHashTable->m_pEntries[m_uEntryIndex].data() : NULL;
 	}
 
 	/**
 	* \brief Returs the value pointed by the iterator
 	*
-	* If the iterator is not valid it returns a default constructed value
-	* This is an alias to current() with just a different name.
+	* ...or NULL if the iterator is not valid.
+	* This is just an alias to current().
 	* \return T *
 	*/
 	T * operator*() const
 	{
-		return m_pIterator ? m_pIterator->current()->data() : NULL;
+		return current();
 	}
 
 	/**
-	* \brief Returs the key pointed by the iterator
+	* \brief Returns the key pointed by the iterator
 	*
-	* If the iterator is not valid it returns a default constructed value
+	* ...or a default constructed key if the iterator is not valid.
 	* \return const Key &
 	*/
 	const Key & currentKey() const
 	{
-		if(m_pIterator)
-			return m_pIterator->current()->key();
+		if(onEntry())
+			return m_pHashTable->m_pEntries[m_uEntryIndex].key();
 		return kvi_hash_key_default(((Key *)NULL));
 	}
 
@@ -1208,24 +1393,39 @@ public:
 public:
 	/**
 	* \brief Creates an iterator pointing to the first item in the hash table, if any.
-	* \param hTable The hash table
-	* \return KviPointerHashTableIterator
+	* \param hTable The hash table to iterate
 	*/
 	KviPointerHashTableIterator(const KviPointerHashTable<Key, T> & hTable)
 	{
-		m_pHashTable = &hTable;
-		m_uEntryIndex = 0;
-		m_pIterator = NULL;
+		attach(&hTable);
+		m_uEntryIndex = NoEntry;
+		m_uEndIndex = 0;
 		moveFirst();
 	}
 
+	/**
+	* \brief Creates an iterator copy.
+	*
+	* The new iterator points exactly to the item pointed by src.
+	* \param src The source iterator to copy from
+	*/
+	KviPointerHashTableIterator(const KviPointerHashTableIterator<Key, T> & src)
+	{
+		m_pHashTable = NULL;
+		m_pPrevIterator = NULL;
+		m_pNextIterator = NULL;
+		if(src.m_pHashTable)
+			attach(src.m_pHashTable);
+		m_uEntryIndex = src.m_uEntryIndex;
+		m_uEndIndex = src.m_uEndIndex;
+	}
+
 	/**
 	* \brief Destroys the iterator
 	*/
 	~KviPointerHashTableIterator()
 	{
-		if(m_pIterator)
-			delete m_pIterator;
+		detach();
 	}
 };
 
@@ -29,9 +29,185 @@
 #include "KviStringConversion.h"
 #include "KviMemory.h"
 #include "KviFile.h"
+#include "KviThread.h"
 
 #include <QColor>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
 #include <QRect>
+#include <QSaveFile>
+#include <QThread>
+
+#include <cstring>
+
+// at most this many threads parse the preloaded files
+#define KVI_CONFIG_MAX_PRELOAD_THREADS 4
+
+struct KviConfigurationFilePreload
+{
+	enum State
+	{
+		Queued,
+		Parsing,
+		Parsed
+	};
+	State eState;
+	KviPointerHashTable<QString, KviConfigurationFileGroup> * pDict; // set when Parsed
+};
+
+class KviConfigurationFilePreloader : public KviThread
+{
+protected:
+	virtual void run();
+};
+
+// All locked by g_pPreloadMutex
+static KviMutex * g_pPreloadMutex = nullptr;
+static QHash<QString, KviConfigurationFilePreload *> * g_pPreloadDict = nullptr;
+static QStringList * g_pPreloadQueue = nullptr;
+// main thread only
+static KviPointerList<KviConfigurationFilePreloader> * g_pPreloadThreads = nullptr;
+
+// The text files smaller than this are parsed faster than a snapshot is validated
+#define KVI_CONFIG_SNAPSHOT_MIN_SIZE 16384
+
+#define KVI_CONFIG_SNAPSHOT_MAGIC 0x4b435346 // "KCSF"
+#define KVI_CONFIG_SNAPSHOT_VERSION 2
+#define KVI_CONFIG_SNAPSHOT_BYTE_ORDER 0x01020304
+
+//
+// The snapshot is the header followed by the payload, all in the native byte order.
+// The payload contains, for each group, the group name, the number of entries
+// and the key/value pairs. The strings are stored as a 32 bit length followed
+// by the UTF-16 characters, padded to 4 bytes so every field is aligned.
+//
+struct KviConfigurationFileSnapshotHeader
+{
+	quint32 uMagic;
+	quint32 uVersion;
+	quint32 uByteOrder;
+	quint32 uGroups;
+	qint64 iSourceSize;     // of the text file the snapshot was made from
+	qint64 iSourceModified; // msecs since the epoch
+	quint64 uSourceHash;    // FNV-1a of the text: the size and the time alone can match a changed file
+	quint64 uPayloadSize;
+	quint64 uPayloadHash; // FNV-1a
+};
+
+static QString g_szSnapshotFallbackDirectory;
+
+#define KVI_CONFIG_SNAPSHOT_HASH_SEED 0xcbf29ce484222325ULL
+
+static quint64 snapshot_hash(const unsigned char * p, quint64 uSize, quint64 h = KVI_CONFIG_SNAPSHOT_HASH_SEED)
+{
+	const unsigned char * e = p + uSize;
+	while(p < e)
+	{
+		h ^= *p++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+static bool snapshot_file_hash(const QString & szFileName, quint64 & uHash)
+{
+	QFile f(szFileName);
+	if(!f.open(QFile::ReadOnly))
+		return false;
+
+	uHash = KVI_CONFIG_SNAPSHOT_HASH_SEED;
+	qint64 iSize = f.size();
+	if(iSize < 1)
+		return true;
+
+	const unsigned char * pData = f.map(0, iSize);
+	if(pData)
+	{
+		uHash = snapshot_hash(pData, iSize);
+		return true;
+	}
+
+	// not mappable on this filesystem
+	char buffer[16384];
+	for(;;)
+	{
+		qint64 iRead = f.read(buffer, sizeof(buffer));
+		if(iRead < 0)
+			return false;
+		if(iRead == 0)
+			return true;
+		uHash = snapshot_hash((const unsigned char *)buffer, iRead, uHash);
+	}
+}
+
+static void snapshot_write_uint(QByteArray & buffer, quint32 u)
+{
+	buffer.append((const char *)&u, sizeof(u));
+}
+
+static void snapshot_write_string(QByteArray & buffer, const QString & sz)
+{
+	snapshot_write_uint(buffer, sz.length());
+	buffer.append((const char *)sz.unicode(), sz.length() * sizeof(QChar));
+	if(sz.length() & 1)
+		buffer.append("\0\0", 2);
+}
+
+static bool snapshot_read_uint(const unsigned char *& p, const unsigned char * e, quint32 & u)
+{
+	if((e - p) < (qint64)sizeof(u))
+		return false;
+	memcpy(&u, p, sizeof(u));
+	p += sizeof(u);
+	return true;
+}
+
+static bool snapshot_read_string(const unsigned char *& p, const unsigned char * e, QString & sz)
+{
+	quint32 uLen;
+	if(!snapshot_read_uint(p, e, uLen))
+		return false;
+	quint64 uBytes = ((quint64)uLen * sizeof(QChar) + 3) & ~((quint64)3);
+	if((quint64)(e - p) < uBytes)
+		return false;
+	sz = QString((const QChar *)p, uLen);
+	p += uBytes;
+	return true;
+}
+
+// The hash tables are sized for the number of items they will contain
+static unsigned int snapshot_table_size(quint32 uItems)
+{
+	return (uItems < 17) ? 17 : ((uItems > 65535 ? 65535 : uItems) | 1);
+}
+
+static bool snapshot_parse(const unsigned char * p, const unsigned char * e, quint32 uGroups, KviPointerHashTable<QString, KviConfigurationFileGroup> * pDict)
+{
+	QString szGroup, szKey, szValue;
+	for(quint32 g = 0; g < uGroups; g++)
+	{
+		quint32 uEntries;
+		if(!snapshot_read_string(p, e, szGroup))
+			return false;
+		if(!snapshot_read_uint(p, e, uEntries))
+			return false;
+
+		KviConfigurationFileGroup * pGroup = new KviConfigurationFileGroup(snapshot_table_size(uEntries), false);
+		pGroup->setAutoDelete(true);
+		pDict->insert(szGroup, pGroup);
+
+		for(quint32 i = 0; i < uEntries; i++)
+		{
+			if(!snapshot_read_string(p, e, szKey))
+				return false;
+			if(!snapshot_read_string(p, e, szValue))
+				return false;
+			pGroup->insert(szKey, new QString(szValue));
+		}
+	}
+	return p == e;
+}
 
 KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f, bool bLocal8Bit)
 {
@@ -44,7 +220,10 @@ KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f,
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
 	if(f != KviConfigurationFile::Write)
-		load();
+	{
+		if(m_bLocal8Bit || !loadPreloaded())
+			load();
+	}
 }
 
 KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bool bLocal8Bit)
@@ -58,7 +237,153 @@ KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bo
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
 	if(f != KviConfigurationFile::Write)
-		load();
+	{
+		if(m_bLocal8Bit || !loadPreloaded())
+			load();
+	}
+}
+
+void KviConfigurationFilePreloader::run()
+{
+	for(;;)
+	{
+		g_pPreloadMutex->lock();
+		QString szFileName;
+		KviConfigurationFilePreload * p = nullptr;
+		while(!g_pPreloadQueue->isEmpty())
+		{
+			szFileName = g_pPreloadQueue->takeFirst();
+			p = g_pPreloadDict->value(szFileName, nullptr);
+			if(p && (p->eState == KviConfigurationFilePreload::Queued))
+				break;
+			p = nullptr; // already taken by the main thread
+		}
+		if(!p)
+		{
+			g_pPreloadMutex->unlock();
+			return;
+		}
+		p->eState = KviConfigurationFilePreload::Parsing;
+		g_pPreloadMutex->unlock();
+
+		// Write mode doesn't load and won't save
+		KviConfigurationFile cfg(szFileName, KviConfigurationFile::Write);
+		cfg.load();
+
+		g_pPreloadMutex->lock();
+		p->pDict = cfg.m_pDict;
+		p->eState = KviConfigurationFilePreload::Parsed;
+		cfg.m_pDict = nullptr;
+		g_pPreloadMutex->unlock();
+	}
+}
+
+void KviConfigurationFile::preload(const QStringList & lFileNames)
+{
+	if(lFileNames.isEmpty())
+		return;
+
+	if(!g_pPreloadMutex)
+	{
+		g_pPreloadMutex = new KviMutex();
+		g_pPreloadDict = new QHash<QString, KviConfigurationFilePreload *>();
+		g_pPreloadQueue = new QStringList();
+		g_pPreloadThreads = new KviPointerList<KviConfigurationFilePreloader>;
+		g_pPreloadThreads->setAutoDelete(true);
+	}
+
+	g_pPreloadMutex->lock();
+	for(auto & szFileName : lFileNames)
+	{
+		if(g_pPreloadDict->contains(szFileName))
+			continue;
+		KviConfigurationFilePreload * p = new KviConfigurationFilePreload;
+		p->eState = KviConfigurationFilePreload::Queued;
+		p->pDict = nullptr;
+		g_pPreloadDict->insert(szFileName, p);
+		g_pPreloadQueue->append(szFileName);
+	}
+	g_pPreloadMutex->unlock();
+
+	int iThreads = qMin(QThread::idealThreadCount(), KVI_CONFIG_MAX_PRELOAD_THREADS);
+	iThreads = qMin(iThreads, lFileNames.count());
+	if(iThreads < 1)
+		iThreads = 1;
+
+	// If a thread can't be started the files are simply loaded
+	// by the main thread when they are needed
+	for(int i = 0; i < iThreads; i++)
+	{
+		KviConfigurationFilePreloader * t = new KviConfigurationFilePreloader();
+		g_pPreloadThreads->append(t);
+		t->start();
+	}
+}
+
+void KviConfigurationFile::discardPreloaded()
+{
+	if(!g_pPreloadMutex)
+		return;
+
+	g_pPreloadMutex->lock();
+	g_pPreloadQueue->clear();
+	g_pPreloadMutex->unlock();
+
+	// this waits for the threads
+	delete g_pPreloadThreads;
+	g_pPreloadThreads = nullptr;
+
+	for(auto p : *g_pPreloadDict)
+	{
+		if(p->pDict)
+			delete p->pDict;
+		delete p;
+	}
+
+	delete g_pPreloadDict;
+	g_pPreloadDict = nullptr;
+	delete g_pPreloadQueue;
+	g_pPreloadQueue = nullptr;
+	delete g_pPreloadMutex;
+	g_pPreloadMutex = nullptr;
+}
+
+bool KviConfigurationFile::loadPreloaded()
+{
+	if(!g_pPreloadMutex)
+		return false;
+
+	for(;;)
+	{
+		g_pPreloadMutex->lock();
+		KviConfigurationFilePreload * p = g_pPreloadDict->value(m_szFileName, nullptr);
+		if(!p)
+		{
+			g_pPreloadMutex->unlock();
+			return false;
+		}
+		if(p->eState == KviConfigurationFilePreload::Parsing)
+		{
+			// almost there
+			g_pPreloadMutex->unlock();
+			KviThread::usleep(200);
+			continue;
+		}
+		g_pPreloadDict->remove(m_szFileName);
+		g_pPreloadMutex->unlock();
+
+		if(p->eState == KviConfigurationFilePreload::Queued)
+		{
+			// not started yet: it's faster to parse it here
+			delete p;
+			return false;
+		}
+
+		delete m_pDict;
+		m_pDict = p->pDict;
+		delete p;
+		return true;
+	}
 }
 
 KviConfigurationFile::~KviConfigurationFile()
@@ -94,9 +419,154 @@ void KviConfigurationFile::clearKey(const QString & szKey)
 		clearGroup(m_szGroup);
 }
 
-#define LOAD_BLOCK_SIZE 32768
+void KviConfigurationFile::setSnapshotFallbackDirectory(const QString & szDirectory)
+{
+	g_szSnapshotFallbackDirectory = szDirectory;
+}
+
+QString KviConfigurationFile::snapshotFileName()
+{
+	QFileInfo inf(m_szFileName);
+	if(QFileInfo(inf.absolutePath()).isWritable())
+		return m_szFileName + ".snapshot";
+
+	if(g_szSnapshotFallbackDirectory.isEmpty())
+		return QString();
+
+	// the global files have the same names as the local ones
+	QByteArray szPath = inf.absoluteFilePath().toUtf8();
+	quint64 uHash = snapshot_hash((const unsigned char *)szPath.constData(), szPath.size());
+	QString szName = QString("%1-%2.snapshot").arg(inf.fileName()).arg(uHash, 16, 16, QChar('0'));
+	return g_szSnapshotFallbackDirectory + KVI_PATH_SEPARATOR_CHAR + szName;
+}
+
+bool KviConfigurationFile::loadSnapshot(const QString & szSnapshot, qint64 iSourceSize, qint64 iSourceModified, quint64 uSourceHash)
+{
+	QFile f(szSnapshot);
+	if(!f.open(QFile::ReadOnly))
+		return false;
+
+	qint64 iSize = f.size();
+	if(iSize < (qint64)sizeof(KviConfigurationFileSnapshotHeader))
+		return false;
+
+	QByteArray buffer;
+	const unsigned char * pData = f.map(0, iSize);
+	if(!pData)
+	{
+		// not mappable on this filesystem
+		buffer = f.readAll();
+		if(buffer.size() != iSize)
+			return false;
+		pData = (const unsigned char *)buffer.constData();
+	}
+
+	KviConfigurationFileSnapshotHeader hdr;
+	memcpy(&hdr, pData, sizeof(hdr));
+	if((hdr.uMagic != KVI_CONFIG_SNAPSHOT_MAGIC) || (hdr.uVersion != KVI_CONFIG_SNAPSHOT_VERSION) || (hdr.uByteOrder != KVI_CONFIG_SNAPSHOT_BYTE_ORDER))
+		return false;
+	if((hdr.iSourceSize != iSourceSize) || (hdr.iSourceModified != iSourceModified) || (hdr.uSourceHash != uSourceHash))
+		return false; // stale: the text has been changed
+	if(hdr.uPayloadSize != (quint64)(iSize - sizeof(hdr)))
+		return false;
+
+	const unsigned char * p = pData + sizeof(hdr);
+	if(snapshot_hash(p, hdr.uPayloadSize) != hdr.uPayloadHash)
+		return false;
+
+	KviPointerHashTable<QString, KviConfigurationFileGroup> * pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(snapshot_table_size(hdr.uGroups), false);
+	pDict->setAutoDelete(true);
+	if(!snapshot_parse(p, p + hdr.uPayloadSize, hdr.uGroups, pDict))
+	{
+		delete pDict;
+		return false;
+	}
+
+	delete m_pDict;
+	m_pDict = pDict;
+	return true;
+}
+
+void KviConfigurationFile::saveSnapshot(const QString & szSnapshot, qint64 iSourceSize, qint64 iSourceModified, quint64 uSourceHash, bool bSkipEmptyGroups)
+{
+	QByteArray payload;
+	quint32 uGroups = 0;
+
+	KviPointerHashTableIterator<QString, KviConfigurationFileGroup> it(*m_pDict);
+	while(KviConfigurationFileGroup * pGroup = it.current())
+	{
+		if((pGroup->count() != 0) || !bSkipEmptyGroups)
+		{
+			snapshot_write_string(payload, it.currentKey());
+			snapshot_write_uint(payload, pGroup->count());
+
+			KviConfigurationFileGroupIterator it2(*pGroup);
+			while(QString * pValue = it2.current())
+			{
+				snapshot_write_string(payload, it2.currentKey());
+				snapshot_write_string(payload, *pValue);
+				++it2;
+			}
+			uGroups++;
+		}
+		++it;
+	}
+
+	KviConfigurationFileSnapshotHeader hdr;
+	hdr.uMagic = KVI_CONFIG_SNAPSHOT_MAGIC;
+	hdr.uVersion = KVI_CONFIG_SNAPSHOT_VERSION;
+	hdr.uByteOrder = KVI_CONFIG_SNAPSHOT_BYTE_ORDER;
+	hdr.uGroups = uGroups;
+	hdr.iSourceSize = iSourceSize;
+	hdr.iSourceModified = iSourceModified;
+	hdr.uSourceHash = uSourceHash;
+	hdr.uPayloadSize = payload.size();
+	hdr.uPayloadHash = snapshot_hash((const unsigned char *)payload.constData(), payload.size());
+
+	// a failure here just means that the text will be parsed again
+	QSaveFile f(szSnapshot);
+	if(!f.open(QIODevice::WriteOnly))
+		return;
+	if(f.write((const char *)&hdr, sizeof(hdr)) != sizeof(hdr))
+		return;
+	if(f.write(payload) != payload.size())
+		return;
+	f.commit();
+}
 
 bool KviConfigurationFile::load()
+{
+	if(m_bLocal8Bit)
+		return loadText(); // the snapshots store the decoded strings
+
+	QFileInfo inf(m_szFileName);
+	if(!inf.exists())
+		return false;
+	if(inf.size() < KVI_CONFIG_SNAPSHOT_MIN_SIZE)
+		return loadText();
+
+	QString szSnapshot = snapshotFileName();
+	if(szSnapshot.isEmpty())
+		return loadText();
+
+	// hashing the text is still much faster than parsing it
+	quint64 uHash;
+	if(!snapshot_file_hash(m_szFileName, uHash))
+		return loadText();
+
+	qint64 iModified = inf.lastModified().toMSecsSinceEpoch();
+	if(loadSnapshot(szSnapshot, inf.size(), iModified, uHash))
+		return true;
+
+	if(!loadText())
+		return false;
+	saveSnapshot(szSnapshot, inf.size(), iModified, uHash, false);
+	return true;
+}
+
+#define LOAD_BLOCK_SIZE 32768
+
+bool KviConfigurationFile::loadText()
 {
 	// this is really faster than the old version :)
 	// open the file
@@ -456,6 +926,18 @@ bool KviConfigurationFile::save()
 	}
 	f.close();
 	m_bDirty = false;
+
+	if(!m_bLocal8Bit)
+	{
+		QFileInfo inf(m_szFileName);
+		if(inf.size() >= KVI_CONFIG_SNAPSHOT_MIN_SIZE)
+		{
+			QString szSnapshot = snapshotFileName();
+			quint64 uHash;
+			if(!szSnapshot.isEmpty() && snapshot_file_hash(m_szFileName, uHash))
+				saveSnapshot(szSnapshot, inf.size(), inf.lastModified().toMSecsSinceEpoch(), uHash, !m_bPreserveEmptyGroups);
+		}
+	}
 	return true;
 }
 
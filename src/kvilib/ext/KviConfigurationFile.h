@@ -48,6 +48,8 @@ typedef KviPointerHashTableIterator<QString, KviConfigurationFileGroup> KviConfi
 
 class KVILIB_API KviConfigurationFile : public KviHeapObject
 {
+	friend class KviConfigurationFilePreloader;
+
 public:
 	enum FileMode
 	{
@@ -73,6 +75,11 @@ private:
 
 private:
 	bool load();
+	bool loadText();
+	bool loadPreloaded(); // takes the data parsed by preload(), if any
+	QString snapshotFileName();
+	bool loadSnapshot(const QString & szSnapshot, qint64 iSourceSize, qint64 iSourceModified, quint64 uSourceHash);
+	void saveSnapshot(const QString & szSnapshot, qint64 iSourceSize, qint64 iSourceModified, quint64 uSourceHash, bool bSkipEmptyGroups);
 	bool save();
 	KviConfigurationFileGroup * getCurrentGroup();
 
@@ -157,6 +164,24 @@ public:
 	void writeEntry(const QString & szKey, unsigned char iValue);
 	unsigned char readUCharEntry(const QString & szKey, unsigned char iDefault);
 
+	//
+	// Parses the files in the background, on a small pool of threads.
+	// The configurations created later for the same files (in Read or ReadWrite
+	// mode, without bLocal8Bit) take the parsed data instead of reading the files.
+	// Call from the main thread only.
+	//
+	static void preload(const QStringList & lFileNames);
+	// Waits for the preloading threads and drops the data that has not been used
+	static void discardPreloaded();
+
+	//
+	// The big files get a binary snapshot of their contents, written next to them
+	// and used instead of the text as long as the text is not changed.
+	// The snapshots of the files in read-only directories go in this directory.
+	// Set it before loading anything.
+	//
+	static void setSnapshotFallbackDirectory(const QString & szDirectory);
+
 	static void getFontProperties(KviCString & buffer, QFont * fnt);
 	static void setFontProperties(KviCString & str, QFont * fnt);
 
@@ -76,8 +76,18 @@ KviMediaManager::~KviMediaManager()
 	delete m_pMediaTypeList;
 }
 
+void KviMediaManager::ensureLoaded()
+{
+	// the caller has locked the manager
+	if(m_szLoadOnDemand.isEmpty())
+		return;
+	QString szFilename = m_szLoadOnDemand;
+	load(szFilename); // clears m_szLoadOnDemand
+}
+
 KviMediaType * KviMediaManager::findMediaTypeByIanaType(const char * ianaType)
 {
+	ensureLoaded();
 	KVI_ASSERT(locked());
 	for(KviMediaType * mt = m_pMediaTypeList->first(); mt; mt = m_pMediaTypeList->next())
 	{
@@ -90,6 +100,7 @@ KviMediaType * KviMediaManager::findMediaTypeByIanaType(const char * ianaType)
 
 KviMediaType * KviMediaManager::findMediaTypeByFileMask(const char * filemask)
 {
+	ensureLoaded();
 	KVI_ASSERT(locked());
 	for(KviMediaType * mt = m_pMediaTypeList->first(); mt; mt = m_pMediaTypeList->next())
 	{
@@ -115,6 +126,7 @@ void KviMediaManager::copyMediaType(KviMediaType * dst, KviMediaType * src)
 
 void KviMediaManager::insertMediaType(KviMediaType * m)
 {
+	ensureLoaded();
 	KVI_ASSERT(locked());
 	int iWildCount = m->szFileMask.occurrences('*');
 	int iNonWildCount = m->szFileMask.len() - iWildCount;
@@ -181,6 +193,7 @@ void KviMediaManager::insertMediaType(KviMediaType * m)
 
 KviMediaType * KviMediaManager::findMediaType(const char * filename, bool bCheckMagic)
 {
+	ensureLoaded();
 	// FIXME: This should be ported at least to QString....
 	KVI_ASSERT(locked());
 
@@ -409,6 +422,8 @@ void KviMediaManager::load(const QString & filename)
 {
 	KVI_ASSERT(locked());
 
+	m_szLoadOnDemand = QString();
+
 	KviConfigurationFile cfg(filename, KviConfigurationFile::Read);
 	cfg.setGroup("MediaTypes");
 	unsigned int nEntries = cfg.readUIntEntry("NEntries", 0);
@@ -452,6 +467,13 @@ void KviMediaManager::load(const QString & filename)
 void KviMediaManager::save(const QString & filename)
 {
 	KVI_ASSERT(locked());
+
+	if(!m_szLoadOnDemand.isEmpty())
+	{
+		if(m_szLoadOnDemand == filename)
+			return; // never used: the file is up to date
+		ensureLoaded();
+	}
 	KviConfigurationFile cfg(filename, KviConfigurationFile::Write);
 
 	cfg.clear();
@@ -39,21 +39,37 @@ public:
 
 protected:
 	KviPointerList<KviMediaType> * m_pMediaTypeList;
+	QString m_szLoadOnDemand; // the file to load on the first use, if not loaded yet
 
 private:
 	KviMediaType * findMediaTypeForRegularFile(const char * pcFullPath, const char * pcFileName, bool bCheckMagic);
+	void ensureLoaded();
 
 public:
-	KviPointerList<KviMediaType> * mediaTypeList() { return m_pMediaTypeList; };
+	KviPointerList<KviMediaType> * mediaTypeList()
+	{
+		ensureLoaded();
+		return m_pMediaTypeList;
+	};
 	KviMediaType * findMediaTypeByFileMask(const char * pcFilemask);
 	KviMediaType * findMediaTypeByIanaType(const char * pcIanaType);
-	bool removeMediaType(KviMediaType * pType) { return m_pMediaTypeList->removeRef(pType); };
-	void clear() { m_pMediaTypeList->clear(); };
+	bool removeMediaType(KviMediaType * pType)
+	{
+		ensureLoaded();
+		return m_pMediaTypeList->removeRef(pType);
+	};
+	void clear()
+	{
+		m_szLoadOnDemand = QString(); // nothing to load anymore
+		m_pMediaTypeList->clear();
+	};
 	void insertMediaType(KviMediaType * pType);
 	KviMediaType * findMediaType(const char * pcFilename, bool bCheckMagic = true);
 	static void copyMediaType(KviMediaType * pDst, KviMediaType * pSrc);
 
 	void load(const QString & szFilename);
+	// Like load() but the file is loaded only when the media types are used for the first time
+	void loadOnDemand(const QString & szFilename) { m_szLoadOnDemand = szFilename; };
 	void save(const QString & szFilename);
 };
 
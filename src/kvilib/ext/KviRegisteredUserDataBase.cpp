@@ -32,6 +32,9 @@
 
 #include <QString>
 
+// The match cache is dropped when it grows above this size
+#define KVI_REGUSERDB_MAX_CACHED_MATCHES 4096
+
 /*
 	@doc: registered_users
 	@title:
@@ -138,6 +141,8 @@ KviRegisteredUserDataBase::KviRegisteredUserDataBase()
 
 	m_pGroupDict = new KviPointerHashTable<QString, KviRegisteredUserGroup>(5, false); // copy keys here!
 	m_pGroupDict->setAutoDelete(true);
+
+	m_bWildMaskIndexDirty = false;
 }
 
 KviRegisteredUserDataBase::~KviRegisteredUserDataBase()
@@ -207,6 +212,8 @@ KviRegisteredUser * KviRegisteredUserDataBase::addMask(KviRegisteredUser * u, Kv
 		return nullptr;
 	KVI_ASSERT(u == m_pUserDict->find(u->name()));
 
+	invalidateMatchCache();
+
 	KviRegisteredUserMaskList * l;
 	if(mask->hasWildNick())
 	{
@@ -276,6 +283,7 @@ void KviRegisteredUserDataBase::copyFrom(KviRegisteredUserDataBase * db)
 	m_pWildMaskList->clear();
 	m_pMaskDict->clear();
 	m_pGroupDict->clear();
+	invalidateMatchCache();
 	emit(databaseCleared());
 
 	KviPointerHashTableIterator<QString, KviRegisteredUser> it(*(db->m_pUserDict));
@@ -359,6 +367,7 @@ bool KviRegisteredUserDataBase::removeMaskByPointer(KviIrcMask * mask)
 {
 	if(!mask)
 		return 0;
+	invalidateMatchCache();
 	if(mask->hasWildNick())
 	{
 		// remove from the wild list
@@ -409,27 +418,234 @@ KviRegisteredUser * KviRegisteredUserDataBase::findMatchingUser(const QString &
 	return nullptr; // no match at all
 }
 
+void KviRegisteredUserDataBase::invalidateMatchCache()
+{
+	m_hMatchCache.clear();
+	m_bWildMaskIndexDirty = true;
+}
+
+// Copies szHost[iFrom,iTo) to szKey in lowercase.
+// Strings with non ASCII characters get no key since their case
+// insensitive comparison is not a plain ASCII one.
+static bool wild_mask_key(const QString & szHost, int iFrom, int iTo, QString & szKey)
+{
+	const QChar * p = szHost.constData();
+	szKey.resize(iTo - iFrom);
+	for(int i = iFrom; i < iTo; i++)
+	{
+		ushort c = p[i].unicode();
+		if(c > 127)
+			return false;
+		if((c >= 'A') && (c <= 'Z'))
+			c += 'a' - 'A';
+		szKey[i - iFrom] = QChar(c);
+	}
+	return true;
+}
+
+// Returns the position of the second last dot of szHost, -1 if there is none
+static int wild_mask_domain_start(const QString & szHost)
+{
+	int iDots = 0;
+	for(int i = szHost.length() - 1; i >= 0; i--)
+	{
+		if(szHost.at(i).unicode() == '.')
+		{
+			if(++iDots == 2)
+				return i;
+		}
+	}
+	return -1;
+}
+
+// The domain key of a host: its last two labels ("example.com" for
+// "a.b.example.com") or the whole host when it has fewer labels
+static bool wild_mask_host_domain_key(const QString & szHost, QString & szKey)
+{
+	return wild_mask_key(szHost, wild_mask_domain_start(szHost) + 1, szHost.length(), szKey);
+}
+
+// The prefix key of a host: everything up to its first dot, included
+static bool wild_mask_host_prefix_key(const QString & szHost, QString & szKey)
+{
+	int iDot = szHost.indexOf(QChar('.'));
+	if(iDot < 0)
+		return false;
+	return wild_mask_key(szHost, 0, iDot + 1, szKey);
+}
+
+void KviRegisteredUserDataBase::rebuildWildMaskIndex()
+{
+	m_WildMaskIndex.clear();
+	m_hWildMaskDomainBuckets.clear();
+	m_hWildMaskPrefixBuckets.clear();
+	m_UnindexedWildMasks.clear();
+	m_bWildMaskIndexDirty = false;
+
+	QString szKey;
+	KviPointerListIterator<KviRegisteredUserMask> it(*m_pWildMaskList);
+	while(KviRegisteredUserMask * m = it.current())
+	{
+		int iPos = m_WildMaskIndex.size();
+		m_WildMaskIndex.push_back(m);
+		++it;
+
+		const QString & szHost = m->mask()->host();
+		int iLen = szHost.length();
+		int iFirstWild = -1;
+		int iLastWild = -1;
+		for(int i = 0; i < iLen; i++)
+		{
+			ushort c = szHost.at(i).unicode();
+			if((c == '*') || (c == '?'))
+			{
+				if(iFirstWild < 0)
+					iFirstWild = i;
+				iLastWild = i;
+			}
+		}
+
+		// A literal host has the same domain key of the hosts it matches.
+		// Otherwise the key is usable only if the literal suffix (whatever
+		// follows the last wildcard) covers the whole last two labels:
+		// "*.users.example.com" can be keyed by "example.com", "*.com" can't.
+		if(iLastWild < 0)
+		{
+			if(wild_mask_host_domain_key(szHost, szKey))
+			{
+				m_hWildMaskDomainBuckets[szKey].push_back(iPos);
+				continue;
+			}
+		}
+		else
+		{
+			int iDomain = wild_mask_domain_start(szHost);
+			if((iDomain > iLastWild) && wild_mask_key(szHost, iDomain + 1, iLen, szKey))
+			{
+				m_hWildMaskDomainBuckets[szKey].push_back(iPos);
+				continue;
+			}
+		}
+
+		// The masks with a wildcard at the end ("192.168.*", "host.isp.*")
+		// fall back to the literal prefix, up to the first dot
+		if(iFirstWild > 0)
+		{
+			int iDot = szHost.indexOf(QChar('.'));
+			if((iDot >= 0) && (iDot < iFirstWild) && wild_mask_key(szHost, 0, iDot + 1, szKey))
+			{
+				m_hWildMaskPrefixBuckets[szKey].push_back(iPos);
+				continue;
+			}
+		}
+
+		m_UnindexedWildMasks.push_back(iPos);
+	}
+}
+
+KviRegisteredUserMask * KviRegisteredUserDataBase::findMatchingWildMask(const QString & nick, const QString & user, const QString & host)
+{
+	if(m_bWildMaskIndexDirty)
+		rebuildWildMaskIndex();
+
+	QString szKey;
+	if(!wild_mask_host_domain_key(host, szKey))
+	{
+		// can't use the buckets: check all the masks in order
+		for(auto m : m_WildMaskIndex)
+		{
+			if(m->mask()->matchesFixed(nick, user, host))
+				return m;
+		}
+		return nullptr;
+	}
+
+	// A host can be matched only by the masks in its domain bucket, in its
+	// prefix bucket (none if it has no dot) and by the unindexed ones.
+	// They are merged so that the masks are checked in the list order and
+	// the first match is the same one of a full scan.
+	static const std::vector<int> emptyBucket;
+	auto d = m_hWildMaskDomainBuckets.constFind(szKey);
+	const std::vector<int> & domainBucket = (d == m_hWildMaskDomainBuckets.constEnd()) ? emptyBucket : d.value();
+
+	const std::vector<int> * pPrefixBucket = &emptyBucket;
+	if(wild_mask_host_prefix_key(host, szKey))
+	{
+		auto p = m_hWildMaskPrefixBuckets.constFind(szKey);
+		if(p != m_hWildMaskPrefixBuckets.constEnd())
+			pPrefixBucket = &(p.value());
+	}
+
+	auto i1 = domainBucket.begin();
+	auto i2 = pPrefixBucket->begin();
+	auto i3 = m_UnindexedWildMasks.begin();
+	for(;;)
+	{
+		// pick the lowest position among the three heads
+		int iPos = m_WildMaskIndex.size();
+		if(i1 != domainBucket.end())
+			iPos = *i1;
+		if((i2 != pPrefixBucket->end()) && (*i2 < iPos))
+			iPos = *i2;
+		if((i3 != m_UnindexedWildMasks.end()) && (*i3 < iPos))
+			iPos = *i3;
+		if(iPos == (int)m_WildMaskIndex.size())
+			return nullptr;
+
+		if((i1 != domainBucket.end()) && (*i1 == iPos))
+			++i1;
+		else if((i2 != pPrefixBucket->end()) && (*i2 == iPos))
+			++i2;
+		else
+			++i3;
+
+		KviRegisteredUserMask * m = m_WildMaskIndex[iPos];
+		if(m->mask()->matchesFixed(nick, user, host))
+			return m;
+	}
+}
+
 KviRegisteredUserMask * KviRegisteredUserDataBase::findMatchingMask(const QString & nick, const QString & user, const QString & host)
 {
 	// first lookup the nickname in the maskDict
 	if(nick.isEmpty())
 		return nullptr;
+
+	// The same users are looked up over and over: remember the results,
+	// including the misses. Any change to the masks drops the cache.
+	QString szCacheKey = nick;
+	szCacheKey.append(QChar('!'));
+	szCacheKey.append(user);
+	szCacheKey.append(QChar('@'));
+	szCacheKey.append(host);
+
+	auto c = m_hMatchCache.constFind(szCacheKey);
+	if(c != m_hMatchCache.constEnd())
+		return c.value();
+
+	KviRegisteredUserMask * pMatch = nullptr;
+
 	KviRegisteredUserMaskList * l = m_pMaskDict->find(nick);
 	if(l)
 	{
 		for(KviRegisteredUserMask * m = l->first(); m; m = l->next())
 		{
 			if(m->mask()->matchesFixed(nick, user, host))
-				return m;
+			{
+				pMatch = m;
+				break;
+			}
 		}
 	}
+
 	// not found....lookup the wild ones
-	for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
-	{
-		if(m->mask()->matchesFixed(nick, user, host))
-			return m;
-	}
-	return nullptr; // no match at all
+	if(!pMatch)
+		pMatch = findMatchingWildMask(nick, user, host);
+
+	if(m_hMatchCache.count() >= KVI_REGUSERDB_MAX_CACHED_MATCHES)
+		m_hMatchCache.clear();
+	m_hMatchCache.insert(szCacheKey, pMatch);
+	return pMatch;
 }
 
 KviRegisteredUser * KviRegisteredUserDataBase::findUserWithMask(const KviIrcMask & mask)
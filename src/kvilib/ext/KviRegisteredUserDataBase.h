@@ -38,8 +38,11 @@
 #include "KviRegisteredUserMask.h"
 #include "KviRegisteredUser.h"
 
+#include <QHash>
 #include <QObject>
 
+#include <vector>
+
 class KviIrcMask;
 class QString;
 
@@ -65,6 +68,23 @@ private:
 	KviRegisteredUserMaskList * m_pWildMaskList;                           // owns the objects
 	KviPointerHashTable<QString, KviRegisteredUserGroup> * m_pGroupDict;
 
+	// Lookup acceleration, rebuilt lazily after any mask change.
+	// The wild masks are bucketed by the last two (lowercase) labels of
+	// their host when its literal suffix covers them ("*.isp.example.com"),
+	// else by the literal prefix up to the first dot ("192.168.*").
+	// A host can be matched only by the masks in its two buckets and by
+	// the ones that have no key at all.
+	std::vector<KviRegisteredUserMask *> m_WildMaskIndex;      // m_pWildMaskList in order
+	QHash<QString, std::vector<int>> m_hWildMaskDomainBuckets; // positions in m_WildMaskIndex, ascending
+	QHash<QString, std::vector<int>> m_hWildMaskPrefixBuckets; // positions in m_WildMaskIndex, ascending
+	std::vector<int> m_UnindexedWildMasks;                     // positions in m_WildMaskIndex, ascending
+	bool m_bWildMaskIndexDirty;
+	QHash<QString, KviRegisteredUserMask *> m_hMatchCache; // nick!user@host -> match (nullptr for no match)
+
+	void invalidateMatchCache();
+	void rebuildWildMaskIndex();
+	KviRegisteredUserMask * findMatchingWildMask(const QString & nick, const QString & user, const QString & host);
+
 public:
 	void copyFrom(KviRegisteredUserDataBase * db);
 	KviRegisteredUser * addUser(const QString & name); // returns 0 if already there
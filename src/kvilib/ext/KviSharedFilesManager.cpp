@@ -140,8 +140,17 @@ void KviSharedFilesManager::cleanup()
 		m_pCleanupTimer->stop();
 }
 
+void KviSharedFilesManager::ensureLoaded()
+{
+	if(m_szLoadOnDemand.isEmpty())
+		return;
+	QString szFilename = m_szLoadOnDemand;
+	load(szFilename); // clears m_szLoadOnDemand
+}
+
 void KviSharedFilesManager::clear()
 {
+	m_szLoadOnDemand = QString(); // nothing to load anymore
 	m_pSharedListDict->clear();
 	emit sharedFilesChanged();
 }
@@ -205,6 +214,8 @@ void KviSharedFilesManager::doInsert(KviSharedFileList * l, KviSharedFile * o)
 
 void KviSharedFilesManager::addSharedFile(KviSharedFile * f)
 {
+	ensureLoaded();
+
 	// First find the list
 	KviSharedFileList * l = m_pSharedListDict->find(f->name());
 	if(!l)
@@ -227,6 +238,8 @@ void KviSharedFilesManager::addSharedFile(KviSharedFile * f)
 
 KviSharedFile * KviSharedFilesManager::addSharedFile(const QString & szName, const QString & szAbsPath, const QString & szMask, int timeoutInSecs)
 {
+	ensureLoaded();
+
 	QFileInfo inf(szAbsPath);
 	if(inf.exists() && inf.isFile() && inf.isReadable() && (inf.size() > 0))
 	{
@@ -263,6 +276,8 @@ KviSharedFile * KviSharedFilesManager::addSharedFile(const QString & szName, con
 
 KviSharedFile * KviSharedFilesManager::lookupSharedFile(const QString & szName, KviIrcMask * mask, unsigned int uFileSize)
 {
+	ensureLoaded();
+
 	KviSharedFileList * l = m_pSharedListDict->find(szName);
 	if(!l)
 		return nullptr;
@@ -293,6 +308,8 @@ KviSharedFile * KviSharedFilesManager::lookupSharedFile(const QString & szName,
 }
 bool KviSharedFilesManager::removeSharedFile(const QString & szName, const QString & szMask, unsigned int uFileSize)
 {
+	ensureLoaded();
+
 	KviSharedFileList * l = m_pSharedListDict->find(szName);
 	if(!l)
 		return false;
@@ -317,6 +334,8 @@ bool KviSharedFilesManager::removeSharedFile(const QString & szName, const QStri
 
 bool KviSharedFilesManager::removeSharedFile(const QString & szName, KviSharedFile * off)
 {
+	ensureLoaded();
+
 	KviSharedFileList * l = m_pSharedListDict->find(szName);
 	if(!l)
 		return false;
@@ -337,6 +356,8 @@ bool KviSharedFilesManager::removeSharedFile(const QString & szName, KviSharedFi
 
 void KviSharedFilesManager::load(const QString & szFilename)
 {
+	m_szLoadOnDemand = QString();
+
 	KviConfigurationFile cfg(szFilename, KviConfigurationFile::Read);
 	cfg.setGroup("PermanentFileOffers");
 	int iNum = cfg.readIntEntry("NEntries", 0);
@@ -356,6 +377,13 @@ void KviSharedFilesManager::load(const QString & szFilename)
 
 void KviSharedFilesManager::save(const QString & szFilename)
 {
+	if(!m_szLoadOnDemand.isEmpty())
+	{
+		if(m_szLoadOnDemand == szFilename)
+			return; // never used: the file is up to date
+		ensureLoaded();
+	}
+
 	KviConfigurationFile cfg(szFilename, KviConfigurationFile::Write);
 	cfg.clear();
 	cfg.setGroup("PermanentFileOffers");
@@ -44,6 +44,7 @@ public:
 private:
 	QTimer * m_pCleanupTimer;
 	KviPointerHashTable<QString, KviSharedFileList> * m_pSharedListDict;
+	QString m_szLoadOnDemand; // the file to load on the first use, if not loaded yet
 
 public:
 	void addSharedFile(KviSharedFile * f);
@@ -52,11 +53,18 @@ public:
 	bool removeSharedFile(const QString & szName, const QString & szMask, unsigned int uFileSize);
 	bool removeSharedFile(const QString & szName, KviSharedFile * off);
 	void load(const QString & filename);
+	// Like load() but the file is loaded only when the shared files are used for the first time
+	void loadOnDemand(const QString & filename) { m_szLoadOnDemand = filename; };
 	void save(const QString & filename);
 	void clear();
-	KviPointerHashTable<QString, KviSharedFileList> * sharedFileListDict() { return m_pSharedListDict; };
+	KviPointerHashTable<QString, KviSharedFileList> * sharedFileListDict()
+	{
+		ensureLoaded();
+		return m_pSharedListDict;
+	};
 private:
 	void doInsert(KviSharedFileList * l, KviSharedFile * o);
+	void ensureLoaded();
 private slots:
 	void cleanup();
 signals:
@@ -75,6 +75,8 @@ KviAvatarCache::~KviAvatarCache()
 
 void KviAvatarCache::replace(const QString & szIdString, const KviIrcMask & mask, const QString & szNetwork)
 {
+	ensureLoaded();
+
 	QString szKey;
 
 	mask.mask(szKey, KviIrcMask::NickCleanUserSmartNet);
@@ -95,6 +97,8 @@ void KviAvatarCache::replace(const QString & szIdString, const KviIrcMask & mask
 
 void KviAvatarCache::remove(const KviIrcMask & mask, const QString & szNetwork)
 {
+	ensureLoaded();
+
 	QString szKey;
 
 	mask.mask(szKey, KviIrcMask::NickCleanUserSmartNet);
@@ -106,6 +110,8 @@ void KviAvatarCache::remove(const KviIrcMask & mask, const QString & szNetwork)
 
 const QString & KviAvatarCache::lookup(const KviIrcMask & mask, const QString & szNetwork)
 {
+	ensureLoaded();
+
 	QString szKey;
 
 	mask.mask(szKey, KviIrcMask::NickCleanUserSmartNet);
@@ -119,8 +125,17 @@ const QString & KviAvatarCache::lookup(const KviIrcMask & mask, const QString &
 	return e->szIdString;
 }
 
+void KviAvatarCache::ensureLoaded()
+{
+	if(m_szLoadOnDemand.isEmpty())
+		return;
+	QString szFileName = m_szLoadOnDemand;
+	load(szFileName); // clears m_szLoadOnDemand
+}
+
 void KviAvatarCache::load(const QString & szFileName)
 {
+	m_szLoadOnDemand = QString();
 	m_pAvatarDict->clear();
 
 	KviConfigurationFile cfg(szFileName, KviConfigurationFile::Read);
@@ -157,6 +172,13 @@ void KviAvatarCache::load(const QString & szFileName)
 
 void KviAvatarCache::save(const QString & szFileName)
 {
+	if(!m_szLoadOnDemand.isEmpty())
+	{
+		if(m_szLoadOnDemand == szFileName)
+			return; // never used: the file is up to date
+		ensureLoaded();
+	}
+
 	KviConfigurationFile cfg(szFileName, KviConfigurationFile::Write);
 	//	cfg.clear(); // not needed with KviConfigurationFile::Write
 
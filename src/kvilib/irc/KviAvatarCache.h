@@ -72,6 +72,14 @@ public:
 
 protected:
 	static KviAvatarCache * m_pAvatarCacheInstance;
+	QString m_szLoadOnDemand; // the file to load on the first use, if not loaded yet
+
+private:
+	/**
+	* \brief Loads the file passed to loadOnDemand(), if not loaded yet
+	* \return void
+	*/
+	void ensureLoaded();
 
 public:
 	/**
@@ -130,6 +138,15 @@ public:
 	*/
 	void load(const QString & szFileName);
 
+	/**
+	* \brief Loads the cache on its first use
+	*
+	* Like load() but the file is read only when the cache is used for the first time
+	* \param szFileName The cache filename
+	* \return void
+	*/
+	void loadOnDemand(const QString & szFileName) { m_szLoadOnDemand = szFileName; };
+
 	/**
 	* \brief Saves the cache
 	* \param szFileName The cache filename
@@ -46,6 +46,13 @@
 #include <QTextCodec>
 #include <QtGlobal>
 
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define KVI_UTF8_DECODE_SSE2
+#include <emmintrin.h>
+#endif
+
 KVILIB_API KviMessageCatalogue * g_pMainCatalogue = nullptr;
 
 static KviTranslator * g_pTranslator = nullptr;
@@ -245,6 +252,139 @@ static bool g_utf8_validate(const char * str, int max_len, const char ** end)
 //   End of gutf8.c
 //
 
+//
+// One pass UTF-8 decoding: accepts exactly what g_utf8_validate() accepts
+// and writes the UTF-16 text while validating. The runs of ASCII characters
+// are checked and widened 16 bytes at a time with SSE2 (always available
+// on x86_64) or 8 bytes at a time with plain integer arithmetic.
+//
+
+static bool utf8_decode(const char * pcData, int iLen, QString & szOut)
+{
+	const unsigned char * p = (const unsigned char *)pcData;
+	const unsigned char * e = p + iLen;
+
+	// the byte order mark is skipped, as the Qt codec does
+	if((iLen >= 3) && (p[0] == 0xef) && (p[1] == 0xbb) && (p[2] == 0xbf))
+		p += 3;
+
+	szOut.resize(e - p); // never more UTF-16 units than bytes
+	ushort * pStart = reinterpret_cast<ushort *>(szOut.data());
+	ushort * d = pStart;
+
+	while(p < e)
+	{
+#ifdef KVI_UTF8_DECODE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		while((e - p) >= 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)p);
+			// the high bit marks the non ASCII bytes, the comparison the terminators
+			int iMask = _mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, zero)));
+			if(iMask == 0)
+			{
+				_mm_storeu_si128((__m128i *)d, _mm_unpacklo_epi8(v, zero));
+				_mm_storeu_si128((__m128i *)(d + 8), _mm_unpackhi_epi8(v, zero));
+				p += 16;
+				d += 16;
+				continue;
+			}
+			// copy the ASCII characters up to the first special byte
+			while(!(iMask & 1))
+			{
+				*d++ = *p++;
+				iMask >>= 1;
+			}
+			break;
+		}
+#else
+		while((e - p) >= 8)
+		{
+			quint64 w;
+			memcpy(&w, p, 8);
+			// the high bits of the non ASCII bytes and of the terminators
+			if(((w | ((w - 0x0101010101010101ULL) & ~w)) & 0x8080808080808080ULL) != 0)
+				break;
+			for(int i = 0; i < 8; i++)
+				d[i] = p[i];
+			p += 8;
+			d += 8;
+		}
+#endif
+		if(p >= e)
+			break;
+
+		unsigned int c = *p;
+		if(c < 0x80)
+		{
+			if(c == 0)
+				return false; // g_utf8_validate() stops at the terminator
+			*d++ = c;
+			p++;
+			continue;
+		}
+
+		unsigned int val, min;
+		int n;
+		if((c & 0xe0) == 0xc0) /* 110xxxxx */
+		{
+			if((c & 0x1e) == 0)
+				return false; // overlong
+			val = c & 0x1f;
+			min = 0;
+			n = 1;
+		}
+		else if((c & 0xf0) == 0xe0) /* 1110xxxx */
+		{
+			val = c & 0x0f;
+			min = (1 << 11);
+			n = 2;
+		}
+		else if((c & 0xf8) == 0xf0) /* 11110xxx */
+		{
+			val = c & 0x07;
+			min = (1 << 16);
+			n = 3;
+		}
+		else
+		{
+			return false;
+		}
+
+		if((e - p) <= n)
+			return false; // truncated
+
+		for(int i = 1; i <= n; i++)
+		{
+			if((p[i] & 0xc0) != 0x80) /* 10xxxxxx */
+				return false;
+			val = (val << 6) | (p[i] & 0x3f);
+		}
+
+		if(n > 1)
+		{
+			if(val < min)
+				return false;
+			if(!UNICODE_VALID(val))
+				return false;
+		}
+
+		if(val >= 0x10000)
+		{
+			*d++ = QChar::highSurrogate(val);
+			*d++ = QChar::lowSurrogate(val);
+		}
+		else
+		{
+			*d++ = val;
+		}
+		p += n + 1;
+	}
+
+	szOut.truncate(d - pStart);
+	return true;
+}
+
 class KviSmartTextCodec : public QTextCodec
 {
 private:
@@ -289,6 +429,17 @@ protected:
 	}
 	QString convertToUnicode(const char * chars, int len, ConverterState * state) const override
 	{
+		// The stateless conversions (all the IRC traffic) are validated
+		// and decoded in a single pass over the data
+		if(!state)
+		{
+			QString szText;
+			if(utf8_decode(chars, len, szText))
+				return szText;
+			return m_pRecvCodec->toUnicode(chars, len, nullptr);
+		}
+
+		// a stream may split a character between two calls: let the Qt codec keep the state
 		if(g_utf8_validate(chars, len, nullptr))
 			return g_pUtf8TextCodec->toUnicode(chars, len, state);
 
@@ -545,6 +545,11 @@ int KviSSL::write(const char * buffer, int len)
 	return SSL_write(m_pSSL, buffer, len);
 }
 
+int KviSSL::pending()
+{
+	return SSL_pending(m_pSSL);
+}
+
 KviSSL::Result KviSSL::getProtocolError(int ret)
 {
 	if(!m_pSSL)
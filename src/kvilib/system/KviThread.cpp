@@ -38,12 +38,19 @@
 
 #include <errno.h>
 
+#ifdef Q_OS_LINUX
+#include <sys/eventfd.h>
+#endif
+
 #include "kvi_settings.h"
 #include "KviError.h"
+#include "KviMemory.h"
 
 #include <QSocketNotifier>
 #include <QApplication>
 
+#include <thread>
+
 static void kvi_threadIgnoreSigalarm()
 {
 // On Windows this stuff is useless anyway
@@ -144,9 +151,88 @@ static void kvi_threadInitialize()
 #define KVI_THREAD_PIPE_SIDE_MASTER 0
 #define KVI_THREAD_PIPE_SIDE_SLAVE 1
 
-// the maximum length of the slave->master queue
-// over this length, the slave is forced to usleep()
-#define KVI_THREAD_MAX_EVENT_QUEUE_LENGTH 50
+// the size of the slave->master ring (must be a power of two)
+// when the ring is full, the slave is forced to usleep()
+#define KVI_THREAD_EVENT_RING_SIZE 256
+#define KVI_THREAD_EVENT_RING_MASK (KVI_THREAD_EVENT_RING_SIZE - 1)
+
+// The KviThreadEvent pools: one free list for each size class,
+// the classes are KVI_THREAD_EVENT_POOL_GRANULARITY bytes apart
+#define KVI_THREAD_EVENT_POOL_GRANULARITY 16
+#define KVI_THREAD_EVENT_POOL_SIZE_CLASSES 8
+// the maximum number of free blocks kept by each pool
+#define KVI_THREAD_EVENT_POOL_MAX_FREE 128
+
+struct KviThreadEventPoolBlock
+{
+	KviThreadEventPoolBlock * pNext;
+};
+
+// The pools are never destroyed: events may be deleted while the statics go away
+static std::atomic_flag g_threadEventPoolLock = ATOMIC_FLAG_INIT;
+static KviThreadEventPoolBlock * g_pThreadEventPool[KVI_THREAD_EVENT_POOL_SIZE_CLASSES] = { nullptr };
+static unsigned int g_uThreadEventPoolFree[KVI_THREAD_EVENT_POOL_SIZE_CLASSES] = { 0 };
+
+static inline void kvi_threadEventPoolLock()
+{
+	// the critical sections are a couple of instructions long
+	while(g_threadEventPoolLock.test_and_set(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+static inline void kvi_threadEventPoolUnlock()
+{
+	g_threadEventPoolLock.clear(std::memory_order_release);
+}
+
+void * KviThreadEvent::operator new(size_t uSize)
+{
+	size_t uClass = (uSize - 1) / KVI_THREAD_EVENT_POOL_GRANULARITY;
+	if(uClass >= KVI_THREAD_EVENT_POOL_SIZE_CLASSES)
+		return KviMemory::allocate(uSize);
+
+	kvi_threadEventPoolLock();
+	KviThreadEventPoolBlock * b = g_pThreadEventPool[uClass];
+	if(b)
+	{
+		g_pThreadEventPool[uClass] = b->pNext;
+		g_uThreadEventPoolFree[uClass]--;
+	}
+	kvi_threadEventPoolUnlock();
+
+	if(b)
+		return b;
+	// all the blocks of a class have the same size, so they can be reused by any event of the class
+	return KviMemory::allocate((uClass + 1) * KVI_THREAD_EVENT_POOL_GRANULARITY);
+}
+
+void KviThreadEvent::operator delete(void * pData, size_t uSize)
+{
+	if(!pData)
+		return;
+
+	size_t uClass = (uSize - 1) / KVI_THREAD_EVENT_POOL_GRANULARITY;
+	if(uClass < KVI_THREAD_EVENT_POOL_SIZE_CLASSES)
+	{
+		KviThreadEventPoolBlock * b = (KviThreadEventPoolBlock *)pData;
+		bool bRecycled = false;
+
+		kvi_threadEventPoolLock();
+		if(g_uThreadEventPoolFree[uClass] < KVI_THREAD_EVENT_POOL_MAX_FREE)
+		{
+			b->pNext = g_pThreadEventPool[uClass];
+			g_pThreadEventPool[uClass] = b;
+			g_uThreadEventPoolFree[uClass]++;
+			bRecycled = true;
+		}
+		kvi_threadEventPoolUnlock();
+
+		if(bRecycled)
+			return;
+	}
+
+	KviMemory::free(pData);
+}
 
 static KviThreadManager * g_pThreadManager = nullptr;
 
@@ -176,11 +262,39 @@ KviThreadManager::KviThreadManager()
 
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
 
-	m_iTriggerCount = 0;
-
-	m_pEventQueue = new KviPointerList<KviThreadPendingEvent>;
-	m_pEventQueue->setAutoDelete(true);
-
+	m_pRing = new RingSlot[KVI_THREAD_EVENT_RING_SIZE];
+	for(unsigned int u = 0; u < KVI_THREAD_EVENT_RING_SIZE; u++)
+		m_pRing[u].uSequence.store(u, std::memory_order_relaxed);
+	m_uEnqueuePos.store(0, std::memory_order_relaxed);
+	m_uDequeuePos = 0;
+
+	m_pOverflowQueue = new KviPointerList<KviThreadPendingEvent>;
+	m_pOverflowQueue->setAutoDelete(true);
+	m_bOverflow.store(false);
+
+	m_uBatchPos = 0;
+	m_bWakeupPending.store(false);
+
+	m_timer.start();
+	m_uPosted.store(0);
+	m_uOverflowed.store(0);
+	m_uThrottled.store(0);
+	m_iPending.store(0);
+	m_iMaxPending.store(0);
+	m_uDelivered = 0;
+	m_uBatches = 0;
+	m_iTotalLatency = 0;
+	m_iMaxLatency = 0;
+
+#ifdef Q_OS_LINUX
+	// a single counter is enough to wake up the master thread
+	m_fd[KVI_THREAD_PIPE_SIDE_MASTER] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_fd[KVI_THREAD_PIPE_SIDE_SLAVE] = m_fd[KVI_THREAD_PIPE_SIDE_MASTER];
+	if(m_fd[KVI_THREAD_PIPE_SIDE_MASTER] == -1)
+	{
+		qDebug("Oops! Thread manager eventfd creation failed (%s)", KviError::getDescription(KviError::translateSystemError(errno)).toUtf8().data());
+	}
+#else
 	if(pipe(m_fd) != 0)
 	{
 		qDebug("Oops! Thread manager pipe creation failed (%s)", KviError::getDescription(KviError::translateSystemError(errno)).toUtf8().data());
@@ -195,6 +309,7 @@ KviThreadManager::KviThreadManager()
 	{
 		qDebug("Oops! Thread manager master pipe initialisation failed (%s)", KviError::getDescription(KviError::translateSystemError(errno)).toUtf8().data());
 	}
+#endif
 
 	m_pSn = new QSocketNotifier(m_fd[KVI_THREAD_PIPE_SIDE_MASTER], QSocketNotifier::Read);
 	connect(m_pSn, SIGNAL(activated(int)), this, SLOT(eventsPending(int)));
@@ -225,22 +340,29 @@ KviThreadManager::~KviThreadManager()
 	// we're no longer in this world
 	g_pThreadManager = nullptr;
 
+	m_pMutex->unlock();
+
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
 	// close the pipes
-	close(m_fd[KVI_THREAD_PIPE_SIDE_SLAVE]);
+	if(m_fd[KVI_THREAD_PIPE_SIDE_SLAVE] != m_fd[KVI_THREAD_PIPE_SIDE_MASTER])
+		close(m_fd[KVI_THREAD_PIPE_SIDE_SLAVE]);
 	close(m_fd[KVI_THREAD_PIPE_SIDE_MASTER]);
 	// Kill the pending events
-	while(KviThreadPendingEvent * ev = m_pEventQueue->first())
+	collectPendingEvents(true);
+	for(size_t u = m_uBatchPos; u < m_Batch.size(); u++)
+		delete m_Batch[u].e;
+	m_Batch.clear();
+	while(KviThreadPendingEvent * ev = m_pOverflowQueue->first())
 	{
 		delete ev->e;
-		m_pEventQueue->removeFirst();
+		m_pOverflowQueue->removeFirst();
 	}
-	delete m_pEventQueue;
-	m_pEventQueue = nullptr;
+	delete m_pOverflowQueue;
+	m_pOverflowQueue = nullptr;
+	delete[] m_pRing;
+	m_pRing = nullptr;
 #endif
 
-	m_pMutex->unlock();
-
 	// finish the cleanup
 	delete m_pMutex;
 	m_pMutex = nullptr;
@@ -262,10 +384,26 @@ void KviThreadManager::killPendingEvents(QObject * receiver)
 void KviThreadManager::killPendingEventsByReceiver(QObject * receiver)
 {
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	// We're on the master side: only we can consume the ring,
+	// so move everything to the batch and kill the events there
+	collectPendingEvents(true);
+
+	for(size_t u = m_uBatchPos; u < m_Batch.size(); u++)
+	{
+		KviThreadPendingEvent & ev = m_Batch[u];
+		if(ev.e && (ev.o == receiver))
+		{
+			delete ev.e;
+			ev.e = nullptr; // skipped by eventsPending()
+			m_iPending.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	// the overflowed events that couldn't be collected yet
 	KviPointerList<KviThreadPendingEvent> l;
 	l.setAutoDelete(false);
 	m_pMutex->lock();
-	for(KviThreadPendingEvent * ev = m_pEventQueue->first(); ev; ev = m_pEventQueue->next())
+	for(KviThreadPendingEvent * ev = m_pOverflowQueue->first(); ev; ev = m_pOverflowQueue->next())
 	{
 		if(ev->o == receiver)
 			l.append(ev);
@@ -273,12 +411,59 @@ void KviThreadManager::killPendingEventsByReceiver(QObject * receiver)
 	for(KviThreadPendingEvent * ev = l.first(); ev; ev = l.next())
 	{
 		delete ev->e;
-		m_pEventQueue->removeRef(ev);
+		m_iPending.fetch_sub(1, std::memory_order_relaxed);
+		m_pOverflowQueue->removeRef(ev);
 	}
 	m_pMutex->unlock();
 #endif
 }
 
+void KviThreadManager::statistics(KviThreadEventStatistics * pStats, bool bReset)
+{
+	pStats->uPosted = 0;
+	pStats->uDelivered = 0;
+	pStats->uOverflowed = 0;
+	pStats->uThrottled = 0;
+	pStats->uBatches = 0;
+	pStats->uPending = 0;
+	pStats->uMaxPending = 0;
+	pStats->iAverageLatency = 0;
+	pStats->iMaxLatency = 0;
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	KviThreadManager * m = g_pThreadManager;
+	if(!m)
+		return;
+
+	pStats->uPosted = m->m_uPosted.load(std::memory_order_relaxed);
+	pStats->uDelivered = m->m_uDelivered;
+	pStats->uOverflowed = m->m_uOverflowed.load(std::memory_order_relaxed);
+	pStats->uThrottled = m->m_uThrottled.load(std::memory_order_relaxed);
+	pStats->uBatches = m->m_uBatches;
+	int iPending = m->m_iPending.load(std::memory_order_relaxed);
+	pStats->uPending = iPending > 0 ? iPending : 0;
+	int iMaxPending = m->m_iMaxPending.load(std::memory_order_relaxed);
+	pStats->uMaxPending = iMaxPending > 0 ? iMaxPending : 0;
+	if(m->m_uDelivered > 0)
+		pStats->iAverageLatency = m->m_iTotalLatency / (qint64)m->m_uDelivered;
+	pStats->iMaxLatency = m->m_iMaxLatency;
+
+	if(bReset)
+	{
+		m->m_uPosted.store(0, std::memory_order_relaxed);
+		m->m_uOverflowed.store(0, std::memory_order_relaxed);
+		m->m_uThrottled.store(0, std::memory_order_relaxed);
+		m->m_iMaxPending.store(iPending, std::memory_order_relaxed);
+		m->m_uDelivered = 0;
+		m->m_uBatches = 0;
+		m->m_iTotalLatency = 0;
+		m->m_iMaxLatency = 0;
+	}
+#else
+	Q_UNUSED(bReset);
+#endif
+}
+
 void KviThreadManager::registerSlaveThread(KviThread * t)
 {
 	m_pMutex->lock();
@@ -293,118 +478,197 @@ void KviThreadManager::unregisterSlaveThread(KviThread * t)
 	m_pMutex->unlock();
 }
 
-void KviThreadManager::postSlaveEvent(QObject * o, QEvent * e)
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+bool KviThreadManager::ringPush(const KviThreadPendingEvent & ev)
 {
-#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
-	QApplication::postEvent(o, e); // we believe this to be thread-safe
+	// Bounded MPSC ring: each slot carries a sequence number that tells
+	// whether it is free for the position being enqueued (== pos), already
+	// filled (== pos + 1) or still in use by the previous lap (< pos)
+	unsigned int uPos = m_uEnqueuePos.load(std::memory_order_relaxed);
+	for(;;)
+	{
+		RingSlot * s = &(m_pRing[uPos & KVI_THREAD_EVENT_RING_MASK]);
+		int iDiff = (int)(s->uSequence.load(std::memory_order_acquire) - uPos);
+		if(iDiff == 0)
+		{
+			// on failure uPos is reloaded
+			if(m_uEnqueuePos.compare_exchange_weak(uPos, uPos + 1, std::memory_order_relaxed))
+			{
+				s->ev = ev;
+				s->uSequence.store(uPos + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if(iDiff < 0)
+		{
+			return false; // full
+		}
+		else
+		{
+			// another slave took this position
+			uPos = m_uEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void KviThreadManager::wakeUpMaster()
+{
+	// Write to the fd... but only if there is no other wakeup pending
+	if(m_bWakeupPending.exchange(true, std::memory_order_acq_rel))
+		return;
+
+#ifdef Q_OS_LINUX
+	quint64 uOne = 1;
+	ssize_t written = write(m_fd[KVI_THREAD_PIPE_SIDE_SLAVE], &uOne, sizeof(uOne));
 #else
-	KviThreadPendingEvent * ev = new KviThreadPendingEvent;
-	ev->o = o;
-	ev->e = e;
+	ssize_t written = write(m_fd[KVI_THREAD_PIPE_SIDE_SLAVE], "?", 1);
+#endif
+	if(written < 1)
+	{
+		// ops.. failed to write down the trigger..
+		// this is quite irritating now...
+		qDebug("Oops! Failed to write down the trigger");
+		m_bWakeupPending.store(false, std::memory_order_release);
+	}
+}
 
-	m_pMutex->lock();
+void KviThreadManager::collectPendingEvents(bool bWaitForSlaves)
+{
+	unsigned int uEnd = m_uEnqueuePos.load(std::memory_order_acquire);
 
-	// if the queue gets too long, make this (slave) thread sleep
-
-	// there is a special case where we can't stop the slaves posting events
-	// it's when a thread-master-side is waiting for it's thread-slave-side
-	// it the thread-master-side runs in the application main thread then
-	// the main thread is sleeping and can't process events.
-	// Since we can't be really sure that the thread-master-side will be running
-	// on the main application thread we also can't artificially process the events.
-	// So the solution is to skip this algorithm when at least one
-	// thread is in waiting state.
-	while((m_pEventQueue->count() > KVI_THREAD_MAX_EVENT_QUEUE_LENGTH) && (m_iWaitingThreads < 1))
+	for(;;)
 	{
-		// wait for the master to process the queue
+		RingSlot * s = &(m_pRing[m_uDequeuePos & KVI_THREAD_EVENT_RING_MASK]);
+		if(s->uSequence.load(std::memory_order_acquire) != (m_uDequeuePos + 1))
+		{
+			// empty, or a slave is filling the slot right now
+			if(!bWaitForSlaves || ((int)(uEnd - m_uDequeuePos) <= 0))
+				break;
+			std::this_thread::yield(); // the slave is just a couple of instructions away
+			continue;
+		}
+		m_Batch.push_back(s->ev);
+		s->uSequence.store(m_uDequeuePos + KVI_THREAD_EVENT_RING_SIZE, std::memory_order_release);
+		m_uDequeuePos++;
+	}
 
-		m_pMutex->unlock();
+	// The overflowed events were posted after the ones in the ring:
+	// take them only once the ring is really empty. If it isn't,
+	// the slave filling the ring will wake us up again.
+	if(!m_bOverflow.load(std::memory_order_acquire))
+		return;
+	if(m_uDequeuePos != m_uEnqueuePos.load(std::memory_order_acquire))
+		return;
 
-// WARNING : This will fail if for some reason
-// the master thread gets here! It will wait indefinitely for itself
-// if(pthread_self() != m_hMasterThread) ... ????
+	m_pMutex->lock();
+	while(KviThreadPendingEvent * ev = m_pOverflowQueue->first())
+	{
+		m_Batch.push_back(*ev);
+		m_pOverflowQueue->removeFirst();
+	}
+	m_bOverflow.store(false, std::memory_order_release);
+	m_pMutex->unlock();
+}
+#endif
 
+void KviThreadManager::postSlaveEvent(QObject * o, QEvent * e)
+{
 #if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
-		::Sleep(1); // 1ms
+	QApplication::postEvent(o, e); // we believe this to be thread-safe
 #else
-		// FIXME : use nanosleep() ?
-		::usleep(1000); // 1 ms
-#endif
-		m_pMutex->lock();
+	KviThreadPendingEvent ev;
+	ev.o = o;
+	ev.e = e;
+	ev.iPostTime = m_timer.nsecsElapsed() / 1000;
+
+	m_uPosted.fetch_add(1, std::memory_order_relaxed);
+	int iPending = m_iPending.fetch_add(1, std::memory_order_relaxed) + 1;
+	int iMaxPending = m_iMaxPending.load(std::memory_order_relaxed);
+	while((iPending > iMaxPending) && !m_iMaxPending.compare_exchange_weak(iMaxPending, iPending, std::memory_order_relaxed))
+	{
 	}
 
-	m_pEventQueue->append(ev);
-	// Write bulk to the pipe... but only if there is no other wakeup pending
-	if(m_iTriggerCount < 1)
+	for(;;)
 	{
-		// I don't know if writing to a pipe is reentrant
-		// thus, in doubt, the write is interlocked (it's non blocking anyway)
-		int written = write(m_fd[KVI_THREAD_PIPE_SIDE_SLAVE], "?", 1);
-		if(written < 1)
-		{
-			// ops.. failed to write down the event..
-			// this is quite irritating now...
-			qDebug("Oops! Failed to write down the trigger");
-			// FIXME: maybe a single shot timer ?
-		}
-		else
+		// the fast path: no locking at all
+		if(!m_bOverflow.load(std::memory_order_acquire) && ringPush(ev))
+			break;
+
+		// if the queue gets too long, make this (slave) thread sleep
+
+		// there is a special case where we can't stop the slaves posting events
+		// it's when a thread-master-side is waiting for it's thread-slave-side
+		// it the thread-master-side runs in the application main thread then
+		// the main thread is sleeping and can't process events.
+		// Since we can't be really sure that the thread-master-side will be running
+		// on the main application thread we also can't artificially process the events.
+		// So the solution is to skip this algorithm when at least one
+		// thread is in waiting state: the event goes to the (unbounded) overflow queue.
+		// Once the overflow queue is in use, all the events go there until
+		// the master collects it, so the events of each slave are kept in order.
+		m_pMutex->lock();
+		if(m_bOverflow.load(std::memory_order_relaxed) || (m_iWaitingThreads > 0))
 		{
-			m_iTriggerCount++;
+			m_pOverflowQueue->append(new KviThreadPendingEvent(ev));
+			m_bOverflow.store(true, std::memory_order_release);
+			m_pMutex->unlock();
+			m_uOverflowed.fetch_add(1, std::memory_order_relaxed);
+			break;
 		}
-	} // else no need to trigger : there is a wakeup pending in there
+		m_pMutex->unlock();
 
-	m_pMutex->unlock();
+		// wait for the master to process the queue
+
+		// WARNING : This will fail if for some reason
+		// the master thread gets here! It will wait indefinitely for itself
+		m_uThrottled.fetch_add(1, std::memory_order_relaxed);
+		wakeUpMaster();
+		// FIXME : use nanosleep() ?
+		::usleep(1000); // 1 ms
+	}
 
+	wakeUpMaster();
 #endif
 }
 
 void KviThreadManager::eventsPending(int fd)
 {
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
-	char buf[10];
-	// do we need to check for errors here ?
-	int readed = read(fd, buf, 10);
+	char buf[16];
+	// the eventfd counter (or the pipe bytes): the value doesn't matter
+	if(read(fd, buf, sizeof(buf)) < 0)
+	{
+		if(errno != EAGAIN)
+			qDebug("Oops! Failed to read the trigger");
+	}
 
-	m_pMutex->lock();
-	// welcome to the critical section :)
+	// from now on the slaves must wake us up again
+	m_bWakeupPending.exchange(false, std::memory_order_acq_rel);
+
+	m_uBatches++;
+	collectPendingEvents(false);
 
-	// grab the first event in the queue
-	while(KviThreadPendingEvent * ev = m_pEventQueue->first())
+	// Hand the whole batch to Qt. The events are posted, not sent: if a
+	// receiver is destroyed by an earlier event, Qt drops the ones left for it.
+	while(m_uBatchPos < m_Batch.size())
 	{
-		// allow the other threads to post events:
-		// unlock the event queue
-		m_pMutex->unlock();
-		// let the app process the event
-		// DANGER !
-		QApplication::postEvent(ev->o, ev->e);
+		KviThreadPendingEvent ev = m_Batch[m_uBatchPos++];
+		if(!ev.e)
+			continue; // killed by killPendingEvents()
 
-		// jump out of the loop if we have been destroyed
-		if(!g_pThreadManager)
-			return;
-		// ufff... we're still alive :)))
+		m_iPending.fetch_sub(1, std::memory_order_relaxed);
+		qint64 iLatency = (m_timer.nsecsElapsed() / 1000) - ev.iPostTime;
+		m_iTotalLatency += iLatency;
+		if(iLatency > m_iMaxLatency)
+			m_iMaxLatency = iLatency;
+		m_uDelivered++;
 
-		// regrab the event queue
-		m_pMutex->lock();
-		// remove the event we have just processed
-		m_pEventQueue->removeRef(ev);
-		// here we're looping locked and havn't decremended the trigger count
-	}
-	// decrement the trigger count on the line: still atomic
-	if(readed >= 0)
-	{
-		if(readed < m_iTriggerCount)
-		{
-			m_iTriggerCount -= readed;
-		}
-		else
-		{
-			m_iTriggerCount = 0;
-		}
+		// let the app process the event
+		QApplication::postEvent(ev.o, ev.e);
 	}
 
-	// ok, job done.. can relax now
-	m_pMutex->unlock();
-
+	m_Batch.clear();
+	m_uBatchPos = 0;
 #endif
 }
 
@@ -30,6 +30,10 @@
 
 #include <QObject>
 #include <QEvent>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <vector>
 
 class QSocketNotifier;
 
@@ -284,6 +288,12 @@ public:
 	    : QEvent((QEvent::Type)KVI_THREAD_EVENT), m_eventId(evId), m_pSender(sender){};
 	virtual ~KviThreadEvent(){};
 
+public:
+	// The events are allocated from per-size pools (thus one per event type)
+	// and recycled: a busy thread doesn't hit the heap for each event
+	static void * operator new(size_t uSize);
+	static void operator delete(void * pData, size_t uSize);
+
 public:
 	// This is the sender of the event
 	// WARNING : this MAY be null, threads CAN send anonymous events
@@ -364,8 +374,23 @@ typedef struct _KviThreadPendingEvent
 {
 	QObject * o;
 	QEvent * e;
+	qint64 iPostTime; // usecs, for the latency statistics
 } KviThreadPendingEvent;
 
+// The slave -> master event delivery counters
+struct KviThreadEventStatistics
+{
+	quint64 uPosted;          // events posted by the slave threads
+	quint64 uDelivered;       // events posted to the Qt event queue of their receivers
+	quint64 uOverflowed;      // events that didn't fit in the queue (a thread was waiting)
+	quint64 uThrottled;       // times a slave thread had to wait for the queue to drain
+	quint64 uBatches;         // wakeups of the master thread
+	unsigned int uPending;    // events waiting for delivery now
+	unsigned int uMaxPending; // the highest number of events waiting for delivery
+	qint64 iAverageLatency;   // usecs between the post and the delivery to Qt
+	qint64 iMaxLatency;       // usecs
+};
+
 class KVILIB_API KviThreadManager : public QObject
 {
 	friend class KviApplication;
@@ -378,19 +403,48 @@ protected:
 	~KviThreadManager();
 
 public:
+	// master side only
 	static void killPendingEvents(QObject * receiver);
+	// master side only: if bReset is true the counters are zeroed after being read
+	static void statistics(KviThreadEventStatistics * pStats, bool bReset = false);
 
 private:
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	// A slot of the slave -> master ring (bounded lock-free MPSC queue)
+	struct RingSlot
+	{
+		std::atomic<unsigned int> uSequence;
+		KviThreadPendingEvent ev;
+	};
+
 	QSocketNotifier * m_pSn;
 #endif
 	KviMutex * m_pMutex; // This class performs only atomic operations
 	KviPointerList<KviThread> * m_pThreadList;
 	int m_iWaitingThreads;
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
-	KviPointerList<KviThreadPendingEvent> * m_pEventQueue;
-	int m_fd[2];
-	int m_iTriggerCount;
+	RingSlot * m_pRing;
+	std::atomic<unsigned int> m_uEnqueuePos;
+	unsigned int m_uDequeuePos; // master side only
+	// used when the ring is full but the slaves can't be stopped (see postSlaveEvent()), locked by m_pMutex
+	KviPointerList<KviThreadPendingEvent> * m_pOverflowQueue;
+	std::atomic<bool> m_bOverflow;
+	// the events taken from the queues and not posted to Qt yet, master side only
+	std::vector<KviThreadPendingEvent> m_Batch;
+	size_t m_uBatchPos;
+	int m_fd[2]; // both are the same eventfd where available
+	std::atomic<bool> m_bWakeupPending;
+	QElapsedTimer m_timer;
+	// statistics
+	std::atomic<quint64> m_uPosted;
+	std::atomic<quint64> m_uOverflowed;
+	std::atomic<quint64> m_uThrottled;
+	std::atomic<int> m_iPending;
+	std::atomic<int> m_iMaxPending;
+	quint64 m_uDelivered; // master side only, like the ones below
+	quint64 m_uBatches;
+	qint64 m_iTotalLatency;
+	qint64 m_iMaxLatency;
 #endif
 protected:
 	// Public to KviThread only
@@ -402,6 +456,13 @@ protected:
 
 	void postSlaveEvent(QObject * o, QEvent * e);
 	void killPendingEventsByReceiver(QObject * receiver);
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	bool ringPush(const KviThreadPendingEvent & ev);
+	void wakeUpMaster();
+	// master side: moves the queued events to m_Batch, if bWaitForSlaves is true
+	// the events being posted right now are waited for too
+	void collectPendingEvents(bool bWaitForSlaves);
+#endif
 	// Public to KviApplication only
 	static void globalInit();
 	static void globalDestroy();
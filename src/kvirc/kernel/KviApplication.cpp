@@ -49,6 +49,7 @@
 #include "KviWindowListBase.h"
 #include "kvi_defaults.h"
 #include "KviLocale.h"
+#include "KviLogWriter.h"
 #include "kvi_out.h"
 #include "KviNickServRuleSet.h"
 #include "KviIdentityProfileSet.h"
@@ -103,6 +104,7 @@
 #include "KviSSL.h"
 #endif
 
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QSplitter>
 #include <QClipboard>
@@ -199,6 +201,35 @@ KVIRC_API KviCryptEngineManager * g_pCryptEngineManager = nullptr;
 
 #include <QStyleFactory>
 
+// The configuration files parsed in the background during the startup
+static const char * g_pcPreloadedConfigFiles[] = {
+	KVI_CONFIGFILE_MAIN,
+	KVI_CONFIGFILE_USERACTIONS,
+	KVI_CONFIGFILE_IDENTITIES,
+	KVI_CONFIGFILE_SERVERDB,
+	KVI_CONFIGFILE_PROXYDB,
+	KVI_CONFIGFILE_EVENTS,
+	KVI_CONFIGFILE_RAWEVENTS,
+	KVI_CONFIGFILE_POPUPS,
+	KVI_CONFIGFILE_CUSTOMTOOLBARS,
+	KVI_CONFIGFILE_ALIASES,
+	KVI_CONFIGFILE_SCRIPTADDONS,
+	KVI_CONFIGFILE_TEXTICONS,
+	KVI_CONFIGFILE_REGUSERDB,
+	KVI_CONFIGFILE_REGCHANDB,
+	KVI_CONFIGFILE_NICKSERVDATABASE,
+	KVI_CONFIGFILE_PROFILESDATABASE,
+	KVI_CONFIGFILE_INPUTHISTORY,
+	KVI_CONFIGFILE_DEFAULTSCRIPT,
+	nullptr
+};
+
+static void kvi_startupPhaseDone(bool bTiming, QElapsedTimer & t, const char * pcPhase)
+{
+	if(bTiming)
+		qDebug("Startup: %-36s %6lld msecs", pcPhase, (long long)t.restart());
+}
+
 KviApplication::KviApplication(int & argc, char ** argv)
     : KviTalApplication(argc, argv)
 {
@@ -211,6 +242,7 @@ KviApplication::KviApplication(int & argc, char ** argv)
 	g_pApp = this;
 	m_szConfigFile = QString();
 	m_bCreateConfig = false;
+	m_bStartupTiming = false;
 	m_bUpdateGuiPending = false;
 	m_pRecentChannelDict = nullptr;
 #ifndef COMPILE_NO_IPC
@@ -245,6 +277,11 @@ void KviApplication::setup()
 	// on each other and we must activate them in the right order.
 	// Don't move stuff around unless you really know what you're doing.
 
+	QElapsedTimer totalTimer;
+	totalTimer.start();
+	QElapsedTimer phaseTimer;
+	phaseTimer.start();
+
 	// Initialize the random number generator
 	::srand(::time(nullptr));
 
@@ -305,6 +342,27 @@ void KviApplication::setup()
 
 	QString szTmp;
 
+	// The binary snapshots of the configuration files that live in read-only
+	// directories (the global defaults) are kept in the local temporary directory
+	getLocalKvircDirectory(szTmp, Tmp);
+	KviConfigurationFile::setSnapshotFallbackDirectory(szTmp);
+
+	// The configuration files don't depend on each other: parse them in the
+	// background while the core is initialized. The load() calls below take
+	// the parsed data (or wait for it) instead of reading the files again.
+	QStringList lPreload;
+	for(int i = 0; g_pcPreloadedConfigFiles[i]; i++)
+	{
+		if(getReadOnlyConfigPath(szTmp, g_pcPreloadedConfigFiles[i]))
+			lPreload.append(szTmp);
+	}
+	getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_WINPROPERTIES);
+	if(KviFileUtils::fileExists(szTmp))
+		lPreload.append(szTmp);
+	KviConfigurationFile::preload(lPreload);
+
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "directories and locale");
+
 	// Initialize the scripting engine
 	KviKvs::init();
 
@@ -327,6 +385,8 @@ void KviApplication::setup()
 
 	KviAnimatedPixmapCache::init();
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "scripting engine, actions, identities");
+
 	// Load the remaining configuration
 	// Note that loadOptions() assumes that the current progress is 12 and
 	// will bump it up to 45 in small steps
@@ -346,6 +406,8 @@ void KviApplication::setup()
 	getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_WINPROPERTIES);
 	g_pWinPropertiesConfig = new KviConfigurationFile(szTmp, KviConfigurationFile::ReadWrite);
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "options");
+
 	// Load the server database
 	g_pServerDataBase = new KviIrcServerDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SERVERDB))
@@ -356,6 +418,8 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_PROXYDB))
 		g_pProxyDataBase->load(szTmp);
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "server and proxy databases");
+
 	// Event manager
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_EVENTS))
 		KviKvs::loadAppEvents(szTmp);
@@ -380,6 +444,8 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SCRIPTADDONS))
 		KviKvs::loadScriptAddons(szTmp);
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "events, popups, toolbars, aliases");
+
 	g_pTextIconManager = new KviTextIconManager();
 	g_pTextIconManager->load();
 
@@ -388,13 +454,15 @@ void KviApplication::setup()
 	//g_pBookmarkList = new QStringList();
 	loadRecentEntries();
 
-	// media manager
+	// media manager: not needed until the first file transfer
 	g_pMediaManager = new KviMediaManager();
 	g_pMediaManager->lock();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_MEDIATYPES))
-		g_pMediaManager->load(szTmp);
+		g_pMediaManager->loadOnDemand(szTmp);
 	g_pMediaManager->unlock();
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "text icons, recent entries");
+
 	// registered user data base
 	g_pRegisteredUserDataBase = new KviRegisteredUserDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_REGUSERDB))
@@ -405,10 +473,10 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_REGCHANDB))
 		g_pRegisteredChannelDataBase->load(szTmp);
 
-	// file trader
+	// file trader: not needed until the first file request
 	g_pSharedFilesManager = new KviSharedFilesManager();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SHAREDFILES))
-		g_pSharedFilesManager->load(szTmp);
+		g_pSharedFilesManager->loadOnDemand(szTmp);
 
 	// nick serv data base
 	g_pNickServRuleSet = new KviNickServRuleSet();
@@ -420,9 +488,10 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_PROFILESDATABASE))
 		KviIdentityProfileSet::instance()->load(szTmp);
 
+	// not needed until the first user is seen
 	KviAvatarCache::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_AVATARCACHE))
-		KviAvatarCache::instance()->load(szTmp);
+		KviAvatarCache::instance()->loadOnDemand(szTmp);
 
 	KviInputHistory::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_INPUTHISTORY))
@@ -434,6 +503,11 @@ void KviApplication::setup()
 	else
 		KviDefaultScriptManager::instance()->loadEmptyConfig();
 
+	// everything has been loaded: stop the preloading threads
+	KviConfigurationFile::discardPreloaded();
+
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "user, channel and profile databases");
+
 // Eventually initialize the crypt engine manager
 #ifdef COMPILE_CRYPT_SUPPORT
 	g_pCryptEngineManager = new KviCryptEngineManager();
@@ -459,9 +533,13 @@ void KviApplication::setup()
 		setStyleSheet(szStyleData);
 	}
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "crypt engines, popups, parser");
+
 	// create the frame window, we're almost up and running...
 	createFrame();
 
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "main window");
+
 	// ok, we also have an UI now
 
 	// check if this is the first time this version of KVIrc runs...
@@ -487,6 +565,9 @@ void KviApplication::setup()
 
 	// start our heartbeat now
 	m_iHeartbeatTimerId = startTimer(1000);
+
+	kvi_startupPhaseDone(m_bStartupTiming, phaseTimer, "first run checks");
+	kvi_startupPhaseDone(m_bStartupTiming, totalTimer, "total");
 }
 
 void KviApplication::frameDestructorCallback()
@@ -536,6 +617,9 @@ KviApplication::~KviApplication()
 	// No more external modules exist: all that happens from now is generated
 	// from inside the kvirc core.
 
+	// All the windows are gone: write out and close the remaining logs
+	KviLogWriter::cleanup();
+
 	// We should have almost no UI here: only certain dialogs or popup windows may
 	// still exist: they should be harmless tough.
 	saveOptions();
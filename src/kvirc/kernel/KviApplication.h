@@ -148,6 +148,7 @@ public:
 	// setup stuff (accessed from KviMain.cpp: consider private otherwise)
 	QString m_szConfigFile; // setup
 	bool m_bCreateConfig;   // setup
+	bool m_bStartupTiming;  // setup: print the time spent in each phase
 	QString m_szExecAfterStartup;
 
 protected:
@@ -0,0 +1,206 @@
+//=============================================================================
+//
+//   File : KviHighlightMatcher.cpp
+//   Creation date : Sun Oct 18 2026 21:12:37 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviHighlightMatcher.h"
+#include "KviOptions.h"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+// Bumped when the highlighting options change: the matchers built
+// with an older generation are rebuilt on their next use
+static unsigned int g_uHighlightOptionsGeneration = 1;
+
+KviHighlightMatcher::KviHighlightMatcher()
+{
+	m_bCaseSensitive = false;
+	m_bWholeWords = false;
+	m_uOptionsGeneration = 0; // not built yet
+	for(auto & b : m_bSplitterAscii)
+		b = false;
+}
+
+KviHighlightMatcher::~KviHighlightMatcher()
+    = default;
+
+void KviHighlightMatcher::invalidate()
+{
+	g_uHighlightOptionsGeneration++;
+}
+
+int KviHighlightMatcher::edge(int iNode, ushort c) const
+{
+	const std::vector<std::pair<ushort, int>> & e = m_Nodes[iNode].edges;
+	auto it = std::lower_bound(e.begin(), e.end(), std::make_pair(c, INT_MIN));
+	if((it == e.end()) || (it->first != c))
+		return -1;
+	return it->second;
+}
+
+bool KviHighlightMatcher::isSplitter(const QChar & c) const
+{
+	if(c.unicode() < 128)
+		return m_bSplitterAscii[c.unicode()];
+	return c.isSpace() || m_szSplitters.contains(c);
+}
+
+void KviHighlightMatcher::addPattern(const QString & szPattern, int iIndex)
+{
+	QString szKey = m_bCaseSensitive ? szPattern : szPattern.toCaseFolded();
+	const ushort * p = szKey.utf16();
+	int iLen = szKey.length();
+
+	int iNode = 0;
+	for(int i = 0; i < iLen; i++)
+	{
+		int iNext = edge(iNode, p[i]);
+		if(iNext < 0)
+		{
+			iNext = m_Nodes.size();
+			m_Nodes.push_back({ {}, 0, -1, -1, i + 1 });
+			std::vector<std::pair<ushort, int>> & e = m_Nodes[iNode].edges;
+			e.insert(std::lower_bound(e.begin(), e.end(), std::make_pair(p[i], INT_MIN)), std::make_pair(p[i], iNext));
+		}
+		iNode = iNext;
+	}
+
+	// a duplicate keeps the priority of the first occurrence
+	if(m_Nodes[iNode].iPattern < 0)
+		m_Nodes[iNode].iPattern = iIndex;
+}
+
+void KviHighlightMatcher::build(const QString & szNick)
+{
+	m_szNick = szNick;
+	m_uOptionsGeneration = g_uHighlightOptionsGeneration;
+
+	m_bCaseSensitive = KVI_OPTION_BOOL(KviOption_boolCaseSensitiveHighlighting);
+	m_bWholeWords = !KVI_OPTION_BOOL(KviOption_boolUseFullWordHighlighting);
+	m_szSplitters = KVI_OPTION_STRING(KviOption_stringWordSplitters);
+	for(int i = 0; i < 128; i++)
+		m_bSplitterAscii[i] = QChar(i).isSpace() || m_szSplitters.contains(QChar(i));
+
+	m_Patterns.clear();
+	m_Nodes.clear();
+	m_Nodes.push_back({ {}, 0, -1, -1, 0 });
+
+	if(!szNick.isEmpty())
+		m_Patterns.append(szNick);
+
+	if(KVI_OPTION_BOOL(KviOption_boolUseWordHighlighting))
+	{
+		for(auto & it : KVI_OPTION_STRINGLIST(KviOption_stringlistHighlightWords))
+		{
+			if(!it.isEmpty())
+				m_Patterns.append(it);
+		}
+	}
+
+	for(int i = 0; i < m_Patterns.count(); i++)
+		addPattern(m_Patterns.at(i), i);
+
+	// Compute the failure links breadth first: the fail node of a node is
+	// always shallower, so it is complete when the node is reached
+	std::queue<int> q;
+	for(auto & e : m_Nodes[0].edges)
+		q.push(e.second); // the root children fail to the root
+
+	while(!q.empty())
+	{
+		int iNode = q.front();
+		q.pop();
+
+		int iFail = m_Nodes[iNode].iFail;
+		m_Nodes[iNode].iOutput = (m_Nodes[iFail].iPattern >= 0) ? iFail : m_Nodes[iFail].iOutput;
+
+		for(auto & e : m_Nodes[iNode].edges)
+		{
+			int f = iFail;
+			int iTarget = edge(f, e.first);
+			while((iTarget < 0) && (f != 0))
+			{
+				f = m_Nodes[f].iFail;
+				iTarget = edge(f, e.first);
+			}
+			m_Nodes[e.second].iFail = (iTarget >= 0) ? iTarget : 0;
+			q.push(e.second);
+		}
+	}
+}
+
+bool KviHighlightMatcher::match(const QString & szNick, const QString & szText, QString & szWord)
+{
+	if((m_uOptionsGeneration != g_uHighlightOptionsGeneration) || (m_szNick != szNick))
+		build(szNick);
+
+	if(m_Patterns.isEmpty())
+		return false;
+
+	QString szKey = m_bCaseSensitive ? szText : szText.toCaseFolded(); // toCaseFolded() preserves the positions
+	const ushort * p = szKey.utf16();
+	const QChar * pText = szText.unicode();
+	int iLen = szKey.length();
+
+	int iBest = INT_MAX;
+	int iNode = 0;
+
+	for(int i = 0; i < iLen; i++)
+	{
+		int iNext;
+		while(((iNext = edge(iNode, p[i])) < 0) && (iNode != 0))
+			iNode = m_Nodes[iNode].iFail;
+		iNode = (iNext >= 0) ? iNext : 0;
+
+		// all the patterns that end at this position
+		for(int n = (m_Nodes[iNode].iPattern >= 0) ? iNode : m_Nodes[iNode].iOutput; n >= 0; n = m_Nodes[n].iOutput)
+		{
+			const Node & o = m_Nodes[n];
+			if(o.iPattern >= iBest)
+				continue;
+
+			if(m_bWholeWords)
+			{
+				int iStart = i - o.iDepth + 1;
+				if((iStart > 0) && !isSplitter(pText[iStart - 1]))
+					continue;
+				if((i + 1 < iLen) && !isSplitter(pText[i + 1]))
+					continue;
+			}
+
+			iBest = o.iPattern;
+			if(iBest == 0)
+				break; // can't do better than this
+		}
+
+		if(iBest == 0)
+			break;
+	}
+
+	if(iBest == INT_MAX)
+		return false;
+
+	szWord = m_Patterns.at(iBest);
+	return true;
+}
@@ -0,0 +1,106 @@
+#ifndef _KVI_HIGHLIGHTMATCHER_H_
+#define _KVI_HIGHLIGHTMATCHER_H_
+//=============================================================================
+//
+//   File : KviHighlightMatcher.h
+//   Creation date : Sun Oct 18 2026 21:12:37 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviHighlightMatcher.h
+* \author The KVIrc Development Team
+* \brief Precompiled matcher for the highlighted words and nickname
+*/
+
+#include "kvi_settings.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+/**
+* \class KviHighlightMatcher
+* \brief Finds the highlighted words (and the own nickname) inside a message
+*
+* All the words are compiled in a single Aho-Corasick automaton so a message
+* is scanned once, regardless of the number of words. The automaton is built
+* from the highlighting options and is rebuilt only when the options or the
+* nickname change: the options invalidate all the matchers via invalidate().
+*/
+class KVIRC_API KviHighlightMatcher
+{
+public:
+	/**
+	* \brief Constructs the matcher object
+	* \return KviHighlightMatcher
+	*/
+	KviHighlightMatcher();
+	~KviHighlightMatcher();
+
+private:
+	struct Node
+	{
+		std::vector<std::pair<ushort, int>> edges; // sorted by character
+		int iFail;                                 // the longest proper suffix that is in the trie
+		int iOutput;                               // the next node in the fail chain that ends a pattern, -1 if none
+		int iPattern;                              // the pattern (lowest index) that ends here, -1 if none
+		int iDepth;                                // length of the string spelled by this node
+	};
+
+	std::vector<Node> m_Nodes;         // m_Nodes[0] is the root
+	QStringList m_Patterns;            // the nickname (if any) and the words, in priority order
+	QString m_szNick;                  // the nickname the automaton was built for
+	QString m_szSplitters;             // the word splitters other than the whitespace
+	bool m_bSplitterAscii[128];        // splitter lookup table for the ASCII characters (whitespace included)
+	bool m_bCaseSensitive;
+	bool m_bWholeWords;                // the matches must be delimited by splitters
+	unsigned int m_uOptionsGeneration; // the options the automaton was built from
+
+public:
+	/**
+	* \brief Rebuilds all the matchers on their next use
+	*
+	* Called when the highlighting options change
+	* \return void
+	*/
+	static void invalidate();
+
+	/**
+	* \brief Finds the first highlighted word contained in the text
+	*
+	* The nickname has priority over the words, which have priority
+	* in the order they appear in the options.
+	* \param szNick The nickname to highlight, empty if the nickname should not be highlighted
+	* \param szText The text to search, already stripped of the control codes
+	* \param szWord Will contain the word that triggered the highlight
+	* \return bool
+	*/
+	bool match(const QString & szNick, const QString & szText, QString & szWord);
+
+private:
+	void build(const QString & szNick);
+	void addPattern(const QString & szPattern, int iIndex);
+	int edge(int iNode, ushort c) const;
+	bool isSplitter(const QChar & c) const;
+};
+
+#endif //_KVI_HIGHLIGHTMATCHER_H_
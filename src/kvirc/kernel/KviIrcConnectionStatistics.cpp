@@ -28,6 +28,9 @@ KviIrcConnectionStatistics::KviIrcConnectionStatistics()
 {
 	m_tConnectionStart = 0;
 	m_tLastMessage = 0;
+	m_uNamesBursts = 0;
+	m_uNamesUsers = 0;
+	m_llNamesTime = 0;
 }
 
 KviIrcConnectionStatistics::~KviIrcConnectionStatistics()
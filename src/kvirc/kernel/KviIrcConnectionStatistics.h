@@ -40,9 +40,21 @@ public:
 protected:
 	kvi_time_t m_tConnectionStart; // (valid only when Connected or LoggingIn)
 	kvi_time_t m_tLastMessage;     // last message received from server
+	unsigned int m_uNamesBursts;   // channel NAMES bursts processed
+	unsigned int m_uNamesUsers;    // users received in the NAMES bursts
+	long long m_llNamesTime;       // time spent building the user lists from the NAMES bursts (usecs)
 public:
 	kvi_time_t connectionStartTime() { return m_tConnectionStart; };
 	kvi_time_t lastMessageTime() { return m_tLastMessage; };
+	unsigned int namesBursts() { return m_uNamesBursts; };
+	unsigned int namesUsers() { return m_uNamesUsers; };
+	long long namesTime() { return m_llNamesTime; };
+	void addNamesTime(long long llUSecs) { m_llNamesTime += llUSecs; };
+	void namesBurstCompleted(unsigned int uUsers)
+	{
+		m_uNamesBursts++;
+		m_uNamesUsers += uUsers;
+	};
 protected:
 	void setLastMessageTime(kvi_time_t t) { m_tLastMessage = t; };
 	void setConnectionStartTime(kvi_time_t t) { m_tConnectionStart = t; };
@@ -46,6 +46,11 @@
 
 #include <QTimer>
 
+// initial size of the line framing buffer: grows only if a single read needs more
+#define KVI_IRCLINK_READ_BUFFER_SIZE 4096
+// 512 bytes for the message itself + 8191 bytes for the IRCv3 tags
+#define KVI_IRCLINK_MAX_PENDING_LINE_LEN 8703
+
 extern KVIRC_API KviIrcServerDataBase * g_pServerDataBase;
 extern KVIRC_API KviProxyDataBase * g_pProxyDataBase;
 
@@ -61,6 +66,7 @@ KviIrcLink::KviIrcLink(KviIrcConnection * pConnection)
 	m_pResolver = nullptr;
 
 	m_pReadBuffer = nullptr; // incoming data buffer
+	m_uReadBufferSize = 0;   // incoming data buffer allocated size
 	m_uReadBufferLen = 0;    // incoming data buffer length
 	m_uReadPackets = 0;      // total packets read per session
 
@@ -206,114 +212,111 @@ void KviIrcLink::resolverTerminated()
 // Incoming data processing
 //
 
-void KviIrcLink::processData(char * buffer, int iLen)
+char * KviIrcLink::readBufferSpace(unsigned int uMinFree, unsigned int * puFree)
 {
-	if(m_pLinkFilter)
+	// make sure that we have uMinFree bytes after the pending data
+	// plus one for the terminator
+	unsigned int uNeeded = m_uReadBufferLen + uMinFree + 1;
+	if(uNeeded > m_uReadBufferSize)
 	{
-		m_pLinkFilter->processData(buffer, iLen);
-		return;
+		unsigned int uNewSize = m_uReadBufferSize > 0 ? m_uReadBufferSize : KVI_IRCLINK_READ_BUFFER_SIZE;
+		while(uNewSize < uNeeded)
+			uNewSize *= 2;
+		m_pReadBuffer = (char *)KviMemory::reallocate(m_pReadBuffer, uNewSize);
+		m_uReadBufferSize = uNewSize;
 	}
 
-	char * p = buffer;
-	char * cBeginOfCurData = buffer;
-	int iBufLen = 0;
-	char * cMessageBuffer = (char *)KviMemory::allocate(1);
+	*puFree = m_uReadBufferSize - m_uReadBufferLen - 1;
+	return m_pReadBuffer + m_uReadBufferLen;
+}
 
-	while(*p)
-	{
-		if((*p == '\r') || (*p == '\n'))
-		{
-			//found a CR or LF...
-			//prepare a message buffer
-			iBufLen = p - cBeginOfCurData;
-			//check for previous unterminated data
-			if(m_uReadBufferLen > 0)
-			{
-				KVI_ASSERT(m_pReadBuffer);
-				cMessageBuffer = (char *)KviMemory::reallocate(cMessageBuffer, iBufLen + m_uReadBufferLen + 1);
-				KviMemory::move(cMessageBuffer, m_pReadBuffer, m_uReadBufferLen);
-				KviMemory::move((void *)(cMessageBuffer + m_uReadBufferLen), cBeginOfCurData, iBufLen);
-				*(cMessageBuffer + iBufLen + m_uReadBufferLen) = '\0';
-				m_uReadBufferLen = 0;
-				KviMemory::free(m_pReadBuffer);
-				m_pReadBuffer = nullptr;
-			}
-			else
-			{
-				KVI_ASSERT(!m_pReadBuffer);
-				cMessageBuffer = (char *)KviMemory::reallocate(cMessageBuffer, iBufLen + 1);
-				KviMemory::move(cMessageBuffer, cBeginOfCurData, iBufLen);
-				*(cMessageBuffer + iBufLen) = '\0';
-			}
-			m_uReadPackets++;
-
-			// FIXME: actually it can happen that the socket gets disconnected
-			// in an incomingMessage() call.
-			// The problem might be that some other parts of KVIrc assume
-			// that the IRC context still exists after a failed write to the socket
-			// (some parts don't even check the return value!)
-			// If the problem presents itself again then the solution is:
-			//   disable queue flushing for the "incomingMessage" call
-			//   and just call queue_insertMessage()
-			//   then after the call terminates flush the queue (eventually detecting
-			//   the disconnect and thus destroying the IRC context).
-			// For now we try to rely on the remaining parts to handle correctly
-			// such conditions. Let's see...
-			if(*cMessageBuffer != 0)
-				m_pConnection->incomingMessage(cMessageBuffer);
-
-			if(m_pSocket->state() != KviIrcSocket::Connected)
-			{
-				// Disconnected in KviConsoleWindow::incomingMessage() call.
-				// This may happen for several reasons (local event loop
-				// with the user hitting the disconnect button, a scripting
-				// handler event that disconnects explicitly)
-				//
-				// We handle it by simply returning control to readData() which
-				// will return immediately (and safely) control to Qt
-				KviMemory::free(cMessageBuffer);
-				return;
-			}
+void KviIrcLink::processData(unsigned int uLength)
+{
+	KVI_ASSERT(m_pReadBuffer);
+	KVI_ASSERT((m_uReadBufferLen + uLength) < m_uReadBufferSize);
 
-			while(*p && ((*p == '\r') || (*p == '\n')))
-				p++;
-			cBeginOfCurData = p;
-		}
-		else
-			p++;
+	char * pNewData = m_pReadBuffer + m_uReadBufferLen;
+	char * pEnd = pNewData + uLength;
+	*pEnd = '\0';
+
+	if(m_pLinkFilter)
+	{
+		// the link filter does its own framing: nothing is kept here
+		KVI_ASSERT(m_uReadBufferLen == 0);
+		m_pLinkFilter->processData(pNewData, uLength);
+		return;
 	}
 
-	//now *p == '\0'
-	//beginOfCurData points to '\0' if we have
-	//no more stuff to parse, or points to something
-	//different than '\r' or '\n'...
-	if(*cBeginOfCurData)
+	char * pBeginOfCurData = m_pReadBuffer;
+	// the pending data contains no line terminators: start from the new data
+	char * p = pNewData;
+
+	while(p < pEnd)
 	{
-		//Have remaining data...in the local buffer
-		iBufLen = p - cBeginOfCurData;
-		if(m_uReadBufferLen > 0)
+		if((*p != '\r') && (*p != '\n'))
 		{
-			//and there was more stuff saved... (really slow connection)
-			KVI_ASSERT(m_pReadBuffer);
-			m_pReadBuffer = (char *)KviMemory::reallocate(m_pReadBuffer, m_uReadBufferLen + iBufLen);
-			KviMemory::move((void *)(m_pReadBuffer + m_uReadBufferLen), cBeginOfCurData, iBufLen);
-			m_uReadBufferLen += iBufLen;
+			p++;
+			continue;
 		}
-		else
+
+		//found a CR or LF...
+		//terminate the message in place: no need to copy it anywhere
+		*p = '\0';
+		m_uReadPackets++;
+
+		// FIXME: actually it can happen that the socket gets disconnected
+		// in an incomingMessage() call.
+		// The problem might be that some other parts of KVIrc assume
+		// that the IRC context still exists after a failed write to the socket
+		// (some parts don't even check the return value!)
+		// If the problem presents itself again then the solution is:
+		//   disable queue flushing for the "incomingMessage" call
+		//   and just call queue_insertMessage()
+		//   then after the call terminates flush the queue (eventually detecting
+		//   the disconnect and thus destroying the IRC context).
+		// For now we try to rely on the remaining parts to handle correctly
+		// such conditions. Let's see...
+		if(*pBeginOfCurData != 0)
+			m_pConnection->incomingMessage(pBeginOfCurData);
+
+		if(m_pSocket->state() != KviIrcSocket::Connected)
 		{
+			// Disconnected in KviConsoleWindow::incomingMessage() call.
+			// This may happen for several reasons (local event loop
+			// with the user hitting the disconnect button, a scripting
+			// handler event that disconnects explicitly)
 			//
-			KVI_ASSERT(!m_pReadBuffer);
-			m_uReadBufferLen = iBufLen;
-			m_pReadBuffer = (char *)KviMemory::allocate(m_uReadBufferLen);
-			KviMemory::move(m_pReadBuffer, cBeginOfCurData, m_uReadBufferLen);
+			// We handle it by simply returning control to readData() which
+			// will return immediately (and safely) control to Qt
+			m_uReadBufferLen = 0;
+			return;
 		}
-		//The m_pReadBuffer contains at max 1 IRC message...
-		//that can not be longer than 510 bytes (the message is not CRLF terminated)
-		// FIXME: Is this limit *really* valid on all servers ?
-		if(m_uReadBufferLen > 510)
-			qDebug("WARNING: receiving an invalid IRC message from server.");
+
+		p++;
+		while((p < pEnd) && ((*p == '\r') || (*p == '\n')))
+			p++;
+		pBeginOfCurData = p;
 	}
-	KviMemory::free(cMessageBuffer);
+
+	//now p == pEnd
+	//pBeginOfCurData points to pEnd if we have
+	//no more stuff to parse, or points to the beginning
+	//of an unterminated message...
+	m_uReadBufferLen = pEnd - pBeginOfCurData;
+	if(m_uReadBufferLen == 0)
+		return;
+
+	//Have remaining data: move it to the head of the buffer
+	//so the next read will append to it
+	if(pBeginOfCurData != m_pReadBuffer)
+		KviMemory::move(m_pReadBuffer, pBeginOfCurData, m_uReadBufferLen);
+
+	//The m_pReadBuffer contains at max 1 IRC message...
+	//that can not be longer than 510 bytes (the message is not CRLF terminated)
+	//plus the IRCv3 message tags
+	// FIXME: Is this limit *really* valid on all servers ?
+	if(m_uReadBufferLen > KVI_IRCLINK_MAX_PENDING_LINE_LEN)
+		qDebug("WARNING: receiving an invalid IRC message from server.");
 }
 
 //
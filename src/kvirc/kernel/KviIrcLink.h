@@ -97,8 +97,12 @@ private:
 
 	State m_eState;
 
-	char * m_pReadBuffer;
-	unsigned int m_uReadBufferLen;
+	// The line framing buffer: KviIrcSocket reads directly into its tail
+	// and complete lines are NUL-terminated in place and passed up.
+	// Only an unterminated line is kept between reads (at the head).
+	char * m_pReadBuffer;            // owned, may be null!
+	unsigned int m_uReadBufferSize;  // allocated size
+	unsigned int m_uReadBufferLen;   // length of the pending partial line
 	unsigned int m_uReadPackets;
 
 	KviIrcConnectionTargetResolver * m_pResolver; // owned
@@ -132,6 +136,12 @@ public:
 	* \return State
 	*/
 	State state() { return m_eState; };
+
+	/**
+	* \brief Returns the number of lines received in this session
+	* \return unsigned int
+	*/
+	unsigned int readPackets() { return m_uReadPackets; };
 protected:
 	/**
 	* \brief Sends a data packet
@@ -177,17 +187,33 @@ protected:
 	void start();
 
 protected:
+	/**
+	* \brief Returns the space where the socket should read the incoming data
+	*
+	* The returned pointer points just past the pending partial line
+	* in the link read buffer. The buffer is grown if needed so that
+	* at least uMinFree bytes are available plus one byte for the
+	* null terminator. The actual number of writable bytes is stored in puFree.
+	* It's an interface for KviIrcSocket (lower protocol in stack)
+	* \param uMinFree The minimum number of bytes that must be writable
+	* \param puFree The number of writable bytes (excluding the terminator)
+	* \return char *
+	*/
+	char * readBufferSpace(unsigned int uMinFree, unsigned int * puFree);
+
 	/**
 	* \brief Process a packet of raw data from the server
 	*
-	* This is called by KviIrcSocket.
-	* The buffer is iLength+1 bytes long and contains a null terminator
+	* This is called by KviIrcSocket after it has read uLength bytes
+	* into the space returned by readBufferSpace().
+	* Complete lines are terminated in place and passed to the connection
+	* without being copied: only the trailing partial line is moved
+	* to the head of the buffer.
 	* It's an interface for KviIrcSocket (lower protocol in stack)
-	* \param buffer The buffer :)
-	* \param iLength The length of the buffer
+	* \param uLength The number of bytes read
 	* \return void
 	*/
-	void processData(char * buffer, int iLength);
+	void processData(unsigned int uLength);
 
 	/**
 	* \brief Called at each state change
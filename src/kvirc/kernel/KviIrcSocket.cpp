@@ -47,6 +47,8 @@
 #include <QTimer>
 #include <QSocketNotifier>
 
+#include <climits>
+
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
 #include <unistd.h> //for gettimeofday()
 #endif
@@ -55,6 +57,15 @@
 
 // FIXME: #warning "Lag-o-meter"
 
+// the minimum free space requested to the link for each read call
+#define KVI_IRCSOCKET_READ_CHUNK_SIZE 4096
+
+// the consecutive messages are written together up to this size (the maximum TLS record payload)
+#define KVI_IRCSOCKET_WRITE_BATCH_SIZE 16384
+
+// at most this many freed queue entries are kept for reuse
+#define KVI_IRCSOCKET_MAX_FREE_ENTRIES 64
+
 unsigned int g_uNextIrcLinkId = 1;
 
 KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
@@ -77,7 +88,9 @@ KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
 
 	m_pTimeoutTimer = nullptr; // timeout for connect()
 
-	m_uReadBytes = 0;   // total read bytes per session
+	m_uReadBytes = 0;         // total read bytes per session
+	m_uReadNotifications = 0; // total read notifier activations per session
+	m_uReadCalls = 0;         // total successful read calls per session
 	m_uSentBytes = 0;   // total sent bytes per session
 	m_uSentPackets = 0; // total packets sent per session
 
@@ -90,8 +103,15 @@ KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
 	m_pSSL = nullptr;
 #endif
 
-	m_tAntiFloodLastMessageTime.tv_sec = 0;
-	m_tAntiFloodLastMessageTime.tv_usec = 0;
+	m_antiFloodClock.start();
+	m_iAntiFloodPenaltyTime = 0;
+
+	m_writeBatch.reserve(KVI_IRCSOCKET_WRITE_BATCH_SIZE);
+	m_iWriteBatchOffset = 0;
+	m_uWriteBatchMessages = 0;
+
+	m_pFreeEntries = nullptr;
+	m_uFreeEntries = 0;
 
 	if(KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout) < 100)
 		KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout) = 100; // this is our minimum, we don't want to lag the app
@@ -105,6 +125,13 @@ KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
 KviIrcSocket::~KviIrcSocket()
 {
 	reset();
+
+	while(m_pFreeEntries)
+	{
+		KviIrcSocketMsgEntry * pEntry = m_pFreeEntries;
+		m_pFreeEntries = pEntry->next_ptr;
+		KviMemory::free(pEntry);
+	}
 }
 
 void KviIrcSocket::reset()
@@ -156,10 +183,11 @@ void KviIrcSocket::reset()
 	m_bInProcessData = false;
 
 	m_uReadBytes = 0;
+	m_uReadNotifications = 0;
+	m_uReadCalls = 0;
 	m_uSentBytes = 0;
 	m_uSentPackets = 0;
-	m_tAntiFloodLastMessageTime.tv_sec = 0;
-	m_tAntiFloodLastMessageTime.tv_usec = 0;
+	m_iAntiFloodPenaltyTime = 0;
 
 	m_bInProcessData = false;
 
@@ -168,6 +196,10 @@ void KviIrcSocket::reset()
 
 	queue_removeAllMessages();
 
+	m_writeBatch.resize(0);
+	m_iWriteBatchOffset = 0;
+	m_uWriteBatchMessages = 0;
+
 	setState(Idle);
 }
 
@@ -181,17 +213,11 @@ void KviIrcSocket::clearOutputQueue(bool bPrivateMessagesOnly)
 
 unsigned int KviIrcSocket::outputQueueSize()
 {
-	KviIrcSocketMsgEntry * pMsg = m_pSendQueueTail;
-	if(!pMsg)
-		return 0;
+	// the batch being written is still waiting to leave
+	unsigned int uCount = m_uWriteBatchMessages;
 
-	unsigned int uCount = 0;
-
-	do
-	{
+	for(KviIrcSocketMsgEntry * pMsg = m_pSendQueueHead; pMsg; pMsg = pMsg->next_ptr)
 		uCount++;
-		pMsg = pMsg->next_ptr;
-	} while(pMsg);
 
 	return uCount;
 }
@@ -1476,73 +1502,97 @@ void KviIrcSocket::linkUp()
 	m_pRsn->setEnabled(true);
 }
 
-void KviIrcSocket::readData(int)
+int KviIrcSocket::readRawData(char * pcBuffer, int iBufLen)
+{
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
+		return m_pSSL->read(pcBuffer, iBufLen);
+#endif
+	return kvi_socket_recv(m_sock, pcBuffer, iBufLen);
+}
+
+bool KviIrcSocket::readWouldBlock(int iReadLength)
 {
-	//read data
-	char cBuffer[1025];
-	int iReadLength;
 #ifdef COMPILE_SSL_SUPPORT
 	if(m_pSSL)
 	{
-		iReadLength = m_pSSL->read(cBuffer, 1024);
-		if(iReadLength <= 0)
+		switch(m_pSSL->getProtocolError(iReadLength))
 		{
-			// ssl error....?
-			switch(m_pSSL->getProtocolError(iReadLength))
-			{
-				case KviSSL::ZeroReturn:
-					iReadLength = 0;
-					break;
-				case KviSSL::WantRead:
-				case KviSSL::WantWrite:
-					// hmmm...
-					return;
-					break;
-				case KviSSL::SyscallError:
-				{
-					int iE = m_pSSL->getLastError(true);
-					if(iE != 0)
-					{
-						raiseSSLError();
-						raiseError(KviError::SSLError);
-						reset();
-						return;
-					}
-				}
+			case KviSSL::WantRead:
+			case KviSSL::WantWrite:
+				return true;
+				break;
+			default:
+				return false;
 				break;
-				case KviSSL::SSLError:
-					raiseSSLError();
-					raiseError(KviError::SSLError);
-					reset();
-					return;
-					break;
-				default:
-					raiseError(KviError::SSLError);
-					reset();
-					return;
-					break;
-			}
-			handleInvalidSocketRead(iReadLength);
-			return;
 		}
 	}
-	else
-	{
 #endif
-		iReadLength = kvi_socket_recv(m_sock, cBuffer, 1024);
+	if(iReadLength == 0)
+		return false;
+
+	int iErr = kvi_socket_error();
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+	return (iErr == EAGAIN) || (iErr == EINTR) || (iErr == WSAEWOULDBLOCK);
+#else
+	return (iErr == EAGAIN) || (iErr == EINTR);
+#endif
+}
+
+void KviIrcSocket::readData(int)
+{
+	m_uReadNotifications++;
+
+	unsigned int uBudget = KVI_OPTION_UINT(KviOption_uintIrcSocketReadBudget);
+	if(uBudget < KVI_IRCSOCKET_READ_CHUNK_SIZE)
+		uBudget = KVI_IRCSOCKET_READ_CHUNK_SIZE;
+	long long iStartTime = KviTimeUtils::getCurrentTimeMills();
+
+	//read data directly into the link line buffer
+	//draining the socket until it would block or we run out of budget
+	unsigned int uTotal = 0;
+	int iReadLength;
+	bool bReadFailed = false;
+
+	for(;;)
+	{
+		unsigned int uFree;
+		char * pcBuffer = m_pLink->readBufferSpace(uTotal + KVI_IRCSOCKET_READ_CHUNK_SIZE, &uFree);
+		uFree -= uTotal;
+
+		iReadLength = readRawData(pcBuffer + uTotal, uFree);
 		if(iReadLength <= 0)
 		{
-			handleInvalidSocketRead(iReadLength);
-			return;
+			if(uTotal == 0)
+			{
+				// nothing read at all: handle the error right now
+				handleInvalidRead(iReadLength);
+				return;
+			}
+			// We have data to process first. If this is not a transient
+			// condition we'll read again after processing and let
+			// handleInvalidRead() report the error.
+			bReadFailed = !readWouldBlock(iReadLength);
+			break;
 		}
-#ifdef COMPILE_SSL_SUPPORT
-	}
-#endif
 
-	//terminate our buffer
-	(*(cBuffer + iReadLength)) = '\0';
+		m_uReadCalls++;
+		uTotal += iReadLength;
 
-	m_uReadBytes += iReadLength;
+		if(uTotal >= uBudget)
+			break;
+		// a short read on a plain socket means that the kernel buffer is empty.
+		// SSL returns at most one record per call so we need to go on until WantRead.
+		if(!usingSSL() && ((unsigned int)iReadLength < uFree))
+			break;
+		if(KVI_OPTION_UINT(KviOption_uintIrcSocketReadTimeBudget) > 0)
+		{
+			if((KviTimeUtils::getCurrentTimeMills() - iStartTime) >= (long long)KVI_OPTION_UINT(KviOption_uintIrcSocketReadTimeBudget))
+				break;
+		}
+	}
+
+	m_uReadBytes += uTotal;
 
 	// Shut up the socket notifier
 	// in case that we enter in a local loop somewhere
@@ -1554,7 +1604,8 @@ void KviIrcSocket::readData(int)
 	// making it always an asynchronous event.
 	m_bInProcessData = true;
 
-	m_pLink->processData(cBuffer, iReadLength);
+	// dispatch all the complete lines of the batch at once
+	m_pLink->processData(uTotal);
 	// after this line there should be nothing that relies
 	// on the "connected" state of this socket.
 	// It may happen that it has been reset() in the middle of the processData() call
@@ -1568,6 +1619,56 @@ void KviIrcSocket::readData(int)
 	// and flush the queue too!
 	if(m_pSendQueueHead)
 		flushSendQueue();
+
+	// The last read failed: now that the data has been processed
+	// read again so the error (or the connection close) gets reported.
+	if(bReadFailed && (m_state == Connected))
+		readData(0);
+}
+
+void KviIrcSocket::handleInvalidRead(int iReadLength)
+{
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
+	{
+		// ssl error....?
+		switch(m_pSSL->getProtocolError(iReadLength))
+		{
+			case KviSSL::ZeroReturn:
+				iReadLength = 0;
+				break;
+			case KviSSL::WantRead:
+			case KviSSL::WantWrite:
+				// hmmm...
+				return;
+				break;
+			case KviSSL::SyscallError:
+			{
+				int iE = m_pSSL->getLastError(true);
+				if(iE != 0)
+				{
+					raiseSSLError();
+					raiseError(KviError::SSLError);
+					reset();
+					return;
+				}
+			}
+			break;
+			case KviSSL::SSLError:
+				raiseSSLError();
+				raiseError(KviError::SSLError);
+				reset();
+				return;
+				break;
+			default:
+				raiseError(KviError::SSLError);
+				reset();
+				return;
+				break;
+		}
+	}
+#endif
+	handleInvalidSocketRead(iReadLength);
 }
 
 void KviIrcSocket::abort()
@@ -1626,13 +1727,41 @@ void KviIrcSocket::queue_insertMessage(KviIrcSocketMsgEntry * pMsg)
 	}
 }
 
+KviIrcSocketMsgEntry * KviIrcSocket::alloc_msgEntry(KviDataBuffer * pData)
+{
+	KviIrcSocketMsgEntry * pEntry;
+	if(m_pFreeEntries)
+	{
+		pEntry = m_pFreeEntries;
+		m_pFreeEntries = pEntry->next_ptr;
+		m_uFreeEntries--;
+	}
+	else
+	{
+		pEntry = (KviIrcSocketMsgEntry *)KviMemory::allocate(sizeof(KviIrcSocketMsgEntry));
+	}
+	pEntry->pData = pData;
+	pEntry->next_ptr = nullptr;
+	return pEntry;
+}
+
 void KviIrcSocket::free_msgEntry(KviIrcSocketMsgEntry * e)
 {
 	if(e->pData)
 		delete e->pData;
 
 	e->pData = nullptr;
-	KviMemory::free(e);
+
+	if(m_uFreeEntries < KVI_IRCSOCKET_MAX_FREE_ENTRIES)
+	{
+		e->next_ptr = m_pFreeEntries;
+		m_pFreeEntries = e;
+		m_uFreeEntries++;
+	}
+	else
+	{
+		KviMemory::free(e);
+	}
 }
 
 bool KviIrcSocket::queue_removeMessage()
@@ -1640,12 +1769,9 @@ bool KviIrcSocket::queue_removeMessage()
 	KVI_ASSERT(m_pSendQueueTail);
 	KVI_ASSERT(m_pSendQueueHead);
 
-	if(m_pSendQueueHead->pData)
-		delete m_pSendQueueHead->pData;
-
 	KviIrcSocketMsgEntry * pEntry = m_pSendQueueHead;
 	m_pSendQueueHead = pEntry->next_ptr;
-	KviMemory::free((void *)pEntry);
+	free_msgEntry(pEntry);
 
 	if(m_pSendQueueHead == nullptr)
 	{
@@ -1679,7 +1805,7 @@ void KviIrcSocket::queue_removePrivateMessages()
 				{
 					pPrevEntry->next_ptr = pEntry->next_ptr;
 					if(!pPrevEntry->next_ptr)
-						m_pSendQueueTail = nullptr;
+						m_pSendQueueTail = pPrevEntry;
 					free_msgEntry(pEntry);
 					pEntry = pPrevEntry->next_ptr;
 				}
@@ -1699,6 +1825,59 @@ void KviIrcSocket::queue_removePrivateMessages()
 	}
 }
 
+unsigned int KviIrcSocket::antiFloodAllowance(int * piWaitMSecs)
+{
+	// This is the penalty scheme of the ircd: each message moves the penalty
+	// time forward by one interval and the messages can be sent as long as
+	// it is at most (burst - 1) intervals in the future. In other words a token
+	// bucket that holds burst messages and gets a new one every interval.
+	qint64 iInterval = KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds);
+	if(iInterval < 1)
+		return UINT_MAX;
+
+	qint64 iBurst = KVI_OPTION_UINT(KviOption_uintOutgoingTrafficBurst);
+	if(iBurst < 1)
+		iBurst = 1;
+
+	qint64 iNow = m_antiFloodClock.nsecsElapsed() / 1000;
+	if(m_iAntiFloodPenaltyTime < iNow)
+		m_iAntiFloodPenaltyTime = iNow; // the bucket is full
+
+	qint64 iLimit = iNow + ((iBurst - 1) * iInterval);
+	if(m_iAntiFloodPenaltyTime > iLimit)
+	{
+		*piWaitMSecs = (int)((m_iAntiFloodPenaltyTime - iLimit) / 1000) + 1;
+		return 0;
+	}
+
+	return (unsigned int)((iLimit - m_iAntiFloodPenaltyTime) / iInterval) + 1;
+}
+
+void KviIrcSocket::fillWriteBatch(unsigned int uMaxMessages)
+{
+	bool bLimit = KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic);
+	qint64 iInterval = KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds);
+
+	m_writeBatch.resize(0); // keeps the reserved space
+	m_iWriteBatchOffset = 0;
+	m_uWriteBatchMessages = 0;
+
+	while(m_pSendQueueHead && (m_uWriteBatchMessages < uMaxMessages))
+	{
+		KviDataBuffer * pData = m_pSendQueueHead->pData;
+		// the first message goes in anyway, even if it is bigger than the batch
+		if((m_uWriteBatchMessages > 0) && ((m_writeBatch.size() + pData->size()) > KVI_IRCSOCKET_WRITE_BATCH_SIZE))
+			break;
+
+		m_writeBatch.append((const char *)pData->data(), pData->size());
+		m_uWriteBatchMessages++;
+		if(bLimit)
+			m_iAntiFloodPenaltyTime += iInterval;
+
+		queue_removeMessage();
+	}
+}
+
 void KviIrcSocket::flushSendQueue()
 {
 	// If we're called from the flush timer, stop it
@@ -1708,51 +1887,57 @@ void KviIrcSocket::flushSendQueue()
 	// OK...have something to send...
 	KVI_ASSERT(m_state != Idle);
 
-	struct timeval curTime;
-
-	while(m_pSendQueueHead)
+	for(;;)
 	{
-		if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
+		if(m_iWriteBatchOffset >= m_writeBatch.size())
 		{
-			kvi_gettimeofday(&curTime, nullptr);
-
-			int iTimeDiff = curTime.tv_usec - m_tAntiFloodLastMessageTime.tv_usec;
-			iTimeDiff += (curTime.tv_sec - m_tAntiFloodLastMessageTime.tv_sec) * 1000000;
+			// The previous batch is gone: take the next messages
+			if(!m_pSendQueueHead)
+				break;
 
-			if(((unsigned int)iTimeDiff) < KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds))
+			unsigned int uAllowed = UINT_MAX;
+			if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
 			{
-				// need to wait for a while....
-				m_pFlushTimer->start(((KVI_OPTION_UINT(KviOption_uintOutgoingTrafficLimitUSeconds) - iTimeDiff) / 1000) + 1);
-				return;
-			} // else can send
+				int iWaitMSecs = 0;
+				uAllowed = antiFloodAllowance(&iWaitMSecs);
+				if(uAllowed == 0)
+				{
+					// need to wait for a while....
+					m_pFlushTimer->start(iWaitMSecs);
+					return;
+				} // else can send
+			}
+
+			fillWriteBatch(uAllowed);
 		}
-		// Write one data buffer...
+
+		// Write the batch (or what is left of it) with a single call.
+		// The batch is not touched until it has been written: after a WantWrite
+		// the SSL write must be retried with the same buffer.
+		const char * pcData = m_writeBatch.constData() + m_iWriteBatchOffset;
+		int iSize = m_writeBatch.size() - m_iWriteBatchOffset;
 		int iResult;
 #ifdef COMPILE_SSL_SUPPORT
 		if(m_pSSL)
 		{
-			iResult = m_pSSL->write((char *)(m_pSendQueueHead->pData->data()), m_pSendQueueHead->pData->size());
+			iResult = m_pSSL->write(pcData, iSize);
 		}
 		else
 		{
 #endif
-			iResult = kvi_socket_send(m_sock, (char *)(m_pSendQueueHead->pData->data()), m_pSendQueueHead->pData->size());
+			iResult = kvi_socket_send(m_sock, pcData, iSize);
 #ifdef COMPILE_SSL_SUPPORT
 		}
 #endif
-		if(iResult == (int)m_pSendQueueHead->pData->size())
+		if(iResult == iSize)
 		{
-			// Successful send...remove this data buffer
-			m_uSentPackets++;
+			// Successful send...all the messages of the batch are gone
+			m_uSentPackets += m_uWriteBatchMessages;
 			m_uSentBytes += iResult;
-			//if(m_pConsole->hasMonitors())outgoingMessageNotifyMonitors((char *)(m_pSendQueueHead->pData->data()),result);
-			queue_removeMessage();
-			if(KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic))
-			{
-				m_tAntiFloodLastMessageTime.tv_sec = curTime.tv_sec;
-				m_tAntiFloodLastMessageTime.tv_usec = curTime.tv_usec;
-			}
-			// And try next buffer...
+			m_writeBatch.resize(0);
+			m_iWriteBatchOffset = 0;
+			m_uWriteBatchMessages = 0;
+			// And try next messages...
 			continue;
 		}
 		else
@@ -1820,7 +2005,7 @@ void KviIrcSocket::flushSendQueue()
 #endif // COMPILE_SSL_SUPPORT
 
 				// Partial send...need to finish it later
-				m_pSendQueueHead->pData->remove(iResult);
+				m_iWriteBatchOffset += iResult;
 
 				m_uSentBytes += iResult;
 				if(_OUTPUT_VERBOSE)
@@ -1952,8 +2137,7 @@ bool KviIrcSocket::sendRawData(const char * pcBuffer, int iBuflen)
 		return false;
 
 	//new buffer
-	KviIrcSocketMsgEntry * pEntry = (KviIrcSocketMsgEntry *)KviMemory::allocate(sizeof(KviIrcSocketMsgEntry));
-	pEntry->pData = new KviDataBuffer(iBuflen);
+	KviIrcSocketMsgEntry * pEntry = alloc_msgEntry(new KviDataBuffer(iBuflen));
 
 	KviMemory::move(pEntry->pData->data(), pcBuffer, iBuflen);
 	queue_insertMessage(pEntry);
@@ -1973,8 +2157,7 @@ bool KviIrcSocket::sendPacket(KviDataBuffer * pData)
 		return false;
 	}
 
-	KviIrcSocketMsgEntry * pEntry = (KviIrcSocketMsgEntry *)KviMemory::allocate(sizeof(KviIrcSocketMsgEntry));
-	pEntry->pData = pData;
+	KviIrcSocketMsgEntry * pEntry = alloc_msgEntry(pData);
 	queue_insertMessage(pEntry);
 
 	if(!m_bInProcessData)
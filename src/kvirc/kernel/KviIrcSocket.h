@@ -38,6 +38,8 @@
 #include "KviError.h"
 
 #include <memory>
+#include <QByteArray>
+#include <QElapsedTimer>
 #include <QObject>
 
 class QTimer;
@@ -116,13 +118,21 @@ protected:
 	KviProxy * m_pProxy;
 	QTimer * m_pTimeoutTimer;
 	unsigned int m_uReadBytes;
+	unsigned int m_uReadNotifications;
+	unsigned int m_uReadCalls;
 	unsigned int m_uSentBytes;
 	KviError::Code m_eLastError;
 	unsigned int m_uSentPackets;
 	KviIrcSocketMsgEntry * m_pSendQueueHead;
 	KviIrcSocketMsgEntry * m_pSendQueueTail;
 	std::unique_ptr<QTimer> m_pFlushTimer;
-	struct timeval m_tAntiFloodLastMessageTime;
+	QElapsedTimer m_antiFloodClock;
+	qint64 m_iAntiFloodPenaltyTime;        // usecs on m_antiFloodClock, each message sent moves it forward
+	QByteArray m_writeBatch;               // the messages taken from the queue and being written
+	int m_iWriteBatchOffset;               // bytes of m_writeBatch already written
+	unsigned int m_uWriteBatchMessages;    // messages in m_writeBatch
+	KviIrcSocketMsgEntry * m_pFreeEntries; // recycled queue entries
+	unsigned int m_uFreeEntries;
 	bool m_bInProcessData;
 #ifdef COMPILE_SSL_SUPPORT
 	KviSSL * m_pSSL;
@@ -187,6 +197,21 @@ public:
 	*/
 	unsigned int readBytes() { return m_uReadBytes; };
 
+	/**
+	* \brief Returns the number of times the read notifier has fired
+	*
+	* Each activation drains the socket in a single batch so this
+	* is usually much smaller than readCalls() on busy connections.
+	* \return unsigned int
+	*/
+	unsigned int readNotifications() { return m_uReadNotifications; };
+
+	/**
+	* \brief Returns the number of successful read calls
+	* \return unsigned int
+	*/
+	unsigned int readCalls() { return m_uReadCalls; };
+
 	/**
 	* \brief Returns the number of bytes sent
 	* \return unsigned int
@@ -399,12 +424,43 @@ protected:
 	*/
 	void handleInvalidSocketRead(int iReadLength);
 
+	/**
+	* \brief Handles a failed read, checking for SSL errors first
+	* \param iReadLength The value returned by readRawData()
+	* \return void
+	*/
+	void handleInvalidRead(int iReadLength);
+
+	/**
+	* \brief Reads raw data from the socket or from the SSL layer
+	* \param pcBuffer The buffer to read into
+	* \param iBufLen The size of the buffer
+	* \return int
+	*/
+	int readRawData(char * pcBuffer, int iBufLen);
+
+	/**
+	* \brief Returns true if a failed read was just a transient condition
+	*
+	* This must be called immediately after the failed read.
+	* \param iReadLength The value returned by readRawData()
+	* \return bool
+	*/
+	bool readWouldBlock(int iReadLength);
+
 	/**
 	* \brief Resets the connection
 	* \return void
 	*/
 	virtual void reset();
 
+	/**
+	* \brief Returns a message entry for the data, recycling the freed ones
+	* \param pData The data of the message, owned by the entry
+	* \return KviIrcSocketMsgEntry *
+	*/
+	KviIrcSocketMsgEntry * alloc_msgEntry(KviDataBuffer * pData);
+
 	/**
 	* \brief Removes the message entry
 	* \param e The entry
@@ -526,11 +582,28 @@ protected slots:
 	*/
 	void readHttpProxyErrorData(int);
 
+	/**
+	* \brief Returns the number of messages that the flood limiter lets through now
+	* \param piWaitMSecs Will contain the time to wait for the next message, if none can be sent
+	* \return unsigned int
+	*/
+	unsigned int antiFloodAllowance(int * piWaitMSecs);
+
+	/**
+	* \brief Moves the messages from the head of the queue to the write batch
+	*
+	* Takes at most uMaxMessages messages and stops when the batch is full.
+	* \param uMaxMessages The maximum number of messages to take
+	* \return void
+	*/
+	void fillWriteBatch(unsigned int uMaxMessages);
+
 	/**
 	* \brief Attempts to send as much as possible to the server
 	*
-	* If fails (happens only on really lagged servers) calls itself with a
-	* QTimer shot after KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout)
+	* Consecutive messages are written with a single call (and a single
+	* TLS record). If fails (happens only on really lagged servers) calls
+	* itself with a QTimer shot after KVI_OPTION_UINT(KviOption_uintSocketQueueFlushTimeout)
 	* ms to retry again...
 	* \return void
 	*/
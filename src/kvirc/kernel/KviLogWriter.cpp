@@ -0,0 +1,384 @@
+//=============================================================================
+//
+//   File : KviLogWriter.cpp
+//   Creation date : Sun Oct 18 2026 16:02:11 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviLogWriter.h"
+#include "KviTimeUtils.h"
+#include "kvi_debug.h"
+
+#include <QFile>
+
+#ifdef COMPILE_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+#include <io.h> // for _commit()
+#else
+#include <unistd.h> // for fsync()
+#endif
+
+#include <algorithm>
+
+// The GUI thread blocks in write() only when this much data is waiting for a single file
+#define KVI_LOGWRITER_MAX_QUEUED_BYTES (1024 * 1024)
+// The compressed streams are flushed (and the plain files handed to the OS)
+// at least this often while data is being written: a crash loses at most this much
+#define KVI_LOGWRITER_FLUSH_INTERVAL 5000
+// Size of the buffer that receives the output of the compressor
+#define KVI_LOGWRITER_ZBUFFER_SIZE 16384
+// The compressor of a gzipped log that received no data for this long is
+// released: the next data starts a new gzip member
+#define KVI_LOGWRITER_IDLE_INTERVAL 60000
+// The compressor settings: a 8 KB window and a small hash table keep the
+// state of each open log under 50 KB, log lines don't gain much from more
+#define KVI_LOGWRITER_ZLIB_LEVEL 6
+#define KVI_LOGWRITER_ZLIB_WINDOW_BITS 13
+#define KVI_LOGWRITER_ZLIB_MEM_LEVEL 5
+
+static KviLogWriter * g_pLogWriter = nullptr;
+
+KviLogWriterFile::KviLogWriterFile(const QString & szFileName, bool bGzip)
+    : m_szFileName(szFileName)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	m_bGzip = bGzip;
+#else
+	Q_UNUSED(bGzip);
+	m_bGzip = false;
+#endif
+	m_pFile = nullptr;
+	m_pZStream = nullptr;
+	m_bFlushRequested = false;
+	m_bCloseRequested = false;
+	m_bDirty = false;
+	m_llLastFlush = KviTimeUtils::getCurrentTimeMills();
+	m_llLastData = m_llLastFlush;
+}
+
+KviLogWriterFile::~KviLogWriterFile()
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(m_pZStream)
+	{
+		deflateEnd((z_stream *)m_pZStream);
+		delete static_cast<z_stream *>(m_pZStream);
+	}
+#endif
+	if(m_pFile)
+		delete m_pFile; // closes the file
+}
+
+bool KviLogWriterFile::openFile()
+{
+	m_pFile = new QFile(m_szFileName);
+
+	// the compressor of the gzipped logs is created when the first data arrives
+	return m_pFile->open(QIODevice::Append | QIODevice::WriteOnly);
+}
+
+#ifdef COMPILE_ZLIB_SUPPORT
+bool KviLogWriterFile::startStream()
+{
+	// Each logging session (and each burst of data after an idle period)
+	// is a new gzip member appended to the file: concatenated members
+	// are still a valid gzip stream.
+	z_stream * pZ = new z_stream;
+	pZ->zalloc = Z_NULL;
+	pZ->zfree = Z_NULL;
+	pZ->opaque = Z_NULL;
+	// + 16: with a gzip header and trailer
+	if(deflateInit2(pZ, KVI_LOGWRITER_ZLIB_LEVEL, Z_DEFLATED, KVI_LOGWRITER_ZLIB_WINDOW_BITS + 16, KVI_LOGWRITER_ZLIB_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		delete pZ;
+		qDebug("WARNING: can't initialize the log compressor.");
+		return false;
+	}
+	m_pZStream = pZ;
+	return true;
+}
+
+void KviLogWriterFile::compress(const QByteArray & data, int iMode)
+{
+	z_stream * pZ = (z_stream *)m_pZStream;
+	char zBuffer[KVI_LOGWRITER_ZBUFFER_SIZE];
+	pZ->next_in = (Bytef *)data.data();
+	pZ->avail_in = data.size();
+	int iRet;
+	do
+	{
+		pZ->next_out = (Bytef *)zBuffer;
+		pZ->avail_out = KVI_LOGWRITER_ZBUFFER_SIZE;
+		iRet = deflate(pZ, iMode);
+		if(iRet == Z_STREAM_ERROR)
+		{
+			qDebug("WARNING: can't compress the log data.");
+			break;
+		}
+		int iLen = KVI_LOGWRITER_ZBUFFER_SIZE - pZ->avail_out;
+		if(iLen > 0)
+			writeRaw(zBuffer, iLen);
+	} while((pZ->avail_out == 0) || ((iMode == Z_FINISH) && (iRet != Z_STREAM_END)));
+}
+
+void KviLogWriterFile::finishStream()
+{
+	compress(QByteArray(), Z_FINISH);
+	deflateEnd((z_stream *)m_pZStream);
+	delete static_cast<z_stream *>(m_pZStream);
+	m_pZStream = nullptr;
+}
+#endif
+
+void KviLogWriterFile::releaseIdleStream(long long llNow)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(!m_pZStream || m_bDirty || ((llNow - m_llLastData) < KVI_LOGWRITER_IDLE_INTERVAL))
+		return;
+	finishStream();
+	m_pFile->flush();
+#else
+	Q_UNUSED(llNow);
+#endif
+}
+
+void KviLogWriterFile::writeRaw(const char * pcData, int iLen)
+{
+	if(m_pFile->write(pcData, iLen) == -1)
+		qDebug("WARNING: can't write to the log file.");
+}
+
+void KviLogWriterFile::writeData(const QByteArray & data, bool bFlush, bool bSync, bool bFinish)
+{
+	if(!data.isEmpty())
+	{
+		m_bDirty = true;
+		m_llLastData = KviTimeUtils::getCurrentTimeMills();
+	}
+
+	if(!m_bGzip)
+	{
+		if(!data.isEmpty())
+			writeRaw(data.data(), data.size());
+	}
+#ifdef COMPILE_ZLIB_SUPPORT
+	else
+	{
+		if(!m_pZStream && !data.isEmpty())
+			startStream();
+		if(m_pZStream)
+		{
+			if(bFinish)
+			{
+				compress(data, Z_NO_FLUSH);
+				finishStream();
+			}
+			else
+			{
+				int iMode = (bFlush && m_bDirty) ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+				if((iMode != Z_NO_FLUSH) || !data.isEmpty())
+					compress(data, iMode);
+			}
+		}
+	}
+#endif
+
+	if(!(bFlush || bFinish))
+		return;
+
+	if(m_bDirty || bSync)
+	{
+		m_pFile->flush();
+		if(bSync || bFinish)
+		{
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+			_commit(m_pFile->handle());
+#else
+			fsync(m_pFile->handle());
+#endif
+		}
+	}
+
+	m_bDirty = false;
+	m_llLastFlush = KviTimeUtils::getCurrentTimeMills();
+}
+
+KviLogWriter::KviLogWriter()
+    : QThread()
+{
+	m_bWorkPending = false;
+	m_bTerminate = false;
+}
+
+KviLogWriter::~KviLogWriter()
+{
+	// all the files have been closed by the writer thread
+	KVI_ASSERT(m_Files.empty());
+}
+
+KviLogWriter * KviLogWriter::instance()
+{
+	if(!g_pLogWriter)
+	{
+		g_pLogWriter = new KviLogWriter();
+		g_pLogWriter->start(QThread::LowPriority);
+	}
+	return g_pLogWriter;
+}
+
+void KviLogWriter::cleanup()
+{
+	if(!g_pLogWriter)
+		return;
+
+	g_pLogWriter->m_mutex.lock();
+	for(auto & f : g_pLogWriter->m_Files)
+		f->m_bCloseRequested = true;
+	g_pLogWriter->m_bTerminate = true;
+	g_pLogWriter->wakeUp();
+	g_pLogWriter->m_mutex.unlock();
+
+	g_pLogWriter->wait();
+	delete g_pLogWriter;
+	g_pLogWriter = nullptr;
+}
+
+void KviLogWriter::wakeUp()
+{
+	// m_mutex must be locked
+	m_bWorkPending = true;
+	m_workAvailable.wakeOne();
+}
+
+KviLogWriterFile * KviLogWriter::open(const QString & szFileName, bool bGzip)
+{
+	KviLogWriterFile * pFile = new KviLogWriterFile(szFileName, bGzip);
+	if(!pFile->openFile())
+	{
+		delete pFile;
+		return nullptr;
+	}
+
+	// from now on the file is used only by the writer thread
+	pFile->m_pFile->moveToThread(this);
+
+	m_mutex.lock();
+	m_Files.push_back(pFile);
+	m_mutex.unlock();
+	return pFile;
+}
+
+void KviLogWriter::write(KviLogWriterFile * pFile, const QByteArray & data)
+{
+	m_mutex.lock();
+
+	// The writer thread picks up everything queued since its last pass:
+	// it needs to be woken up only when the queue becomes non-empty.
+	if(pFile->m_Queue.isEmpty())
+		wakeUp();
+	pFile->m_Queue.append(data);
+
+	// Don't let a stuck disk eat all the memory: wait for the writer to catch up
+	while(pFile->m_Queue.size() > KVI_LOGWRITER_MAX_QUEUED_BYTES)
+	{
+		wakeUp();
+		m_queueDrained.wait(&m_mutex);
+	}
+
+	m_mutex.unlock();
+}
+
+void KviLogWriter::flush(KviLogWriterFile * pFile)
+{
+	m_mutex.lock();
+	pFile->m_bFlushRequested = true;
+	wakeUp();
+	m_mutex.unlock();
+}
+
+void KviLogWriter::close(KviLogWriterFile * pFile)
+{
+	m_mutex.lock();
+	pFile->m_bCloseRequested = true;
+	wakeUp();
+	m_mutex.unlock();
+}
+
+void KviLogWriter::run()
+{
+	struct Job
+	{
+		KviLogWriterFile * pFile;
+		QByteArray data;
+		bool bSync;
+		bool bClose;
+	};
+
+	std::vector<Job> jobs;
+
+	m_mutex.lock();
+
+	for(;;)
+	{
+		if(!m_bWorkPending && !m_bTerminate)
+			m_workAvailable.wait(&m_mutex, KVI_LOGWRITER_FLUSH_INTERVAL);
+		m_bWorkPending = false;
+
+		// Grab everything that has been queued: the I/O is done without holding the lock
+		for(auto & f : m_Files)
+		{
+			jobs.push_back({ f, QByteArray(), f->m_bFlushRequested, f->m_bCloseRequested });
+			jobs.back().data.swap(f->m_Queue);
+			f->m_bFlushRequested = false;
+		}
+
+		m_Files.erase(
+		    std::remove_if(m_Files.begin(), m_Files.end(), [](KviLogWriterFile * f) { return f->m_bCloseRequested; }),
+		    m_Files.end());
+
+		bool bTerminate = m_bTerminate && m_Files.empty();
+
+		m_mutex.unlock();
+
+		long long llNow = KviTimeUtils::getCurrentTimeMills();
+
+		for(auto & j : jobs)
+		{
+			bool bFlush = j.bSync || (llNow - j.pFile->m_llLastFlush >= KVI_LOGWRITER_FLUSH_INTERVAL);
+			j.pFile->writeData(j.data, bFlush, j.bSync, j.bClose);
+			if(j.bClose)
+				delete j.pFile;
+			else
+				j.pFile->releaseIdleStream(llNow);
+		}
+		jobs.clear();
+
+		m_mutex.lock();
+		m_queueDrained.wakeAll();
+
+		if(bTerminate)
+			break;
+	}
+
+	m_mutex.unlock();
+}
@@ -0,0 +1,170 @@
+#ifndef _KVI_LOGWRITER_H_
+#define _KVI_LOGWRITER_H_
+//=============================================================================
+//
+//   File : KviLogWriter.h
+//   Creation date : Sun Oct 18 2026 16:02:11 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviLogWriter.h
+* \author The KVIrc Development Team
+* \brief Asynchronous log file writer
+*
+* The window logs are formatted on the GUI thread and handed over to a
+* single background thread that does the actual (possibly slow) disk I/O.
+*/
+
+#include "kvi_settings.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <vector>
+
+class KviLogWriterFile;
+class QFile;
+
+/**
+* \class KviLogWriter
+* \brief The background thread that writes all the log files
+*
+* Each open log has its own queue of pending data. The GUI thread only
+* appends to the queue: the writer thread coalesces everything queued
+* since its last pass into a single write per file. Gzipped logs are
+* compressed on the fly so the file on disk is always a valid
+* compressed stream up to the last flush.
+*/
+class KVIRC_API KviLogWriter : public QThread
+{
+protected:
+	KviLogWriter();
+	~KviLogWriter();
+
+protected:
+	QMutex m_mutex;
+	QWaitCondition m_workAvailable; // signaled when there is something to write, flush or close
+	QWaitCondition m_queueDrained;  // signaled after each pass of the writer thread
+	std::vector<KviLogWriterFile *> m_Files;
+	bool m_bWorkPending;
+	bool m_bTerminate;
+
+public:
+	/**
+	* \brief Returns the instance of the log writer, creating it if needed
+	* \return KviLogWriter *
+	*/
+	static KviLogWriter * instance();
+
+	/**
+	* \brief Flushes and closes all the logs and stops the writer thread
+	* \return void
+	*/
+	static void cleanup();
+
+	/**
+	* \brief Opens a log file for appending
+	*
+	* The file is opened synchronously so that the caller gets a meaningful
+	* return value: everything else happens on the writer thread.
+	* \param szFileName The name of the file
+	* \param bGzip Whether the data should be gzip-compressed
+	* \return KviLogWriterFile *, nullptr if the file can't be opened
+	*/
+	KviLogWriterFile * open(const QString & szFileName, bool bGzip);
+
+	/**
+	* \brief Queues data to be appended to the log
+	*
+	* Blocks only if the writer is too far behind on this file
+	* \param pFile The log file
+	* \param data The data to append
+	* \return void
+	*/
+	void write(KviLogWriterFile * pFile, const QByteArray & data);
+
+	/**
+	* \brief Asks the writer to flush the log and sync it to the disk
+	* \param pFile The log file
+	* \return void
+	*/
+	void flush(KviLogWriterFile * pFile);
+
+	/**
+	* \brief Closes the log after all the queued data has been written
+	*
+	* The handle must not be used after this call
+	* \param pFile The log file
+	* \return void
+	*/
+	void close(KviLogWriterFile * pFile);
+
+protected:
+	virtual void run();
+	void wakeUp();
+};
+
+/**
+* \class KviLogWriterFile
+* \brief A log file handled by KviLogWriter
+*
+* The GUI thread treats this as an opaque handle: only the file name
+* may be read from outside the writer.
+*/
+class KVIRC_API KviLogWriterFile
+{
+	friend class KviLogWriter;
+
+protected:
+	KviLogWriterFile(const QString & szFileName, bool bGzip);
+	~KviLogWriterFile();
+
+protected:
+	QString m_szFileName;
+	bool m_bGzip;
+	QFile * m_pFile;
+	void * m_pZStream;       // z_stream, only for gzipped logs that received data recently (writer thread only)
+	QByteArray m_Queue;      // data waiting for the writer thread (protected by the writer mutex)
+	bool m_bFlushRequested;  // protected by the writer mutex
+	bool m_bCloseRequested;  // protected by the writer mutex
+	bool m_bDirty;           // data written since the last stream flush (writer thread only)
+	long long m_llLastFlush; // time of the last stream flush in msecs (writer thread only)
+	long long m_llLastData;  // time of the last data written in msecs (writer thread only)
+
+public:
+	const QString & fileName() const { return m_szFileName; };
+
+protected:
+	bool openFile();
+	void writeData(const QByteArray & data, bool bFlush, bool bSync, bool bFinish);
+	void writeRaw(const char * pcData, int iLen);
+	void releaseIdleStream(long long llNow);
+#ifdef COMPILE_ZLIB_SUPPORT
+	bool startStream();
+	void compress(const QByteArray & data, int iMode);
+	void finishStream();
+#endif
+};
+
+#endif //_KVI_LOGWRITER_H_
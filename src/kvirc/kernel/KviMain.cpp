@@ -64,6 +64,7 @@ typedef struct _ParseArgs
 	bool bForceNewSession;
 	bool bShowPopup;
 	bool bExecuteCommandAndClose;
+	bool bStartupTiming;
 	QString szExecCommand;
 	QString szExecRemoteCommand;
 } ParseArgs;
@@ -137,6 +138,7 @@ int parseArgs(ParseArgs * a)
 			KviQString::appendFormatted(szMessage, "                 You can eventually use this switch more than once\n");
 			KviQString::appendFormatted(szMessage, "  -m           : If a KVIrc session is already running, show an informational\n");
 			KviQString::appendFormatted(szMessage, "                 popup dialog instead of writing to the console\n");
+			KviQString::appendFormatted(szMessage, "  -t, --timing : Print the time spent in each startup phase\n");
 			KviQString::appendFormatted(szMessage, "  [server]     : Connect to this server after startup\n");
 			KviQString::appendFormatted(szMessage, "  [port]       : Use this port for connection\n");
 			KviQString::appendFormatted(szMessage, "  [ircurl]     : URL in the following form:\n");
@@ -237,6 +239,12 @@ int parseArgs(ParseArgs * a)
 			continue;
 		}
 
+		if(kvi_strEqualCI("-t", p) || kvi_strEqualCI("-timing", p))
+		{
+			a->bStartupTiming = true;
+			continue;
+		}
+
 		if(kvi_strEqualCI("-session", p) || kvi_strEqualCI("-display", p) || kvi_strEqualCI("-name", p))
 		{
 			// Qt apps are supposed to handle the params to these switches, but we'll skip arg for now
@@ -352,6 +360,7 @@ int main(int argc, char ** argv)
 	a.bForceNewSession = false;
 	a.bShowPopup = false,
 	a.bExecuteCommandAndClose = false;
+	a.bStartupTiming = false;
 
 	int iRetCode = parseArgs(&a);
 
@@ -480,6 +489,7 @@ int main(int argc, char ** argv)
 #endif
 
 	pTheApp->m_bCreateConfig = a.createFile;
+	pTheApp->m_bStartupTiming = a.bStartupTiming;
 	pTheApp->m_szConfigFile = a.configFile;
 	pTheApp->m_szExecAfterStartup = a.szExecCommand;
 	pTheApp->setup();
@@ -41,6 +41,7 @@
 #include "KviInternalCommand.h"
 #include "KviTheme.h"
 #include "KviFileUtils.h"
+#include "KviHighlightMatcher.h"
 
 #include <QMessageBox>
 #include <QDir>
@@ -79,7 +80,7 @@ KviBoolOption g_boolOptionsTable[KVI_NUM_BOOL_OPTIONS] = {
 	BOOL_OPTION("UseAntiSpamOnPrivmsg", false, KviOption_sectFlagAntiSpam),
 	BOOL_OPTION("UseExtendedPrivmsgView", false, KviOption_sectFlagIrcView | KviOption_groupTheme),
 	BOOL_OPTION("ShowUserAndHostInPrivmsgView", false, KviOption_sectFlagIrcView | KviOption_groupTheme),
-	BOOL_OPTION("UseWordHighlighting", true, KviOption_sectFlagIrcView), /* _ALL_ newbie users, with who i was taling asks me where can they switch on */
+	BOOL_OPTION("UseWordHighlighting", true, KviOption_sectFlagIrcView | KviOption_resetRebuildHighlighting), /* _ALL_ newbie users, with who i was taling asks me where can they switch on */
 	BOOL_OPTION("CleanupUnusedModules", true, KviOption_sectFlagModules),
 	BOOL_OPTION("IgnoreCtcpPing", false, KviOption_sectFlagCtcp),
 	BOOL_OPTION("IgnoreCtcpVersion", false, KviOption_sectFlagCtcp),
@@ -256,7 +257,7 @@ KviBoolOption g_boolOptionsTable[KVI_NUM_BOOL_OPTIONS] = {
 	BOOL_OPTION("ShowExtendedInfoInQueryLabel", true, KviOption_resetUpdateGui),
 	BOOL_OPTION("UseUserListColorsAsNickColors", true, KviOption_sectFlagIrcView | KviOption_groupTheme),
 	BOOL_OPTION("GzipLogs", false, KviOption_sectFlagLogging),
-	BOOL_OPTION("UseFullWordHighlighting", false, KviOption_sectFlagIrcView),
+	BOOL_OPTION("UseFullWordHighlighting", false, KviOption_sectFlagIrcView | KviOption_resetRebuildHighlighting),
 	BOOL_OPTION("NotifierFlashing", true, KviOption_sectFlagFrame),
 	BOOL_OPTION("CommandlineInUserFriendlyModeByDefault", true, KviOption_sectFlagFrame),
 	BOOL_OPTION("EnableVisualEffects", true, KviOption_resetUpdateGui),
@@ -318,7 +319,7 @@ KviBoolOption g_boolOptionsTable[KVI_NUM_BOOL_OPTIONS] = {
 	BOOL_OPTION("EnableEscapeLinkToolTip", true, KviOption_sectFlagGui),
 	BOOL_OPTION("UseDBusNotifier", false, KviOption_sectFlagConnection),
 	BOOL_OPTION("UseKDENotifier", false, KviOption_sectFlagConnection),
-	BOOL_OPTION("CaseSensitiveHighlighting", false, KviOption_sectFlagIrcView),
+	BOOL_OPTION("CaseSensitiveHighlighting", false, KviOption_sectFlagIrcView | KviOption_resetRebuildHighlighting),
 	BOOL_OPTION("MinimizeInTray", false, KviOption_sectFlagFrame | KviOption_resetUpdateGui),
 	BOOL_OPTION("DisplayNotifierOnPrimaryScreen", true, KviOption_sectFlagFrame),
 	BOOL_OPTION("ShowDialogOnChannelCtcpPage", false, KviOption_sectFlagCtcp),
@@ -401,7 +402,7 @@ KviStringOption g_stringOptionsTable[KVI_NUM_STRING_OPTIONS] = {
 	STRING_OPTION("CtcpUserInfoGender", "", KviOption_sectFlagUser),
 	STRING_OPTION("CtcpUserInfoLocation", "", KviOption_sectFlagUser),
 	STRING_OPTION("CtcpUserInfoLanguages", "", KviOption_sectFlagUser),
-	STRING_OPTION("WordSplitters", ",\"';:|.%^~!\\$#()?", KviOption_sectFlagIrcView),
+	STRING_OPTION("WordSplitters", ",\"';:|.%^~!\\$#()?", KviOption_sectFlagIrcView | KviOption_resetRebuildHighlighting),
 	STRING_OPTION("OnNewQueryOpenedSound", "", KviOption_sectFlagFrame),
 	STRING_OPTION("OnHighlightedMessageSound", "", KviOption_sectFlagFrame),
 	STRING_OPTION("OnMeKickedSound", "", KviOption_sectFlagFrame),
@@ -421,7 +422,7 @@ KviStringOption g_stringOptionsTable[KVI_NUM_STRING_OPTIONS] = {
 	KviStringListOption(KVI_STRINGLIST_OPTIONS_PREFIX _txt, QStringList(_def), _flags)
 
 KviStringListOption g_stringlistOptionsTable[KVI_NUM_STRINGLIST_OPTIONS] = {
-	STRINGLIST_OPTION("HighlightWords", KviOption_sectFlagIrcView),
+	STRINGLIST_OPTION("HighlightWords", KviOption_sectFlagIrcView | KviOption_resetRebuildHighlighting),
 	STRINGLIST_OPTION("SpamWords", KviOption_sectFlagAntiSpam),
 	STRINGLIST_OPTION_WITHDEFAULT("RecentChannels", KviOption_sectFlagRecent, "#kvirc" KVI_RECENT_CHANNELS_SEPARATOR "freenode"),
 	STRINGLIST_OPTION("RecentServers", KviOption_sectFlagRecent),
@@ -636,7 +637,11 @@ KviUIntOption g_uintOptionsTable[KVI_NUM_UINT_OPTIONS] = {
 	UINT_OPTION("ToolBarButtonStyle", 0, KviOption_groupTheme), // 0 = Qt::ToolButtonIconOnly
 	UINT_OPTION("MaximumBlowFishKeySize", 56, KviOption_sectFlagNone),
 	UINT_OPTION("CustomCursorWidth", 1, KviOption_resetUpdateGui),
-	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme)
+	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme),
+	UINT_OPTION("IrcSocketReadBudget", 65536, KviOption_sectFlagIrcSocket),
+	UINT_OPTION("IrcSocketReadTimeBudget", 20, KviOption_sectFlagIrcSocket),
+	UINT_OPTION("OutgoingTrafficBurst", 5, KviOption_sectFlagIrcSocket),
+	UINT_OPTION("KvsEngine", 0, KviOption_sectFlagUserParser)
 };
 
 #define FONT_OPTION(_name, _face, _size, _flags) \
@@ -1344,6 +1349,11 @@ void KviApplication::optionResetUpdate(int flags)
 	{
 		emit updateNotifier();
 	}
+
+	if(flags & KviOption_resetRebuildHighlighting)
+	{
+		KviHighlightMatcher::invalidate();
+	}
 }
 
 bool KviApplication::setOptionValue(const QString & optName, const QString & value)
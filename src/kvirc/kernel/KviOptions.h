@@ -595,8 +595,12 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_uintMaximumBlowFishKeySize 80
 #define KviOption_uintCustomCursorWidth 81                                    /* Interface */
 #define KviOption_uintUserListMinimumWidth 82
+#define KviOption_uintIrcSocketReadBudget 83                                  /* connection::transport */
+#define KviOption_uintIrcSocketReadTimeBudget 84                              /* connection::transport */
+#define KviOption_uintOutgoingTrafficBurst 85                                 /* connection::transport */
+#define KviOption_uintKvsEngine 86                                            /* KVI_KVS_ENGINE_* in KviKvsVirtualMachine.h */
 
-#define KVI_NUM_UINT_OPTIONS 83
+#define KVI_NUM_UINT_OPTIONS 87
 
 namespace KviIdentdOutputMode
 {
@@ -738,6 +742,7 @@ extern KVIRC_API KviStringListOption g_stringlistOptionsTable[KVI_NUM_STRINGLIST
 #define KviOption_resetReloadImages (1 << 23)
 #define KviOption_resetRestartLagMeter (1 << 24)
 #define KviOption_resetRecentChannels (1 << 25)
+#define KviOption_resetRebuildHighlighting (1 << 26)
 
 #define KviOption_resetMask (~(KviOption_sectMask | KviOption_groupMask))
 
@@ -0,0 +1,91 @@
+//=============================================================================
+//
+//   File : KviKvsBytecode.cpp
+//   Creation date : Sun Oct 18 2026 14:05:31 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsBytecode.h"
+#include "KviKvsTreeNodeBase.h"
+#include "KviKvsVariant.h"
+
+#define KVI_KVS_BYTECODE_NAME(_name) #_name,
+
+static const char * g_pcOpCodeNames[KviKvsBytecodeProgram::OpCodeCount] = {
+	KVI_KVS_BYTECODE_OPCODES(KVI_KVS_BYTECODE_NAME)
+};
+
+KviKvsBytecodeProgram::KviKvsBytecodeProgram()
+{
+	m_uStackSize = 0;
+	m_bThreaded = false;
+}
+
+KviKvsBytecodeProgram::~KviKvsBytecodeProgram()
+{
+	for(auto p : m_Constants)
+		delete p;
+}
+
+const char * KviKvsBytecodeProgram::opCodeName(int iOpCode)
+{
+	if((iOpCode < 0) || (iOpCode >= OpCodeCount))
+		return "Unknown";
+	return g_pcOpCodeNames[iOpCode];
+}
+
+void KviKvsBytecodeProgram::dump(const char * prefix)
+{
+	qDebug("%s BytecodeProgram (%u instructions, %u constants, stack %u)", prefix, (unsigned int)m_Code.size(), (unsigned int)m_Constants.size(), m_uStackSize);
+	QString tmp = prefix;
+	tmp.append("  ");
+
+	for(unsigned int u = 0; u < m_Constants.size(); u++)
+	{
+		qDebug("%s constant %u", prefix, u);
+		m_Constants[u]->dump(tmp.toUtf8().data());
+	}
+
+	for(unsigned int u = 0; u < m_Code.size(); u++)
+	{
+		const KviKvsBytecodeInstruction & i = m_Code[u];
+		QString szNode;
+		if(i.pNode)
+			i.pNode->contextDescription(szNode);
+		switch(i.iOpCode)
+		{
+			case PushLocal:
+			case StoreLocal:
+			case IncrementLocal:
+			case DecrementLocal:
+			case SelfSumLocal:
+			case SelfSubtractionLocal:
+			case AppendLocal:
+				qDebug("%s %04u %s %s", prefix, u, opCodeName(i.iOpCode), m_Names[i.iArg].toUtf8().data());
+				break;
+			default:
+				qDebug("%s %04u %s %d %s", prefix, u, opCodeName(i.iOpCode), i.iArg, szNode.toUtf8().data());
+				break;
+		}
+	}
+
+	for(auto & l : m_Loops)
+		qDebug("%s loop %04u-%04u break %04u continue %04u (%d)", prefix, l.uBegin, l.uEnd, l.uBreak, l.uContinue, l.eContinue);
+}
@@ -0,0 +1,214 @@
+#ifndef _KVI_KVS_BYTECODE_H_
+#define _KVI_KVS_BYTECODE_H_
+//=============================================================================
+//
+//   File : KviKvsBytecode.h
+//   Creation date : Sun Oct 18 2026 14:05:31 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsBytecode.h
+* \brief The bytecode run by KviKvsVirtualMachine
+*/
+
+#include "kvi_settings.h"
+#include "KviQString.h"
+#include "KviKvsTypes.h"
+#include "KviKvsKernel.h"
+
+#include <vector>
+
+class KviKvsTreeNode;
+class KviKvsTreeNodeSwitchList;
+class KviKvsVariant;
+class KviKvsHash;
+
+//
+// The instruction set of the stack machine.
+//
+// "push" puts a value on the top of the stack, "pop" takes it away.
+// The instructions that use a local variable take the index of its name
+// in the name pool as argument. The jumps take the target address.
+//
+// Keep the order in sync with the handler table in KviKvsVirtualMachine.cpp:
+// both are generated from this list.
+//
+#define KVI_KVS_BYTECODE_OPCODES(_op)                                                                        \
+	_op(PushConstant)         /* push the constant iArg                                                 */ \
+	_op(PushLocal)            /* push the local variable iArg                                           */ \
+	_op(Evaluate)             /* push the value of the data node (fallback to the tree)                 */ \
+	_op(Concat)               /* pop iArg values, push them joined as a string                          */ \
+	_op(ToNumber)             /* check that the top (left operand) is a number                          */ \
+	_op(Negate)               /* unary operators: replace the top                                       */ \
+	_op(BitwiseNot)                                                                                          \
+	_op(LogicalNot)                                                                                          \
+	_op(Sum)                  /* binary operators: pop two values, push the result                      */ \
+	_op(Subtraction)                                                                                         \
+	_op(Multiplication)                                                                                      \
+	_op(Division)                                                                                            \
+	_op(Modulus)                                                                                             \
+	_op(BitwiseAnd)                                                                                          \
+	_op(BitwiseOr)                                                                                           \
+	_op(BitwiseXor)                                                                                          \
+	_op(ShiftLeft)                                                                                           \
+	_op(ShiftRight)                                                                                          \
+	_op(LowerThan)                                                                                           \
+	_op(GreaterThan)                                                                                         \
+	_op(LowerOrEqualTo)                                                                                      \
+	_op(GreaterOrEqualTo)                                                                                    \
+	_op(EqualTo)                                                                                             \
+	_op(NotEqualTo)                                                                                          \
+	_op(Xor)                                                                                                 \
+	_op(AndJump)              /* if the top is false make it false and jump, pop it otherwise           */ \
+	_op(OrJump)               /* if the top is true make it true and jump, pop it otherwise             */ \
+	_op(ToBoolean)            /* convert the top to a boolean                                           */ \
+	_op(CallFunction)         /* pop iArg parameters, call the core function, push its result           */ \
+	_op(CallCommand)          /* pop iArg parameters, call the core command                             */ \
+	_op(Execute)              /* execute the instruction node (fallback to the tree)                    */ \
+	_op(StoreLocal)           /* pop into the local variable iArg                                       */ \
+	_op(StoreData)            /* pop into the read-write data node                                      */ \
+	_op(IncrementLocal)       /* the operations on the local variable iArg: ++, --, +=, -= and <<       */ \
+	_op(DecrementLocal)                                                                                      \
+	_op(SelfSumLocal)                                                                                        \
+	_op(SelfSubtractionLocal)                                                                                \
+	_op(AppendLocal)                                                                                         \
+	_op(SetReturnValue)       /* pop into the return value                                              */ \
+	_op(Jump)                 /* continue at iArg                                                       */ \
+	_op(JumpIfFalse)          /* pop, continue at iArg if false                                         */ \
+	_op(JumpIfTrue)           /* pop, continue at iArg if true                                          */ \
+	_op(Break)                /* same as the break and continue commands                                */ \
+	_op(Continue)                                                                                            \
+	_op(End)                  /* successful end of the program                                          */
+
+#define KVI_KVS_BYTECODE_ENUM(_name) _name,
+
+/**
+* \class KviKvsBytecodeInstruction
+* \brief A single instruction of a bytecode program
+*/
+class KVIRC_API KviKvsBytecodeInstruction
+{
+public:
+	KviKvsBytecodeInstruction(int iOpCode, int iArg, KviKvsTreeNode * pNode)
+	    : pHandler(nullptr), iOpCode(iOpCode), iArg(iArg), pNode(pNode), pSwitches(nullptr),
+	      pCachedHash(nullptr), uCachedGeneration(0), pCachedVariable(nullptr)
+	{
+		u.pFunction = nullptr;
+	}
+
+public:
+	void * pHandler; // the address of the handler, set when the program is threaded
+	int iOpCode;
+	int iArg;
+	KviKvsTreeNode * pNode; // the node that the instruction comes from: reported in the errors
+	union {
+		KviKvsCoreFunctionExecRoutine * pFunction;
+		KviKvsCoreSimpleCommandExecRoutine * pCommand;
+	} u;
+	KviKvsTreeNodeSwitchList * pSwitches; // the switches of CallCommand, may be 0
+
+	// Inline cache of the local variable lookup, as in KviKvsTreeNodeLocalVariable
+	KviKvsHash * pCachedHash;
+	kvs_uint_t uCachedGeneration;
+	KviKvsVariant * pCachedVariable;
+};
+
+/**
+* \class KviKvsBytecodeLoop
+* \brief Tells what to do when the code in a loop fails
+*
+* The instructions report a break, a continue, an error or a halt by
+* failing, exactly as the tree nodes return false. The failure is handled
+* by the innermost loop whose range contains the failed instruction: if it
+* doesn't handle it, the failure goes on to the enclosing loops and then
+* out of the program.
+*/
+class KVIRC_API KviKvsBytecodeLoop
+{
+public:
+	enum ContinueAction
+	{
+		ContinueJump,     /**< Handle the continue and jump to uContinue */
+		ContinueAndFail,  /**< Handle the continue but fail anyway */
+		ContinueFail      /**< Leave the continue to the enclosing loops */
+	};
+
+	unsigned int uBegin; // the range of the instructions
+	unsigned int uEnd;
+	unsigned int uBreak; // where a break jumps to
+	ContinueAction eContinue;
+	unsigned int uContinue;
+};
+
+/**
+* \class KviKvsBytecodeProgram
+* \brief The bytecode compiled from a syntax tree
+*
+* The program refers to the nodes of the tree it was compiled from, so
+* it must be destroyed before the tree.
+*/
+class KVIRC_API KviKvsBytecodeProgram
+{
+	friend class KviKvsBytecodeCompiler;
+	friend class KviKvsVirtualMachine;
+
+public:
+	enum OpCode
+	{
+		KVI_KVS_BYTECODE_OPCODES(KVI_KVS_BYTECODE_ENUM)
+		    OpCodeCount
+	};
+
+public:
+	KviKvsBytecodeProgram();
+	~KviKvsBytecodeProgram();
+
+protected:
+	std::vector<KviKvsBytecodeInstruction> m_Code;
+	std::vector<KviKvsVariant *> m_Constants; // the constant pool: owned
+	std::vector<QString> m_Names;             // the names of the local variables
+	std::vector<KviKvsBytecodeLoop> m_Loops;  // the innermost loops first
+	unsigned int m_uStackSize;                // the maximum depth of the stack
+	bool m_bThreaded;                         // the handler addresses are set
+
+public:
+	/**
+	* \brief Returns the number of instructions
+	* \return unsigned int
+	*/
+	unsigned int size() const { return m_Code.size(); };
+
+	/**
+	* \brief Returns the name of an opcode
+	* \param iOpCode The opcode
+	* \return const char *
+	*/
+	static const char * opCodeName(int iOpCode);
+
+	/**
+	* \brief Dumps the program
+	* \param prefix The prefix of the lines
+	* \return void
+	*/
+	void dump(const char * prefix);
+};
+
+#endif //_KVI_KVS_BYTECODE_H_
@@ -0,0 +1,214 @@
+//=============================================================================
+//
+//   File : KviKvsBytecodeCompiler.cpp
+//   Creation date : Sun Oct 18 2026 14:26:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsBytecodeCompiler.h"
+#include "KviKvsTreeNodeInstruction.h"
+#include "KviKvsTreeNodeData.h"
+#include "KviKvsVariant.h"
+#include "kvi_debug.h"
+
+KviKvsBytecodeCompiler::KviKvsBytecodeCompiler()
+{
+	m_pProgram = new KviKvsBytecodeProgram();
+	m_iStackDepth = 0;
+}
+
+KviKvsBytecodeCompiler::~KviKvsBytecodeCompiler()
+{
+	if(m_pProgram)
+		delete m_pProgram;
+}
+
+KviKvsBytecodeProgram * KviKvsBytecodeCompiler::compile(KviKvsTreeNodeInstruction * pTree)
+{
+	KviKvsBytecodeCompiler c;
+	pTree->compile(&c);
+	c.emit(KviKvsBytecodeProgram::End);
+	KVI_ASSERT(c.m_iStackDepth == 0);
+
+	KviKvsBytecodeProgram * pProgram = c.m_pProgram;
+	c.m_pProgram = nullptr;
+	return pProgram;
+}
+
+int KviKvsBytecodeCompiler::stackEffect(int iOpCode, int iArg)
+{
+	switch(iOpCode)
+	{
+		case KviKvsBytecodeProgram::PushConstant:
+		case KviKvsBytecodeProgram::PushLocal:
+		case KviKvsBytecodeProgram::Evaluate:
+			return 1;
+		case KviKvsBytecodeProgram::Concat:
+		case KviKvsBytecodeProgram::CallFunction:
+			return 1 - iArg;
+		case KviKvsBytecodeProgram::CallCommand:
+			return -iArg;
+		case KviKvsBytecodeProgram::Sum:
+		case KviKvsBytecodeProgram::Subtraction:
+		case KviKvsBytecodeProgram::Multiplication:
+		case KviKvsBytecodeProgram::Division:
+		case KviKvsBytecodeProgram::Modulus:
+		case KviKvsBytecodeProgram::BitwiseAnd:
+		case KviKvsBytecodeProgram::BitwiseOr:
+		case KviKvsBytecodeProgram::BitwiseXor:
+		case KviKvsBytecodeProgram::ShiftLeft:
+		case KviKvsBytecodeProgram::ShiftRight:
+		case KviKvsBytecodeProgram::LowerThan:
+		case KviKvsBytecodeProgram::GreaterThan:
+		case KviKvsBytecodeProgram::LowerOrEqualTo:
+		case KviKvsBytecodeProgram::GreaterOrEqualTo:
+		case KviKvsBytecodeProgram::EqualTo:
+		case KviKvsBytecodeProgram::NotEqualTo:
+		case KviKvsBytecodeProgram::Xor:
+		case KviKvsBytecodeProgram::AndJump: // when it doesn't jump
+		case KviKvsBytecodeProgram::OrJump:
+		case KviKvsBytecodeProgram::StoreLocal:
+		case KviKvsBytecodeProgram::StoreData:
+		case KviKvsBytecodeProgram::SelfSumLocal:
+		case KviKvsBytecodeProgram::SelfSubtractionLocal:
+		case KviKvsBytecodeProgram::AppendLocal:
+		case KviKvsBytecodeProgram::SetReturnValue:
+		case KviKvsBytecodeProgram::JumpIfFalse:
+		case KviKvsBytecodeProgram::JumpIfTrue:
+			return -1;
+		default:
+			return 0;
+	}
+}
+
+unsigned int KviKvsBytecodeCompiler::emit(int iOpCode, KviKvsTreeNode * pNode, int iArg)
+{
+	m_pProgram->m_Code.push_back(KviKvsBytecodeInstruction(iOpCode, iArg, pNode));
+
+	m_iStackDepth += stackEffect(iOpCode, iArg);
+	KVI_ASSERT(m_iStackDepth >= 0);
+	if(m_iStackDepth > (int)m_pProgram->m_uStackSize)
+		m_pProgram->m_uStackSize = m_iStackDepth;
+
+	return m_pProgram->m_Code.size() - 1;
+}
+
+void KviKvsBytecodeCompiler::emitConstant(KviKvsVariant * pValue)
+{
+	// Only the scalars are pooled: the key tells the type too,
+	// so that "1" and 1 stay different constants
+	QString szKey;
+	switch(pValue->type())
+	{
+		case KviKvsVariantData::Nothing:
+			szKey = QString("n");
+			break;
+		case KviKvsVariantData::String:
+			szKey = QString("s") + pValue->string();
+			break;
+		case KviKvsVariantData::Integer:
+			szKey = QString("i%1").arg(pValue->integer());
+			break;
+		case KviKvsVariantData::Real:
+			szKey = QString("r") + QString::number(pValue->real(), 'g', 17);
+			break;
+		case KviKvsVariantData::Boolean:
+			szKey = pValue->boolean() ? QString("b1") : QString("b0");
+			break;
+		default:
+			break;
+	}
+
+	unsigned int uIdx;
+	QHash<QString, unsigned int>::const_iterator it = szKey.isEmpty() ? m_hConstants.constEnd() : m_hConstants.constFind(szKey);
+	if(it != m_hConstants.constEnd())
+	{
+		uIdx = it.value();
+	}
+	else
+	{
+		uIdx = m_pProgram->m_Constants.size();
+		m_pProgram->m_Constants.push_back(new KviKvsVariant(*pValue));
+		if(!szKey.isEmpty())
+			m_hConstants.insert(szKey, uIdx);
+	}
+
+	emit(KviKvsBytecodeProgram::PushConstant, nullptr, uIdx);
+}
+
+void KviKvsBytecodeCompiler::emitLocal(int iOpCode, const QString & szName, KviKvsTreeNode * pNode)
+{
+	unsigned int uIdx;
+	QHash<QString, unsigned int>::const_iterator it = m_hNames.constFind(szName);
+	if(it != m_hNames.constEnd())
+	{
+		uIdx = it.value();
+	}
+	else
+	{
+		uIdx = m_pProgram->m_Names.size();
+		m_pProgram->m_Names.push_back(szName);
+		m_hNames.insert(szName, uIdx);
+	}
+
+	emit(iOpCode, pNode, uIdx);
+}
+
+void KviKvsBytecodeCompiler::emitFunctionCall(KviKvsTreeNode * pNode, KviKvsCoreFunctionExecRoutine * pRoutine, unsigned int uParams)
+{
+	unsigned int uAddr = emit(KviKvsBytecodeProgram::CallFunction, pNode, uParams);
+	m_pProgram->m_Code[uAddr].u.pFunction = pRoutine;
+}
+
+void KviKvsBytecodeCompiler::emitCommandCall(KviKvsTreeNode * pNode, KviKvsCoreSimpleCommandExecRoutine * pRoutine, KviKvsTreeNodeSwitchList * pSwitches, unsigned int uParams)
+{
+	unsigned int uAddr = emit(KviKvsBytecodeProgram::CallCommand, pNode, uParams);
+	m_pProgram->m_Code[uAddr].u.pCommand = pRoutine;
+	m_pProgram->m_Code[uAddr].pSwitches = pSwitches;
+}
+
+void KviKvsBytecodeCompiler::emitFallback(KviKvsTreeNodeInstruction * pNode)
+{
+	emit(KviKvsBytecodeProgram::Execute, pNode);
+}
+
+void KviKvsBytecodeCompiler::emitFallback(KviKvsTreeNodeData * pNode)
+{
+	emit(KviKvsBytecodeProgram::Evaluate, pNode);
+}
+
+void KviKvsBytecodeCompiler::setJumpTarget(unsigned int uJump, unsigned int uTarget)
+{
+	m_pProgram->m_Code[uJump].iArg = uTarget;
+}
+
+void KviKvsBytecodeCompiler::addLoop(unsigned int uBegin, unsigned int uEnd, unsigned int uBreak, KviKvsBytecodeLoop::ContinueAction eContinue, unsigned int uContinue)
+{
+	if(uBegin == uEnd)
+		return; // nothing can fail in there
+
+	KviKvsBytecodeLoop l;
+	l.uBegin = uBegin;
+	l.uEnd = uEnd;
+	l.uBreak = uBreak;
+	l.eContinue = eContinue;
+	l.uContinue = uContinue;
+	m_pProgram->m_Loops.push_back(l);
+}
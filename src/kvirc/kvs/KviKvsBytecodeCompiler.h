@@ -0,0 +1,165 @@
+#ifndef _KVI_KVS_BYTECODECOMPILER_H_
+#define _KVI_KVS_BYTECODECOMPILER_H_
+//=============================================================================
+//
+//   File : KviKvsBytecodeCompiler.h
+//   Creation date : Sun Oct 18 2026 14:26:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsBytecodeCompiler.h
+* \brief Lowers a KVS syntax tree to bytecode
+*/
+
+#include "kvi_settings.h"
+#include "KviQString.h"
+#include "KviKvsBytecode.h"
+
+#include <QHash>
+
+class KviKvsTreeNodeInstruction;
+class KviKvsTreeNodeData;
+
+/**
+* \class KviKvsBytecodeCompiler
+* \brief Lowers a KVS syntax tree to a KviKvsBytecodeProgram
+*
+* The nodes emit their own code through compile(): the ones that don't
+* reimplement it are emitted as Execute or Evaluate instructions, which run
+* the node with the tree walker. So every tree can be compiled.
+* The constants and the names of the local variables are pooled.
+*/
+class KVIRC_API KviKvsBytecodeCompiler
+{
+protected:
+	KviKvsBytecodeCompiler();
+
+public:
+	~KviKvsBytecodeCompiler();
+
+protected:
+	KviKvsBytecodeProgram * m_pProgram;
+	int m_iStackDepth;
+	QHash<QString, unsigned int> m_hConstants; // the pooled scalars by type and value
+	QHash<QString, unsigned int> m_hNames;
+
+public:
+	/**
+	* \brief Compiles a syntax tree
+	* \param pTree The tree: it must live longer than the program
+	* \return KviKvsBytecodeProgram *
+	*/
+	static KviKvsBytecodeProgram * compile(KviKvsTreeNodeInstruction * pTree);
+
+	/**
+	* \brief Returns the address of the next instruction
+	* \return unsigned int
+	*/
+	unsigned int address() const { return m_pProgram->m_Code.size(); };
+
+	/**
+	* \brief Emits an instruction
+	* \param iOpCode The opcode
+	* \param pNode The node that the instruction comes from
+	* \param iArg The argument
+	* \return unsigned int The address of the instruction
+	*/
+	unsigned int emit(int iOpCode, KviKvsTreeNode * pNode = nullptr, int iArg = 0);
+
+	/**
+	* \brief Emits the push of a constant, adding it to the pool if needed
+	* \param pValue The value
+	* \return void
+	*/
+	void emitConstant(KviKvsVariant * pValue);
+
+	/**
+	* \brief Emits an instruction that works on a local variable
+	* \param iOpCode The opcode
+	* \param szName The name of the variable
+	* \param pNode The node that the instruction comes from
+	* \return void
+	*/
+	void emitLocal(int iOpCode, const QString & szName, KviKvsTreeNode * pNode);
+
+	/**
+	* \brief Emits the call of a core function
+	*
+	* The parameters must be already on the stack
+	* \param pNode The function call node
+	* \param pRoutine The routine of the function
+	* \param uParams The number of parameters
+	* \return void
+	*/
+	void emitFunctionCall(KviKvsTreeNode * pNode, KviKvsCoreFunctionExecRoutine * pRoutine, unsigned int uParams);
+
+	/**
+	* \brief Emits the call of a core command
+	*
+	* The parameters must be already on the stack
+	* \param pNode The command node
+	* \param pRoutine The routine of the command
+	* \param pSwitches The switches of the command, may be 0
+	* \param uParams The number of parameters
+	* \return void
+	*/
+	void emitCommandCall(KviKvsTreeNode * pNode, KviKvsCoreSimpleCommandExecRoutine * pRoutine, KviKvsTreeNodeSwitchList * pSwitches, unsigned int uParams);
+
+	/**
+	* \brief Emits an instruction that runs the node with the tree walker
+	* \param pNode The node
+	* \return void
+	*/
+	void emitFallback(KviKvsTreeNodeInstruction * pNode);
+
+	/**
+	* \brief Emits an instruction that evaluates the node with the tree walker
+	* \param pNode The node
+	* \return void
+	*/
+	void emitFallback(KviKvsTreeNodeData * pNode);
+
+	/**
+	* \brief Sets the target of a jump emitted before
+	* \param uJump The address of the jump
+	* \param uTarget The target address
+	* \return void
+	*/
+	void setJumpTarget(unsigned int uJump, unsigned int uTarget);
+
+	/**
+	* \brief Adds a loop that handles the failures in a range of instructions
+	*
+	* The inner loops must be added first
+	* \param uBegin The first instruction of the range
+	* \param uEnd The end of the range
+	* \param uBreak The target of break
+	* \param eContinue What continue does
+	* \param uContinue The target of continue
+	* \return void
+	*/
+	void addLoop(unsigned int uBegin, unsigned int uEnd, unsigned int uBreak, KviKvsBytecodeLoop::ContinueAction eContinue, unsigned int uContinue = 0);
+
+protected:
+	static int stackEffect(int iOpCode, int iArg);
+};
+
+#endif //_KVI_KVS_BYTECODECOMPILER_H_
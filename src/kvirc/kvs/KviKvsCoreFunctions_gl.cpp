@@ -914,6 +914,8 @@ namespace KviKvsCoreFunctions
 			Returns an array with the keys of the <hash> parameter.
 			<hash> must be obviously a hash (or eventually an empty variable
 			that is treated as an empty hash).
+			The keys are in the order they were first inserted in the hash:
+			changing the value of a key doesn't move it.
 		@seealso:
 			[cmd]foreach[/cmd]
 	*/
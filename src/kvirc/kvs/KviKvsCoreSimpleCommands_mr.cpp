@@ -621,7 +621,7 @@ namespace KviKvsCoreSimpleCommands
 		@title:
 			parse
 		@syntax:
-			parse [-q] [-e] [-f] [-r] <filename:string> [<parameter1:variant> [<parameter2:variant> [...]]]
+			parse [-q] [-e] [-f] [-r] [-c] <filename:string> [<parameter1:variant> [<parameter2:variant> [...]]]
 		@short:
 			Executes commands from a file
 		@switches:
@@ -644,6 +644,13 @@ namespace KviKvsCoreSimpleCommands
 			Causes the return value of the script to be propagated to the
 			calling context. This allows the usage of ${ } trick to extract
 			this return value. See the examples section for a sample usage.
+			!sw: -c | --compare-engines
+			Runs the script with both the bytecode and the tree engines and
+			prints a warning if the run status, the return value or the local
+			variables differ. This is meant for the benchmark and test scripts
+			that just compute a result: everything else (output, server
+			commands, global variables, objects...) happens twice and the
+			second run sees the global variables changed by the first one.
 		@description:
 			Executes commands from the external file <filename>.[br]
 			<filename> can be an absolute or relative path.[br]
@@ -764,7 +771,11 @@ namespace KviKvsCoreSimpleCommands
 
 		KviKvsExtendedRunTimeData rtd(&szFileName);
 
-		if(!s.run(KVSCSC_pContext->window(), &vList, pRetVal, KviKvsScript::PreserveParams, &rtd))
+		int iRunFlags = KviKvsScript::PreserveParams;
+		if(KVSCSC_pSwitches->find('c', "compare-engines"))
+			iRunFlags |= KviKvsScript::CompareEngines;
+
+		if(!s.run(KVSCSC_pContext->window(), &vList, pRetVal, iRunFlags, &rtd))
 		{
 			if(KVSCSC_pSwitches->find('f', "fail-on-error"))
 				return false;
@@ -24,16 +24,21 @@
 
 #include "KviKvsHash.h"
 
+// KVS runs only in the GUI thread
+static kvs_uint_t g_uNextKvsHashGeneration = 0;
+
 KviKvsHash::KviKvsHash()
 {
 	m_pDict = new KviPointerHashTable<QString, KviKvsVariant>(17, false);
 	m_pDict->setAutoDelete(true);
+	changed();
 }
 
 KviKvsHash::KviKvsHash(const KviKvsHash & hash)
 {
 	m_pDict = new KviPointerHashTable<QString, KviKvsVariant>();
 	m_pDict->setAutoDelete(true);
+	changed();
 	KviPointerHashTableIterator<QString, KviKvsVariant> it(*(hash.m_pDict));
 	while(it.current())
 	{
@@ -63,14 +68,22 @@ KviKvsHash::~KviKvsHash()
 // It took me a whole day to figure this out.
 //
 
+void KviKvsHash::changed()
+{
+	m_uGeneration = ++g_uNextKvsHashGeneration;
+}
+
 void KviKvsHash::unset(const QString & szKey)
 {
-	m_pDict->remove(szKey);
+	if(m_pDict->remove(szKey))
+		changed();
 }
 
 void KviKvsHash::set(const QString & szKey, KviKvsVariant * pVal)
 {
+	// this may delete a previous value
 	m_pDict->replace(szKey, pVal);
+	changed();
 }
 
 KviKvsVariant * KviKvsHash::find(const QString & szKey) const
@@ -86,6 +99,7 @@ bool KviKvsHash::isEmpty() const
 void KviKvsHash::clear()
 {
 	m_pDict->clear();
+	changed();
 }
 
 const KviPointerHashTable<QString, KviKvsVariant> * KviKvsHash::dict()
@@ -146,5 +160,6 @@ KviKvsVariant * KviKvsHash::get(const QString & szKey)
 		return pVariant;
 	pVariant = new KviKvsVariant();
 	m_pDict->replace(szKey, pVariant);
+	changed();
 	return pVariant;
 }
@@ -137,8 +137,22 @@ public:
 	*/
 	void serialize(QString & szResult);
 
+	/**
+	* \brief Returns the generation of the hash
+	*
+	* The generation changes whenever an element is added to or removed from
+	* the hash and it is unique across all the hashes: as long as it is
+	* unchanged any element pointer obtained from this hash stays valid
+	* and any failed lookup would still fail.
+	* \return kvs_uint_t
+	*/
+	kvs_uint_t generation() const { return m_uGeneration; };
+
 private:
 	KviPointerHashTable<QString, KviKvsVariant> * m_pDict;
+	kvs_uint_t m_uGeneration;
+
+	void changed();
 };
 
 #endif // _KVI_KVS_HASH_H_
@@ -28,11 +28,21 @@
 #include "KviKvsReport.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviKvsTreeNodeInstruction.h"
+#include "KviKvsBytecode.h"
+#include "KviKvsBytecodeCompiler.h"
+#include "KviKvsVirtualMachine.h"
 #include "KviKvsVariantList.h"
+#include "KviKvsHash.h"
+#include "KviKvsArray.h"
 #include "KviKvsKernel.h"
 #include "KviLocale.h"
 #include "KviWindow.h"
 #include "KviApplication.h"
+#include "KviOptions.h"
+
+// The engine forced by executeCompare() on the scripts called by the compared one.
+// Negative when KviOption_uintKvsEngine is used.
+static int g_iKvsEngineOverride = -1;
 
 //#warning "THERE IS SOME MESS WITH m_szBuffer and m_pBuffer : with some script copying we may get errors with negative char indexes!"
 
@@ -49,6 +59,7 @@ KviKvsScript::KviKvsScript(const QString & szName, const QString & szBuffer, Scr
 	m_pData->m_pBuffer = m_pData->m_szBuffer.constData(); // never 0
 	m_pData->m_uLock = 0;
 	m_pData->m_pTree = nullptr;
+	m_pData->m_pProgram = nullptr;
 }
 
 KviKvsScript::KviKvsScript(const QString & szName, const QString & szBuffer, KviKvsTreeNodeInstruction * pPreparsedTree, ScriptType eType)
@@ -64,6 +75,7 @@ KviKvsScript::KviKvsScript(const QString & szName, const QString & szBuffer, Kvi
 	m_pData->m_pBuffer = m_pData->m_szBuffer.constData(); // never 0
 	m_pData->m_uLock = 0;
 	m_pData->m_pTree = pPreparsedTree;
+	m_pData->m_pProgram = nullptr;
 }
 
 KviKvsScript::KviKvsScript(const KviKvsScript & src)
@@ -78,6 +90,9 @@ KviKvsScript::~KviKvsScript()
 	{
 		if(m_pData->m_uLock)
 			qDebug("WARNING: destroying a locked KviKvsScript");
+		// the program refers to the tree nodes
+		if(m_pData->m_pProgram)
+			delete m_pData->m_pProgram;
 		if(m_pData->m_pTree)
 			delete m_pData->m_pTree;
 		delete m_pData;
@@ -135,6 +150,7 @@ void KviKvsScript::detach()
 	d->m_pBuffer = d->m_szBuffer.constData(); // never 0
 	d->m_uLock = 0;
 	d->m_pTree = nullptr;
+	d->m_pProgram = nullptr;
 	m_pData = d;
 }
 
@@ -225,13 +241,13 @@ int KviKvsScript::run(KviKvsRunTimeContext * pContext, int iRunFlags)
 	{
 		bool bMustReEnable = !(pContext->reportingDisabled());
 		pContext->disableReporting();
-		iRet = executeInternal(pContext);
+		iRet = executeInternal(pContext, iRunFlags);
 		if(bMustReEnable)
 			pContext->enableReporting();
 	}
 	else
 	{
-		iRet = executeInternal(pContext);
+		iRet = executeInternal(pContext, iRunFlags);
 	}
 
 	return iRet;
@@ -257,9 +273,12 @@ bool KviKvsScript::parse(KviWindow * pOutput, int iRunFlags)
 				qDebug("WARNING: trying to reparse a locked KviKvsScript!");
 				return false;
 			}
+			if(m_pData->m_pProgram)
+				delete m_pData->m_pProgram;
 			if(m_pData->m_pTree)
 				delete m_pData->m_pTree;
 
+			m_pData->m_pProgram = nullptr;
 			m_pData->m_pTree = nullptr;
 		}
 	} // else there is no tree at all, nobody can be locked inside
@@ -292,14 +311,11 @@ bool KviKvsScript::parse(KviWindow * pOutput, int iRunFlags)
 	return !p.error();
 }
 
-int KviKvsScript::executeInternal(KviKvsRunTimeContext * pContext)
+int KviKvsScript::runStatus(KviKvsRunTimeContext * pContext, bool bResult)
 {
-	// lock this script
-	m_pData->m_uLock++;
-
 	int iRunStatus = Success;
 
-	if(!m_pData->m_pTree->execute(pContext))
+	if(!bResult)
 	{
 		if(pContext->error())
 			iRunStatus = Error;
@@ -311,12 +327,199 @@ int KviKvsScript::executeInternal(KviKvsRunTimeContext * pContext)
 		}
 	}
 
+	return iRunStatus;
+}
+
+int KviKvsScript::executeInternal(KviKvsRunTimeContext * pContext, int iRunFlags)
+{
+	// lock this script
+	m_pData->m_uLock++;
+
+	unsigned int uEngine = (g_iKvsEngineOverride >= 0) ? g_iKvsEngineOverride : KVI_OPTION_UINT(KviOption_uintKvsEngine);
+
+	int iRunStatus;
+	if(iRunFlags & CompareEngines)
+		iRunStatus = executeCompare(pContext);
+	else
+		iRunStatus = runStatus(pContext, executeWithEngine(pContext, uEngine));
+
 	// we can't block any longer: unlock
 	m_pData->m_uLock--;
 
 	return iRunStatus;
 }
 
+bool KviKvsScript::executeWithEngine(KviKvsRunTimeContext * pContext, unsigned int uEngine)
+{
+	if(uEngine != KVI_KVS_ENGINE_BYTECODE)
+		return m_pData->m_pTree->execute(pContext);
+
+	// the tree doesn't change while it exists: compile it once
+	if(!m_pData->m_pProgram)
+		m_pData->m_pProgram = KviKvsBytecodeCompiler::compile(m_pData->m_pTree);
+
+	return KviKvsVirtualMachine::execute(m_pData->m_pProgram, pContext);
+}
+
+static void script_deep_copy(const KviKvsVariant * pSrc, KviKvsVariant * pDst);
+
+static void script_deep_copy_hash(KviKvsHash * pSrc, KviKvsHash * pDst)
+{
+	KviPointerHashTableIterator<QString, KviKvsVariant> it(*(pSrc->dict()));
+	while(KviKvsVariant * v = it.current())
+	{
+		KviKvsVariant * pCopy = new KviKvsVariant();
+		script_deep_copy(v, pCopy);
+		pDst->set(it.currentKey(), pCopy);
+		++it;
+	}
+}
+
+static void script_deep_copy(const KviKvsVariant * pSrc, KviKvsVariant * pDst)
+{
+	// the arrays and the hashes are shared by the shallow copies
+	if(pSrc->isArray())
+	{
+		KviKvsArray * pSrcArray = pSrc->array();
+		KviKvsArray * pArray = new KviKvsArray();
+		for(kvs_uint_t u = 0; u < pSrcArray->size(); u++)
+		{
+			if(KviKvsVariant * v = pSrcArray->at(u))
+			{
+				KviKvsVariant * pCopy = new KviKvsVariant();
+				script_deep_copy(v, pCopy);
+				pArray->set(u, pCopy);
+			}
+		}
+		pDst->setArray(pArray);
+	}
+	else if(pSrc->isHash())
+	{
+		KviKvsHash * pHash = new KviKvsHash();
+		script_deep_copy_hash(pSrc->hash(), pHash);
+		pDst->setHash(pHash);
+	}
+	else
+	{
+		pDst->copyFrom(pSrc);
+	}
+}
+
+static bool script_variants_equal(const KviKvsVariant * v1, const KviKvsVariant * v2);
+
+static bool script_hashes_equal(KviKvsHash * pHash1, KviKvsHash * pHash2)
+{
+	if(pHash1->size() != pHash2->size())
+		return false;
+	KviPointerHashTableIterator<QString, KviKvsVariant> it(*(pHash1->dict()));
+	while(KviKvsVariant * v = it.current())
+	{
+		KviKvsVariant * v2 = pHash2->find(it.currentKey());
+		if(!v2)
+			return false;
+		if(!script_variants_equal(v, v2))
+			return false;
+		++it;
+	}
+	return true;
+}
+
+static bool script_variants_equal(const KviKvsVariant * v1, const KviKvsVariant * v2)
+{
+	if(v1->isArray() || v2->isArray())
+	{
+		if(!(v1->isArray() && v2->isArray()))
+			return false;
+		KviKvsArray * a1 = v1->array();
+		KviKvsArray * a2 = v2->array();
+		if(a1->size() != a2->size())
+			return false;
+		for(kvs_uint_t u = 0; u < a1->size(); u++)
+		{
+			KviKvsVariant * e1 = a1->at(u);
+			KviKvsVariant * e2 = a2->at(u);
+			if(!e1 || !e2)
+			{
+				if(e1 != e2)
+					return false;
+				continue;
+			}
+			if(!script_variants_equal(e1, e2))
+				return false;
+		}
+		return true;
+	}
+
+	if(v1->isHash() || v2->isHash())
+	{
+		if(!(v1->isHash() && v2->isHash()))
+			return false;
+		return script_hashes_equal(v1->hash(), v2->hash());
+	}
+
+	if(v1->isHObject() || v2->isHObject())
+		return v1->isHObject() && v2->isHObject() && (v1->hobject() == v2->hobject());
+
+	// the scalars must have the same type and value
+	KviKvsVariant c1(*v1);
+	KviKvsVariant c2(*v2);
+	if(c1.type() != c2.type())
+		return false;
+	QString sz1, sz2;
+	c1.serialize(sz1);
+	c2.serialize(sz2);
+	return sz1 == sz2;
+}
+
+int KviKvsScript::executeCompare(KviKvsRunTimeContext * pContext)
+{
+	KviKvsHash * pLocals = pContext->m_pLocalVariables;
+	KviKvsVariant * pRetVal = pContext->m_pReturnValue;
+	unsigned int uFlags = pContext->m_uRunTimeFlags;
+	bool bError = pContext->m_bError;
+
+	KviKvsHash * pVmLocals = new KviKvsHash();
+	script_deep_copy_hash(pLocals, pVmLocals);
+	KviKvsVariant vmRetVal;
+	script_deep_copy(pRetVal, &vmRetVal);
+
+	int iSavedOverride = g_iKvsEngineOverride;
+
+	// the errors are reported by the tree run
+	pContext->m_pLocalVariables = pVmLocals;
+	pContext->m_pReturnValue = &vmRetVal;
+	pContext->disableReporting();
+	g_iKvsEngineOverride = KVI_KVS_ENGINE_BYTECODE;
+	int iVmStatus = runStatus(pContext, executeWithEngine(pContext, KVI_KVS_ENGINE_BYTECODE));
+
+	pContext->m_pLocalVariables = pLocals;
+	pContext->m_pReturnValue = pRetVal;
+	pContext->m_uRunTimeFlags = uFlags;
+	pContext->m_bError = bError;
+	g_iKvsEngineOverride = KVI_KVS_ENGINE_TREE;
+	int iTreeStatus = runStatus(pContext, executeWithEngine(pContext, KVI_KVS_ENGINE_TREE));
+
+	g_iKvsEngineOverride = iSavedOverride;
+
+	QString szWhat;
+	if(iVmStatus != iTreeStatus)
+		szWhat = __tr2qs_ctx("run status", "kvs");
+	else if(!script_variants_equal(&vmRetVal, pRetVal))
+		szWhat = __tr2qs_ctx("return value", "kvs");
+	else if(!script_hashes_equal(pVmLocals, pContext->m_pLocalVariables))
+		szWhat = __tr2qs_ctx("local variables", "kvs");
+
+	delete pVmLocals;
+
+	if(!szWhat.isEmpty())
+	{
+		pContext->window()->output(KVI_OUT_SYSTEMWARNING, __tr2qs_ctx("The bytecode and the tree engines disagree on the %Q of the script '%Q'", "kvs"), &szWhat, &(m_pData->m_szName));
+		qDebug("KVS engine comparison failed on the %s of the script %s", szWhat.toUtf8().data(), m_pData->m_szName.toUtf8().data());
+	}
+
+	return iTreeStatus;
+}
+
 int KviKvsScript::execute(KviWindow * pWnd, KviKvsVariantList * pParams, KviKvsVariant * pRetVal, int iRunFlags, KviKvsExtendedRunTimeData * pExtData)
 {
 	bool bDeleteParams = !(iRunFlags & PreserveParams);
@@ -352,7 +555,7 @@ int KviKvsScript::execute(KviWindow * pWnd, KviKvsVariantList * pParams, KviKvsV
 	if(iRunFlags & Quiet)
 		ctx.disableReporting();
 
-	int iRunStatus = executeInternal(&ctx);
+	int iRunStatus = executeInternal(&ctx, iRunFlags);
 
 	// don't forget to delete the params
 	if(bDeleteParams)
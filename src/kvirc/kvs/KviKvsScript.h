@@ -39,6 +39,7 @@
 #include "KviHeapObject.h"
 
 class KviKvsTreeNodeInstruction;
+class KviKvsBytecodeProgram;
 class KviKvsExtendedRunTimeData;
 class KviKvsScriptData;
 class KviKvsReport;
@@ -96,7 +97,10 @@ public:
 		AssumeLocals = 2, /**< Assume that the variables are local unless explicitly declared (flag used only for parse()) */
 		// FIXME: This should be a global option, eventually
 		Pedantic = 4, /**< Be more pedantic: spit more warnings and sometimes more errors */
-		Quiet = 8     /**< Don't print any errors */
+		Quiet = 8,    /**< Don't print any errors */
+		// Only for the benchmark and test scripts: the side effects that are not local to the script
+		// (output, server commands, global variables, objects...) happen twice
+		CompareEngines = 16 /**< Run the script with both engines and compare the results (only execute() and run()) */
 	};
 
 public:
@@ -293,9 +297,44 @@ protected:
 	* Returns 0 (KviKvsScript::RunFailure) on error
 	* Returns a nonzero combination of RunStatus flags on success
 	* \param pContext The context where the script is bound to
+	* \param iRunFlags A combination of run flags: only CompareEngines matters here
 	* \return int
 	*/
-	int executeInternal(KviKvsRunTimeContext * pContext);
+	int executeInternal(KviKvsRunTimeContext * pContext, int iRunFlags = 0);
+
+	/**
+	* \brief Runs the script with the engine selected by KviOption_uintKvsEngine
+	*
+	* Same as the tree execute(): false means an error or halt, return and similar
+	* \param pContext The context where the script is bound to
+	* \param uEngine The engine, one of KVI_KVS_ENGINE_*
+	* \return bool
+	*/
+	bool executeWithEngine(KviKvsRunTimeContext * pContext, unsigned int uEngine);
+
+	/**
+	* \brief Runs the script with both the engines and compares the results
+	*
+	* The bytecode runs first on copies of the local variables and of the
+	* return value, then the tree runs on the real ones. The status, the
+	* return value and the local variables must be the same: a warning is
+	* printed otherwise. The results of the tree are kept.
+	* Everything else is shared: the tree run sees the global variables
+	* already changed by the bytecode run and all the side effects happen
+	* twice. This is for the scripts that compute a result, like the ones
+	* of scripts/kvsbench, and it is used only with the CompareEngines flag.
+	* \param pContext The context where the script is bound to
+	* \return int The run status of the tree
+	*/
+	int executeCompare(KviKvsRunTimeContext * pContext);
+
+	/**
+	* \brief Returns the run status for the result of a run
+	* \param pContext The context of the run
+	* \param bResult The value returned by the engine
+	* \return int
+	*/
+	static int runStatus(KviKvsRunTimeContext * pContext, bool bResult);
 
 	/**
 	* \brief Returns the data of the script
@@ -328,6 +367,7 @@ protected:
 	KviKvsScript::ScriptType m_eType; // the type of the code in m_szBuffer
 
 	KviKvsTreeNodeInstruction * m_pTree; // syntax tree
+	KviKvsBytecodeProgram * m_pProgram;  // compiled from m_pTree by the first bytecode run, may be 0
 	unsigned int m_uLock;                // this is increased while the script is being executed
 };
 
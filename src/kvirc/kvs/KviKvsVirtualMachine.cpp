@@ -0,0 +1,743 @@
+//=============================================================================
+//
+//   File : KviKvsVirtualMachine.cpp
+//   Creation date : Sun Oct 18 2026 15:02:47 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsVirtualMachine.h"
+#include "KviKvsBytecode.h"
+#include "KviKvsRunTimeContext.h"
+#include "KviKvsTreeNodeInstruction.h"
+#include "KviKvsTreeNodeData.h"
+#include "KviKvsTreeNodeSwitchList.h"
+#include "KviKvsHash.h"
+#include "KviKvsSwitchList.h"
+#include "KviKvsVariant.h"
+#include "KviKvsVariantList.h"
+#include "KviLocale.h"
+
+#include <math.h>
+
+// The programs that need at most this many stack slots keep them on the C stack
+#define KVI_KVS_VM_INLINE_STACK_SIZE 32
+
+// GCC and clang can take the address of a label: each handler jumps
+// straight to the next one. The other compilers go through a switch.
+#if defined(__GNUC__)
+#define KVI_KVS_VM_DIRECT_THREADING
+#endif
+
+#ifdef KVI_KVS_VM_DIRECT_THREADING
+#define VM_OP(_name) op_##_name:
+#define VM_NEXT() goto *(pIns->pHandler)
+#define KVI_KVS_VM_HANDLER(_name) &&op_##_name,
+#else
+#define VM_OP(_name) case KviKvsBytecodeProgram::_name:
+#define VM_NEXT() goto vm_dispatch
+#endif
+
+// The local variables are looked up as KviKvsTreeNodeLocalVariable does,
+// with the cache in the instruction.
+static inline KviKvsVariant * vm_find_local(KviKvsBytecodeInstruction * pIns, KviKvsHash * pHash, const QString & szName)
+{
+	if((pHash == pIns->pCachedHash) && (pHash->generation() == pIns->uCachedGeneration))
+		return pIns->pCachedVariable;
+
+	pIns->pCachedVariable = pHash->find(szName);
+	pIns->pCachedHash = pHash;
+	pIns->uCachedGeneration = pHash->generation();
+	return pIns->pCachedVariable;
+}
+
+static inline KviKvsVariant * vm_get_local(KviKvsBytecodeInstruction * pIns, KviKvsHash * pHash, const QString & szName)
+{
+	KviKvsVariant * v = vm_find_local(pIns, pHash, szName);
+	if(!v)
+	{
+		v = pHash->get(szName);
+		pIns->pCachedVariable = v;
+		pIns->uCachedGeneration = pHash->generation();
+	}
+	return v;
+}
+
+// same as KviKvsHashElement does on destruction
+static inline void vm_release_local(KviKvsHash * pHash, const QString & szName, KviKvsVariant * v)
+{
+	if(v->isEmpty())
+		pHash->unset(szName);
+}
+
+static bool vm_add_delta(KviKvsVariant * pVariable, kvs_int_t iDelta)
+{
+	kvs_int_t iVal;
+	if(pVariable->asInteger(iVal))
+	{
+		pVariable->setInteger(iVal + iDelta);
+		return true;
+	}
+
+	kvs_real_t dVal;
+	if(pVariable->asReal(dVal))
+	{
+		pVariable->setReal(dVal + iDelta);
+		return true;
+	}
+
+	return false;
+}
+
+bool KviKvsVirtualMachine::execute(KviKvsBytecodeProgram * pProgram, KviKvsRunTimeContext * c)
+{
+	if(pProgram->m_uStackSize <= KVI_KVS_VM_INLINE_STACK_SIZE)
+	{
+		KviKvsVariant aStack[KVI_KVS_VM_INLINE_STACK_SIZE];
+		KviKvsNumber aNumbers[KVI_KVS_VM_INLINE_STACK_SIZE];
+		return run(pProgram, c, aStack, aNumbers);
+	}
+
+	KviKvsVariant * pStack = new KviKvsVariant[pProgram->m_uStackSize];
+	KviKvsNumber * pNumbers = new KviKvsNumber[pProgram->m_uStackSize];
+	bool bRet = run(pProgram, c, pStack, pNumbers);
+	delete[] pStack;
+	delete[] pNumbers;
+	return bRet;
+}
+
+// The operands of the arithmetic operators: the left one has been
+// converted by ToNumber, the right one is converted here.
+#define VM_NUMERIC_OPERANDS                                                                     \
+	KviKvsVariant * pLeft = pTop - 2;                                                           \
+	const KviKvsNumber & nLeft = pNumbers[pLeft - pStack];                                      \
+	KviKvsNumber nRight;                                                                        \
+	if(!pTop[-1].asNumber(nRight))                                                              \
+	{                                                                                           \
+		c->error(pIns->pNode, __tr2qs_ctx("Right operand didn't evaluate to a number", "kvs")); \
+		goto vm_fail;                                                                           \
+	}                                                                                           \
+	pTop--;
+
+#define VM_INTEGER_OPERATOR(_name, _op)                                                 \
+	VM_OP(_name)                                                                        \
+	{                                                                                   \
+		VM_NUMERIC_OPERANDS                                                             \
+		int iLeft = nLeft.isInteger() ? nLeft.integer() : (kvs_int_t)(nLeft.real());    \
+		int iRight = nRight.isInteger() ? nRight.integer() : (kvs_int_t)(nRight.real()); \
+		pLeft->setInteger(iLeft _op iRight);                                            \
+	}                                                                                   \
+	pIns++;                                                                             \
+	VM_NEXT();
+
+#define VM_COMPARISON_OPERATOR(_name, _cond)           \
+	VM_OP(_name)                                       \
+	{                                                  \
+		pTop--;                                        \
+		int iCmp = pTop[-1].compare(pTop, true);       \
+		pTop[-1].setBoolean(_cond);                    \
+	}                                                  \
+	pIns++;                                            \
+	VM_NEXT();
+
+bool KviKvsVirtualMachine::run(KviKvsBytecodeProgram * pProgram, KviKvsRunTimeContext * c, KviKvsVariant * pStack, KviKvsNumber * pNumbers)
+{
+	KviKvsBytecodeInstruction * pCode = pProgram->m_Code.data();
+	KviKvsVariant ** pConstants = pProgram->m_Constants.data();
+	const QString * pNames = pProgram->m_Names.data();
+
+#ifdef KVI_KVS_VM_DIRECT_THREADING
+	if(!pProgram->m_bThreaded)
+	{
+		static void * const aHandlers[KviKvsBytecodeProgram::OpCodeCount] = {
+			KVI_KVS_BYTECODE_OPCODES(KVI_KVS_VM_HANDLER)
+		};
+
+		for(auto & i : pProgram->m_Code)
+			i.pHandler = aHandlers[i.iOpCode];
+		pProgram->m_bThreaded = true;
+	}
+#endif
+
+	KviKvsBytecodeInstruction * pIns = pCode;
+	KviKvsVariant * pTop = pStack; // the first free slot
+
+#ifdef KVI_KVS_VM_DIRECT_THREADING
+	VM_NEXT();
+#else
+vm_dispatch:
+	switch(pIns->iOpCode)
+	{
+#endif
+
+	VM_OP(PushConstant)
+	{
+		pTop->copyFrom(pConstants[pIns->iArg]);
+		pTop++;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(PushLocal)
+	{
+		KviKvsVariant * v = vm_find_local(pIns, c->localVariables(), pNames[pIns->iArg]);
+		if(v)
+			pTop->copyFrom(v);
+		else
+			pTop->setNothing();
+		pTop++;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Evaluate)
+	{
+		// the tree nodes expect an empty buffer
+		pTop->setNothing();
+		if(!static_cast<KviKvsTreeNodeData *>(pIns->pNode)->evaluateReadOnly(c, pTop))
+			goto vm_fail;
+		pTop++;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Concat)
+	{
+		KviKvsVariant * pBase = pTop - pIns->iArg;
+		QString * pS = new QString();
+		for(KviKvsVariant * p = pBase; p < pTop; p++)
+			p->appendAsString(*pS);
+		pBase->setString(pS);
+		pTop = pBase + 1;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(ToNumber)
+	{
+		if(!pTop[-1].asNumber(pNumbers[pTop - pStack - 1]))
+		{
+			c->error(pIns->pNode, __tr2qs_ctx("Left operand didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Negate)
+	{
+		KviKvsNumber n;
+		if(!pTop[-1].asNumber(n))
+		{
+			c->error(pIns->pNode, __tr2qs_ctx("Operand of unary operator didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+		if(n.isReal())
+			pTop[-1].setReal(-n.real());
+		else
+			pTop[-1].setInteger(-n.integer());
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(BitwiseNot)
+	{
+		KviKvsNumber n;
+		if(!pTop[-1].asNumber(n))
+		{
+			c->error(pIns->pNode, __tr2qs_ctx("Operand of unary operator didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+		if(n.isReal())
+			pTop[-1].setInteger(~(int)(n.real()));
+		else
+			pTop[-1].setInteger(~n.integer());
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(LogicalNot)
+	{
+		pTop[-1].setBoolean(!pTop[-1].asBoolean());
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Sum)
+	{
+		VM_NUMERIC_OPERANDS
+		if(nLeft.isInteger())
+		{
+			if(nRight.isInteger())
+				pLeft->setInteger(nLeft.integer() + nRight.integer());
+			else
+				pLeft->setReal(nLeft.integer() + nRight.real());
+		}
+		else
+		{
+			if(nRight.isInteger())
+				pLeft->setReal(nLeft.real() + nRight.integer());
+			else
+				pLeft->setReal(nLeft.real() + nRight.real());
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Subtraction)
+	{
+		VM_NUMERIC_OPERANDS
+		if(nLeft.isInteger())
+		{
+			if(nRight.isInteger())
+				pLeft->setInteger(nLeft.integer() - nRight.integer());
+			else
+				pLeft->setReal(((kvs_real_t)(nLeft.integer())) - nRight.real());
+		}
+		else
+		{
+			if(nRight.isInteger())
+				pLeft->setReal(nLeft.real() - ((kvs_real_t)(nRight.integer())));
+			else
+				pLeft->setReal(nLeft.real() - nRight.real());
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Multiplication)
+	{
+		VM_NUMERIC_OPERANDS
+		if(nLeft.isInteger())
+		{
+			if(nRight.isInteger())
+				pLeft->setInteger(nLeft.integer() * nRight.integer());
+			else
+				pLeft->setReal(((kvs_real_t)(nLeft.integer())) * nRight.real());
+		}
+		else
+		{
+			if(nRight.isInteger())
+				pLeft->setReal(nLeft.real() * ((kvs_real_t)(nRight.integer())));
+			else
+				pLeft->setReal(nLeft.real() * nRight.real());
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Division)
+	{
+		VM_NUMERIC_OPERANDS
+		if(nRight.isInteger())
+		{
+			if(nRight.integer() == 0)
+			{
+				c->error(pIns->pNode, __tr2qs_ctx("Division by zero", "kvs"));
+				goto vm_fail;
+			}
+			if(nLeft.isInteger())
+				pLeft->setInteger(nLeft.integer() / nRight.integer());
+			else
+				pLeft->setReal(nLeft.real() / ((kvs_real_t)(nRight.integer())));
+		}
+		else
+		{
+			if(nRight.real() == 0.0)
+			{
+				c->error(pIns->pNode, __tr2qs_ctx("Division by zero", "kvs"));
+				goto vm_fail;
+			}
+			if(nLeft.isInteger())
+				pLeft->setReal(((kvs_real_t)(nLeft.integer())) / nRight.real());
+			else
+				pLeft->setReal(nLeft.real() / nRight.real());
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Modulus)
+	{
+		VM_NUMERIC_OPERANDS
+		if(nRight.isInteger())
+		{
+			if(nRight.integer() == 0)
+			{
+				c->error(pIns->pNode, __tr2qs_ctx("Division by zero", "kvs"));
+				goto vm_fail;
+			}
+			if(nLeft.isInteger())
+				pLeft->setInteger(nLeft.integer() % nRight.integer());
+			else
+				pLeft->setReal(fmod(nLeft.real(), ((kvs_real_t)(nRight.integer()))));
+		}
+		else
+		{
+			if(nRight.real() == 0.0)
+			{
+				c->error(pIns->pNode, __tr2qs_ctx("Division by zero", "kvs"));
+				goto vm_fail;
+			}
+			if(nLeft.isInteger())
+				pLeft->setReal(fmod(((kvs_real_t)(nLeft.integer())), nRight.real()));
+			else
+				pLeft->setReal(fmod(nLeft.real(), nRight.real()));
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_INTEGER_OPERATOR(BitwiseAnd, &)
+	VM_INTEGER_OPERATOR(BitwiseOr, |)
+	VM_INTEGER_OPERATOR(BitwiseXor, ^)
+	VM_INTEGER_OPERATOR(ShiftLeft, <<)
+	VM_INTEGER_OPERATOR(ShiftRight, >>)
+
+	// same as the tree nodes: compare() returns the opposite sign
+	VM_COMPARISON_OPERATOR(LowerThan, iCmp > 0)
+	VM_COMPARISON_OPERATOR(GreaterThan, iCmp < 0)
+	VM_COMPARISON_OPERATOR(LowerOrEqualTo, iCmp >= 0)
+	VM_COMPARISON_OPERATOR(GreaterOrEqualTo, iCmp <= 0)
+	VM_COMPARISON_OPERATOR(EqualTo, iCmp == 0)
+	VM_COMPARISON_OPERATOR(NotEqualTo, iCmp != 0)
+
+	VM_OP(Xor)
+	{
+		pTop--;
+		pTop[-1].setBoolean(pTop[-1].asBoolean() != pTop->asBoolean());
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(AndJump)
+	{
+		if(!pTop[-1].asBoolean())
+		{
+			pTop[-1].setBoolean(false);
+			pIns = pCode + pIns->iArg;
+			VM_NEXT();
+		}
+		pTop--;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(OrJump)
+	{
+		if(pTop[-1].asBoolean())
+		{
+			pTop[-1].setBoolean(true);
+			pIns = pCode + pIns->iArg;
+			VM_NEXT();
+		}
+		pTop--;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(ToBoolean)
+	{
+		pTop[-1].setBoolean(pTop[-1].asBoolean());
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(CallFunction)
+	{
+		KviKvsVariant * pBase = pTop - pIns->iArg;
+		KviKvsVariantList l;
+		for(KviKvsVariant * p = pBase; p < pTop; p++)
+		{
+			KviKvsVariant * v = new KviKvsVariant();
+			v->takeFrom(p);
+			l.append(v);
+		}
+		pTop = pBase + 1;
+		pBase->setNothing();
+		c->setDefaultReportLocation(pIns->pNode);
+		if(!pIns->u.pFunction->proc(c, &l, pBase))
+			goto vm_fail;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(CallCommand)
+	{
+		KviKvsVariant * pBase = pTop - pIns->iArg;
+		KviKvsVariantList l;
+		for(KviKvsVariant * p = pBase; p < pTop; p++)
+		{
+			KviKvsVariant * v = new KviKvsVariant();
+			v->takeFrom(p);
+			l.append(v);
+		}
+		pTop = pBase;
+		KviKvsSwitchList swl;
+		if(pIns->pSwitches)
+		{
+			if(!pIns->pSwitches->evaluate(c, &swl))
+				goto vm_fail;
+		}
+		c->setDefaultReportLocation(pIns->pNode);
+		if(!pIns->u.pCommand->proc(c, &l, &swl))
+			goto vm_fail;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Execute)
+	{
+		if(!static_cast<KviKvsTreeNodeInstruction *>(pIns->pNode)->execute(c))
+			goto vm_fail;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(StoreLocal)
+	{
+		pTop--;
+		KviKvsHash * pHash = c->localVariables();
+		KviKvsVariant * v = vm_get_local(pIns, pHash, pNames[pIns->iArg]);
+		v->takeFrom(pTop);
+		vm_release_local(pHash, pNames[pIns->iArg], v);
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(StoreData)
+	{
+		pTop--;
+		KviKvsRWEvaluationResult * pTarget = static_cast<KviKvsTreeNodeData *>(pIns->pNode)->evaluateReadWrite(c);
+		if(!pTarget)
+			goto vm_fail;
+		pTarget->result()->takeFrom(pTop);
+		delete pTarget;
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(IncrementLocal)
+	{
+		KviKvsHash * pHash = c->localVariables();
+		KviKvsVariant * v = vm_get_local(pIns, pHash, pNames[pIns->iArg]);
+		if(!vm_add_delta(v, 1))
+		{
+			vm_release_local(pHash, pNames[pIns->iArg], v);
+			c->error(pIns->pNode, __tr2qs_ctx("The target variable didn't evaluate to an integer or real value", "kvs"));
+			goto vm_fail;
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(DecrementLocal)
+	{
+		KviKvsHash * pHash = c->localVariables();
+		KviKvsVariant * v = vm_get_local(pIns, pHash, pNames[pIns->iArg]);
+		if(!vm_add_delta(v, -1))
+		{
+			vm_release_local(pHash, pNames[pIns->iArg], v);
+			c->error(pIns->pNode, __tr2qs_ctx("The target variable didn't evaluate to an integer or real value", "kvs"));
+			goto vm_fail;
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(SelfSumLocal)
+	{
+		pTop--;
+		KviKvsNumber nRight;
+		if(!pTop->asNumber(nRight))
+		{
+			c->error(pIns->pNode, __tr2qs_ctx("The right side of operator '+=' didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+		KviKvsHash * pHash = c->localVariables();
+		KviKvsVariant * v = vm_get_local(pIns, pHash, pNames[pIns->iArg]);
+		KviKvsNumber nLeft;
+		if(!v->asNumber(nLeft))
+		{
+			vm_release_local(pHash, pNames[pIns->iArg], v);
+			c->error(pIns->pNode, __tr2qs_ctx("The left side of operator '+=' didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+		if(nRight.isInteger())
+		{
+			if(nLeft.isInteger())
+				v->setInteger(nLeft.integer() + nRight.integer());
+			else
+				v->setReal(nLeft.real() + (kvs_real_t)(nRight.integer()));
+		}
+		else
+		{
+			if(nLeft.isInteger())
+				v->setReal(((kvs_real_t)(nLeft.integer())) + nRight.real());
+			else
+				v->setReal(nLeft.real() + nRight.real());
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(SelfSubtractionLocal)
+	{
+		pTop--;
+		KviKvsNumber nRight;
+		if(!pTop->asNumber(nRight))
+		{
+			c->error(pIns->pNode, __tr2qs_ctx("The right side of operator '-=' didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+		KviKvsHash * pHash = c->localVariables();
+		KviKvsVariant * v = vm_get_local(pIns, pHash, pNames[pIns->iArg]);
+		KviKvsNumber nLeft;
+		if(!v->asNumber(nLeft))
+		{
+			vm_release_local(pHash, pNames[pIns->iArg], v);
+			c->error(pIns->pNode, __tr2qs_ctx("The left side of operator '-=' didn't evaluate to a number", "kvs"));
+			goto vm_fail;
+		}
+		if(nRight.isInteger())
+		{
+			if(nLeft.isInteger())
+				v->setInteger(nLeft.integer() - nRight.integer());
+			else
+				v->setReal(nLeft.real() - (kvs_real_t)(nRight.integer()));
+		}
+		else
+		{
+			if(nLeft.isInteger())
+				v->setReal(((kvs_real_t)(nLeft.integer())) - nRight.real());
+			else
+				v->setReal(nLeft.real() - nRight.real());
+		}
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(AppendLocal)
+	{
+		pTop--;
+		KviKvsHash * pHash = c->localVariables();
+		KviKvsVariant * v = vm_get_local(pIns, pHash, pNames[pIns->iArg]);
+		QString sz;
+		v->asString(sz);
+		pTop->appendAsString(sz);
+		v->setString(sz);
+		vm_release_local(pHash, pNames[pIns->iArg], v);
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(SetReturnValue)
+	{
+		pTop--;
+		c->returnValue()->takeFrom(pTop);
+	}
+	pIns++;
+	VM_NEXT();
+
+	VM_OP(Jump)
+	{
+		pIns = pCode + pIns->iArg;
+	}
+	VM_NEXT();
+
+	VM_OP(JumpIfFalse)
+	{
+		pTop--;
+		if(pTop->asBoolean())
+			pIns++;
+		else
+			pIns = pCode + pIns->iArg;
+	}
+	VM_NEXT();
+
+	VM_OP(JumpIfTrue)
+	{
+		pTop--;
+		if(pTop->asBoolean())
+			pIns = pCode + pIns->iArg;
+		else
+			pIns++;
+	}
+	VM_NEXT();
+
+	VM_OP(Break)
+	{
+		c->setBreakPending();
+		goto vm_fail;
+	}
+
+	VM_OP(Continue)
+	{
+		c->setContinuePending();
+		goto vm_fail;
+	}
+
+	VM_OP(End)
+	{
+		return true;
+	}
+
+#ifndef KVI_KVS_VM_DIRECT_THREADING
+		default:
+			return false; // not reached
+	}
+#endif
+
+vm_fail:
+	// Same as the loop nodes of the tree do when their body returns false
+	{
+		unsigned int uPc = pIns - pCode;
+		for(auto & l : pProgram->m_Loops)
+		{
+			if((uPc < l.uBegin) || (uPc >= l.uEnd))
+				continue;
+
+			if(c->error())
+				return false;
+
+			if(c->breakPending())
+			{
+				c->handleBreak();
+				pIns = pCode + l.uBreak;
+				pTop = pStack; // the loops are instructions: nothing is on the stack there
+				VM_NEXT();
+			}
+
+			if(c->continuePending())
+			{
+				if(l.eContinue == KviKvsBytecodeLoop::ContinueJump)
+				{
+					c->handleContinue();
+					pIns = pCode + l.uContinue;
+					pTop = pStack;
+					VM_NEXT();
+				}
+				if(l.eContinue == KviKvsBytecodeLoop::ContinueAndFail)
+					c->handleContinue();
+			}
+			// leave it to the enclosing loops
+		}
+	}
+	return false;
+}
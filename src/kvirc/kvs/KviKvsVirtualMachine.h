@@ -0,0 +1,76 @@
+#ifndef _KVI_KVS_VIRTUALMACHINE_H_
+#define _KVI_KVS_VIRTUALMACHINE_H_
+//=============================================================================
+//
+//   File : KviKvsVirtualMachine.h
+//   Creation date : Sun Oct 18 2026 15:02:47 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsVirtualMachine.h
+* \brief The bytecode interpreter of KVS
+*/
+
+#include "kvi_settings.h"
+
+class KviKvsBytecodeProgram;
+class KviKvsRunTimeContext;
+class KviKvsVariant;
+class KviKvsNumber;
+
+//
+// The engines that can run the scripts (KviOption_uintKvsEngine)
+//
+// The tree walker runs the syntax tree directly.
+#define KVI_KVS_ENGINE_TREE 0
+// The syntax tree is compiled to bytecode the first time the script runs.
+// The two engines can be compared with parse -c (KviKvsScript::CompareEngines).
+#define KVI_KVS_ENGINE_BYTECODE 1
+
+/**
+* \class KviKvsVirtualMachine
+* \brief Runs the programs made by KviKvsBytecodeCompiler
+*
+* This is a stack machine. With GCC and clang the dispatch is direct
+* threaded: the first run of a program stores in each instruction the
+* address of its handler and each handler jumps straight to the next one.
+* The instructions that can't be compiled run their tree node, so the
+* results are the same as the tree walker ones.
+*/
+class KVIRC_API KviKvsVirtualMachine
+{
+public:
+	/**
+	* \brief Runs a program
+	*
+	* Same as KviKvsTreeNodeInstruction::execute(): false means an error
+	* or halt, return and similar.
+	* \param pProgram The program
+	* \param c The context
+	* \return bool
+	*/
+	static bool execute(KviKvsBytecodeProgram * pProgram, KviKvsRunTimeContext * c);
+
+protected:
+	static bool run(KviKvsBytecodeProgram * pProgram, KviKvsRunTimeContext * c, KviKvsVariant * pStack, KviKvsNumber * pNumbers);
+};
+
+#endif //_KVI_KVS_VIRTUALMACHINE_H_
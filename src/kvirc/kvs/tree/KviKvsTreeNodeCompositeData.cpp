@@ -24,6 +24,7 @@
 
 #include "KviKvsTreeNodeCompositeData.h"
 #include "KviQString.h"
+#include "KviKvsBytecodeCompiler.h"
 
 #define DEBUGME
 
@@ -81,3 +82,14 @@ void KviKvsTreeNodeCompositeData::dump(const char * prefix)
 		p->dump(tmp.toUtf8().data());
 	}
 }
+
+void KviKvsTreeNodeCompositeData::compile(KviKvsBytecodeCompiler * c)
+{
+	KviPointerListIterator<KviKvsTreeNodeData> it(*m_pSubData);
+	while(KviKvsTreeNodeData * d = it.current())
+	{
+		d->compile(c);
+		++it;
+	}
+	c->emit(KviKvsBytecodeProgram::Concat, this, m_pSubData->count());
+}
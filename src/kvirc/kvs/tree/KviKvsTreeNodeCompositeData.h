@@ -39,6 +39,7 @@ protected:
 
 public:
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 	virtual void contextDescription(QString & szBuffer);
 
 	virtual void dump(const char * prefix);
@@ -23,6 +23,7 @@
 //=============================================================================
 
 #include "KviKvsTreeNodeConstantData.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeConstantData::KviKvsTreeNodeConstantData(const QChar * pLocation, KviKvsVariant * v)
     : KviKvsTreeNodeData(pLocation)
@@ -74,3 +75,8 @@ bool KviKvsTreeNodeConstantData::evaluateReadOnly(KviKvsRunTimeContext *, KviKvs
 	pBuffer->copyFrom(m_pValue);
 	return true;
 }
+
+void KviKvsTreeNodeConstantData::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitConstant(m_pValue);
+}
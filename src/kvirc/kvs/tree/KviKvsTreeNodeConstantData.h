@@ -38,6 +38,7 @@ protected:
 	KviKvsVariant * m_pValue; // literal value of the parameter
 public:
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 	virtual void contextDescription(QString & szBuffer);
 
 	virtual void dump(const char * prefix);
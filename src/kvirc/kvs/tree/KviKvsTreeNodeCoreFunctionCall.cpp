@@ -24,6 +24,7 @@
 
 #include "KviKvsTreeNodeCoreFunctionCall.h"
 #include "KviKvsRunTimeContext.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeCoreFunctionCall::KviKvsTreeNodeCoreFunctionCall(const QChar * pLocation, const QString & szFncName, KviKvsCoreFunctionExecRoutine * r, KviKvsTreeNodeDataList * pParams)
     : KviKvsTreeNodeFunctionCall(pLocation, szFncName, pParams)
@@ -57,3 +58,8 @@ bool KviKvsTreeNodeCoreFunctionCall::evaluateReadOnly(KviKvsRunTimeContext * c,
 	c->setDefaultReportLocation(this);
 	return m_pExecRoutine->proc(c, &l, pBuffer);
 }
+
+void KviKvsTreeNodeCoreFunctionCall::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitFunctionCall(this, m_pExecRoutine, m_pParams->compile(c));
+}
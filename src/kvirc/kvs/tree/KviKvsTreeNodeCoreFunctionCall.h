@@ -45,6 +45,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 #endif //!_KVI_KVS_TREENODE_COREFUNCTIONCALL_H_
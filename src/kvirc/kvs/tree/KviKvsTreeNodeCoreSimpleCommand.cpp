@@ -26,6 +26,7 @@
 #include "KviKvsTreeNodeDataList.h"
 #include "KviKvsTreeNodeSwitchList.h"
 #include "KviKvsRunTimeContext.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeCoreSimpleCommand::KviKvsTreeNodeCoreSimpleCommand(const QChar * pLocation, const QString & szCmdName, KviKvsTreeNodeDataList * params, KviKvsCoreSimpleCommandExecRoutine * r)
     : KviKvsTreeNodeSimpleCommand(pLocation, szCmdName, params)
@@ -66,3 +67,8 @@ bool KviKvsTreeNodeCoreSimpleCommand::execute(KviKvsRunTimeContext * c)
 
 	return m_pExecRoutine->proc(c, &l, &swl);
 }
+
+void KviKvsTreeNodeCoreSimpleCommand::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitCommandCall(this, m_pExecRoutine, m_pSwitches, m_pParams->compile(c));
+}
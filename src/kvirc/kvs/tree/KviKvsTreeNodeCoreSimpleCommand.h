@@ -31,6 +31,7 @@
 
 class KviKvsTreeNodeDataList;
 class KviKvsRunTimeContext;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeCoreSimpleCommand : public KviKvsTreeNodeSimpleCommand
 {
@@ -44,6 +45,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 #endif //!_KVI_KVS_TREENODE_CORESIMPLECOMMAND_H_
@@ -23,6 +23,7 @@
 //=============================================================================
 
 #include "KviKvsTreeNodeData.h"
+#include "KviKvsBytecodeCompiler.h"
 #include "KviLocale.h"
 
 KviKvsTreeNodeData::KviKvsTreeNodeData(const QChar * pLocation)
@@ -43,6 +44,11 @@ void KviKvsTreeNodeData::dump(const char * prefix)
 	qDebug("%s Data", prefix);
 }
 
+void KviKvsTreeNodeData::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitFallback(this);
+}
+
 bool KviKvsTreeNodeData::isReadOnly()
 {
 	return true;
@@ -63,6 +69,11 @@ bool KviKvsTreeNodeData::isFunctionCall()
 	return false;
 }
 
+bool KviKvsTreeNodeData::isLocalVariable()
+{
+	return false;
+}
+
 bool KviKvsTreeNodeData::convertStringConstantToNumeric()
 {
 	return false;
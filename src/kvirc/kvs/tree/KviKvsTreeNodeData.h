@@ -30,6 +30,7 @@
 #include "KviKvsRWEvaluationResult.h"
 
 class KviKvsObject;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeData : public KviKvsTreeNode
 {
@@ -52,10 +53,15 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 
+	// Emits the code that pushes the read-only value on the stack of the virtual machine:
+	// by default it's a call to evaluateReadOnly()
+	virtual void compile(KviKvsBytecodeCompiler * c);
+
 	virtual bool isReadOnly();                   // true by default
 	virtual bool canEvaluateToObjectReference(); // no by default
 	virtual bool isFunctionCall();               // no by default
 	virtual bool canEvaluateInObjectScope();     // no by default
+	virtual bool isLocalVariable();              // no by default
 
 	virtual bool convertStringConstantToNumeric(); // this does nothing by default and is reimplemented only by KviKvsTreeNodeConstantData
 };
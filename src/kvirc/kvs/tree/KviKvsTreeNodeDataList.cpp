@@ -26,6 +26,7 @@
 #include "KviKvsRunTimeContext.h"
 
 #include "KviQString.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeDataList::KviKvsTreeNodeDataList(const QChar * pLocation)
     : KviKvsTreeNode(pLocation)
@@ -106,3 +107,14 @@ void KviKvsTreeNodeDataList::prependItem(KviKvsTreeNodeData * p)
 	m_pDataList->prepend(p);
 	p->setParent(this);
 }
+
+unsigned int KviKvsTreeNodeDataList::compile(KviKvsBytecodeCompiler * c)
+{
+	KviPointerListIterator<KviKvsTreeNodeData> it(*m_pDataList);
+	while(KviKvsTreeNodeData * t = it.current())
+	{
+		t->compile(c);
+		++it;
+	}
+	return m_pDataList->count();
+}
@@ -31,6 +31,7 @@
 #include "KviKvsTreeNodeData.h"
 
 class KviKvsRunTimeContext;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeDataList : public KviKvsTreeNode
 {
@@ -51,6 +52,8 @@ public:
 	KviKvsTreeNodeData * item(unsigned int uIdx);
 	KviKvsTreeNodeData * releaseFirst();
 	bool evaluate(KviKvsRunTimeContext * c, KviKvsVariantList * pBuffer);
+	// Emits the code that pushes the items on the stack, returns their number
+	unsigned int compile(KviKvsBytecodeCompiler * c);
 	virtual void contextDescription(QString & szBuffer);
 
 	virtual void dump(const char * prefix);
@@ -23,6 +23,7 @@
 //=============================================================================
 
 #include "KviKvsTreeNodeExpression.h"
+#include "KviKvsBytecodeCompiler.h"
 #include "KviLocale.h"
 
 #include <math.h>
@@ -119,6 +120,11 @@ bool KviKvsTreeNodeExpressionVariableOperand::evaluateReadOnly(KviKvsRunTimeCont
 	return m_pData->evaluateReadOnly(c, pBuffer);
 }
 
+void KviKvsTreeNodeExpressionVariableOperand::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pData->compile(c);
+}
+
 KviKvsTreeNodeExpressionConstantOperand::KviKvsTreeNodeExpressionConstantOperand(const QChar * pLocation, KviKvsVariant * pConstant)
     : KviKvsTreeNodeExpression(pLocation)
 {
@@ -149,6 +155,11 @@ bool KviKvsTreeNodeExpressionConstantOperand::evaluateReadOnly(KviKvsRunTimeCont
 	return true;
 }
 
+void KviKvsTreeNodeExpressionConstantOperand::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitConstant(m_pConstant);
+}
+
 KviKvsTreeNodeExpressionOperator::KviKvsTreeNodeExpressionOperator(const QChar * pLocation)
     : KviKvsTreeNodeExpression(pLocation)
 {
@@ -244,6 +255,12 @@ bool KviKvsTreeNodeExpressionUnaryOperatorNegate::evaluateReadOnly(KviKvsRunTime
 	return true;
 }
 
+void KviKvsTreeNodeExpressionUnaryOperatorNegate::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pData->compile(c);
+	c->emit(KviKvsBytecodeProgram::Negate, this);
+}
+
 KviKvsTreeNodeExpressionUnaryOperatorBitwiseNot::KviKvsTreeNodeExpressionUnaryOperatorBitwiseNot(const QChar * pLocation, KviKvsTreeNodeExpression * pData)
     : KviKvsTreeNodeExpressionUnaryOperator(pLocation, pData)
 {
@@ -281,6 +298,12 @@ bool KviKvsTreeNodeExpressionUnaryOperatorBitwiseNot::evaluateReadOnly(KviKvsRun
 	return true;
 }
 
+void KviKvsTreeNodeExpressionUnaryOperatorBitwiseNot::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pData->compile(c);
+	c->emit(KviKvsBytecodeProgram::BitwiseNot, this);
+}
+
 KviKvsTreeNodeExpressionUnaryOperatorLogicalNot::KviKvsTreeNodeExpressionUnaryOperatorLogicalNot(const QChar * pLocation, KviKvsTreeNodeExpression * pData)
     : KviKvsTreeNodeExpressionUnaryOperator(pLocation, pData)
 {
@@ -317,6 +340,12 @@ bool KviKvsTreeNodeExpressionUnaryOperatorLogicalNot::evaluateReadOnly(KviKvsRun
 	return true;
 }
 
+void KviKvsTreeNodeExpressionUnaryOperatorLogicalNot::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pData->compile(c);
+	c->emit(KviKvsBytecodeProgram::LogicalNot, this);
+}
+
 KviKvsTreeNodeExpressionBinaryOperator::KviKvsTreeNodeExpressionBinaryOperator(const QChar * pLocation)
     : KviKvsTreeNodeExpressionOperator(pLocation)
 {
@@ -353,6 +382,14 @@ bool KviKvsTreeNodeExpressionBinaryOperator::evaluateOperands(KviKvsRunTimeConte
 	return true;
 }
 
+void KviKvsTreeNodeExpressionBinaryOperator::compileOperands(KviKvsBytecodeCompiler * c, bool bNumeric)
+{
+	m_pLeft->compile(c);
+	if(bNumeric)
+		c->emit(KviKvsBytecodeProgram::ToNumber, this);
+	m_pRight->compile(c);
+}
+
 KviKvsTreeNodeExpression * KviKvsTreeNodeExpressionBinaryOperator::left()
 {
 	return m_pLeft;
@@ -415,6 +452,13 @@ void KviKvsTreeNodeExpressionBinaryOperator::dump(const char * prefix)
 	void __name::contextDescription(QString & szBuffer) { szBuffer = __contextdescription; }   \
 	int __name::precedence() { return __precedence; };
 
+#define COMPILE_BINARY_OPERATOR(__name, __opcode, __numeric) \
+	void __name::compile(KviKvsBytecodeCompiler * c)         \
+	{                                                        \
+		compileOperands(c, __numeric);                       \
+		c->emit(KviKvsBytecodeProgram::__opcode, this);      \
+	}
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorSum, "ExpressionBinaryOperatorSum", "Expression Binary Operator \"+\"", PREC_OP_SUM)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorSum::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -438,6 +482,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorSum::evaluateReadOnly(KviKvsRunTimeCo
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorSum, Sum, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorSubtraction, "ExpressionBinaryOperatorSubtraction", "Expression Binary Operator \"-\"", PREC_OP_SUBTRACTION)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorSubtraction::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -461,6 +507,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorSubtraction::evaluateReadOnly(KviKvsR
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorSubtraction, Subtraction, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorMultiplication, "ExpressionBinaryOperatorMultiplication", "Expression Binary Operator \"*\"", PREC_OP_MULTIPLICATION)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorMultiplication::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -484,6 +532,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorMultiplication::evaluateReadOnly(KviK
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorMultiplication, Multiplication, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorDivision, "ExpressionBinaryOperatorDivision", "Expression Binary Operator \"/\"", PREC_OP_DIVISION)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorDivision::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -518,6 +568,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorDivision::evaluateReadOnly(KviKvsRunT
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorDivision, Division, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorModulus, "ExpressionBinaryOperatorModulus", "Expression Binary Operator \"modulus\"", PREC_OP_MODULUS)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorModulus::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -552,6 +604,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorModulus::evaluateReadOnly(KviKvsRunTi
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorModulus, Modulus, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorBitwiseAnd, "ExpressionBinaryOperatorBitwiseAnd", "Expression Binary Operator \"&\"", PREC_OP_BITWISEAND)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorBitwiseAnd::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -564,6 +618,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorBitwiseAnd::evaluateReadOnly(KviKvsRu
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorBitwiseAnd, BitwiseAnd, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorBitwiseOr, "ExpressionBinaryOperatorBitwiseOr", "Expression Binary Operator \"|\"", PREC_OP_BITWISEOR)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorBitwiseOr::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -576,6 +632,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorBitwiseOr::evaluateReadOnly(KviKvsRun
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorBitwiseOr, BitwiseOr, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorBitwiseXor, "ExpressionBinaryOperatorBitwiseXor", "Expression Binary Operator \"^\"", PREC_OP_BITWISEXOR)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorBitwiseXor::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -588,6 +646,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorBitwiseXor::evaluateReadOnly(KviKvsRu
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorBitwiseXor, BitwiseXor, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorShiftLeft, "ExpressionBinaryOperatorShiftLeft", "Expression Binary Operator \"<<\"", PREC_OP_SHIFTLEFT)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorShiftLeft::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -600,6 +660,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorShiftLeft::evaluateReadOnly(KviKvsRun
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorShiftLeft, ShiftLeft, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorShiftRight, "ExpressionBinaryOperatorShiftRight", "Expression Binary Operator \">>\"", PREC_OP_SHIFTRIGHT)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorShiftRight::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -612,6 +674,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorShiftRight::evaluateReadOnly(KviKvsRu
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorShiftRight, ShiftRight, true)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorAnd, "ExpressionBinaryOperatorAnd", "Expression Binary Operator \"&&\"", PREC_OP_AND)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorAnd::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -632,6 +696,16 @@ bool KviKvsTreeNodeExpressionBinaryOperatorAnd::evaluateReadOnly(KviKvsRunTimeCo
 	return true;
 }
 
+void KviKvsTreeNodeExpressionBinaryOperatorAnd::compile(KviKvsBytecodeCompiler * c)
+{
+	// the left operand is the result when it decides it
+	m_pLeft->compile(c);
+	unsigned int uJump = c->emit(KviKvsBytecodeProgram::AndJump, this);
+	m_pRight->compile(c);
+	c->emit(KviKvsBytecodeProgram::ToBoolean, this);
+	c->setJumpTarget(uJump, c->address());
+}
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorOr, "ExpressionBinaryOperatorOr", "Expression Binary Operator \"||\"", PREC_OP_OR)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorOr::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -652,6 +726,16 @@ bool KviKvsTreeNodeExpressionBinaryOperatorOr::evaluateReadOnly(KviKvsRunTimeCon
 	return true;
 }
 
+void KviKvsTreeNodeExpressionBinaryOperatorOr::compile(KviKvsBytecodeCompiler * c)
+{
+	// the left operand is the result when it decides it
+	m_pLeft->compile(c);
+	unsigned int uJump = c->emit(KviKvsBytecodeProgram::OrJump, this);
+	m_pRight->compile(c);
+	c->emit(KviKvsBytecodeProgram::ToBoolean, this);
+	c->setJumpTarget(uJump, c->address());
+}
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorXor, "ExpressionBinaryOperatorXor", "Expression Binary Operator \"^^\"", PREC_OP_XOR)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorXor::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -675,6 +759,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorXor::evaluateReadOnly(KviKvsRunTimeCo
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorXor, Xor, false)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorLowerThan, "ExpressionBinaryOperatorLowerThan", "Expression Binary Operator \"<\"", PREC_OP_LOWERTHAN)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorLowerThan::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -689,6 +775,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorLowerThan::evaluateReadOnly(KviKvsRun
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorLowerThan, LowerThan, false)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorGreaterThan, "ExpressionBinaryOperatorGreaterThan", "Expression Binary Operator \">\"", PREC_OP_GREATERTHAN)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorGreaterThan::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -703,6 +791,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorGreaterThan::evaluateReadOnly(KviKvsR
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorGreaterThan, GreaterThan, false)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorLowerOrEqualTo, "ExpressionBinaryOperatorLowerOrEqualTo", "Expression Binary Operator \"<=\"", PREC_OP_LOWEROREQUALTO)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorLowerOrEqualTo::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -717,6 +807,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorLowerOrEqualTo::evaluateReadOnly(KviK
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorLowerOrEqualTo, LowerOrEqualTo, false)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorGreaterOrEqualTo, "ExpressionBinaryOperatorGreaterOrEqualTo", "Expression Binary Operator \">=\"", PREC_OP_GREATEROREQUALTO)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorGreaterOrEqualTo::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -731,6 +823,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorGreaterOrEqualTo::evaluateReadOnly(Kv
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorGreaterOrEqualTo, GreaterOrEqualTo, false)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorEqualTo, "ExpressionBinaryOperatorEqualTo", "Expression Binary Operator \"==\"", PREC_OP_EQUALTO)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorEqualTo::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -745,6 +839,8 @@ bool KviKvsTreeNodeExpressionBinaryOperatorEqualTo::evaluateReadOnly(KviKvsRunTi
 	return true;
 }
 
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorEqualTo, EqualTo, false)
+
 PREIMPLEMENT_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorNotEqualTo, "ExpressionBinaryOperatorNotEqualTo", "Expression Binary Operator \"!=\"", PREC_OP_NOTEQUALTO)
 
 bool KviKvsTreeNodeExpressionBinaryOperatorNotEqualTo::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
@@ -758,3 +854,5 @@ bool KviKvsTreeNodeExpressionBinaryOperatorNotEqualTo::evaluateReadOnly(KviKvsRu
 	pBuffer->setBoolean(v1.compare(&v2, true) != 0);
 	return true;
 }
+
+COMPILE_BINARY_OPERATOR(KviKvsTreeNodeExpressionBinaryOperatorNotEqualTo, NotEqualTo, false)
@@ -28,6 +28,8 @@
 #include "KviKvsVariant.h"
 #include "KviKvsTreeNodeData.h"
 
+class KviKvsBytecodeCompiler;
+
 // absolute precedence (~operand part)
 #define PREC_MAXIMUM -10
 
@@ -100,6 +102,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KVIRC_API KviKvsTreeNodeExpressionConstantOperand : public KviKvsTreeNodeExpression
@@ -115,6 +118,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KVIRC_API KviKvsTreeNodeExpressionOperator : public KviKvsTreeNodeExpression
@@ -154,6 +158,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KVIRC_API KviKvsTreeNodeExpressionUnaryOperatorBitwiseNot : public KviKvsTreeNodeExpressionUnaryOperator
@@ -167,6 +172,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KVIRC_API KviKvsTreeNodeExpressionUnaryOperatorLogicalNot : public KviKvsTreeNodeExpressionUnaryOperator
@@ -180,6 +186,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KVIRC_API KviKvsTreeNodeExpressionBinaryOperator : public KviKvsTreeNodeExpressionOperator
@@ -207,6 +214,9 @@ public:
 
 protected:
 	bool evaluateOperands(KviKvsRunTimeContext * c);
+	// Emits the operands in the order of evaluateOperands(): the numeric
+	// ones check the left operand before evaluating the right one
+	void compileOperands(KviKvsBytecodeCompiler * c, bool bNumeric);
 };
 
 #define DECLARE_BINARY_OPERATOR(__name)                                                   \
@@ -220,6 +230,7 @@ protected:
 		virtual void contextDescription(QString & szBuffer);                              \
 		virtual void dump(const char * prefix);                                           \
 		virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult); \
+		virtual void compile(KviKvsBytecodeCompiler * c);                                 \
 		virtual int precedence();                                                         \
 	}
 
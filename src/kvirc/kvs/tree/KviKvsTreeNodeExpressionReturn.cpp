@@ -26,6 +26,7 @@
 #include "KviKvsTreeNodeExpression.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeExpressionReturn::KviKvsTreeNodeExpressionReturn(const QChar * pLocation, KviKvsTreeNodeExpression * pExpression)
     : KviKvsTreeNodeInstruction(pLocation)
@@ -56,3 +57,9 @@ bool KviKvsTreeNodeExpressionReturn::execute(KviKvsRunTimeContext * c)
 {
 	return m_pExpression->evaluateReadOnly(c, c->returnValue());
 }
+
+void KviKvsTreeNodeExpressionReturn::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pExpression->compile(c);
+	c->emit(KviKvsBytecodeProgram::SetReturnValue, this);
+}
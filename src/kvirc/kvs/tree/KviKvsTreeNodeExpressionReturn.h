@@ -28,6 +28,7 @@
 #include "KviKvsTreeNodeInstruction.h"
 
 class KviKvsTreeNodeExpression;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeExpressionReturn : public KviKvsTreeNodeInstruction
 {
@@ -42,6 +43,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 #endif //!_KVI_KVS_TREENODE_EXPRESSIONRETURN_H_
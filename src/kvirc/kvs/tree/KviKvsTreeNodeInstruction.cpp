@@ -23,6 +23,7 @@
 //=============================================================================
 
 #include "KviKvsTreeNodeInstruction.h"
+#include "KviKvsBytecodeCompiler.h"
 
 void KviKvsTreeNodeInstruction::contextDescription(QString & szBuffer)
 {
@@ -33,3 +34,8 @@ void KviKvsTreeNodeInstruction::dump(const char * prefix)
 {
 	qDebug("%s Instruction", prefix);
 }
+
+void KviKvsTreeNodeInstruction::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitFallback(this);
+}
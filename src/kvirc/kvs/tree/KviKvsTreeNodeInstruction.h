@@ -34,6 +34,7 @@
 #include "KviKvsTreeNodeBase.h"
 
 class KviKvsRunTimeContext;
+class KviKvsBytecodeCompiler;
 
 /**
 * \class KviKvsTreeNodeInstruction
@@ -81,6 +82,16 @@ public:
 	* \return bool
 	*/
 	virtual bool execute(KviKvsRunTimeContext * c) = 0;
+
+	/**
+	* \brief Emits the bytecode of the instruction
+	*
+	* By default the instruction is emitted as a call to execute(): the
+	* nodes that the virtual machine can run directly reimplement this.
+	* \param c The compiler
+	* \return void
+	*/
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 #endif //_KVI_KVS_TREENODE_H_
@@ -24,6 +24,7 @@
 
 #include "KviKvsTreeNodeInstructionBlock.h"
 #include "KviKvsRunTimeContext.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeInstructionBlock::KviKvsTreeNodeInstructionBlock(const QChar * pLocation)
     : KviKvsTreeNodeInstruction(pLocation)
@@ -84,3 +85,13 @@ bool KviKvsTreeNodeInstructionBlock::execute(KviKvsRunTimeContext * c)
 	}
 	return true;
 }
+
+void KviKvsTreeNodeInstructionBlock::compile(KviKvsBytecodeCompiler * c)
+{
+	KviPointerListIterator<KviKvsTreeNodeInstruction> it(*m_pInstructionList);
+	while(KviKvsTreeNodeInstruction * i = it.current())
+	{
+		i->compile(c);
+		++it;
+	}
+}
@@ -31,6 +31,7 @@
 #include "KviKvsTreeNodeInstruction.h"
 
 class KviKvsRunTimeContext;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeInstructionBlock : public KviKvsTreeNodeInstruction
 {
@@ -49,6 +50,7 @@ public:
 	virtual void dump(const char * prefix);
 
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 #endif //!_KVI_KVS_TREENODE_INSTRUCTIONBLOCK_H_
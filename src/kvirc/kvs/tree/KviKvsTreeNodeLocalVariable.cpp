@@ -24,10 +24,15 @@
 
 #include "KviKvsTreeNodeLocalVariable.h"
 #include "KviKvsRunTimeContext.h"
+#include "KviKvsHash.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeLocalVariable::KviKvsTreeNodeLocalVariable(const QChar * pLocation, const QString & szIdentifier)
     : KviKvsTreeNodeVariable(pLocation, szIdentifier)
 {
+	m_pCachedHash = nullptr;
+	m_uCachedGeneration = 0;
+	m_pCachedVariable = nullptr;
 }
 
 KviKvsTreeNodeLocalVariable::~KviKvsTreeNodeLocalVariable()
@@ -45,9 +50,27 @@ void KviKvsTreeNodeLocalVariable::dump(const char * prefix)
 	qDebug("%s LocalVariable(%s)", prefix, m_szIdentifier.toUtf8().data());
 }
 
+KviKvsVariant * KviKvsTreeNodeLocalVariable::cachedFind(KviKvsHash * pHash)
+{
+	// The generations are unique across all the hashes so this is safe
+	// also when the same tree is run in a different (or recursive) context.
+	if((pHash == m_pCachedHash) && (pHash->generation() == m_uCachedGeneration))
+		return m_pCachedVariable;
+
+	m_pCachedVariable = pHash->find(m_szIdentifier);
+	m_pCachedHash = pHash;
+	m_uCachedGeneration = pHash->generation();
+	return m_pCachedVariable;
+}
+
+bool KviKvsTreeNodeLocalVariable::isLocalVariable()
+{
+	return true;
+}
+
 bool KviKvsTreeNodeLocalVariable::evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pBuffer)
 {
-	KviKvsVariant * v = c->localVariables()->find(m_szIdentifier);
+	KviKvsVariant * v = cachedFind(c->localVariables());
 
 	if(v)
 		pBuffer->copyFrom(v);
@@ -57,11 +80,38 @@ bool KviKvsTreeNodeLocalVariable::evaluateReadOnly(KviKvsRunTimeContext * c, Kvi
 	return true;
 }
 
+KviKvsVariant * KviKvsTreeNodeLocalVariable::localVariable(KviKvsRunTimeContext * c)
+{
+	KviKvsHash * pHash = c->localVariables();
+	KviKvsVariant * v = cachedFind(pHash);
+	if(!v)
+	{
+		// get() creates the variable and changes the generation:
+		// cache the new one so that the next access is a hit
+		v = pHash->get(m_szIdentifier);
+		m_pCachedVariable = v;
+		m_uCachedGeneration = pHash->generation();
+	}
+	return v;
+}
+
+void KviKvsTreeNodeLocalVariable::releaseLocalVariable(KviKvsRunTimeContext * c, KviKvsVariant * pVariable)
+{
+	// same as KviKvsHashElement does on destruction
+	if(pVariable->isEmpty())
+		c->localVariables()->unset(m_szIdentifier);
+}
+
 KviKvsRWEvaluationResult * KviKvsTreeNodeLocalVariable::evaluateReadWrite(KviKvsRunTimeContext * c)
 {
 	return new KviKvsHashElement(
 	    nullptr,
-	    c->localVariables()->get(m_szIdentifier),
+	    localVariable(c),
 	    c->localVariables(),
 	    m_szIdentifier);
 }
+
+void KviKvsTreeNodeLocalVariable::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emitLocal(KviKvsBytecodeProgram::PushLocal, m_szIdentifier, this);
+}
@@ -29,6 +29,7 @@
 #include "KviKvsTreeNodeVariable.h"
 
 class KviKvsRunTimeContext;
+class KviKvsHash;
 
 class KVIRC_API KviKvsTreeNodeLocalVariable : public KviKvsTreeNodeVariable
 {
@@ -36,11 +37,29 @@ public:
 	KviKvsTreeNodeLocalVariable(const QChar * pLocation, const QString & szIdentifier);
 	~KviKvsTreeNodeLocalVariable();
 
+protected:
+	// Inline cache of the last lookup: the variable doesn't need to be searched
+	// (and its name hashed) again as long as the local variable hash is unchanged.
+	KviKvsHash * m_pCachedHash;
+	kvs_uint_t m_uCachedGeneration;
+	KviKvsVariant * m_pCachedVariable; // may be 0 (not set)
+
+	KviKvsVariant * cachedFind(KviKvsHash * pHash);
+
 public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
+	virtual bool isLocalVariable(); // yes
 	virtual bool evaluateReadOnly(KviKvsRunTimeContext * c, KviKvsVariant * pResult);
 	virtual KviKvsRWEvaluationResult * evaluateReadWrite(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
+
+	// Direct read-write access used by the operations instead of evaluateReadWrite():
+	// it doesn't allocate a KviKvsRWEvaluationResult.
+	// localVariable() creates the variable if needed and releaseLocalVariable()
+	// must be called when done: it unsets the variable if it was left empty.
+	KviKvsVariant * localVariable(KviKvsRunTimeContext * c);
+	void releaseLocalVariable(KviKvsRunTimeContext * c, KviKvsVariant * pVariable);
 };
 
 #endif //!_KVI_KVS_TREENODE_LOCALVARIABLE_H_
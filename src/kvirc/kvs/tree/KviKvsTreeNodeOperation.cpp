@@ -24,6 +24,8 @@
 
 #include "KviKvsTreeNodeOperation.h"
 #include "KviKvsTreeNodeData.h"
+#include "KviKvsTreeNodeLocalVariable.h"
+#include "KviKvsBytecodeCompiler.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
 
@@ -35,6 +37,7 @@ KviKvsTreeNodeOperation::KviKvsTreeNodeOperation(const QChar * pLocation)
     : KviKvsTreeNodeInstruction(pLocation)
 {
 	//m_pTargetData = 0; no need to set it
+	m_pLocalTarget = nullptr;
 }
 
 KviKvsTreeNodeOperation::~KviKvsTreeNodeOperation()
@@ -46,6 +49,8 @@ void KviKvsTreeNodeOperation::setTargetVariableReference(KviKvsTreeNodeData * r)
 {
 	m_pTargetData = r;
 	m_pTargetData->setParent(this);
+	// the most common operations on local variables take a shortcut
+	m_pLocalTarget = r->isLocalVariable() ? static_cast<KviKvsTreeNodeLocalVariable *>(r) : nullptr;
 }
 
 void KviKvsTreeNodeOperation::contextDescription(QString & szBuffer)
@@ -93,6 +98,14 @@ bool KviKvsTreeNodeOperationAssignment::execute(KviKvsRunTimeContext * c)
 	if(!m_pRightSide->evaluateReadOnly(c, &v))
 		return false;
 
+	if(m_pLocalTarget)
+	{
+		KviKvsVariant * pTarget = m_pLocalTarget->localVariable(c);
+		pTarget->takeFrom(v);
+		m_pLocalTarget->releaseLocalVariable(c, pTarget);
+		return true;
+	}
+
 	KviKvsRWEvaluationResult * target = m_pTargetData->evaluateReadWrite(c);
 	if(!target)
 		return false;
@@ -102,6 +115,34 @@ bool KviKvsTreeNodeOperationAssignment::execute(KviKvsRunTimeContext * c)
 	return true;
 }
 
+void KviKvsTreeNodeOperationAssignment::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pRightSide->compile(c);
+	if(m_pLocalTarget)
+		c->emitLocal(KviKvsBytecodeProgram::StoreLocal, m_pLocalTarget->identifier(), this);
+	else
+		c->emit(KviKvsBytecodeProgram::StoreData, m_pTargetData);
+}
+
+static bool operation_add_delta(KviKvsVariant * pVariable, kvs_int_t iDelta)
+{
+	kvs_int_t iVal;
+	if(pVariable->asInteger(iVal))
+	{
+		pVariable->setInteger(iVal + iDelta);
+		return true;
+	}
+
+	kvs_real_t dVal;
+	if(pVariable->asReal(dVal))
+	{
+		pVariable->setReal(dVal + iDelta);
+		return true;
+	}
+
+	return false;
+}
+
 KviKvsTreeNodeOperationDecrement::KviKvsTreeNodeOperationDecrement(const QChar * pLocation)
     : KviKvsTreeNodeOperation(pLocation)
 {
@@ -125,25 +166,23 @@ void KviKvsTreeNodeOperationDecrement::dump(const char * prefix)
 
 bool KviKvsTreeNodeOperationDecrement::execute(KviKvsRunTimeContext * c)
 {
+	if(m_pLocalTarget)
+	{
+		KviKvsVariant * pTarget = m_pLocalTarget->localVariable(c);
+		if(operation_add_delta(pTarget, -1))
+			return true;
+		m_pLocalTarget->releaseLocalVariable(c, pTarget);
+		c->error(this, __tr2qs_ctx("The target variable didn't evaluate to an integer or real value", "kvs"));
+		return false;
+	}
+
 	KviKvsRWEvaluationResult * v = m_pTargetData->evaluateReadWrite(c);
 	if(!v)
 		return false;
 
-	kvs_int_t iVal;
-	if(v->result()->asInteger(iVal))
-	{
-		v->result()->setInteger(iVal - 1);
-		delete v;
-		v = nullptr;
-		return true;
-	}
-
-	kvs_real_t dVal;
-	if(v->result()->asReal(dVal))
+	if(operation_add_delta(v->result(), -1))
 	{
-		v->result()->setReal(dVal - 1.0);
 		delete v;
-		v = nullptr;
 		return true;
 	}
 
@@ -152,6 +191,16 @@ bool KviKvsTreeNodeOperationDecrement::execute(KviKvsRunTimeContext * c)
 	return false;
 }
 
+void KviKvsTreeNodeOperationDecrement::compile(KviKvsBytecodeCompiler * c)
+{
+	if(!m_pLocalTarget)
+	{
+		KviKvsTreeNodeOperation::compile(c);
+		return;
+	}
+	c->emitLocal(KviKvsBytecodeProgram::DecrementLocal, m_pLocalTarget->identifier(), this);
+}
+
 KviKvsTreeNodeOperationIncrement::KviKvsTreeNodeOperationIncrement(const QChar * pLocation)
     : KviKvsTreeNodeOperation(pLocation)
 {
@@ -175,32 +224,41 @@ void KviKvsTreeNodeOperationIncrement::dump(const char * prefix)
 
 bool KviKvsTreeNodeOperationIncrement::execute(KviKvsRunTimeContext * c)
 {
+	if(m_pLocalTarget)
+	{
+		KviKvsVariant * pTarget = m_pLocalTarget->localVariable(c);
+		if(operation_add_delta(pTarget, 1))
+			return true;
+		m_pLocalTarget->releaseLocalVariable(c, pTarget);
+		c->error(this, __tr2qs_ctx("The target variable didn't evaluate to an integer or real value", "kvs"));
+		return false;
+	}
+
 	KviKvsRWEvaluationResult * v = m_pTargetData->evaluateReadWrite(c);
 	if(!v)
 		return false;
 
-	kvs_int_t iVal;
-	if(v->result()->asInteger(iVal))
+	if(operation_add_delta(v->result(), 1))
 	{
-		v->result()->setInteger(iVal + 1);
 		delete v;
-		v = nullptr;
 		return true;
 	}
 
-	kvs_real_t dVal;
-	if(v->result()->asReal(dVal))
-	{
-		v->result()->setReal(dVal + 1.0);
-		delete v;
-		v = nullptr;
-		return true;
-	}
 	c->error(this, __tr2qs_ctx("The target variable didn't evaluate to an integer or real value", "kvs"));
 	delete v;
 	return false;
 }
 
+void KviKvsTreeNodeOperationIncrement::compile(KviKvsBytecodeCompiler * c)
+{
+	if(!m_pLocalTarget)
+	{
+		KviKvsTreeNodeOperation::compile(c);
+		return;
+	}
+	c->emitLocal(KviKvsBytecodeProgram::IncrementLocal, m_pLocalTarget->identifier(), this);
+}
+
 KviKvsTreeNodeOperationSelfAnd::KviKvsTreeNodeOperationSelfAnd(const QChar * pLocation, KviKvsTreeNodeData * pRightSide)
     : KviKvsTreeNodeOperation(pLocation)
 {
@@ -748,6 +806,17 @@ bool KviKvsTreeNodeOperationSelfSubtraction::execute(KviKvsRunTimeContext * c)
 	return true;
 }
 
+void KviKvsTreeNodeOperationSelfSubtraction::compile(KviKvsBytecodeCompiler * c)
+{
+	if(!m_pLocalTarget)
+	{
+		KviKvsTreeNodeOperation::compile(c);
+		return;
+	}
+	m_pRightSide->compile(c);
+	c->emitLocal(KviKvsBytecodeProgram::SelfSubtractionLocal, m_pLocalTarget->identifier(), this);
+}
+
 KviKvsTreeNodeOperationSelfSum::KviKvsTreeNodeOperationSelfSum(const QChar * pLocation, KviKvsTreeNodeData * pRightSide)
     : KviKvsTreeNodeOperation(pLocation)
 {
@@ -821,6 +890,17 @@ bool KviKvsTreeNodeOperationSelfSum::execute(KviKvsRunTimeContext * c)
 	return true;
 }
 
+void KviKvsTreeNodeOperationSelfSum::compile(KviKvsBytecodeCompiler * c)
+{
+	if(!m_pLocalTarget)
+	{
+		KviKvsTreeNodeOperation::compile(c);
+		return;
+	}
+	m_pRightSide->compile(c);
+	c->emitLocal(KviKvsBytecodeProgram::SelfSumLocal, m_pLocalTarget->identifier(), this);
+}
+
 KviKvsTreeNodeOperationSelfXor::KviKvsTreeNodeOperationSelfXor(const QChar * pLocation, KviKvsTreeNodeData * pRightSide)
     : KviKvsTreeNodeOperation(pLocation)
 {
@@ -923,6 +1003,17 @@ bool KviKvsTreeNodeOperationStringAppend::execute(KviKvsRunTimeContext * c)
 	return true;
 }
 
+void KviKvsTreeNodeOperationStringAppend::compile(KviKvsBytecodeCompiler * c)
+{
+	if(!m_pLocalTarget)
+	{
+		KviKvsTreeNodeOperation::compile(c);
+		return;
+	}
+	m_pRightSide->compile(c);
+	c->emitLocal(KviKvsBytecodeProgram::AppendLocal, m_pLocalTarget->identifier(), this);
+}
+
 KviKvsTreeNodeOperationArrayAppend::KviKvsTreeNodeOperationArrayAppend(const QChar * pLocation, KviKvsTreeNodeData * pRightSide)
     : KviKvsTreeNodeOperation(pLocation)
 {
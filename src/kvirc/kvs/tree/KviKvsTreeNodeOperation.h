@@ -29,7 +29,9 @@
 #include "KviKvsTreeNodeInstruction.h"
 
 class KviKvsTreeNodeData;
+class KviKvsTreeNodeLocalVariable;
 class KviKvsRunTimeContext;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeOperation : public KviKvsTreeNodeInstruction
 {
@@ -38,7 +40,8 @@ public:
 	~KviKvsTreeNodeOperation();
 
 protected:
-	KviKvsTreeNodeData * m_pTargetData; // can't be null
+	KviKvsTreeNodeData * m_pTargetData;           // can't be null
+	KviKvsTreeNodeLocalVariable * m_pLocalTarget; // m_pTargetData if it's a plain local variable, 0 otherwise
 public:
 	void setTargetVariableReference(KviKvsTreeNodeData * r);
 	virtual void contextDescription(QString & szBuffer);
@@ -57,6 +60,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KviKvsTreeNodeOperationDecrement : public KviKvsTreeNodeOperation
@@ -69,6 +73,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KviKvsTreeNodeOperationIncrement : public KviKvsTreeNodeOperation
@@ -81,6 +86,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KviKvsTreeNodeOperationSelfAnd : public KviKvsTreeNodeOperation
@@ -193,6 +199,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KviKvsTreeNodeOperationSelfSum : public KviKvsTreeNodeOperation
@@ -207,6 +214,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KviKvsTreeNodeOperationSelfXor : public KviKvsTreeNodeOperation
@@ -235,6 +243,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 class KviKvsTreeNodeOperationArrayAppend : public KviKvsTreeNodeOperation
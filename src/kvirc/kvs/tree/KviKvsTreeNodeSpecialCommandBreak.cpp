@@ -25,6 +25,7 @@
 #include "KviKvsTreeNodeSpecialCommandBreak.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeSpecialCommandBreak::KviKvsTreeNodeSpecialCommandBreak(const QChar * pLocation)
     : KviKvsTreeNodeSpecialCommand(pLocation, "break")
@@ -49,3 +50,8 @@ bool KviKvsTreeNodeSpecialCommandBreak::execute(KviKvsRunTimeContext * c)
 	c->setBreakPending();
 	return false;
 }
+
+void KviKvsTreeNodeSpecialCommandBreak::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emit(KviKvsBytecodeProgram::Break, this);
+}
@@ -25,6 +25,7 @@
 #include "KviKvsTreeNodeSpecialCommandContinue.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeSpecialCommandContinue::KviKvsTreeNodeSpecialCommandContinue(const QChar * pLocation)
     : KviKvsTreeNodeSpecialCommand(pLocation, "continue")
@@ -49,3 +50,8 @@ bool KviKvsTreeNodeSpecialCommandContinue::execute(KviKvsRunTimeContext * c)
 	c->setContinuePending();
 	return false;
 }
+
+void KviKvsTreeNodeSpecialCommandContinue::compile(KviKvsBytecodeCompiler * c)
+{
+	c->emit(KviKvsBytecodeProgram::Continue, this);
+}
@@ -29,6 +29,7 @@
 #include "KviKvsTreeNodeSpecialCommand.h"
 
 class KviKvsRunTimeContext;
+class KviKvsBytecodeCompiler;
 
 class KVIRC_API KviKvsTreeNodeSpecialCommandContinue : public KviKvsTreeNodeSpecialCommand
 {
@@ -40,6 +41,7 @@ public:
 	virtual void contextDescription(QString & szBuffer);
 	virtual void dump(const char * prefix);
 	virtual bool execute(KviKvsRunTimeContext * c);
+	virtual void compile(KviKvsBytecodeCompiler * c);
 };
 
 #endif //!_KVI_KVS_TREENODE_SPECIALCOMMANDCONTINUE_H_
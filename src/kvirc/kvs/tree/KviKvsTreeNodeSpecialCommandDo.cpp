@@ -27,6 +27,7 @@
 #include "KviKvsTreeNodeInstruction.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeSpecialCommandDo::KviKvsTreeNodeSpecialCommandDo(const QChar * pLocation, KviKvsTreeNodeExpression * e, KviKvsTreeNodeInstruction * i)
     : KviKvsTreeNodeSpecialCommand(pLocation, "do")
@@ -88,3 +89,15 @@ bool KviKvsTreeNodeSpecialCommandDo::execute(KviKvsRunTimeContext * c)
 	}
 	return true;
 }
+
+void KviKvsTreeNodeSpecialCommandDo::compile(KviKvsBytecodeCompiler * c)
+{
+	// continue skips the condition, as in execute()
+	unsigned int uBody = c->address();
+	if(m_pInstruction)
+		m_pInstruction->compile(c);
+	unsigned int uBodyEnd = c->address();
+	m_pExpression->compile(c);
+	c->emit(KviKvsBytecodeProgram::JumpIfTrue, this, uBody);
+	c->addLoop(uBody, uBodyEnd, c->address(), KviKvsBytecodeLoop::ContinueJump, uBody);
+}
@@ -27,6 +27,7 @@
 #include "KviKvsTreeNodeInstruction.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeSpecialCommandFor::KviKvsTreeNodeSpecialCommandFor(const QChar * pLocation, KviKvsTreeNodeInstruction * pInit, KviKvsTreeNodeExpression * pCond, KviKvsTreeNodeInstruction * pUpd, KviKvsTreeNodeInstruction * pLoop)
     : KviKvsTreeNodeSpecialCommand(pLocation, "for")
@@ -152,3 +153,40 @@ bool KviKvsTreeNodeSpecialCommandFor::execute(KviKvsRunTimeContext * c)
 	// not reached
 	return false;
 }
+
+void KviKvsTreeNodeSpecialCommandFor::compile(KviKvsBytecodeCompiler * c)
+{
+	unsigned int uInit = c->address();
+	if(m_pInitialization)
+		m_pInitialization->compile(c);
+	unsigned int uInitEnd = c->address();
+
+	unsigned int uCondition = c->address();
+	unsigned int uExit = 0;
+	if(m_pCondition)
+	{
+		m_pCondition->compile(c);
+		uExit = c->emit(KviKvsBytecodeProgram::JumpIfFalse, this);
+	}
+
+	unsigned int uBody = c->address();
+	if(m_pLoop)
+		m_pLoop->compile(c);
+	unsigned int uBodyEnd = c->address();
+
+	unsigned int uUpdate = c->address();
+	if(m_pUpdate)
+		m_pUpdate->compile(c);
+	unsigned int uUpdateEnd = c->address();
+
+	c->emit(KviKvsBytecodeProgram::Jump, this, uCondition);
+	unsigned int uEnd = c->address();
+	if(m_pCondition)
+		c->setJumpTarget(uExit, uEnd);
+
+	// Same as execute(): continue is allowed only in the body and
+	// in the update, where it is handled but still ends the loop
+	c->addLoop(uInit, uInitEnd, uEnd, KviKvsBytecodeLoop::ContinueFail);
+	c->addLoop(uBody, uBodyEnd, uEnd, KviKvsBytecodeLoop::ContinueJump, uUpdate);
+	c->addLoop(uUpdate, uUpdateEnd, uEnd, KviKvsBytecodeLoop::ContinueAndFail);
+}
@@ -27,6 +27,7 @@
 #include "KviKvsTreeNodeInstruction.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeSpecialCommandIf::KviKvsTreeNodeSpecialCommandIf(const QChar * pLocation, KviKvsTreeNodeExpression * e, KviKvsTreeNodeInstruction * pIf, KviKvsTreeNodeInstruction * pElse)
     : KviKvsTreeNodeSpecialCommand(pLocation, "if")
@@ -81,3 +82,22 @@ bool KviKvsTreeNodeSpecialCommandIf::execute(KviKvsRunTimeContext * c)
 	}
 	return true;
 }
+
+void KviKvsTreeNodeSpecialCommandIf::compile(KviKvsBytecodeCompiler * c)
+{
+	m_pExpression->compile(c);
+	unsigned int uElse = c->emit(KviKvsBytecodeProgram::JumpIfFalse, this);
+	if(m_pIfInstruction)
+		m_pIfInstruction->compile(c);
+	if(m_pElseInstruction)
+	{
+		unsigned int uEnd = c->emit(KviKvsBytecodeProgram::Jump, this);
+		c->setJumpTarget(uElse, c->address());
+		m_pElseInstruction->compile(c);
+		c->setJumpTarget(uEnd, c->address());
+	}
+	else
+	{
+		c->setJumpTarget(uElse, c->address());
+	}
+}
@@ -27,6 +27,7 @@
 #include "KviKvsTreeNodeInstruction.h"
 #include "KviKvsRunTimeContext.h"
 #include "KviLocale.h"
+#include "KviKvsBytecodeCompiler.h"
 
 KviKvsTreeNodeSpecialCommandWhile::KviKvsTreeNodeSpecialCommandWhile(const QChar * pLocation, KviKvsTreeNodeExpression * e, KviKvsTreeNodeInstruction * i)
     : KviKvsTreeNodeSpecialCommand(pLocation, "while")
@@ -89,3 +90,17 @@ bool KviKvsTreeNodeSpecialCommandWhile::execute(KviKvsRunTimeContext * c)
 	}
 	return true;
 }
+
+void KviKvsTreeNodeSpecialCommandWhile::compile(KviKvsBytecodeCompiler * c)
+{
+	unsigned int uCondition = c->address();
+	m_pExpression->compile(c);
+	unsigned int uExit = c->emit(KviKvsBytecodeProgram::JumpIfFalse, this);
+	unsigned int uBody = c->address();
+	if(m_pInstruction)
+		m_pInstruction->compile(c);
+	unsigned int uBodyEnd = c->address();
+	c->emit(KviKvsBytecodeProgram::Jump, this, uCondition);
+	c->setJumpTarget(uExit, c->address());
+	c->addLoop(uBody, uBodyEnd, c->address(), KviKvsBytecodeLoop::ContinueJump, uCondition);
+}
@@ -40,6 +40,9 @@ public:
 protected:
 	QString m_szIdentifier;
 
+public:
+	const QString & identifier() const { return m_szIdentifier; };
+
 protected:
 	virtual bool isReadOnly();
 	virtual bool canEvaluateInObjectScope();
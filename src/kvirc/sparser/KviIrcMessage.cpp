@@ -25,104 +25,164 @@
 #include "KviIrcMessage.h"
 #include "KviIrcConnection.h"
 #include "KviKvsHash.h"
+#include "KviMemory.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <utility>
+
+// the storage of the recently destroyed messages, ready to be reused
+static std::vector<KviIrcMessageStorage> g_IrcMessageStoragePool;
+// nested messages are rare: a couple of entries are enough
+#define KVI_IRCMESSAGE_STORAGE_POOL_SIZE 4
+
+// the target of the empty views
+static char g_szEmptyView[1] = { '\0' };
 
 KviIrcMessage::KviIrcMessage(const char * message, KviIrcConnection * pConnection)
 {
 	m_pConnection = pConnection;
 	m_pConsole = pConnection->console();
 	m_iFlags = 0;
+	m_bMessageTagsParsed = false;
+	m_bPrefixDecoded = false;
+	m_bAllParamsDecoded = false;
+
+	if(!g_IrcMessageStoragePool.empty())
+	{
+		m_Storage = std::move(g_IrcMessageStoragePool.back());
+		g_IrcMessageStoragePool.pop_back();
+		m_Storage.params.clear();
+	}
+
+	// Copy the whole line in our (recycled) buffer and split it in place:
+	// all the fields are views in the buffer, terminated by overwriting the separators.
+	size_t uLen = strlen(message) + 1;
+	if(m_Storage.buffer.size() < uLen)
+		m_Storage.buffer.resize(uLen);
+	KviMemory::copy(m_Storage.buffer.data(), message, uLen);
+
+	char * pcBuffer = m_Storage.buffer.data();
+	char * p = pcBuffer;
 
-	const char * aux;
-	m_ptr = message;
+	m_pcMessageTags = g_szEmptyView;
+	m_pcPrefix = g_szEmptyView;
+	m_pcCommand = g_szEmptyView;
 
-	while(*m_ptr == ' ')
-		++m_ptr;
-	const char * allParams = m_ptr; // just to be sure
-	if(*m_ptr)
+	while(*p == ' ')
+		++p;
+	char * allParams = p; // just to be sure
+	if(*p)
 	{
-		if(*m_ptr == '@')
+		if(*p == '@')
 		{
-			aux = ++m_ptr;
-			while(*m_ptr && (*m_ptr != ' '))
-				++m_ptr;
-			m_szMessageTags.extractFromString(aux, m_ptr);
-			parseMessageTags();
-			while(*m_ptr == ' ')
-				++m_ptr;
+			m_pcMessageTags = ++p;
+			while(*p && (*p != ' '))
+				++p;
+			while(*p == ' ')
+				*p++ = '\0';
 		}
 
-		if(*m_ptr == ':')
+		if(*p == ':')
 		{
-			aux = ++m_ptr;
-			while(*m_ptr && (*m_ptr != ' '))
-				++m_ptr;
-			m_szPrefix.extractFromString(aux, m_ptr);
-			while(*m_ptr == ' ')
-				++m_ptr;
+			m_pcPrefix = ++p;
+			while(*p && (*p != ' '))
+				++p;
+			while(*p == ' ')
+				*p++ = '\0';
 		}
-		aux = m_ptr;
-		while(*m_ptr && (*m_ptr != ' '))
-			++m_ptr;
-		m_szCommand.extractFromString(aux, m_ptr);
-		while(*m_ptr == ' ')
-			++m_ptr;
-		allParams = m_ptr;
-		while(*m_ptr)
+
+		m_pcCommand = p;
+		while(*p && (*p != ' '))
+			++p;
+		m_iCommandLen = p - m_pcCommand;
+		while(*p == ' ')
+			*p++ = '\0';
+
+		allParams = p;
+		while(*p)
 		{
-			if(*m_ptr == ':')
+			if(*p == ':')
 			{
-				++m_ptr;
-				m_pParams.push_back(KviCString(m_ptr));
+				++p;
+				m_Storage.params.push_back(p);
 				break; // this was the last
 			}
 			else
 			{
-				aux = m_ptr;
-				while(*m_ptr && (*m_ptr != ' '))
-					++m_ptr;
-				m_pParams.push_back(KviCString(aux, m_ptr));
-				while(*m_ptr == ' ')
-					++m_ptr;
+				m_Storage.params.push_back(p);
+				while(*p && (*p != ' '))
+					++p;
+				while(*p == ' ')
+					*p++ = '\0';
 			}
 		}
 	}
-	m_ptr = allParams;
+	else
+	{
+		m_iCommandLen = 0;
+	}
+
+	// point in the original message
+	m_ptr = message + (allParams - pcBuffer);
 
-	m_iNumericCommand = (*m_szCommand.ptr() - '0') * 100;
+	m_iNumericCommand = (*m_pcCommand - '0') * 100;
 
-	if((m_szCommand.len() == 3) && (m_iNumericCommand <= 900) && (m_iNumericCommand >= 0))
+	if((m_iCommandLen == 3) && (m_iNumericCommand <= 900) && (m_iNumericCommand >= 0))
 	{
-		aux = m_szCommand.ptr();
+		char * aux = m_pcCommand;
 		aux++;
 		if((*aux >= '0') && (*aux <= '9'))
 		{
 			m_iNumericCommand += (*aux - '0') * 10;
 			aux++;
 			if((*aux >= '0') && (*aux <= '9'))
-			{
 				m_iNumericCommand += (*aux - '0');
-			}
 			else
-			{
 				m_iNumericCommand = -1;
-				m_szCommand.toUpper();
-			}
 		}
 		else
 		{
 			m_iNumericCommand = -1;
-			m_szCommand.toUpper();
 		}
 	}
 	else
 	{
 		m_iNumericCommand = -1;
-		m_szCommand.toUpper();
+	}
+
+	if(m_iNumericCommand < 0)
+	{
+		// uppercase the literal command in place and hash it once:
+		// the server parser dispatches on it
+		for(char * c = m_pcCommand; *c; c++)
+			*c = toupper(*c);
+		m_uCommandHash = hashCommand(m_pcCommand, m_iCommandLen);
+	}
+	else
+	{
+		m_uCommandHash = 0;
 	}
 }
 
 KviIrcMessage::~KviIrcMessage()
 {
+	m_Storage.decoded.clear(); // don't keep the strings alive in the pool
+	if(g_IrcMessageStoragePool.size() < KVI_IRCMESSAGE_STORAGE_POOL_SIZE)
+		g_IrcMessageStoragePool.push_back(std::move(m_Storage));
+}
+
+unsigned int KviIrcMessage::hashCommand(const char * pcCommand, int iLen)
+{
+	// FNV-1a
+	unsigned int uHash = 2166136261u;
+	const char * pcEnd = pcCommand + iLen;
+	while(pcCommand < pcEnd)
+	{
+		uHash ^= (unsigned char)*pcCommand++;
+		uHash *= 16777619u;
+	}
+	return uHash;
 }
 
 void KviIrcMessage::decodeAndSplitMask(char * b, QString & szNick, QString & szUser, QString & szHost)
@@ -188,49 +248,109 @@ void KviIrcMessage::decodeAndSplitMask(char * b, QString & szNick, QString & szU
 
 void KviIrcMessage::decodeAndSplitPrefix(QString & szNick, QString & szUser, QString & szHost)
 {
-	char * b;
-	if(m_szPrefix.hasData())
-		b = m_szPrefix.ptr();
-	else
+	decodeAndSplitMask((char *)safePrefix(), szNick, szUser, szHost);
+}
+
+QString KviIrcMessage::decodedParam(unsigned int idx)
+{
+	if(idx >= m_Storage.params.size())
+		return connection()->decodeText(KviCString::emptyString().ptr());
+
+	if(m_Storage.decoded.size() != m_Storage.params.size())
+		m_Storage.decoded.resize(m_Storage.params.size());
+
+	QString & szDecoded = m_Storage.decoded[idx];
+	if(szDecoded.isNull())
+		szDecoded = connection()->decodeText(m_Storage.params[idx]);
+	return szDecoded;
+}
+
+QString KviIrcMessage::decodedParam(unsigned int idx, KviWindow * pWindow)
+{
+	if(pWindow->textCodec() == connection()->serverCodec())
+		return decodedParam(idx);
+	return pWindow->decodeText(safeParam(idx));
+}
+
+QString KviIrcMessage::decodedTrailing()
+{
+	if(m_Storage.params.empty())
+		return connection()->decodeText(KviCString::emptyString().ptr());
+	return decodedParam(m_Storage.params.size() - 1);
+}
+
+QString KviIrcMessage::decodedTrailing(KviWindow * pWindow)
+{
+	if(pWindow->textCodec() == connection()->serverCodec())
+		return decodedTrailing();
+	return pWindow->decodeText(safeTrailing());
+}
+
+const QString & KviIrcMessage::decodedPrefix()
+{
+	if(!m_bPrefixDecoded)
+	{
+		m_szDecodedPrefix = connection()->decodeText(safePrefix());
+		m_bPrefixDecoded = true;
+	}
+	return m_szDecodedPrefix;
+}
+
+const QString & KviIrcMessage::decodedAllParams()
+{
+	if(!m_bAllParamsDecoded)
 	{
-		m_szPrefix = connection()->currentServerName();
-		b = m_szPrefix.ptr();
+		m_szDecodedAllParams = connection()->decodeText(allParams());
+		m_bAllParamsDecoded = true;
 	}
-	decodeAndSplitMask(b, szNick, szUser, szHost);
+	return m_szDecodedAllParams;
 }
 
 const char * KviIrcMessage::safePrefix()
 {
-	if(m_szPrefix.hasData())
-		return m_szPrefix.ptr();
-	m_szPrefix = connection()->currentServerName();
-	return m_szPrefix.ptr();
+	if(*m_pcPrefix)
+		return m_pcPrefix;
+	m_szServerPrefix = connection()->currentServerName();
+	if(m_szServerPrefix.hasData())
+		m_pcPrefix = m_szServerPrefix.ptr();
+	return m_szServerPrefix.ptr();
+}
+
+static QString decodeMessageTag(KviIrcConnection * pConnection, const KviCString & szTag)
+{
+	// the tags are parsed lazily: the connection might be already gone
+	if(!pConnection)
+		return QString::fromUtf8(szTag.ptr());
+	return pConnection->decodeText(szTag.ptr());
 }
 
 void KviIrcMessage::parseMessageTags()
 {
-	if(m_szMessageTags.isEmpty())
+	m_bMessageTagsParsed = true;
+
+	if(!*m_pcMessageTags)
 		return;
+	KviIrcConnection * pConnection = connection();
 	KviCString szKey;
 	KviCString szValue;
-	for(int i = 0; i < m_szMessageTags.len(); ++i)
+	for(const char * p = m_pcMessageTags; *p; ++p)
 	{
-		if(m_szMessageTags.at(i) == '=')
+		if(*p == '=')
 		{
-			for(++i; i < m_szMessageTags.len(); ++i)
+			for(++p; *p; ++p)
 			{
-				if(m_szMessageTags.at(i) == ';')
+				if(*p == ';')
 				{
-					m_ParsedMessageTags[connection()->decodeText(szKey)] = connection()->decodeText(szValue);
+					m_ParsedMessageTags[decodeMessageTag(pConnection, szKey)] = decodeMessageTag(pConnection, szValue);
 					szKey.clear();
 					szValue.clear();
 					break;
 				}
-				else if(m_szMessageTags.at(i) == '\\')
+				else if(*p == '\\')
 				{
-					if(++i >= m_szMessageTags.len())
+					if(!*(++p))
 						break;
-					switch(m_szMessageTags.at(i))
+					switch(*p)
 					{
 						case ':':
 							szValue += ';';
@@ -248,33 +368,36 @@ void KviIrcMessage::parseMessageTags()
 							szValue += '\n';
 							break;
 						default:
-							szValue += m_szMessageTags.at(i);
+							szValue += *p;
 					}
 				}
 				else
 				{
-					szValue += m_szMessageTags.at(i);
+					szValue += *p;
 				}
 			}
+			if(!*p)
+				break;
 		}
-		else if(m_szMessageTags.at(i) == ';')
+		else if(*p == ';')
 		{
 			// Insert key without value
-			m_ParsedMessageTags[connection()->decodeText(szKey)].clear();
+			m_ParsedMessageTags[decodeMessageTag(pConnection, szKey)].clear();
 			szKey.clear();
 		}
 		else
 		{
-			szKey += m_szMessageTags.at(i);
+			szKey += *p;
 		}
 	}
-	m_ParsedMessageTags[connection()->decodeText(szKey)] = connection()->decodeText(szValue);
+	m_ParsedMessageTags[decodeMessageTag(pConnection, szKey)] = decodeMessageTag(pConnection, szValue);
 
 	m_time = QDateTime::fromString(m_ParsedMessageTags.value("time"), Qt::ISODate); // empty value will be invalid time
 }
 
 QString * KviIrcMessage::messageTagPtr(const QString & szTag)
 {
+	ensureMessageTagsParsed();
 	QHash<QString, QString>::iterator i = m_ParsedMessageTags.find(szTag);
 	if(i == m_ParsedMessageTags.end())
 		return nullptr;
@@ -46,6 +46,19 @@ class KviKvsHash;
 // be done on the targeting context (mainly channel or query...)
 //
 
+///
+/// The tokenizer storage of a message: a copy of the line that
+/// is split in place and the views of the parameters inside it.
+/// The storage is recycled between consecutive messages so
+/// parsing a line doesn't need any memory allocation.
+///
+typedef struct _KviIrcMessageStorage
+{
+	std::vector<char> buffer;   // the tokenized copy of the line
+	std::vector<char *> params; // the parameters (views in buffer)
+	std::vector<QString> decoded; // the parameters decoded with the server codec, null until requested
+} KviIrcMessageStorage;
+
 class KVIRC_API KviIrcMessage
 {
 public:
@@ -73,86 +86,138 @@ public:
 
 private:
 	const char * m_ptr;                          // shallow! never null
-	KviCString m_szPrefix;                       // the extracted prefix string
-	KviCString m_szMessageTags;                  // the extracted message tags
-	KviCString m_szCommand;                      // the extracted command (may be numeric)
-	std::vector<KviCString> m_pParams;           // the list of parameters
-	QHash<QString, QString> m_ParsedMessageTags; // parsed messaged tags
+	KviIrcMessageStorage m_Storage;              // the tokenized line (recycled)
+	char * m_pcPrefix;                           // the extracted prefix string (view in m_Storage), never null
+	char * m_pcMessageTags;                      // the extracted message tags (view in m_Storage), never null
+	char * m_pcCommand;                          // the extracted command (view in m_Storage), may be numeric, never null
+	int m_iCommandLen;                           // the length of m_pcCommand
+	KviCString m_szServerPrefix;                 // the server name, used as prefix when the message has none
+	QHash<QString, QString> m_ParsedMessageTags; // parsed messaged tags (only after parseMessageTags())
+	bool m_bMessageTagsParsed;                   // has parseMessageTags() been called ?
 	KviConsoleWindow * m_pConsole;               // the console we're attacched to
 	KviIrcConnection * m_pConnection;            // the connection we're attacched to
 	int m_iNumericCommand;                       // the numeric of the command (0 if non numeric)
+	unsigned int m_uCommandHash;                 // hash of the uppercased literal command (0 if numeric)
 	int m_iFlags;                                // yes.. flags :D
 	QDateTime m_time;                            // from server-time tag, if presented
+	QString m_szDecodedPrefix;                   // safePrefix() decoded with the server codec
+	KviCString m_szSafeTrailing;                 // the storage returned by safeTrailingString()
+	QString m_szDecodedAllParams;                // allParams() decoded with the server codec
+	bool m_bPrefixDecoded;
+	bool m_bAllParamsDecoded;
 public:
 	KviConsoleWindow * console() { return m_pConsole; };
 	KviIrcConnection * connection() { return m_pConsole->connection(); };
 
 	bool isNumeric() { return (m_iNumericCommand >= 0); };
-	const char * command() { return m_szCommand.ptr(); };
-	KviCString * commandPtr() { return &m_szCommand; };
+	const char * command() { return m_pcCommand; };
 	int numeric() { return m_iNumericCommand; };
+	unsigned int commandHash() { return m_uCommandHash; };
 
-	KviCString * prefixPtr() { return &m_szPrefix; };
-	const char * prefix() { return m_szPrefix.ptr(); };
+	const char * prefix() { return m_pcPrefix; };
 	const char * safePrefix();
-	bool hasPrefix() { return m_szPrefix.hasData(); };
+	bool hasPrefix() { return *m_pcPrefix; };
 
-	KviCString * messageTagsPtr() { return &m_szMessageTags; };
-	const char * messageTags() { return m_szMessageTags.ptr(); };
-	bool hasMessageTags() { return m_szMessageTags.hasData(); };
+	const char * messageTags() { return m_pcMessageTags; };
+	bool hasMessageTags() { return *m_pcMessageTags; };
 
+	//
+	// The message tags are parsed only when one of the functions
+	// below is called for the first time.
+	//
 	QString * messageTagPtr(const QString & szTag);
-	bool hasMessageTag(const QString & szTag) { return m_ParsedMessageTags.contains(szTag); };
-	QHash<QString, QString> & messageTagsMap() { return m_ParsedMessageTags; };
+	bool hasMessageTag(const QString & szTag)
+	{
+		ensureMessageTagsParsed();
+		return m_ParsedMessageTags.contains(szTag);
+	};
+	QHash<QString, QString> & messageTagsMap()
+	{
+		ensureMessageTagsParsed();
+		return m_ParsedMessageTags;
+	};
 	KviKvsHash * messageTagsKvsHash();
 
-	QDateTime serverTime() { return m_time; }
+	QDateTime serverTime()
+	{
+		ensureMessageTagsParsed();
+		return m_time;
+	}
 
-	bool isEmpty() { return (m_szPrefix.isEmpty() && m_szCommand.isEmpty() && m_pParams.empty()); };
+	bool isEmpty() { return ((!*m_pcPrefix) && (!*m_pcCommand) && m_Storage.params.empty()); };
 
-	int paramCount() { return m_pParams.size(); };
+	int paramCount() { return m_Storage.params.size(); };
 
-	const char * param(unsigned int idx) { return (idx < m_pParams.size()) ? m_pParams[idx].ptr() : 0; };
+	const char * param(unsigned int idx) { return (idx < m_Storage.params.size()) ? m_Storage.params[idx] : 0; };
 
-	const char * safeParam(unsigned int idx) { return (idx < m_pParams.size()) ? m_pParams[idx].ptr() : KviCString::emptyString().ptr(); };
+	const char * safeParam(unsigned int idx) { return (idx < m_Storage.params.size()) ? m_Storage.params[idx] : KviCString::emptyString().ptr(); };
 
-	KviCString paramString(unsigned int idx) { return m_pParams[idx]; };
+	KviCString paramString(unsigned int idx) { return KviCString(m_Storage.params[idx]); };
 
 	const char * trailing()
 	{
-		if(m_pParams.empty())
+		if(m_Storage.params.empty())
 			return nullptr;
-		return m_pParams.back();
+		return m_Storage.params.back();
 	};
-	KviCString trailingString() { return m_pParams.back(); };
+	KviCString trailingString() { return KviCString(m_Storage.params.back()); };
+	// a copy of the trailing parameter owned by the message: it stays valid
+	// until the next call and the caller may modify it in place
 	KviCString & safeTrailingString()
 	{
-		if(m_pParams.empty())
-			return KviCString::emptyString();
-		return m_pParams.back();
+		if(m_Storage.params.empty())
+			m_szSafeTrailing.clear();
+		else
+			m_szSafeTrailing = m_Storage.params.back();
+		return m_szSafeTrailing;
 	};
 	const char * safeTrailing()
 	{
-		if(m_pParams.empty())
+		if(m_Storage.params.empty())
 			return KviCString::emptyString().ptr();
-		return m_pParams.back().ptr();
+		return m_Storage.params.back();
 	};
 
 	const char * allParams() { return m_ptr; };
 
-	KviCString firstParam() { return m_pParams.front(); };
-	std::vector<KviCString> const & params() const { return m_pParams; };
+	KviCString firstParam() { return KviCString(m_Storage.params.front()); };
+	std::vector<char *> const & params() const { return m_Storage.params; };
 
 	void setHaltOutput() { m_iFlags |= HaltOutput; };
 	bool haltOutput() { return (m_iFlags & HaltOutput); };
 	void setUnrecognized() { m_iFlags |= Unrecognized; };
 	bool unrecognized() { return (m_iFlags & Unrecognized); };
 
+	//
+	// The fields decoded with the server codec (the one used by KviIrcConnection::decodeText()).
+	// Each field is decoded once per message, no matter how many handlers, events
+	// and outputs ask for it. The variants with a window decode with the window codec
+	// and share the decoded text when the window uses the server codec.
+	//
+	QString decodedParam(unsigned int idx);
+	QString decodedParam(unsigned int idx, KviWindow * pWindow);
+	QString decodedTrailing();
+	QString decodedTrailing(KviWindow * pWindow);
+	const QString & decodedPrefix();
+	const QString & decodedAllParams();
+
 	void decodeAndSplitPrefix(QString & szNick, QString & szUser, QString & szHost);
 	void decodeAndSplitMask(char * mask, QString & szNick, QString & szUser, QString & szHost);
 
 private:
 	void parseMessageTags();
+	void ensureMessageTagsParsed()
+	{
+		if(!m_bMessageTagsParsed)
+			parseMessageTags();
+	};
+
+public:
+	///
+	/// Returns the hash of a literal command as stored by commandHash().
+	/// This is used by the server parser to build its dispatch table.
+	///
+	static unsigned int hashCommand(const char * pcCommand, int iLen);
 };
 
 #endif //_KVI_IRCMESSAGE_H_
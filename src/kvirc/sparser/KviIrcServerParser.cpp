@@ -37,15 +37,77 @@
 
 KviIrcServerParser * g_pServerParser = nullptr;
 
+// the largest perfect hash we're willing to build for the literal commands (in bits)
+#define KVI_SPARSER_LITERAL_HASH_MAX_BITS 10
+// the number of multipliers to try for each hash size
+#define KVI_SPARSER_LITERAL_HASH_MAX_TRIES 65536
+
 KviIrcServerParser::KviIrcServerParser()
     : QObject(nullptr)
 {
 	setObjectName("server_parser");
+	buildLiteralParseProcHash();
 }
 
 KviIrcServerParser::~KviIrcServerParser()
     = default;
 
+void KviIrcServerParser::buildLiteralParseProcHash()
+{
+	// Find a multiplicative hash of the precomputed command hashes
+	// that maps each literal command to a distinct slot.
+	// With ~20 commands this is usually found in a 64 entry table
+	// after a handful of tries: the lookup then costs a single string compare.
+	for(unsigned int uBits = 5; uBits <= KVI_SPARSER_LITERAL_HASH_MAX_BITS; uBits++)
+	{
+		unsigned int uShift = 32 - uBits;
+		for(unsigned int uMultiplier = 1; uMultiplier < (2 * KVI_SPARSER_LITERAL_HASH_MAX_TRIES); uMultiplier += 2)
+		{
+			m_literalParseProcHash.assign(1 << uBits, nullptr);
+			bool bCollision = false;
+			for(int i = 0; m_literalParseProcTable[i].msgName; i++)
+			{
+				const char * pcName = m_literalParseProcTable[i].msgName;
+				unsigned int uSlot = (KviIrcMessage::hashCommand(pcName, strlen(pcName)) * uMultiplier) >> uShift;
+				if(m_literalParseProcHash[uSlot])
+				{
+					bCollision = true;
+					break;
+				}
+				m_literalParseProcHash[uSlot] = &(m_literalParseProcTable[i]);
+			}
+			if(!bCollision)
+			{
+				m_uLiteralParseProcHashMultiplier = uMultiplier;
+				m_uLiteralParseProcHashShift = uShift;
+				return;
+			}
+		}
+	}
+
+	// no luck: findLiteralParseProc() will fall back to a linear scan
+	qDebug("WARNING: could not build the literal message dispatch table");
+	m_literalParseProcHash.clear();
+	m_uLiteralParseProcHashMultiplier = 0;
+	m_uLiteralParseProcHashShift = 0;
+}
+
+KviLiteralMessageParseStruct * KviIrcServerParser::findLiteralParseProc(KviIrcMessage * msg)
+{
+	if(m_literalParseProcHash.empty())
+	{
+		for(int i = 0; m_literalParseProcTable[i].msgName; i++)
+			if(kvi_strEqualCS(m_literalParseProcTable[i].msgName, msg->command()))
+				return &(m_literalParseProcTable[i]);
+		return nullptr;
+	}
+
+	KviLiteralMessageParseStruct * pEntry = m_literalParseProcHash[(msg->commandHash() * m_uLiteralParseProcHashMultiplier) >> m_uLiteralParseProcHashShift];
+	if(pEntry && kvi_strEqualCS(pEntry->msgName, msg->command()))
+		return pEntry;
+	return nullptr;
+}
+
 void KviIrcServerParser::parseMessage(const char * message, KviIrcConnection * pConnection)
 {
 	if(message == nullptr || message[0] == '\0')
@@ -58,11 +120,11 @@ void KviIrcServerParser::parseMessage(const char * message, KviIrcConnection * p
 		if(KviKvsEventManager::instance()->hasRawHandlers(msg.numeric()))
 		{
 			KviKvsVariantList parms;
-			parms.append(pConnection->decodeText(msg.safePrefix()));
+			parms.append(msg.decodedPrefix());
 			parms.append(pConnection->decodeText(msg.command()));
 
-			for(auto & str : msg.params())
-				parms.append(pConnection->console()->decodeText(str.ptr()));
+			for(int i = 0; i < msg.paramCount(); i++)
+				parms.append(msg.decodedParam(i, pConnection->console()));
 
 			if(KviKvsEventManager::instance()->triggerRaw(msg.numeric(), pConnection->console(), &parms))
 				msg.setHaltOutput();
@@ -105,22 +167,22 @@ void KviIrcServerParser::parseMessage(const char * message, KviIrcConnection * p
 	}
 	else
 	{
-		for(int i = 0; m_literalParseProcTable[i].msgName; i++)
-			if(kvi_strEqualCS(m_literalParseProcTable[i].msgName, msg.command()))
-			{
-				(this->*(m_literalParseProcTable[i].proc))(&msg);
-				if(!msg.unrecognized())
-					return; // parsed
-			}
+		KviLiteralMessageParseStruct * pEntry = findLiteralParseProc(&msg);
+		if(pEntry)
+		{
+			(this->*(pEntry->proc))(&msg);
+			if(!msg.unrecognized())
+				return; // parsed
+		}
 
 		if(KviKvsEventManager::instance()->hasAppHandlers(KviEvent_OnUnhandledLiteral))
 		{
 			KviKvsVariantList parms;
-			parms.append(pConnection->decodeText(msg.safePrefix()));
+			parms.append(msg.decodedPrefix());
 			parms.append(pConnection->decodeText(msg.command()));
 
-			for(auto & str : msg.params())
-				parms.append(pConnection->console()->decodeText(str.ptr()));
+			for(int i = 0; i < msg.paramCount(); i++)
+				parms.append(msg.decodedParam(i, pConnection->console()));
 
 			if(KviKvsEventManager::instance()->trigger(KviEvent_OnUnhandledLiteral, pConnection->console(), &parms))
 				msg.setHaltOutput();
@@ -130,7 +192,7 @@ void KviIrcServerParser::parseMessage(const char * message, KviIrcConnection * p
 	// unhandled || unrecognized
 	if(!msg.haltOutput() && !_OUTPUT_MUTE)
 	{
-		QString szWText = pConnection->decodeText(msg.allParams());
+		QString szWText = msg.decodedAllParams();
 		if(msg.unrecognized())
 		{
 			pConnection->console()->output(KVI_OUT_UNRECOGNIZED,
@@ -31,6 +31,7 @@
 #include <QObject>
 
 #include <time.h>
+#include <vector>
 
 class KviChannelWindow;
 class KviIrcConnection;
@@ -121,6 +122,10 @@ private:
 	static messageParseProc m_numericParseProcTable[1000];
 	static KviLiteralMessageParseStruct m_literalParseProcTable[];
 	static KviCtcpMessageParseStruct m_ctcpParseProcTable[];
+	// perfect hash over m_literalParseProcTable (see buildLiteralParseProcHash())
+	std::vector<KviLiteralMessageParseStruct *> m_literalParseProcHash;
+	unsigned int m_uLiteralParseProcHashMultiplier;
+	unsigned int m_uLiteralParseProcHashShift;
 	KviCString m_szLastParserError;
 
 	//	KviCString                          m_szNoAwayNick; //<-- moved to KviConsoleWindow.h in KviConnectionInfo
@@ -128,6 +133,9 @@ public:
 	void parseMessage(const char * message, KviIrcConnection * pConnection);
 
 private:
+	void buildLiteralParseProcHash();
+	KviLiteralMessageParseStruct * findLiteralParseProc(KviIrcMessage * msg);
+
 	void parseNumeric001(KviIrcMessage * msg);
 	void parseNumeric002(KviIrcMessage * msg);
 	void parseNumeric003(KviIrcMessage * msg);
@@ -83,8 +83,8 @@ void KviIrcServerParser::parseLiteralPing(KviIrcMessage * msg)
 	// <optional_prefix> PING :<argument>
 	msg->connection()->sendFmtData("PONG %s", msg->console()->connection()->encodeText(msg->allParams()).data());
 
-	QString szPrefix = msg->connection()->decodeText(msg->safePrefix());
-	QString szAllParams = msg->connection()->decodeText(msg->allParams());
+	QString szPrefix = msg->decodedPrefix();
+	QString szAllParams = msg->decodedAllParams();
 
 	if(KVS_TRIGGER_EVENT_2_HALTED(KviEvent_OnPing, msg->console(), szPrefix, szAllParams))
 		msg->setHaltOutput();
@@ -103,8 +103,8 @@ void KviIrcServerParser::parseLiteralPing(KviIrcMessage * msg)
 
 void KviIrcServerParser::parseLiteralPong(KviIrcMessage * msg)
 {
-	QString szPrefix = msg->connection()->decodeText(msg->safePrefix());
-	QString szAllParams = msg->connection()->decodeText(msg->allParams());
+	QString szPrefix = msg->decodedPrefix();
+	QString szAllParams = msg->decodedAllParams();
 
 	if(KVS_TRIGGER_EVENT_2_HALTED(KviEvent_OnPong, msg->console(), szPrefix, szAllParams))
 		msg->setHaltOutput();
@@ -132,8 +132,8 @@ void KviIrcServerParser::parseLiteralError(KviIrcMessage * msg)
 	// <optional_prefix> ERROR :<argument>
 	// ERROR :Closing Link: phoenix.pragmaware.net (Ping timeout)
 
-	QString szPrefix = msg->connection()->decodeText(msg->safePrefix());
-	QString szParams = msg->connection()->decodeText(msg->allParams());
+	QString szPrefix = msg->decodedPrefix();
+	QString szParams = msg->decodedAllParams();
 
 	if(KVS_TRIGGER_EVENT_2_HALTED(KviEvent_OnError, msg->console(), szPrefix, szParams))
 		msg->setHaltOutput();
@@ -155,7 +155,7 @@ void KviIrcServerParser::parseLiteralAccount(KviIrcMessage * msg)
 	// :<mask> ACCOUNT <account|*>
 	// If the "account" is an asterisk, they have logged out.
 	QString szNick, szUser, szHost;
-	QString szAccount = msg->connection()->decodeText(msg->safeParam(0));
+	QString szAccount = msg->decodedParam(0);
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
 	KviIrcUserDataBase * db = msg->connection()->userDataBase();
@@ -183,8 +183,8 @@ void KviIrcServerParser::parseLiteralChghost(KviIrcMessage * msg)
 	// CHGHOST
 	// :<mask> CHGHOST <user> <new.host>
 	QString szNick, szUser, szHost;
-	QString szNewUser = msg->connection()->decodeText(msg->safeParam(0));
-	QString szNewHost = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNewUser = msg->decodedParam(0);
+	QString szNewHost = msg->decodedParam(1);
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
 	KviIrcUserDataBase * db = msg->connection()->userDataBase();
@@ -263,10 +263,10 @@ void KviIrcServerParser::parseLiteralJoin(KviIrcMessage * msg)
 
 	if(msg->connection()->stateData()->enabledCaps().contains("extended-join"))
 	{
-		szAccount = msg->connection()->decodeText(msg->safeParam(1));
+		szAccount = msg->decodedParam(1);
 		KviCString trailing = msg->safeTrailing();
 		szReal = msg->connection()->decodeText(trailing.ptr());
-		channel = msg->connection()->decodeText(msg->safeParam(0));
+		channel = msg->decodedParam(0);
 	}
 	else
 	{
@@ -437,7 +437,7 @@ void KviIrcServerParser::parseLiteralPart(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
-	QString szChan = msg->connection()->decodeText(msg->safeParam(0));
+	QString szChan = msg->decodedParam(0);
 
 	// Now lookup the channel
 	KviConsoleWindow * console = msg->console();
@@ -451,7 +451,7 @@ void KviIrcServerParser::parseLiteralPart(KviIrcMessage * msg)
 	}
 
 	// always decode with the textEncoding of the channel
-	QString partMsg = msg->paramCount() > 1 ? chan->decodeText(msg->safeTrailing()) : QString();
+	QString partMsg = msg->paramCount() > 1 ? msg->decodedTrailing(chan) : QString();
 
 	if(IS_ME(msg, szNick))
 	{
@@ -599,7 +599,7 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 	{
 		// compute the channel list
 		QString chanlist;
-		QString szReason = msg->connection()->decodeText(msg->safeTrailing());
+		QString szReason = msg->decodedTrailing();
 
 		if(console->connection())
 		{
@@ -635,7 +635,7 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 		{
 			if(!msg->haltOutput())
 			{
-				QString quitMsg = c->decodeText(msg->safeTrailing());
+				QString quitMsg = msg->decodedTrailing(c);
 
 				if(bWasSplit)
 				{
@@ -655,7 +655,7 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 		KviQueryWindow * q = msg->connection()->findQuery(szNick);
 		if(q)
 		{
-			QString quitMsg = q->decodeText(msg->safeTrailing());
+			QString quitMsg = msg->decodedTrailing(q);
 			if(bWasSplit)
 			{
 				quitMsg.prepend("NETSPLIT ");
@@ -677,8 +677,8 @@ void KviIrcServerParser::parseLiteralKick(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
-	QString szChan = msg->connection()->decodeText(msg->safeParam(0));
-	QString victim = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(0);
+	QString victim = msg->decodedParam(1);
 
 	KviConsoleWindow * console = msg->console();
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
@@ -690,7 +690,7 @@ void KviIrcServerParser::parseLiteralKick(KviIrcMessage * msg)
 		return;
 	}
 
-	QString szKickMsg = chan->decodeText(msg->safeTrailing());
+	QString szKickMsg = msg->decodedTrailing(chan);
 
 	if(IS_ME(msg, victim))
 	{
@@ -849,8 +849,8 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 	QString szSourceNick, szSourceUser, szSourceHost;
 	msg->decodeAndSplitPrefix(szSourceNick, szSourceUser, szSourceHost);
 
-	QString szTarget = msg->connection()->decodeText(msg->safeParam(0));
-	QString szMsg = msg->connection()->decodeText(msg->safeTrailing());
+	QString szTarget = msg->decodedParam(0);
+	QString szMsg = msg->decodedTrailing();
 
 	QString szTargetNick, szTargetUser, szTargetHost;
 	msg->decodeAndSplitMask(szTarget.toLatin1().data(), szTargetNick, szTargetUser, szTargetHost);
@@ -988,7 +988,7 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 						// FIXME: OnSpam ?
 						if(!(msg->haltOutput() || KVI_OPTION_BOOL(KviOption_boolSilentAntiSpam)))
 						{
-							QString szMsg = msg->connection()->decodeText(msg->safeTrailing());
+							QString szMsg = msg->decodedTrailing();
 							console->output(KVI_OUT_SPAM, msg->serverTime(),
 							    __tr2qs("Spam PRIVMSG from \r!n\r%Q\r [%Q@\r!h\r%Q\r]: %Q (matching spamword \"%s\")"),
 							    &szSourceNick, &szSourceUser, &szSourceHost, &szMsg, spamWord.ptr());
@@ -1005,7 +1005,7 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 			// it manually or they can set the option to true at KVIrc startup
 			if(KVI_OPTION_BOOL(KviOption_boolCreateQueryOnPrivmsg))
 			{
-				QString szMsg = msg->connection()->decodeText(msg->safeTrailing());
+				QString szMsg = msg->decodedTrailing();
 
 				// We still want to create it
 				// Give the scripter a chance to filter it out again
@@ -1092,7 +1092,7 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 		{
 			// no query creation: no decryption possible
 			// trigger the query message event in the console
-			QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+			QString szMsgText = msg->decodedTrailing();
 			if(KVS_TRIGGER_EVENT_6_HALTED(KviEvent_OnQueryMessage, console, szSourceNick, szSourceUser, szSourceHost, szMsgText, (kvs_int_t)0, msg->messageTagsKvsHash()))
 				msg->setHaltOutput();
 
@@ -1174,7 +1174,7 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 		{
 			if(!msg->haltOutput())
 			{
-				QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+				QString szMsgText = msg->decodedTrailing();
 
 				// if the message is identified (identify-msg CAP) then re-add the +/- char at the beginning
 				if(eCapState != IdentifyMsgCapNotUsed)
@@ -1250,7 +1250,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 				ctcp.pData = pTrailing.ptr();
 				KviIrcMask talker(szNick, szUser, szHost); // FIXME
 				ctcp.pSource = &talker;
-				ctcp.szTarget = msg->connection()->decodeText(msg->safeParam(0));
+				ctcp.szTarget = msg->decodedParam(0);
 				ctcp.bIgnored = false;
 				ctcp.bIsFlood = false;
 				ctcp.bUnknown = false;
@@ -1260,7 +1260,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 		}
 	}
 
-	QString szTarget = msg->connection()->decodeText(msg->safeParam(0));
+	QString szTarget = msg->decodedParam(0);
 
 	KviRegisteredUser * u = msg->connection()->userDataBase()->registeredUser(szNick, szUser, szHost);
 	//Ignore it?
@@ -1270,7 +1270,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 		{
 			if(KVI_OPTION_BOOL(KviOption_boolVerboseIgnore))
 			{
-				QString szMsg = msg->connection()->decodeText(msg->safeTrailing());
+				QString szMsg = msg->decodedTrailing();
 				console->output(KVI_OUT_IGNORE, msg->serverTime(), __tr2qs("Ignoring NOTICE from \r!nc\r%Q\r [%Q@\r!h\r%Q\r]: %Q"), &szNick, &szUser, &szHost, &szMsg);
 			}
 			return;
@@ -1281,7 +1281,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 	if(IS_ME(msg, szTarget) && !bIsServerNotice)
 	{
 		// Nickserv nick identification routine
-		QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szMsgText = msg->decodedTrailing();
 		KviIrcMask talker(szNick, szUser, szHost);
 		KviNickServRule * rule = nullptr;
 
@@ -1362,7 +1362,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 		// Chanserv nick identification routine
 		if(KviQString::equalCI(szNick, "ChanServ"))
 		{
-			QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+			QString szMsgText = msg->decodedTrailing();
 			if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnChanServNotice, console, szNick, szUser, szHost, szMsgText, msg->messageTagsKvsHash()))
 				msg->setHaltOutput();
 			if(!msg->haltOutput())
@@ -1388,7 +1388,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 		// Chanserv nick identification routine
 		if(KviQString::equalCI(szNick, "MemoServ"))
 		{
-			QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+			QString szMsgText = msg->decodedTrailing();
 			if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnMemoServNotice, console, szNick, szUser, szHost, szMsgText, msg->messageTagsKvsHash()))
 				msg->setHaltOutput();
 			if(!msg->haltOutput())
@@ -1437,7 +1437,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 
 						if(!(msg->haltOutput() || KVI_OPTION_BOOL(KviOption_boolSilentAntiSpam)))
 						{
-							QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+							QString szMsgText = msg->decodedTrailing();
 							QString szSpamWord = spamWord.ptr();
 							console->output(KVI_OUT_SPAM, msg->serverTime(), __tr2qs("Spam notice from \r!n\r%Q\r [%Q@\r!h\r%Q\r]: %Q (matching spamword \"%Q\")"),
 							    &szNick, &szUser, &szHost, &szMsgText, &szSpamWord);
@@ -1454,7 +1454,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 			// it manually or they can set the option to true at KVIrc startup
 			if(KVI_OPTION_BOOL(KviOption_boolCreateQueryOnNotice))
 			{
-				QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+				QString szMsgText = msg->decodedTrailing();
 				// We still want to create it
 				// Give the scripter a chance to filter it out again
 				if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnQueryWindowRequest, console, szNick, szUser, szHost, szMsgText, msg->messageTagsKvsHash()))
@@ -1524,7 +1524,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 		}
 		else
 		{
-			QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+			QString szMsgText = msg->decodedTrailing();
 
 			// no query creation: no decryption possible
 			// trigger the query message event in the console
@@ -1576,7 +1576,7 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 
 	if(!chan)
 	{
-		QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szMsgText = msg->decodedTrailing();
 
 		if(bIsServerNotice)
 		{
@@ -1669,7 +1669,7 @@ void KviIrcServerParser::parseLiteralTopic(KviIrcMessage * msg)
 	// :<source_mask> TOPIC <channel> :<topic>
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
-	QString szTarget = msg->connection()->decodeText(msg->safeParam(0));
+	QString szTarget = msg->decodedParam(0);
 
 	// Now lookup the channel
 	KviChannelWindow * chan = msg->connection()->findChannel(szTarget);
@@ -1729,7 +1729,7 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 	KviConsoleWindow * console = msg->console();
-	QString szNewNick = msg->connection()->decodeText(msg->safeTrailing());
+	QString szNewNick = msg->decodedTrailing();
 
 	bool bIsMe = IS_ME(msg, szNick);
 
@@ -1851,8 +1851,8 @@ void KviIrcServerParser::parseLiteralInvite(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
-	QString szTarget = msg->connection()->decodeText(msg->safeParam(0));
-	QString szChannel = msg->connection()->decodeText(msg->safeParam(1));
+	QString szTarget = msg->decodedParam(0);
+	QString szChannel = msg->decodedParam(1);
 
 	KviConsoleWindow * console = msg->console();
 	KviRegisteredUser * u = msg->connection()->userDataBase()->registeredUser(szNick, szUser, szHost);
@@ -1898,7 +1898,7 @@ void KviIrcServerParser::parseLiteralWallops(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
-	QString szMsg = msg->connection()->decodeText(msg->safeTrailing());
+	QString szMsg = msg->decodedTrailing();
 
 	if(KVS_TRIGGER_EVENT_4_HALTED(KviEvent_OnWallops, msg->console(), szNick, szUser, szHost, szMsg))
 		msg->setHaltOutput();
@@ -1958,7 +1958,7 @@ void KviIrcServerParser::parseLiteralMode(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
-	QString szTarget = msg->connection()->decodeText(msg->safeParam(0));
+	QString szTarget = msg->decodedParam(0);
 	KviCString modefl(msg->safeParam(1));
 
 	if(IS_ME(msg, szTarget))
@@ -2147,7 +2147,7 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 	case modechar:                                                                                                                        \
 		if(msg->connection()->serverInfo()->isSupportedModeFlag(modechar))                                                                \
 		{                                                                                                                                 \
-			aParam = msg->connection()->decodeText(msg->safeParam(curParam++));                                                           \
+			aParam = msg->decodedParam(curParam++);                                                           \
 			bIsMe = IS_ME(msg, aParam);                                                                                                   \
 			chan->chanfunc(aParam, bSet, bIsMe);                                                                                          \
 			if(bIsMe)                                                                                                                     \
@@ -2201,9 +2201,9 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 					// (ircq) unrealircd's channel admin (channel mode a with nickname)
 					// not existing but supported mode (channel mode a with mask)
 
-					aParam = msg->connection()->decodeText(msg->safeParam(curParam++));
+					aParam = msg->decodedParam(curParam++);
 					// we call setModeInList anyway to fill the "mode q editor"
-					chan->setModeInList(*aux, aParam, bSet, msg->connection()->decodeText(msg->safePrefix()), QDateTime::currentDateTime().toTime_t());
+					chan->setModeInList(*aux, aParam, bSet, msg->decodedPrefix(), QDateTime::currentDateTime().toTime_t());
 					if(aParam.contains('!'))
 					{
 						// it's a mask
@@ -2291,7 +2291,7 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 				else if(msg->connection()->serverInfo()->supportedParameterModes().contains(*aux)
 				    || (msg->connection()->serverInfo()->supportedParameterWhenSetModes().contains(*aux) && bSet))
 				{
-					aParam = msg->connection()->decodeText(msg->safeParam(curParam++));
+					aParam = msg->decodedParam(curParam++);
 					chan->setChannelModeWithParam(*aux, aParam);
 
 					if(!(msg->haltOutput() || bShowAsCompact))
@@ -2339,8 +2339,8 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 
 #define CHANNEL_MODE(modefl, evmeset, evmeunset, evset, evunset, icomeset, icomeunset, icoset, icounset)                                    \
 	case modefl:                                                                                                                            \
-		aParam = msg->connection()->decodeText(msg->safeParam(curParam++));                                                                 \
-		chan->setModeInList(*aux, aParam, bSet, msg->connection()->decodeText(msg->safePrefix()), QDateTime::currentDateTime().toTime_t()); \
+		aParam = msg->decodedParam(curParam++);                                                                 \
+		chan->setModeInList(*aux, aParam, bSet, msg->decodedPrefix(), QDateTime::currentDateTime().toTime_t()); \
 		{                                                                                                                                   \
 		KviIrcMask auxMask(aParam);                                                                                                         \
 		bIsMe = auxMask.matchesFixed(                                                                                                       \
@@ -2381,8 +2381,8 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 				 * Examples:
 				 * spam filter with parameter like mode "g" in inspircd
 				 */
-					aParam = msg->connection()->decodeText(msg->safeParam(curParam++));
-					chan->setModeInList(*aux, aParam, bSet, msg->connection()->decodeText(msg->safePrefix()), QDateTime::currentDateTime().toTime_t());
+					aParam = msg->decodedParam(curParam++);
+					chan->setModeInList(*aux, aParam, bSet, msg->decodedPrefix(), QDateTime::currentDateTime().toTime_t());
 
 					if(!(msg->haltOutput() || bShowAsCompact))
 					{
@@ -2410,7 +2410,7 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 				 * flood mode with parameter like "[5m#M4]:5", see bug #505
 				 * Channel join throttling like "4:5", see bug #731
 				 */
-					aParam = msg->connection()->decodeText(msg->safeParam(curParam++));
+					aParam = msg->decodedParam(curParam++);
 					chan->setChannelModeWithParam(*aux, aParam);
 
 					if(!(msg->haltOutput() || bShowAsCompact))
@@ -2438,7 +2438,7 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 				 * We need to correctly echo it, and be sure it doesn't
 				 * get confused as a channel mode
 				 */
-					aParam = msg->connection()->decodeText(msg->safeParam(curParam++));
+					aParam = msg->decodedParam(curParam++);
 					// TODO support custom mode prefixes
 					//chan->setChannelModeWithParam(*aux,aParam);
 
@@ -2490,13 +2490,13 @@ void KviIrcServerParser::parseChannelMode(const QString & szNick, const QString
 
 	QString param;
 	QString params;
-	param = msg->connection()->decodeText(msg->safeParam(curParamSave++));
+	param = msg->decodedParam(curParamSave++);
 	while(!param.isEmpty())
 	{
 		if(!params.isEmpty())
 			params.append(' ');
 		params.append(param);
-		param = msg->connection()->decodeText(msg->safeParam(curParamSave++));
+		param = msg->decodedParam(curParamSave++);
 	}
 
 	if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnChannelModeChange, chan, szNick, szUser, szHost, modefl.ptr(), params))
@@ -2528,9 +2528,9 @@ void KviIrcServerParser::parseLiteralCap(KviIrcMessage * msg)
 	// Client2server subcommands:
 	// LIST, LS, REQ, CLEAR, END
 
-	QString szPrefix = msg->connection()->decodeText(msg->safePrefix());
-	QString szCmd = msg->connection()->decodeText(msg->safeParam(1));
-	QString szProtocols = msg->connection()->decodeText(msg->safeTrailing());
+	QString szPrefix = msg->decodedPrefix();
+	QString szCmd = msg->decodedParam(1);
+	QString szProtocols = msg->decodedTrailing();
 
 	if(KVS_TRIGGER_EVENT_3_HALTED(KviEvent_OnCap, msg->console(), szPrefix, szCmd, szProtocols))
 		msg->setHaltOutput();
@@ -2540,7 +2540,7 @@ void KviIrcServerParser::parseLiteralCap(KviIrcMessage * msg)
 		// :prefix CAP <nickname> LS [*] :<cap1> <cap2> <cap3> ....
 		// All but the last LS messages have the asterisk
 
-		QString szAsterisk = msg->connection()->decodeText(msg->safeParam(2));
+		QString szAsterisk = msg->decodedParam(2);
 		bool bLast = szAsterisk != "*";
 
 		msg->connection()->serverInfo()->addSupportedCaps(szProtocols);
@@ -2568,7 +2568,7 @@ void KviIrcServerParser::parseLiteralCap(KviIrcMessage * msg)
 		msg->connection()->serverInfo()->addSupportedCaps(szProtocols);
 		msg->connection()->stateData()->changeEnabledCapList(szProtocols);
 
-		QString szAsterisk = msg->connection()->decodeText(msg->safeParam(2));
+		QString szAsterisk = msg->decodedParam(2);
 		bool bLast = szAsterisk != "*";
 
 		if(msg->connection()->stateData()->isInsideInitialCapReq())
@@ -2636,7 +2636,7 @@ void KviIrcServerParser::parseLiteralAway(KviIrcMessage * msg)
 	QString szNick, szUser, szHost;
 	msg->decodeAndSplitPrefix(szNick, szUser, szHost);
 
-	QString awayMsg = msg->paramCount() > 0 ? msg->connection()->decodeText(msg->safeTrailing()) : QString();
+	QString awayMsg = msg->paramCount() > 0 ? msg->decodedTrailing() : QString();
 
 	// Update the user entry
 	KviIrcUserDataBase * db = msg->connection()->userDataBase();
@@ -32,6 +32,7 @@
 #include "KviIrcSocket.h"
 #include "KviOptions.h"
 #include "KviChannelWindow.h"
+#include "KviIrcConnectionStatistics.h"
 #include "KviTopicWidget.h"
 #include "KviIrcUserDataBase.h"
 #include "kvi_defaults.h"
@@ -61,6 +62,7 @@
 
 #include <QPixmap>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QTextCodec>
 #include <QRegExp>
 #include <QByteArray>
@@ -80,7 +82,7 @@ void KviIrcServerParser::parseNumeric001(KviIrcMessage * msg)
 	// 001: RPL_WELCOME
 	// :prefix 001 target :Welcome to the Internet Relay Network <usermask>
 	// FIXME: #warning "SET THE USERMASK FROM SERVER"
-	QString szText = msg->connection()->decodeText(msg->safeTrailing());
+	QString szText = msg->decodedTrailing();
 	QRegExp rx(" ([^ ]+)!([^ ]+)@([^ ]+)$");
 	if(rx.indexIn(szText) != -1)
 	{
@@ -101,7 +103,7 @@ void KviIrcServerParser::parseNumeric002(KviIrcMessage * msg)
 	if(msg->connection()->context()->state() != KviIrcContext::Connected)
 		msg->connection()->loginComplete(msg->connection()->decodeText(msg->param(0)));
 	if(!msg->haltOutput())
-		msg->console()->outputNoFmt(KVI_OUT_SERVERINFO, msg->connection()->decodeText(msg->safeTrailing()));
+		msg->console()->outputNoFmt(KVI_OUT_SERVERINFO, msg->decodedTrailing());
 }
 
 void KviIrcServerParser::parseNumeric003(KviIrcMessage * msg)
@@ -111,7 +113,7 @@ void KviIrcServerParser::parseNumeric003(KviIrcMessage * msg)
 	if(msg->connection()->context()->state() != KviIrcContext::Connected)
 		msg->connection()->loginComplete(msg->connection()->decodeText(msg->param(0)));
 	if(!msg->haltOutput())
-		msg->console()->outputNoFmt(KVI_OUT_SERVERINFO, msg->connection()->decodeText(msg->safeTrailing()));
+		msg->console()->outputNoFmt(KVI_OUT_SERVERINFO, msg->decodedTrailing());
 }
 
 void KviIrcServerParser::parseNumeric004(KviIrcMessage * msg)
@@ -205,7 +207,7 @@ void KviIrcServerParser::parseNumeric004(KviIrcMessage * msg)
 		}
 	}
 
-	QString szServer = msg->connection()->decodeText(msg->safeParam(1));
+	QString szServer = msg->decodedParam(1);
 
 	msg->connection()->serverInfoReceived(szServer, umodes.ptr(), chanmodes.ptr());
 
@@ -389,7 +391,7 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 	}
 	else
 	{
-		QString inf = msg->connection()->decodeText(msg->safeTrailing());
+		QString inf = msg->decodedTrailing();
 		if(!msg->haltOutput())
 			msg->console()->outputNoFmt(KVI_OUT_SERVERINFO, inf);
 	}
@@ -412,7 +414,7 @@ void KviIrcServerParser::parseNumericYourUID(KviIrcMessage * msg)
 	// :prefix 042 <target> <UID> :your unique ID
 	if(!msg->haltOutput())
 	{
-		QString szUID = msg->connection()->decodeText(msg->safeParam(1));
+		QString szUID = msg->decodedParam(1);
 
 		// Not important to us, just pass it off as server info.
 		msg->console()->output(KVI_OUT_SERVERINFO, __tr2qs("%Q is your unique ID"), &szUID);
@@ -431,7 +433,7 @@ void KviIrcServerParser::parseNumericMotd(KviIrcMessage * msg)
 	// :prefix 376 target :End of /MOTD command.
 	// FIXME: #warning "SKIP MOTD, MOTD IN A SEPARATE WINDOW, SILENT ENDOFMOTD, MOTD IN ACTIVE WINDOW"
 	if(!msg->haltOutput())
-		msg->console()->outputNoFmt(KVI_OUT_MOTD, msg->connection()->decodeText(msg->safeTrailing()), 0, msg->serverTime());
+		msg->console()->outputNoFmt(KVI_OUT_MOTD, msg->decodedTrailing(), 0, msg->serverTime());
 
 	if(msg->numeric() == RPL_ENDOFMOTD)
 		msg->connection()->endOfMotdReceived();
@@ -441,10 +443,17 @@ void KviIrcServerParser::parseNumericEndOfNames(KviIrcMessage * msg)
 {
 	// 366: RPL_ENDOFNAMES [I,E,U,D]
 	// :prefix 366 target <channel> :End of /NAMES list.
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan && !chan->hasAllNames())
 	{
+		// the NAMES burst is complete: build the user list
+		QElapsedTimer timer;
+		timer.start();
+		chan->userListView()->endBulkJoin();
+		msg->connection()->statistics()->addNamesTime(timer.nsecsElapsed() / 1000);
+		msg->connection()->statistics()->namesBurstCompleted(chan->count());
+
 		chan->setHasAllNames();
 		return;
 	}
@@ -464,7 +473,7 @@ void KviIrcServerParser::parseNumeric020(KviIrcMessage * msg)
 	QString szServer;
 	if(!msg->haltOutput())
 	{
-		QString szWText = msg->console()->decodeText(msg->safeTrailing());
+		QString szWText = msg->decodedTrailing(msg->console());
 		msg->console()->output(
 		    KVI_OUT_CONNECTION, "%c\r!s\r%s\r%c: %Q", KviControlCodes::Bold,
 		    msg->safePrefix(), KviControlCodes::Bold, &szWText);
@@ -479,9 +488,10 @@ void KviIrcServerParser::parseNumericNames(KviIrcMessage * msg)
 	// [=|*|@] is the type of the channel:
 	// = --> public  * --> private   @ --> secret
 	// ...but we ignore it
-	QString szChan = msg->connection()->decodeText(msg->safeParam(2));
+	QString szChan = msg->decodedParam(2);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
-	// and run to the first nickname
+	// and run to the first nickname: the nicknames are split in place
+	// in the copy owned by the message, which outlives this function
 	char * aux = msg->safeTrailingString().ptr();
 	while((*aux) && (*aux == ' '))
 		aux++;
@@ -493,10 +503,19 @@ void KviIrcServerParser::parseNumericNames(KviIrcMessage * msg)
 
 	if(chan)
 	{
-		bHalt = bHalt || (!chan->hasAllNames());
+		// The NAMES burst that follows our JOIN is collected and
+		// inserted in the user list at once on RPL_ENDOFNAMES
+		bool bBurst = !chan->hasAllNames();
+		bHalt = bHalt || bBurst;
+
+		QElapsedTimer timer;
+		timer.start();
 
 		// K...time to parse a lot of data
-		chan->enableUserListUpdates(false);
+		if(bBurst)
+			chan->userListView()->beginBulkJoin();
+		else
+			chan->enableUserListUpdates(false);
 
 		int iPrevFlags = chan->myFlags();
 
@@ -539,7 +558,10 @@ void KviIrcServerParser::parseNumericNames(KviIrcMessage * msg)
 		if(iPrevFlags != chan->myFlags())
 			chan->updateCaption();
 
-		chan->enableUserListUpdates(true);
+		if(bBurst)
+			msg->connection()->statistics()->addNamesTime(timer.nsecsElapsed() / 1000);
+		else
+			chan->enableUserListUpdates(true);
 		// finished a block
 	}
 
@@ -599,7 +621,7 @@ void KviIrcServerParser::parseNumericTopic(KviIrcMessage * msg)
 {
 	// 332: RPL_TOPIC [I,E,U,D]
 	// :prefix 332 target <channel> :<topic>
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan)
 	{
@@ -620,7 +642,7 @@ void KviIrcServerParser::parseNumericTopic(KviIrcMessage * msg)
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolServerRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
 
-		QString szTopic = msg->connection()->decodeText(msg->safeTrailing());
+		QString szTopic = msg->decodedTrailing();
 		pOut->output(KVI_OUT_TOPIC, __tr2qs("Topic for \r!c\r%Q\r is: %Q"),
 		    &szChan, &szTopic);
 	}
@@ -630,7 +652,7 @@ void KviIrcServerParser::parseNumericNoTopic(KviIrcMessage * msg)
 {
 	// 331: RPL_NOTOPIC [I,E,U,D]
 	// :prefix 331 target <channel> :No topic is set
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan)
 	{
@@ -651,7 +673,7 @@ void KviIrcServerParser::parseNumericTopicWhoTime(KviIrcMessage * msg)
 	// 333: RPL_TOPICWHOTIME [e,U,D]
 	// :prefix 333 target <channel> <whoset> <time>
 
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 
 	KviCString tmp = msg->safeParam(3);
@@ -679,7 +701,7 @@ void KviIrcServerParser::parseNumericTopicWhoTime(KviIrcMessage * msg)
 			break;
 	}
 
-	QString szWho = msg->connection()->decodeText(msg->safeParam(2));
+	QString szWho = msg->decodedParam(2);
 	KviIrcMask who(szWho);
 	QString szDisplayableWho;
 	if(!(who.hasUser() && who.hasHost()))
@@ -723,8 +745,8 @@ void KviIrcServerParser::parseNumericChannelModeIs(KviIrcMessage * msg)
 {
 	// 324: RPL_CHANNELMODEIS [I,E,U,D]
 	// :prefix 324 target <channel> +<chanmode>
-	QString szSource = msg->connection()->decodeText(msg->safePrefix());
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szSource = msg->decodedPrefix();
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	KviCString modefl = msg->safeParam(2);
 	if(chan)
@@ -778,9 +800,9 @@ void KviIrcServerParser::parseNumeric367(KviIrcMessage * msg)
 {
 	// 367: RPL_BANLIST [I,E,U,D]
 	// :prefix 367 target <channel> <banmask> [bansetby] [bansetat]
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-	QString banmask = msg->connection()->decodeText(msg->safeParam(2));
-	QString bansetby = msg->connection()->decodeText(msg->safeParam(3));
+	QString szChan = msg->decodedParam(1);
+	QString banmask = msg->decodedParam(2);
+	QString bansetby = msg->decodedParam(3);
 	QString bansetat;
 	getDateTimeStringFromCharTimeT(bansetat, msg->safeParam(4));
 	if(bansetby.isEmpty())
@@ -801,7 +823,7 @@ void KviIrcServerParser::parseNumeric367(KviIrcMessage * msg)
 
 void KviIrcServerParser::parseNumeric368(KviIrcMessage * msg)
 {
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan && chan->sentListRequest('b'))
 	{
@@ -818,7 +840,7 @@ void KviIrcServerParser::parseNumeric368(KviIrcMessage * msg)
 #define PARSE_NUMERIC_ENDOFLIST(__funcname, __modechar, __daicon, __szWhatQString)                                                                                                   \
 	void KviIrcServerParser::__funcname(KviIrcMessage * msg)                                                                                                                         \
 	{                                                                                                                                                                                \
-		QString szChan = msg->connection()->decodeText(msg->safeParam(1));                                                                                                           \
+		QString szChan = msg->decodedParam(1);                                                                                                           \
 		KviChannelWindow * chan = msg->connection()->findChannel(szChan);                                                                                                            \
 		if(chan)                                                                                                                                                                     \
 		{                                                                                                                                                                            \
@@ -848,9 +870,9 @@ PARSE_NUMERIC_ENDOFLIST(parseNumericEndOfExemptChanOpList, 'X', KVI_OUT_INVITEEX
 #define PARSE_NUMERIC_LIST(__funcname, __modechar, __ico, __szWhatQString)                                                                                                           \
 	void KviIrcServerParser::__funcname(KviIrcMessage * msg)                                                                                                                         \
 	{                                                                                                                                                                                \
-		QString szChan = msg->connection()->decodeText(msg->safeParam(1));                                                                                                           \
-		QString banmask = msg->connection()->decodeText(msg->safeParam(2));                                                                                                          \
-		QString bansetby = msg->connection()->decodeText(msg->safeParam(3));                                                                                                         \
+		QString szChan = msg->decodedParam(1);                                                                                                           \
+		QString banmask = msg->decodedParam(2);                                                                                                          \
+		QString bansetby = msg->decodedParam(3);                                                                                                         \
 		QString bansetat;                                                                                                                                                            \
 		getDateTimeStringFromCharTimeT(bansetat, msg->safeParam(4));                                                                                                                 \
 		if(bansetby.isEmpty())                                                                                                                                                       \
@@ -887,12 +909,12 @@ void KviIrcServerParser::parseNumericWhoReply(KviIrcMessage * msg)
 	// 352: RPL_WHOREPLY [I,E,U,D]
 	// :prefix 352 target <chan> <usr> <hst> <srv> <nck> <stat> :<hops> <real>
 
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-	QString szUser = msg->connection()->decodeText(msg->safeParam(2));
-	QString szHost = msg->connection()->decodeText(msg->safeParam(3));
-	QString szServ = msg->connection()->decodeText(msg->safeParam(4));
-	QString szNick = msg->connection()->decodeText(msg->safeParam(5));
-	QString szFlag = msg->connection()->decodeText(msg->safeParam(6));
+	QString szChan = msg->decodedParam(1);
+	QString szUser = msg->decodedParam(2);
+	QString szHost = msg->decodedParam(3);
+	QString szServ = msg->decodedParam(4);
+	QString szNick = msg->decodedParam(5);
+	QString szFlag = msg->decodedParam(6);
 	bool bAway = szFlag.indexOf('G') != -1;
 	bool bIrcOp = szFlag.indexOf('*') != -1;
 
@@ -994,7 +1016,7 @@ void KviIrcServerParser::parseNumericWhospcrpl(KviIrcMessage * msg)
 	// :prefix 354 target <chan> <user> <host> <server> <nick> <flags> <hops> <idle> <account> :<gecos>
 	// NOTE: Because you can arbitrarily send parameters to query extended WHOX,
 	// we will not parse anything that was not generated by the client itself.
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 
 	// TODO: Send a templated response to the user.
 	// We could add logic to determine what parameters they requested and try to
@@ -1006,7 +1028,7 @@ void KviIrcServerParser::parseNumericWhospcrpl(KviIrcMessage * msg)
 	{
 		if(chan->hasWhoList() && !chan->sentSyncWhoRequest())
 		{
-			QString szWText = msg->connection()->decodeText(msg->allParams());
+			QString szWText = msg->decodedAllParams();
 			KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoRepliesToActiveWindow) && chan ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
 
 			pOut->output(KVI_OUT_UNHANDLED,
@@ -1021,15 +1043,15 @@ void KviIrcServerParser::parseNumericWhospcrpl(KviIrcMessage * msg)
 
 	if(!chan->hasWhoList() || chan->sentSyncWhoRequest())
 	{
-		QString szUser = msg->connection()->decodeText(msg->safeParam(2));
-		QString szHost = msg->connection()->decodeText(msg->safeParam(3));
-		QString szServ = msg->connection()->decodeText(msg->safeParam(4));
-		QString szNick = msg->connection()->decodeText(msg->safeParam(5));
-		QString szFlag = msg->connection()->decodeText(msg->safeParam(6));
+		QString szUser = msg->decodedParam(2);
+		QString szHost = msg->decodedParam(3);
+		QString szServ = msg->decodedParam(4);
+		QString szNick = msg->decodedParam(5);
+		QString szFlag = msg->decodedParam(6);
 		KviCString iHops = msg->safeParam(7);
 		// KviCString szIdle = msg->safeParam(8);
-		QString szAcct = msg->connection()->decodeText(msg->safeParam(9));
-		QString szReal = msg->connection()->decodeText(msg->safeTrailing());
+		QString szAcct = msg->decodedParam(9);
+		QString szReal = msg->decodedTrailing();
 		bool bAway = szFlag.indexOf('G') != -1;
 		bool bIrcOp = szFlag.indexOf('*') != -1;
 
@@ -1095,7 +1117,7 @@ void KviIrcServerParser::parseNumericEndOfWho(KviIrcMessage * msg)
 {
 	// 315: RPL_ENDOFWHO [I,E,U,D]
 	// :prefix 315 target <channel/nick> :End of /WHO List.
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan)
 	{
@@ -1127,7 +1149,7 @@ void KviIrcServerParser::parseNumericEndOfWho(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoRepliesToActiveWindow) && chan ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
-		QString whoTarget = msg->connection()->decodeText(msg->safeParam(1));
+		QString whoTarget = msg->decodedParam(1);
 		if(IS_CHANNEL_TYPE_FLAG(whoTarget[0]))
 			whoTarget.prepend("\r!c\r");
 		else
@@ -1145,7 +1167,7 @@ void KviIrcServerParser::parseLoginNicknameProblem(KviIrcMessage * msg)
 
 	QString szNextNick = msg->connection()->pickNextLoginNickName(
 	    false, // false = fallback to random choices, then give up with an empty string
-	    msg->connection()->decodeText(msg->safeParam(1)),
+	    msg->decodedParam(1),
 	    szChoiceDescriptionBuffer);
 
 	if(szNextNick.isEmpty())
@@ -1165,9 +1187,9 @@ void KviIrcServerParser::parseLoginNicknameProblem(KviIrcMessage * msg)
 		msg->console()->output(
 		    KVI_OUT_NICKNAMEPROBLEM,
 		    __tr2qs("No way to login as \r!n\r%1\r: the server said '%2: %3'")
-		        .arg(msg->connection()->decodeText(msg->safeParam(1)))
+		        .arg(msg->decodedParam(1))
 		        .arg(msg->numeric())
-		        .arg(msg->connection()->decodeText(msg->safeTrailing())));
+		        .arg(msg->decodedTrailing()));
 
 		QString szOut = __tr2qs("Trying to use %1 as nickname").arg(szNextNick);
 		if(_OUTPUT_VERBOSE)
@@ -1187,7 +1209,7 @@ void KviIrcServerParser::parseNumericUnknownCommand(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = msg->console()->activeWindow();
-		QString szCmd = msg->connection()->decodeText(msg->safeParam(1));
+		QString szCmd = msg->decodedParam(1);
 		pOut->output(KVI_OUT_GENERICERROR, __tr2qs("%Q is an unknown server command"), &szCmd);
 	}
 }
@@ -1198,7 +1220,7 @@ void KviIrcServerParser::parseNumericMotdMissing(KviIrcMessage * msg)
 	// :prefix 422 <target> :- MOTD file not found!  Please contact your IRC administrator.
 	if(!msg->haltOutput())
 	{
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szText = msg->decodedTrailing();
 		msg->console()->output(KVI_OUT_GENERICERROR, szText);
 	}
 }
@@ -1212,8 +1234,8 @@ void KviIrcServerParser::parseNumericBanOnChan(KviIrcMessage * msg)
 		KviWindow * pOut = static_cast<KviWindow *>(msg->connection()->findChannel(msg->safeParam(2)));
 		if(!pOut)
 			pOut = static_cast<KviWindow *>(msg->console());
-		QString szChannel = msg->connection()->decodeText(msg->safeParam(2));
-		QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szChannel = msg->decodedParam(2);
+		QString szWText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_JOINERROR,
 		    "\r!c\r%Q\r: %Q", &szChannel, &szWText);
 	}
@@ -1232,8 +1254,8 @@ void KviIrcServerParser::parseNumericUnavailResource(KviIrcMessage * msg)
 		// already connected... just say that we have problems
 		if(!msg->haltOutput())
 		{
-			QString szNk = msg->connection()->decodeText(msg->safeParam(1));
-			QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+			QString szNk = msg->decodedParam(1);
+			QString szWText = msg->decodedTrailing();
 			msg->console()->output(KVI_OUT_NICKNAMEPROBLEM, "\r!n\r%Q\r: %Q", &szNk, &szWText);
 		}
 	}
@@ -1248,8 +1270,8 @@ void KviIrcServerParser::parseNumericUserInChan(KviIrcMessage * msg)
 		KviWindow * pOut = static_cast<KviWindow *>(msg->connection()->findChannel(msg->safeParam(2)));
 		if(!pOut)
 			pOut = static_cast<KviWindow *>(msg->console()); // This would be interesting...
-		QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-		QString szChan = msg->connection()->decodeText(msg->safeParam(2));
+		QString szNick = msg->decodedParam(1);
+		QString szChan = msg->decodedParam(2);
 		pOut->output(KVI_OUT_GENERICERROR, __tr2qs("%Q is already in %Q"), &szNick, &szChan);
 	}
 }
@@ -1260,9 +1282,9 @@ void KviIrcServerParser::parseNumericForward(KviIrcMessage * msg)
 	// :prefix 470 target <oldchan> <newchan> :Forwarding to another channel
 	if(!msg->haltOutput())
 	{
-		QString pref = msg->connection()->decodeText(msg->safePrefix());
-		QString szOldChan = msg->connection()->decodeText(msg->safeParam(1));
-		QString szNewChan = msg->connection()->decodeText(msg->safeParam(2));
+		QString pref = msg->decodedPrefix();
+		QString szOldChan = msg->decodedParam(1);
+		QString szNewChan = msg->decodedParam(2);
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolServerNoticesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
 		// This technically isn't a notice, yet it is fairly useful information.
 		// The server gives us good data with a pretty unusable description. So
@@ -1285,8 +1307,8 @@ void KviIrcServerParser::parseNumericCantJoinChannel(KviIrcMessage * msg)
 		KviWindow * pOut = static_cast<KviWindow *>(msg->connection()->findChannel(msg->safeParam(1)));
 		if(!pOut)
 			pOut = static_cast<KviWindow *>(msg->console());
-		QString szChannel = msg->connection()->decodeText(msg->safeParam(1));
-		QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szChannel = msg->decodedParam(1);
+		QString szWText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_JOINERROR,
 		    "\r!c\r%Q\r: %Q", &szChannel, &szWText);
 	}
@@ -1301,7 +1323,7 @@ void KviIrcServerParser::parseNumericNoPrivs(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_GENERICERROR, szText);
 	}
 }
@@ -1317,8 +1339,8 @@ void KviIrcServerParser::otherChannelError(KviIrcMessage * msg)
 		KviWindow * pOut = static_cast<KviWindow *>(msg->connection()->findChannel(msg->safeParam(1)));
 		if(!pOut)
 			pOut = static_cast<KviWindow *>(msg->console());
-		QString szChannel = msg->connection()->decodeText(msg->safeParam(1));
-		QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szChannel = msg->decodedParam(1);
+		QString szWText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_GENERICERROR, "\r!c\r%Q\r: %Q", &szChannel, &szWText);
 	}
 }
@@ -1332,8 +1354,8 @@ void KviIrcServerParser::parseNumeric486(KviIrcMessage * msg)
 	// :prefix 486 <target> :CMD is currently disabled, please try again later.
 	if(!msg->haltOutput())
 	{
-		QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szNick = msg->decodedParam(1);
+		QString szText = msg->decodedTrailing();
 		KviIrcConnectionServerInfo * pServerInfo = msg->connection()->serverInfo();
 		QString version = pServerInfo->software();
 
@@ -1361,8 +1383,8 @@ void KviIrcServerParser::parseCommandSyntaxHelp(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szCommand = msg->connection()->decodeText(msg->safeParam(1));
-		QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szCommand = msg->decodedParam(1);
+		QString szWText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_HELP,
 		    __tr2qs("Command syntax %Q: %Q"), &szCommand, &szWText); // Pragma: wheee..... that should be in English :D
 	}
@@ -1375,8 +1397,8 @@ void KviIrcServerParser::parseCommandHelp(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szCommand = msg->connection()->decodeText(msg->safeParam(1));
-		QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szCommand = msg->decodedParam(1);
+		QString szWText = msg->decodedTrailing();
 		pOut->outputNoFmt(KVI_OUT_HELP, szWText);
 	}
 }
@@ -1388,8 +1410,8 @@ void KviIrcServerParser::parseNumericNotifyGeneric(KviIrcMessage * msg)
 	// :prefix 71? target <nick> :has been informed that you messaged them.
 	if(!msg->haltOutput())
 	{
-		QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szNick = msg->decodedParam(1);
+		QString szText = msg->decodedTrailing();
 
 		// Send this to the active query, since if they are trying to message this
 		// user then it should appear directly within the window. Otherwise, just
@@ -1410,9 +1432,9 @@ void KviIrcServerParser::parseNumericYouHaveCallerID(KviIrcMessage * msg)
 	// :prefix 718 <target> <remote nick[ [user@host]]> :is messaging you, and you are umode +g or +G.
 	if(!msg->haltOutput())
 	{
-		QString szRemoteUser = msg->connection()->decodeText(msg->safeParam(1));
-		QString szRemoteHost = msg->connection()->decodeText(msg->safeParam(2));
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szRemoteUser = msg->decodedParam(1);
+		QString szRemoteHost = msg->decodedParam(2);
+		QString szText = msg->decodedTrailing();
 
 		// This would be ironic if it hit, but you never know...
 		KviWindow * pOut = static_cast<KviWindow *>(msg->connection()->findQuery(szRemoteUser));
@@ -1435,8 +1457,8 @@ void KviIrcServerParser::parseChannelHelp(KviIrcMessage * msg)
 	// :prefix 477 <target> <channel> :text
 	if(!msg->haltOutput())
 	{
-		QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szChan = msg->decodedParam(1);
+		QString szText = msg->decodedTrailing();
 		KviWindow * pOut = msg->connection()->findChannel(szChan);
 		if(pOut)
 		{
@@ -1456,7 +1478,7 @@ void KviIrcServerParser::parseNumericNeedSSL(KviIrcMessage * msg)
 	// :prefix 480 <target> <channel> :<text>
 	if(!msg->haltOutput())
 	{
-		QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+		QString szChan = msg->decodedParam(1);
 		KviWindow * pOut = msg->connection()->findChannel(szChan);
 		if(pOut)
 		{
@@ -1478,7 +1500,7 @@ void KviIrcServerParser::parseCommandEndOfHelp(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szCommand = msg->connection()->decodeText(msg->safeParam(1));
+		QString szCommand = msg->decodedParam(1);
 		pOut->output(KVI_OUT_HELP,
 		    __tr2qs("End of help about %Q"), &szCommand);
 	}
@@ -1500,8 +1522,8 @@ void KviIrcServerParser::parseNumericNicknameProblem(KviIrcMessage * msg)
 		// already connected... just say that we have problems
 		if(!msg->haltOutput())
 		{
-			QString szNk = msg->connection()->decodeText(msg->safeParam(1));
-			QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+			QString szNk = msg->decodedParam(1);
+			QString szWText = msg->decodedTrailing();
 			msg->console()->output(KVI_OUT_NICKNAMEPROBLEM,
 			    "\r!n\r%Q\r: %Q", &szNk, &szWText);
 		}
@@ -1513,7 +1535,7 @@ void KviIrcServerParser::parseNumericWhoisAway(KviIrcMessage * msg)
 	// FIXME: #warning "Need an icon here too: sth like KVI_OUT_WHOISSERVER, but with 'A' letter"
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNk = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNk = msg->decodedParam(1);
 	KviIrcUserDataBase * db = msg->connection()->userDataBase();
 	KviIrcUserEntry * e = db->find(szNk);
 	if(e)
@@ -1521,7 +1543,7 @@ void KviIrcServerParser::parseNumericWhoisAway(KviIrcMessage * msg)
 	KviQueryWindow * q = msg->connection()->findQuery(szNk);
 	if(q)
 		q->updateLabelText();
-	QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+	QString szWText = msg->decodedTrailing();
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNk);
 	if(i)
@@ -1549,10 +1571,10 @@ void KviIrcServerParser::parseNumericWhoisUser(KviIrcMessage * msg)
 	// :prefix 311 <target> <nick> <user> <host> * :<real_name>
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-	QString szUser = msg->connection()->decodeText(msg->safeParam(2));
-	QString szHost = msg->connection()->decodeText(msg->safeParam(3));
-	QString szReal = msg->connection()->decodeText(msg->safeTrailing());
+	QString szNick = msg->decodedParam(1);
+	QString szUser = msg->decodedParam(2);
+	QString szHost = msg->decodedParam(3);
+	QString szReal = msg->decodedTrailing();
 	KviIrcUserDataBase * db = msg->connection()->userDataBase();
 	KviIrcUserEntry * e = db->find(szNick);
 	if(e)
@@ -1614,10 +1636,10 @@ void KviIrcServerParser::parseNumericWhowasUser(KviIrcMessage * msg)
 
 	if(!msg->haltOutput())
 	{
-		QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-		QString szUser = msg->connection()->decodeText(msg->safeParam(2));
-		QString szHost = msg->connection()->decodeText(msg->safeParam(3));
-		QString szReal = msg->connection()->decodeText(msg->safeTrailing());
+		QString szNick = msg->decodedParam(1);
+		QString szUser = msg->decodedParam(2);
+		QString szHost = msg->decodedParam(3);
+		QString szReal = msg->decodedTrailing();
 
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoisRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
 		pOut->output(
@@ -1637,8 +1659,8 @@ void KviIrcServerParser::parseNumericWhoisChannels(KviIrcMessage * msg)
 
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-	QString szChans = msg->connection()->decodeText(msg->safeTrailing());
+	QString szNick = msg->decodedParam(1);
+	QString szChans = msg->decodedTrailing();
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(i)
@@ -1707,7 +1729,7 @@ void KviIrcServerParser::parseNumericWhoisIdle(KviIrcMessage * msg)
 	// FIXME: #warning "and NICK LINKS"
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNick = msg->decodedParam(1);
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(i)
@@ -1779,8 +1801,8 @@ void KviIrcServerParser::parseNumericWhoisServer(KviIrcMessage * msg)
 	// :prefix 312 <target> <nick> <server> :<server description / last whowas date>
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-	QString szServ = msg->connection()->decodeText(msg->safeParam(2));
+	QString szNick = msg->decodedParam(1);
+	QString szServ = msg->decodedParam(2);
 
 	KviIrcUserDataBase * db = msg->connection()->userDataBase();
 	KviIrcUserEntry * e = db->find(szNick);
@@ -1805,7 +1827,7 @@ void KviIrcServerParser::parseNumericWhoisServer(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoisRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
-		QString szWText = pOut->decodeText(msg->safeTrailing());
+		QString szWText = msg->decodedTrailing(pOut);
 		pOut->output(
 		    KVI_OUT_WHOISSERVER, __tr2qs("%c\r!n\r%Q\r%c's server: \r!s\r%Q\r - %Q"), KviControlCodes::Bold,
 		    &szNick, KviControlCodes::Bold, &szServ, &szWText);
@@ -1819,8 +1841,8 @@ void KviIrcServerParser::parseNumericWhoisAuth(KviIrcMessage * msg)
 
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-	QString szAuth = (msg->numeric() == 307) ? szNick : msg->connection()->decodeText(msg->safeParam(2));
+	QString szNick = msg->decodedParam(1);
+	QString szAuth = (msg->numeric() == 307) ? szNick : msg->decodedParam(2);
 
 	KviAsyncWhoisInfo * pInfo = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(pInfo)
@@ -1845,7 +1867,7 @@ void KviIrcServerParser::parseNumericWhoisRegistered(KviIrcMessage * msg)
 
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNick = msg->decodedParam(1);
 
 	if(!msg->haltOutput())
 	{
@@ -1867,10 +1889,10 @@ void KviIrcServerParser::parseNumericWhoisActually(KviIrcMessage * msg)
 	// FIXME: #warning "and NICK LINKS"
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-	QString szUserHost = msg->connection()->decodeText(msg->safeParam(2));
-	QString szIpAddr = msg->connection()->decodeText(msg->safeParam(3));
-	QString szOth = msg->connection()->decodeText(msg->safeTrailing());
+	QString szNick = msg->decodedParam(1);
+	QString szUserHost = msg->decodedParam(2);
+	QString szIpAddr = msg->decodedParam(3);
+	QString szOth = msg->decodedTrailing();
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(i)
@@ -1909,8 +1931,8 @@ void KviIrcServerParser::parseNumericWhoisOther(KviIrcMessage * msg)
 
 	msg->connection()->stateData()->setLastReceivedWhoisReply(kvi_unixTime());
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-	QString szOth = msg->connection()->decodeText(msg->safeTrailing());
+	QString szNick = msg->decodedParam(1);
+	QString szOth = msg->decodedTrailing();
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(i)
@@ -1940,7 +1962,7 @@ void KviIrcServerParser::parseNumericEndOfWhois(KviIrcMessage * msg)
 
 	msg->connection()->stateData()->setLastReceivedWhoisReply(0);
 
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNick = msg->decodedParam(1);
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(i)
@@ -1973,7 +1995,7 @@ void KviIrcServerParser::parseNumericEndOfWhois(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoisRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
-		QString pref = msg->connection()->decodeText(msg->safePrefix());
+		QString pref = msg->decodedPrefix();
 		pOut->output(
 		    KVI_OUT_WHOISOTHER, __tr2qs("%c\r!n\r%Q\r%c WHOIS info from \r!s\r%Q\r"), KviControlCodes::Bold,
 		    &szNick, KviControlCodes::Bold, &pref);
@@ -1989,9 +2011,9 @@ void KviIrcServerParser::parseNumericEndOfWhowas(KviIrcMessage * msg)
 
 	if(!msg->haltOutput())
 	{
-		QString szNick = msg->connection()->decodeText(msg->safeParam(1));
+		QString szNick = msg->decodedParam(1);
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoisRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
-		QString pref = msg->connection()->decodeText(msg->safePrefix());
+		QString pref = msg->decodedPrefix();
 		pOut->output(
 		    KVI_OUT_WHOISOTHER, __tr2qs("%c\r!n\r%Q\r%c WHOWAS info from \r!s\r%Q\r"), KviControlCodes::Bold,
 		    &szNick, KviControlCodes::Bold, &pref);
@@ -2004,7 +2026,7 @@ void KviIrcServerParser::parseNumericNoSuchNick(KviIrcMessage * msg)
 	// 406: ERR_WASNOSUCHNICK [I,E,U,D]
 	// :prefix 401 <target> <nick> :No such nick/channel
 	// :prefix 406 <target> <nick> :There was no such nickname
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNick = msg->decodedParam(1);
 
 	if(msg->numeric() == ERR_NOSUCHNICK)
 	{
@@ -2037,7 +2059,7 @@ void KviIrcServerParser::parseNumericNoSuchNick(KviIrcMessage * msg)
 		//} else {
 		//	(static_cast<KviQueryWindow *>(pOut))->removeTarget(msg->safeParam(1));
 		//}
-		QString szWText = pOut->decodeText(msg->safeTrailing());
+		QString szWText = msg->decodedTrailing(pOut);
 		pOut->output(KVI_OUT_NICKNAMEPROBLEM, "\r!n\r%Q\r: %Q",
 		    &szNick, &szWText);
 	}
@@ -2048,14 +2070,14 @@ void KviIrcServerParser::parseNumericChanUrl(KviIrcMessage * msg)
 	// 328: RPL_CHANURL
 	// :prefix 328 target <channel> :<url>
 
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 
 	QString szUrl;
 
 	if(chan)
 	{
-		szUrl = chan->decodeText(msg->safeTrailing());
+		szUrl = msg->decodedTrailing(chan);
 		if(!msg->haltOutput())
 		{
 			chan->output(KVI_OUT_CHANURL, __tr2qs("This channel's website is: %Q"), &szUrl);
@@ -2063,7 +2085,7 @@ void KviIrcServerParser::parseNumericChanUrl(KviIrcMessage * msg)
 	}
 	else
 	{
-		szUrl = msg->console()->decodeText(msg->safeTrailing());
+		szUrl = msg->decodedTrailing(msg->console());
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolServerRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
 		pOut->output(KVI_OUT_CHANURL, __tr2qs("This channel's website is: %Q"), &szUrl);
 	}
@@ -2073,7 +2095,7 @@ void KviIrcServerParser::parseNumericCreationTime(KviIrcMessage * msg)
 {
 	// 329: RPL_CREATIONTIME
 	// :prefix 329 <target> <channel> <creation_time>
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	KviCString tmstr = msg->safeParam(2);
 	QDateTime date;
@@ -2130,8 +2152,8 @@ void KviIrcServerParser::parseNumericIsOn(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = msg->console()->activeWindow();
-		QString szPrefix = msg->connection()->decodeText(msg->safePrefix());
-		QString szUser = msg->connection()->decodeText(msg->safeTrailing());
+		QString szPrefix = msg->decodedPrefix();
+		QString szUser = msg->decodedTrailing();
 		QString szOutput = szUser.isEmpty() ? "That user is not online" : szUser + "is online";
 		pOut->output(KVI_OUT_HELP, szOutput);
 	}
@@ -2150,7 +2172,7 @@ void KviIrcServerParser::parseNumericUserhost(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolServerRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
-		QString szUser = msg->connection()->decodeText(msg->safeTrailing());
+		QString szUser = msg->decodedTrailing();
 		pOut->output(KVI_OUT_WHOISUSER, __tr2qs("USERHOST info: %Q"), &szUser);
 	}
 }
@@ -2204,7 +2226,7 @@ void KviIrcServerParser::parseNumericList(KviIrcMessage * msg)
 	else
 	{
 		// Oops...can't load the module...
-		QString szList = msg->connection()->decodeText(msg->allParams());
+		QString szList = msg->decodedAllParams();
 		msg->console()->output(KVI_OUT_LIST, __tr2qs("List: %Q"), &szList);
 	}
 }
@@ -2246,7 +2268,7 @@ void KviIrcServerParser::parseNumericLinks(KviIrcMessage * msg)
 		// Oops...can't load the module... or the event halted the window creation
 		if(!msg->haltOutput())
 		{
-			QString szList = msg->connection()->decodeText(msg->allParams());
+			QString szList = msg->decodedAllParams();
 			msg->console()->output(KVI_OUT_LINKS, __tr2qs("Link: %Q"), &szList);
 		}
 	}
@@ -2275,7 +2297,7 @@ void KviIrcServerParser::parseNumericBackFromAway(KviIrcMessage * msg)
 	// :prefix 305 <target> :You are no longer away
 	bool bWasAway = msg->connection()->userInfo()->isAway();
 	QString szNickBeforeAway;
-	QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+	QString szWText = msg->decodedTrailing();
 
 	if(bWasAway)
 		szNickBeforeAway = msg->connection()->userInfo()->nickNameBeforeAway();
@@ -2316,7 +2338,7 @@ void KviIrcServerParser::parseNumericAway(KviIrcMessage * msg)
 	// 306: RPL_NOWAWAY [I,E,U,D]
 	// :prefix 305 <target> :You're away man
 	msg->connection()->changeAwayState(true);
-	QString szWText = msg->connection()->decodeText(msg->safeTrailing());
+	QString szWText = msg->decodedTrailing();
 
 	if(KVS_TRIGGER_EVENT_1_HALTED(KviEvent_OnMeAway, msg->console(), szWText))
 		msg->setHaltOutput();
@@ -2329,7 +2351,7 @@ void KviIrcServerParser::parseNumericAway(KviIrcMessage * msg)
 
 	if(KVI_OPTION_BOOL(KviOption_boolChangeNickAway))
 	{
-		QString nick = msg->connection()->decodeText(msg->safeParam(0));
+		QString nick = msg->decodedParam(0);
 		QString szNewNick;
 		if(KVI_OPTION_BOOL(KviOption_boolAutoGeneratedAwayNick))
 		{
@@ -2359,7 +2381,7 @@ void KviIrcServerParser::parseNumericUsersDontMatch(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = msg->console()->activeWindow();
-		QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szMsgText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_GENERICERROR, szMsgText);
 	}
 }
@@ -2411,7 +2433,7 @@ void KviIrcServerParser::parseNumericStats(KviIrcMessage * msg)
 		}
 		else
 		{
-			pOut->outputNoFmt(KVI_OUT_STATS, msg->connection()->decodeText(msg->safeTrailing()).toUtf8().data());
+			pOut->outputNoFmt(KVI_OUT_STATS, msg->decodedTrailing().toUtf8().data());
 		}
 	}
 }
@@ -2422,7 +2444,7 @@ void KviIrcServerParser::parseNumericServerAdminInfoTitle(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		pOut->outputNoFmt(KVI_OUT_SERVERINFO, msg->connection()->decodeText(msg->safeTrailing()).toUtf8().data());
+		pOut->outputNoFmt(KVI_OUT_SERVERINFO, msg->decodedTrailing().toUtf8().data());
 	}
 }
 void KviIrcServerParser::parseNumericServerAdminInfoServerName(KviIrcMessage * msg)
@@ -2431,7 +2453,7 @@ void KviIrcServerParser::parseNumericServerAdminInfoServerName(KviIrcMessage * m
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szInfo = msg->decodedTrailing();
 		pOut->output(KVI_OUT_SERVERINFO, __tr2qs("%c\r!s\r%s\r%c's server info: %s"), KviControlCodes::Bold, msg->prefix(), KviControlCodes::Bold, szInfo.toUtf8().data());
 	}
 }
@@ -2442,7 +2464,7 @@ void KviIrcServerParser::parseNumericServerAdminInfoAdminName(KviIrcMessage * ms
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szInfo = msg->decodedTrailing();
 		pOut->output(KVI_OUT_SERVERINFO, __tr2qs("%c\r!s\r%s\r%c's administrator is %s"), KviControlCodes::Bold, msg->prefix(), KviControlCodes::Bold, szInfo.toUtf8().data());
 	}
 }
@@ -2453,7 +2475,7 @@ void KviIrcServerParser::parseNumericServerAdminInfoAdminContact(KviIrcMessage *
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szInfo = msg->decodedTrailing();
 		pOut->output(KVI_OUT_SERVERINFO, __tr2qs("%c\r!s\r%s\r%c's contact address is %s"), KviControlCodes::Bold, msg->prefix(), KviControlCodes::Bold, szInfo.toUtf8().data());
 	}
 }
@@ -2464,8 +2486,8 @@ void KviIrcServerParser::parseNumericTryAgain(KviIrcMessage * msg)
 	// :prefix 263 <target> <command> :This command could not be completed because it has been used recently, and is rate-limited.
 	if(!msg->haltOutput())
 	{
-		QString szCmd = msg->connection()->decodeText(msg->safeParam(1));
-		QString szComment = msg->connection()->decodeText(msg->safeTrailing());
+		QString szCmd = msg->decodedParam(1);
+		QString szComment = msg->decodedTrailing();
 		KviWindow * pOut = msg->console()->activeWindow();
 
 		// Bank on the IRCd providing a useful explanation.
@@ -2480,7 +2502,7 @@ void KviIrcServerParser::parseNumericCommandSyntax(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		pOut->outputNoFmt(KVI_OUT_STATS, msg->connection()->decodeText(msg->safeTrailing()));
+		pOut->outputNoFmt(KVI_OUT_STATS, msg->decodedTrailing());
 	}
 }
 
@@ -2489,9 +2511,9 @@ void KviIrcServerParser::parseNumericInviting(KviIrcMessage * msg)
 	//RPL_INVITING         341
 	if(!msg->haltOutput())
 	{
-		QString szWho = msg->connection()->decodeText(msg->safeParam(0));
-		QString szTarget = msg->connection()->decodeText(msg->safeParam(1));
-		QString szChan = msg->connection()->decodeText(msg->safeParam(2));
+		QString szWho = msg->decodedParam(0);
+		QString szTarget = msg->decodedParam(1);
+		QString szChan = msg->decodedParam(2);
 		KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 		if(chan)
 		{
@@ -2510,9 +2532,9 @@ void KviIrcServerParser::parseNumericInvited(KviIrcMessage * msg)
 	//RPL_INVITED          345
 	if(!msg->haltOutput())
 	{
-		QString szWho = msg->connection()->decodeText(msg->safeParam(2));
-		QString szTarget = msg->connection()->decodeText(msg->safeParam(1));
-		QString szChan = msg->connection()->decodeText(msg->safeParam(0));
+		QString szWho = msg->decodedParam(2);
+		QString szTarget = msg->decodedParam(1);
+		QString szChan = msg->decodedParam(0);
 		KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 		if(chan)
 		{
@@ -2600,9 +2622,9 @@ void KviIrcServerParser::parseNumeric742(KviIrcMessage * msg)
 {
 	// ERR_MLOCKRESTRICTED 742
 	// :<prefix> 742 <target> <channel> <mode> <mlocked modes> :MODE cannot be set due to channel having an active MLOCK restriction policy
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-	QString mode = msg->connection()->decodeText(msg->safeParam(2));
-	QString lock = msg->connection()->decodeText(msg->safeParam(3));
+	QString szChan = msg->decodedParam(1);
+	QString mode = msg->decodedParam(2);
+	QString lock = msg->decodedParam(3);
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan)
 	{
@@ -2623,7 +2645,7 @@ void KviIrcServerParser::parseNumericInfo(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szInfo = msg->decodedTrailing();
 		pOut->outputNoFmt(KVI_OUT_SERVERINFO, szInfo);
 	}
 }
@@ -2654,7 +2676,7 @@ void KviIrcServerParser::parseNumericTime(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szInfo = msg->decodedTrailing();
 		pOut->output(KVI_OUT_SERVERINFO, __tr2qs("%c\r!s\r%s\r%c's time is %Q"), KviControlCodes::Bold, msg->prefix(), KviControlCodes::Bold, &szInfo);
 	}
 }
@@ -2663,9 +2685,9 @@ void KviIrcServerParser::parseNumericHiddenHost(KviIrcMessage * msg)
 {
 	//RPL_HOSTHIDDEN       396
 	//<prefix> 396 target <[user@]host> :<message>
-	QString pref = msg->connection()->decodeText(msg->safePrefix());
-	QString szHost = msg->connection()->decodeText(msg->safeParam(1));
-	QString szMsgText = msg->connection()->decodeText(msg->safeTrailing());
+	QString pref = msg->decodedPrefix();
+	QString szHost = msg->decodedParam(1);
+	QString szMsgText = msg->decodedTrailing();
 
 	if(KVS_TRIGGER_EVENT_2_HALTED(KviEvent_OnMeHostChange, msg->console(), pref, szHost))
 		msg->setHaltOutput();
@@ -2681,7 +2703,7 @@ void KviIrcServerParser::parseNumericNoSuchServer(KviIrcMessage * msg)
 {
 	//ERR_NOSUCHSERVER     402
 	//this can be an "awhois -i" reply for a nickname that's not connected
-	QString szNick = msg->connection()->decodeText(msg->safeParam(1));
+	QString szNick = msg->decodedParam(1);
 
 	KviAsyncWhoisInfo * i = msg->connection()->asyncWhoisData()->lookup(szNick);
 	if(i)
@@ -2703,7 +2725,7 @@ void KviIrcServerParser::parseNumericNoSuchServer(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szWhat = msg->connection()->decodeText(msg->safeParam(1));
+		QString szWhat = msg->decodedParam(1);
 		pOut->output(KVI_OUT_GENERICERROR, __tr2qs("%Q: no such server"), &szWhat);
 	}
 }
@@ -2714,7 +2736,7 @@ void KviIrcServerParser::parseNumericNoSuchChannel(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szWhat = msg->connection()->decodeText(msg->safeParam(1));
+		QString szWhat = msg->decodedParam(1);
 		pOut->output(KVI_OUT_GENERICERROR, __tr2qs("%Q: no such channel"), &szWhat);
 	}
 }
@@ -2724,8 +2746,8 @@ void KviIrcServerParser::parseNumericCannotSendColor(KviIrcMessage * msg)
 	// ERR_NOCOLORSONCHAN   408
 	if(!msg->haltOutput())
 	{
-		QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szChan = msg->decodedParam(1);
+		QString szInfo = msg->decodedTrailing();
 		KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 		if(chan)
 		{
@@ -2744,8 +2766,8 @@ void KviIrcServerParser::parseNumericCannotSend(KviIrcMessage * msg)
 	// ERR_CANNOTSENDTOCHAN 404
 	if(!msg->haltOutput())
 	{
-		QString szChan = msg->connection()->decodeText(msg->safeParam(1));
-		QString szInfo = msg->connection()->decodeText(msg->safeTrailing());
+		QString szChan = msg->decodedParam(1);
+		QString szInfo = msg->decodedTrailing();
 		KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 		if(chan)
 		{
@@ -2765,7 +2787,7 @@ void KviIrcServerParser::parseNumericCodePageSet(KviIrcMessage * msg)
 	// 700: RPL_CODEPAGESET
 	// :prefix 700 target <encoding> :is now your translation scheme
 
-	QString encoding = msg->connection()->decodeText(msg->safeParam(1));
+	QString encoding = msg->decodedParam(1);
 	if(msg->connection()->serverInfo()->supportsCodePages())
 	{
 		if(encoding == "NONE")
@@ -2776,7 +2798,7 @@ void KviIrcServerParser::parseNumericCodePageSet(KviIrcMessage * msg)
 	}
 	else
 	{
-		QString szMe = msg->connection()->decodeText(msg->safeParam(0));
+		QString szMe = msg->decodedParam(0);
 		if((szMe == msg->connection()->currentNickName() || szMe == "*") //fix for pre-login codepage message
 		    && KviLocale::instance()->codecForName(encoding.toUtf8().data()))
 		{
@@ -2786,7 +2808,7 @@ void KviIrcServerParser::parseNumericCodePageSet(KviIrcMessage * msg)
 		}
 		else if(!msg->haltOutput()) // simply unhandled
 		{
-			QString szWText = msg->connection()->decodeText(msg->allParams());
+			QString szWText = msg->decodedAllParams();
 			msg->connection()->console()->output(KVI_OUT_UNHANDLED,
 			    "[%s][%s] %Q", msg->prefix(), msg->command(), &szWText);
 		}
@@ -2803,13 +2825,13 @@ void KviIrcServerParser::parseNumericCodePageScheme(KviIrcMessage * msg)
 
 	if(msg->connection()->serverInfo()->supportsCodePages())
 	{
-		QString szNick = msg->connection()->decodeText(msg->safeParam(1));
-		QString szCodepage = msg->connection()->decodeText(msg->safeParam(2));
+		QString szNick = msg->decodedParam(1);
+		QString szCodepage = msg->decodedParam(2);
 
 		if(!msg->haltOutput())
 		{
 			KviWindow * pOut = KVI_OPTION_BOOL(KviOption_boolWhoisRepliesToActiveWindow) ? msg->console()->activeWindow() : static_cast<KviWindow *>(msg->console());
-			QString szWText = pOut->decodeText(msg->safeTrailing());
+			QString szWText = msg->decodedTrailing(pOut);
 			pOut->output(
 			    KVI_OUT_WHOISOTHER, __tr2qs("%c\r!n\r%Q\r%c's codepage is %Q: %Q"), KviControlCodes::Bold,
 			    &szNick, KviControlCodes::Bold, &szCodepage, &szWText);
@@ -2820,7 +2842,7 @@ void KviIrcServerParser::parseNumericCodePageScheme(KviIrcMessage * msg)
 		// simply unhandled
 		if(!msg->haltOutput())
 		{
-			QString szWText = msg->connection()->decodeText(msg->allParams());
+			QString szWText = msg->decodedAllParams();
 			msg->connection()->console()->output(KVI_OUT_UNHANDLED,
 			    "[%s][%s] %Q", msg->prefix(), msg->command(), &szWText);
 		}
@@ -2846,7 +2868,7 @@ void KviIrcServerParser::parseNumericEndOfStats(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szText = msg->decodedTrailing();
 		pOut->outputNoFmt(KVI_OUT_STATS, szText);
 	}
 }
@@ -2858,8 +2880,8 @@ void KviIrcServerParser::parseNumericYoureOper(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szPrefix = msg->connection()->decodeText(msg->safePrefix());
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szPrefix = msg->decodedPrefix();
+		QString szText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_HELP, "%Q on server %Q", &szText, &szPrefix);
 	}
 }
@@ -2871,7 +2893,7 @@ void KviIrcServerParser::parseNumericNotEnoughParams(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = msg->console()->activeWindow();
-		QString szParam = msg->connection()->decodeText(msg->safeParam(1));
+		QString szParam = msg->decodedParam(1);
 		pOut->output(KVI_OUT_GENERICERROR, __tr2qs("%Q requires more parameters"), &szParam);
 	}
 }
@@ -2883,7 +2905,7 @@ void KviIrcServerParser::parseNumericAlreadyRegistered(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szText = msg->decodedTrailing();
 		pOut->output(KVI_OUT_GENERICERROR, szText);
 	}
 }
@@ -2895,7 +2917,7 @@ void KviIrcServerParser::parseNumericPasswordIncorrect(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = msg->console()->activeWindow();
-		QString szCmd = msg->connection()->decodeText(msg->safeParam(1));
+		QString szCmd = msg->decodedParam(1);
 		pOut->output(KVI_OUT_GENERICERROR, szCmd);
 	}
 }
@@ -2970,8 +2992,8 @@ void KviIrcServerParser::parseNumericNotRegistered(KviIrcMessage * msg)
 	// We didn't send CAP LS so better show this to the user
 	if(!msg->haltOutput())
 	{
-		QString szCmd = msg->connection()->decodeText(msg->safeParam(0));
-		QString szErrorText = msg->connection()->decodeText(msg->safeTrailing());
+		QString szCmd = msg->decodedParam(0);
+		QString szErrorText = msg->decodedTrailing();
 		msg->console()->output(KVI_OUT_GENERICERROR, "%Q: %Q", &szCmd, &szErrorText);
 	}
 }
@@ -2985,7 +3007,7 @@ void KviIrcServerParser::parseNumericSaslLogin(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szParam = msg->connection()->decodeText(msg->safeParam(2));
+		QString szParam = msg->decodedParam(2);
 		pOut->output(KVI_OUT_SERVERINFO, __tr2qs("Authenticated as %Q"), &szParam);
 	}
 
@@ -3032,7 +3054,7 @@ void KviIrcServerParser::parseNumericSaslFail(KviIrcMessage * msg)
 	if(!msg->haltOutput())
 	{
 		KviWindow * pOut = static_cast<KviWindow *>(msg->console());
-		QString szParam = msg->connection()->decodeText(msg->safeTrailing());
+		QString szParam = msg->decodedTrailing();
 		pOut->output(KVI_OUT_SERVERINFO, __tr2qs("SASL authentication error: %Q"), &szParam);
 	}
 
@@ -3044,13 +3066,13 @@ void KviIrcServerParser::parseNumericOftcQuietList(KviIrcMessage * msg)
 {
 	// 344: RPL_QUIETLIST (oftc)
 	// :prefix 344 target <channel> <banmask> [bansetby] [bansetat]
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	// chMode is hard coded here, they do not give us any indication of what
 	// it is in the reply. Another IRCd (u2+ircd-darenet) uses this same format
 	// and uses +q for quiets as well.
 	char chMode = 'q';
-	QString banmask = msg->connection()->decodeText(msg->safeParam(2));
-	QString bansetby = msg->connection()->decodeText(msg->safeParam(3));
+	QString banmask = msg->decodedParam(2);
+	QString bansetby = msg->decodedParam(3);
 	QString bansetat;
 	getDateTimeStringFromCharTimeT(bansetat, msg->safeParam(4));
 	if(bansetby.isEmpty())
@@ -3073,11 +3095,11 @@ void KviIrcServerParser::parseNumericQuietList(KviIrcMessage * msg)
 {
 	// 728: RPL_QUIETLIST (freenode)
 	// :prefix 728 target <channel> <mode> <banmask> [bansetby] [bansetat]
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	// chMode is supposed to be a hardcoded 'q', but they could add other flags in the future
-	char chMode = msg->connection()->decodeText(msg->safeParam(2)).at(0).toLatin1();
-	QString banmask = msg->connection()->decodeText(msg->safeParam(3));
-	QString bansetby = msg->connection()->decodeText(msg->safeParam(4));
+	char chMode = msg->decodedParam(2).at(0).toLatin1();
+	QString banmask = msg->decodedParam(3);
+	QString bansetby = msg->decodedParam(4);
 	QString bansetat;
 	getDateTimeStringFromCharTimeT(bansetat, msg->safeParam(5));
 	if(bansetby.isEmpty())
@@ -3100,7 +3122,7 @@ void KviIrcServerParser::parseNumericOftcEndOfQuietList(KviIrcMessage * msg)
 {
 	// 729: RPL_QUIETLISTEND (oftc)
 	// :prefix 729 target <channel> :End of Channel Quiet List
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	// because this is fork specific, we can be assured that the mode will
 	// always be +q
 	char chMode = 'q';
@@ -3121,9 +3143,9 @@ void KviIrcServerParser::parseNumericEndOfQuietList(KviIrcMessage * msg)
 {
 	// 729: RPL_QUIETLISTEND (freenode)
 	// :prefix 729 target <channel> <mode> :End of Channel Quiet List
-	QString szChan = msg->connection()->decodeText(msg->safeParam(1));
+	QString szChan = msg->decodedParam(1);
 	// chMode is supposed to be a hardcoded 'q', but they could add other flags in the future
-	char chMode = msg->connection()->decodeText(msg->safeParam(2)).at(0).toLatin1();
+	char chMode = msg->decodedParam(2).at(0).toLatin1();
 	KviChannelWindow * chan = msg->connection()->findChannel(szChan);
 	if(chan && chan->sentListRequest(chMode))
 	{
@@ -69,6 +69,7 @@
 #include "KviKvsEventTriggers.h"
 #include "KviTalHBox.h"
 #include "KviNickColors.h"
+#include "KviHighlightMatcher.h"
 
 #ifdef COMPILE_SSL_SUPPORT
 #include "KviSSLMaster.h"
@@ -136,6 +137,7 @@ KviConsoleWindow::KviConsoleWindow(int iFlags) : KviWindow(KviWindow::Console, _
 	m_pInput = new KviInput(this, m_pNotifyListView);
 
 	m_pTmpHighLightedChannels = new QStringList;
+	m_pHighlightMatcher = new KviHighlightMatcher();
 
 	applyOptions();
 }
@@ -187,6 +189,7 @@ KviConsoleWindow::~KviConsoleWindow()
 	m_pContext = nullptr;
 
 	delete m_pTmpHighLightedChannels;
+	delete m_pHighlightMatcher;
 }
 
 void KviConsoleWindow::triggerCreationEvents()
@@ -622,59 +625,14 @@ void KviConsoleWindow::removeHighlightedChannel(const QString & szChan)
 // if it returns -1 you should just return and not display the message
 int KviConsoleWindow::applyHighlighting(KviWindow * wnd, int type, const QString & nick, const QString & user, const QString & host, const QString & szMsg)
 {
-	QString szPattern = KVI_OPTION_STRING(KviOption_stringWordSplitters);
-	QString szSource;
-	QString szStripMsg = KviControlCodes::stripControlBytes(szMsg);
-	QRegExp rgxHlite;
-	Qt::CaseSensitivity cs = KVI_OPTION_BOOL(KviOption_boolCaseSensitiveHighlighting) ? Qt::CaseSensitive : Qt::CaseInsensitive;
-
+	// The nickname and the highlighted words are all searched in a single pass
+	QString szNick;
 	if(KVI_OPTION_BOOL(KviOption_boolAlwaysHighlightNick) && connection())
-	{
-		if(KVI_OPTION_BOOL(KviOption_boolUseFullWordHighlighting))
-		{
-			if(szStripMsg.contains(connection()->userInfo()->nickName(), cs))
-				return triggerOnHighlight(wnd, type, nick, user, host, szMsg, connection()->userInfo()->nickName());
-		}
-		else
-		{
-			if(!szPattern.isEmpty())
-				rgxHlite.setPattern(
-				    QString("(?:[%1]|\\s|^)%2(?:[%1]|\\s|$)").arg(QRegExp::escape(szPattern), QRegExp::escape(connection()->userInfo()->nickName())));
-			else
-				rgxHlite.setPattern(
-				    QString("(?:\\s|^)%1(?:\\s|$)").arg(QRegExp::escape(connection()->userInfo()->nickName())));
-			rgxHlite.setCaseSensitivity(cs);
-			if(szStripMsg.contains(rgxHlite))
-				return triggerOnHighlight(wnd, type, nick, user, host, szMsg, connection()->userInfo()->nickName());
-		}
-	}
-
-	if(KVI_OPTION_BOOL(KviOption_boolUseWordHighlighting))
-	{
-		for(auto & it : KVI_OPTION_STRINGLIST(KviOption_stringlistHighlightWords))
-		{
-			if(it.isEmpty())
-				continue;
+		szNick = connection()->userInfo()->nickName();
 
-			if(KVI_OPTION_BOOL(KviOption_boolUseFullWordHighlighting))
-			{
-				if(szStripMsg.contains(it, cs))
-					return triggerOnHighlight(wnd, type, nick, user, host, szMsg, it);
-			}
-			else
-			{
-				if(!szPattern.isEmpty())
-					rgxHlite.setPattern(
-					    QString("(?:[%1]|\\s|^)%2(?:[%1]|\\s|$)").arg(QRegExp::escape(szPattern), QRegExp::escape(it)));
-				else
-					rgxHlite.setPattern(
-					    QString("(?:\\s|^)%1(?:\\s|$)").arg(QRegExp::escape(it)));
-				rgxHlite.setCaseSensitivity(cs);
-				if(szStripMsg.contains(rgxHlite))
-					return triggerOnHighlight(wnd, type, nick, user, host, szMsg, it);
-			}
-		}
-	}
+	QString szTrigger;
+	if(m_pHighlightMatcher->match(szNick, KviControlCodes::stripControlBytes(szMsg), szTrigger))
+		return triggerOnHighlight(wnd, type, nick, user, host, szMsg, szTrigger);
 
 	if(wnd->type() == KviWindow::Channel)
 	{
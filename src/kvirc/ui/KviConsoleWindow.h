@@ -52,6 +52,7 @@ class KviProxy;
 class KviUserListView;
 class KviNotifyListManager;
 class KviRegisteredUser;
+class KviHighlightMatcher;
 class KviWindowToolPageButton;
 
 #ifdef COMPILE_ON_WINDOWS
@@ -93,6 +94,7 @@ protected:
 	QString m_szStatusString; // nick (flags) on server | not connected
 	QString m_szOwnSmartColor;
 	QStringList * m_pTmpHighLightedChannels;
+	KviHighlightMatcher * m_pHighlightMatcher;
 	KviIrcContext * m_pContext;
 	QList<int> m_SplitterSizesList;
 
@@ -70,6 +70,8 @@
 #include "KviIrcView.h"
 #include "KviIrcView_tools.h"
 #include "KviIrcView_private.h"
+#include "KviIrcViewGlyphCache.h"
+#include "KviIrcViewLayoutIndex.h"
 #include "kvi_debug.h"
 #include "KviApplication.h"
 #include "kvi_settings.h"
@@ -102,6 +104,7 @@
 #include <QPaintEvent>
 #include <QDateTime>
 #include <QScrollBar>
+#include <QElapsedTimer>
 #include <QFontDialog>
 #include <QByteArray>
 #include <QMenu>
@@ -165,6 +168,15 @@ extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 
 #define KVI_IRCVIEW_PIXMAP_SIZE 16
 
+// The wrap blocks of the lines that are out of the view are released
+// once this many lines have been (re)wrapped since the last sweep.
+// They are cheap to recompute when the lines are scrolled back into view.
+#define KVI_IRCVIEW_WRAP_SWEEP_THRESHOLD 512
+
+// The background relayout of the lines out of the view gives back
+// the control to the event loop after this many milliseconds
+#define KVI_IRCVIEW_RELAYOUT_SLICE_MSECS 5
+
 #define KVI_IRCVIEW_ESCAPE_TAG_URLLINK 'u'
 #define KVI_IRCVIEW_ESCAPE_TAG_NICKLINK 'n'
 #define KVI_IRCVIEW_ESCAPE_TAG_SERVERLINK 's'
@@ -212,6 +224,13 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_bHaveUnreadedMessages = false;
 	m_iNumLines = 0;
 	m_iMaxLines = KVI_OPTION_UINT(KviOption_uintIrcViewMaxBufferSize);
+	m_uLineWrapsSinceSweep = 0;
+
+	m_pLayoutIndex = new KviIrcViewLayoutIndex();
+	m_iRelayoutTimer = 0;
+	m_iRelayoutWidth = -1;
+	m_pRelayoutUp = nullptr;
+	m_pRelayoutDown = nullptr;
 
 	m_uNextLineIndex = 0;
 	m_pSelectionInitLine = nullptr;
@@ -257,6 +276,7 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	setAutoFillBackground(false);
 
 	m_pFm = nullptr; // will be updated in the first paint event
+	m_pGlyphCache = nullptr;
 	m_iFontDescent = 0;
 	m_iFontLineSpacing = 0;
 	m_iFontLineWidth = 0;
@@ -291,6 +311,7 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_pToolsButton->show();
 
 	connect(m_pScrollBar, SIGNAL(valueChanged(int)), this, SLOT(scrollBarPositionChanged(int)));
+	connect(m_pScrollBar, SIGNAL(actionTriggered(int)), this, SLOT(scrollBarActionTriggered(int)));
 	m_iLastScrollBarValue = 0;
 
 	// set the minimum size
@@ -343,6 +364,8 @@ KviIrcView::~KviIrcView()
 		killTimer(m_iSelectTimer);
 	if(m_iMouseTimer)
 		killTimer(m_iMouseTimer);
+	if(m_iRelayoutTimer)
+		killTimer(m_iRelayoutTimer);
 
 	// and close the log file (flush!)
 	stopLogging();
@@ -366,6 +389,9 @@ KviIrcView::~KviIrcView()
 	if(m_pFm)
 		delete m_pFm;
 
+	KviIrcViewGlyphCache::release(m_pGlyphCache);
+
+	delete m_pLayoutIndex;
 	delete m_pToolTip;
 	delete m_pWrappedBlockSelectionInfo;
 }
@@ -388,6 +414,7 @@ void KviIrcView::setFont(const QFont & f)
 		l->iMaxLineWidth = -1;
 		l = l->pNext;
 	}
+	m_iRelayoutWidth = -1; // relayout everything for the new font
 
 	QFont newFont(f);
 	newFont.setKerning(false);
@@ -651,6 +678,10 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 		}
 	}
 
+	// the positions will be reassigned if the index is rebuilt
+	if(m_pLayoutIndex->isValid())
+		m_pLayoutIndex->append(ptr->uLineWraps + 1, &(ptr->uLayoutIndex));
+
 	if(m_pLastLine)
 	{
 		// There is at least one line in the view
@@ -726,6 +757,14 @@ void KviIrcView::removeHeadLine(bool bRepaint)
 	if(m_pFirstLine == m_pCursorLine)
 		m_pCursorLine = nullptr;
 
+	// the background relayout walks up to the first line and then down from the view
+	if(m_pFirstLine == m_pRelayoutUp)
+		m_pRelayoutUp = nullptr;
+	if(m_pFirstLine == m_pRelayoutDown)
+		m_pRelayoutDown = m_pFirstLine->pNext;
+	if(m_pLayoutIndex->isValid())
+		m_pLayoutIndex->removeFirst(m_pFirstLine->uLineWraps + 1);
+
 	if(m_pFirstLine->pNext)
 	{
 		KviIrcViewLine * aux_ptr = m_pFirstLine->pNext; // get the next line
@@ -819,6 +858,9 @@ void KviIrcView::splitMessagesTo(KviIrcView * v)
 	v->m_pCursorLine = nullptr;
 	m_pCursorLine = nullptr;
 
+	invalidateLayout();
+	v->invalidateLayout();
+
 	m_iLastScrollBarValue = m_iNumLines;
 	m_pScrollBar->setRange(0, m_iNumLines);
 	m_pScrollBar->setValue(m_iNumLines);
@@ -851,6 +893,8 @@ void KviIrcView::appendMessagesFrom(KviIrcView * v)
 	v->m_pCursorLine = nullptr;
 	m_iNumLines += v->m_iNumLines;
 	v->m_iNumLines = 0;
+	invalidateLayout();
+	v->invalidateLayout();
 	//	v->m_pScrollBar->setRange(0,0);
 	//	v->m_pScrollBar->setValue(0);
 	m_iLastScrollBarValue = m_iNumLines;
@@ -918,6 +962,8 @@ void KviIrcView::joinMessagesFrom(KviIrcView * v)
 	v->m_pCursorLine = nullptr;
 	m_iNumLines += v->m_iNumLines;
 	v->m_iNumLines = 0;
+	invalidateLayout();
+	v->invalidateLayout();
 	//	v->m_pScrollBar->setRange(0,0);
 	//	v->m_pScrollBar->setValue(0);
 	m_iLastScrollBarValue = m_iNumLines;
@@ -1137,10 +1183,11 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	while((curBottomCoord >= KVI_IRCVIEW_VERTICAL_BORDER) && pCurTextLine)
 	{
 		// Paint pCurTextLine
-		if(maxLineWidth != pCurTextLine->iMaxLineWidth)
+		if((maxLineWidth != pCurTextLine->iMaxLineWidth) || (pCurTextLine->iBlockCount == 0))
 		{
 			// Width of the widget or the font has been changed
 			// from the last time that this line was painted
+			// (or only its height has been kept)
 			calculateLineWraps(pCurTextLine, maxLineWidth);
 		}
 
@@ -1333,7 +1380,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	}
 
 #define DRAW_SELECTED_TEXT(_text_str, _text_idx, _text_len, _text_width)                                                                                                               \
-	SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_SELECT).fore(), block->pChunk ? block->pChunk->customFore : QColor());                                                                          \
+	SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_SELECT).fore(), block->pChunk ? QColor(block->pChunk->customFore) : QColor());                                                                  \
 	{                                                                                                                                                                                  \
 		int theWdth = _text_width;                                                                                                                                                     \
 		if(theWdth < 0)                                                                                                                                                                \
@@ -1350,7 +1397,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	curLeftCoord += _text_width;
 
 #define DRAW_NORMAL_TEXT(_text_str, _text_idx, _text_len, _text_width)                                                                                              \
-	SET_PEN(curFore, block->pChunk ? block->pChunk->customFore : QColor());                                                                                         \
+	SET_PEN(curFore, block->pChunk ? QColor(block->pChunk->customFore) : QColor());                                                                                 \
 	if(curBack != KviControlCodes::Transparent)                                                                                                                     \
 	{                                                                                                                                                               \
 		int theWdth = _text_width;                                                                                                                                  \
@@ -1499,7 +1546,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 					// FIXME: We could avoid this XSetForeground if the curFore was not changed....
 
-					SET_PEN(curFore, block->pChunk ? block->pChunk->customFore : QColor());
+					SET_PEN(curFore, block->pChunk ? QColor(block->pChunk->customFore) : QColor());
 
 					if(curBack != KviControlCodes::Transparent && curBack < 16)
 					{
@@ -1516,7 +1563,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 					if(curLink)
 					{
-						SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_LINK).fore(), block->pChunk ? block->pChunk->customFore : QColor());
+						SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_LINK).fore(), block->pChunk ? QColor(block->pChunk->customFore) : QColor());
 						pa.drawLine(curLeftCoord, curBottomCoord + 2, curLeftCoord + wdth, curBottomCoord + 2);
 					}
 
@@ -1579,6 +1626,9 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 		iLinesPerPage++;
 	}
 
+	// this is the first line above the view (if any)
+	KviIrcViewLine * pFirstHiddenLine = pCurTextLine;
+
 	/* REMINDER
 	 * Try to get the current number of KviIrcViewLines from the paintEvent and set the m_pScrollBar's
 	 * pageStep accordingly; the calculated value is valid only:
@@ -1658,15 +1708,198 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	widgetWidth--;
 	pa.drawLine(1, widgetHeight - 1, widgetWidth, widgetHeight - 1);
 	pa.drawLine(widgetWidth, 1, widgetWidth, widgetHeight);
+
+	// Keep the wrap blocks only for the lines around the view:
+	// on large buffers they would otherwise stay allocated for every line ever painted
+	if(m_pCurLine && (m_uLineWrapsSinceSweep > KVI_IRCVIEW_WRAP_SWEEP_THRESHOLD))
+		releaseInvisibleLineWraps(pFirstHiddenLine);
+
+	// The visible lines are wrapped: do the rest of the buffer in background
+	if(m_pCurLine && (maxLineWidth >= m_iMinimumPaintWidth) && (maxLineWidth != m_iRelayoutWidth))
+		startRelayout(maxLineWidth, pFirstHiddenLine);
+}
+
+//
+// The IrcView : release the wrap blocks of the lines out of the view
+//
+
+void KviIrcView::releaseInvisibleLineWraps(KviIrcViewLine * pFirstHiddenLine)
+{
+	// pFirstHiddenLine is the first line above the view (or nullptr if the view reaches the top of the buffer)
+	// and m_pCurLine->pNext is the first line below it: everything visible lies in between.
+	// The sweep is a plain walk over the buffer but it runs only once every
+	// KVI_IRCVIEW_WRAP_SWEEP_THRESHOLD wraps so its cost is spread over the painting.
+	KviIrcViewLine * l = pFirstHiddenLine;
+	while(l)
+	{
+		if(l->iBlockCount != 0)
+			releaseLineWraps(l);
+		l = l->pPrev;
+	}
+
+	l = m_pCurLine->pNext;
+	while(l)
+	{
+		if(l->iBlockCount != 0)
+			releaseLineWraps(l);
+		l = l->pNext;
+	}
+
+	m_uLineWrapsSinceSweep = 0;
+}
+
+void KviIrcView::releaseLineWraps(KviIrcViewLine * pLine)
+{
+	if((m_pLastLinkUnderMouse >= pLine->pBlocks) && (m_pLastLinkUnderMouse < (pLine->pBlocks + pLine->iBlockCount)))
+		m_pLastLinkUnderMouse = nullptr;
+
+	// uLineWraps and iMaxLineWidth are kept: the height of the line is still known
+	// and the blocks are recomputed when the line is painted again
+	KviMemory::free(pLine->pBlocks);
+	pLine->pBlocks = nullptr;
+	pLine->iBlockCount = 0;
+}
+
+//
+// The IrcView : background relayout
+//
+
+void KviIrcView::startRelayout(int iWidth, KviIrcViewLine * pFirstHiddenLine)
+{
+	// The lines above the view go first: they are the ones that scrolling back reaches
+	m_iRelayoutWidth = iWidth;
+	m_pRelayoutUp = pFirstHiddenLine;
+	m_pRelayoutDown = m_pCurLine->pNext;
+
+	if(!m_iRelayoutTimer && (m_pRelayoutUp || m_pRelayoutDown))
+		m_iRelayoutTimer = startTimer(0); // fires when the event loop is idle
+}
+
+void KviIrcView::relayoutSlice()
+{
+	QElapsedTimer slice;
+	slice.start();
+
+	unsigned int uLines = 0;
+	while(m_pRelayoutUp || m_pRelayoutDown)
+	{
+		KviIrcViewLine * l;
+		if(m_pRelayoutUp)
+		{
+			l = m_pRelayoutUp;
+			m_pRelayoutUp = l->pPrev;
+		}
+		else
+		{
+			l = m_pRelayoutDown;
+			m_pRelayoutDown = l->pNext;
+		}
+
+		if(l->iMaxLineWidth != m_iRelayoutWidth)
+		{
+			// only the height is needed: don't keep blocks that the line didn't have
+			bool bHadBlocks = l->iBlockCount != 0;
+			unsigned int uWrapsSinceSweep = m_uLineWrapsSinceSweep;
+			calculateLineWraps(l, m_iRelayoutWidth);
+			if(!bHadBlocks && (l->iBlockCount != 0))
+			{
+				releaseLineWraps(l);
+				m_uLineWrapsSinceSweep = uWrapsSinceSweep;
+			}
+		}
+
+		uLines++;
+		if(((uLines % 32) == 0) && (slice.elapsed() >= KVI_IRCVIEW_RELAYOUT_SLICE_MSECS))
+			return; // more in the next slice
+	}
+
+	killTimer(m_iRelayoutTimer);
+	m_iRelayoutTimer = 0;
+}
+
+void KviIrcView::invalidateLayout()
+{
+	// the lines have been moved between the views
+	m_pLayoutIndex->invalidate();
+	m_pRelayoutUp = nullptr;
+	m_pRelayoutDown = nullptr;
+	m_iRelayoutWidth = -1; // restart from the next paint event
+}
+
+void KviIrcView::rebuildLayoutIndex()
+{
+	m_pLayoutIndex->reset(m_iNumLines);
+	for(KviIrcViewLine * l = m_pFirstLine; l; l = l->pNext)
+		m_pLayoutIndex->append(l->uLineWraps + 1, &(l->uLayoutIndex));
+}
+
+void KviIrcView::scrollBarActionTriggered(int iAction)
+{
+	// The page steps move by the height of the view instead of a fixed number of lines.
+	// The heights of the lines not yet wrapped for the current width are the ones
+	// of their last layout: the background relayout corrects them quickly.
+	if((iAction != QAbstractSlider::SliderPageStepAdd) && (iAction != QAbstractSlider::SliderPageStepSub))
+		return;
+	if(!m_pCurLine || !m_pFm)
+		return; // no metrics yet: keep the default step
+
+	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
+	int iViewHeight = height() - toolWidgetHeight - (KVI_IRCVIEW_VERTICAL_BORDER * 2);
+	if(iViewHeight <= 0)
+		return;
+
+	if(!m_pLayoutIndex->isValid())
+		rebuildLayoutIndex();
+
+	unsigned int uCur = m_pCurLine->uLayoutIndex;
+	unsigned int uFirst = m_pLayoutIndex->first();
+	unsigned int uLast = m_pLayoutIndex->end() - 1;
+	int iBottom = m_pLayoutIndex->lineTop(uCur + 1, m_iFontLineSpacing, m_iFontDescent);
+	unsigned int uTarget;
+
+	if(iAction == QAbstractSlider::SliderPageStepSub)
+	{
+		// the line at the top of the view becomes the bottom one
+		uTarget = m_pLayoutIndex->lineAt(iBottom - iViewHeight, m_iFontLineSpacing, m_iFontDescent);
+		if((uTarget >= uCur) && (uCur > uFirst))
+			uTarget = uCur - 1;
+	}
+	else
+	{
+		// the current line stays (at least partially) in the view
+		int iY = iBottom + iViewHeight;
+		if(iY >= m_pLayoutIndex->lineTop(uLast + 1, m_iFontLineSpacing, m_iFontDescent))
+		{
+			uTarget = uLast;
+		}
+		else
+		{
+			uTarget = m_pLayoutIndex->lineAt(iY, m_iFontLineSpacing, m_iFontDescent);
+			uTarget = (uTarget > uCur + 1) ? uTarget - 1 : uCur + 1;
+		}
+	}
+
+	// the scroll bar value of a line is its index in the buffer plus one
+	m_pScrollBar->setSliderPosition(uTarget - uFirst + 1);
 }
 
 //
 // The IrcView : calculate line wraps
 //
 
-#define IRCVIEW_WCHARWIDTH(c) (((c).unicode() < 0xff) ? m_iFontCharacterWidth[(c).unicode()] : m_pFm->width(c))
+// p points inside a null terminated string: the surrogate pairs are measured as a whole
+#define IRCVIEW_WCHARWIDTH(p) (((p)->unicode() < 0xff) ? m_iFontCharacterWidth[(p)->unicode()] : m_pGlyphCache->advance(p))
 
 void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
+{
+	// keep the layout index in sync with the height of the line
+	unsigned int uOldLineWraps = ptr->uLineWraps;
+	splitLineInBlocks(ptr, maxWidth);
+	if((ptr->uLineWraps != uOldLineWraps) && m_pLayoutIndex->isValid())
+		m_pLayoutIndex->add(ptr->uLayoutIndex, (int)ptr->uLineWraps - (int)uOldLineWraps);
+}
+
+void KviIrcView::splitLineInBlocks(KviIrcViewLine * ptr, int maxWidth)
 {
 	// Another monster
 	if(maxWidth <= m_iIconWidth)
@@ -1675,6 +1908,8 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 	if(ptr->iBlockCount != 0)
 		KviMemory::free(ptr->pBlocks); // free any previous wrap blocks
 
+	m_uLineWrapsSinceSweep++;
+
 	ptr->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::allocate(sizeof(KviIrcViewWrappedBlock)); // alloc one block
 	ptr->iMaxLineWidth = maxWidth;                                                                // calculus for this width
 	ptr->iBlockCount = 0;                                                                         // it will be ++
@@ -1710,7 +1945,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 			while(curBlockLen < maxBlockLen)
 			{
 				// FIXME: this is ugly :/
-				curBlockWidth += IRCVIEW_WCHARWIDTH(*p);
+				curBlockWidth += IRCVIEW_WCHARWIDTH(p);
 				curBlockLen++;
 				p++;
 			}
@@ -1748,7 +1983,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 		{
 			p--;
 			curBlockLen--;
-			curLineWidth -= IRCVIEW_WCHARWIDTH(*p);
+			curLineWidth -= IRCVIEW_WCHARWIDTH(p);
 		}
 
 		// Now look for a space (or a tabulation)
@@ -1756,7 +1991,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 		{
 			p--;
 			curBlockLen--;
-			curLineWidth -= IRCVIEW_WCHARWIDTH(*p);
+			curLineWidth -= IRCVIEW_WCHARWIDTH(p);
 		}
 
 		if(curBlockLen == 0)
@@ -1781,13 +2016,13 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 			// Go ahead up to the biggest possible string
 			if(maxBlockLen > 0)
 			{
-				// avoid a loop when IRCVIEW_WCHARWIDTH(*p) > maxWidth
+				// avoid a loop when IRCVIEW_WCHARWIDTH(p) > maxWidth
 				uint uLoopedChars = 0;
 				do
 				{
 					curBlockLen++;
 					p++;
-					curLineWidth += IRCVIEW_WCHARWIDTH(*p);
+					curLineWidth += IRCVIEW_WCHARWIDTH(p);
 					uLoopedChars++;
 				} while((curLineWidth < maxWidth) && (curBlockLen < maxBlockLen));
 				// Now overrun, go back 1 char (if we ran over at least 2 chars)
@@ -1917,13 +2152,13 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 			m_pWrappedBlockSelectionInfo->part_2_width = 0;
 			for(int i = 0; i < m_pWrappedBlockSelectionInfo->part_1_length; i++)
 			{
-				int www = IRCVIEW_WCHARWIDTH(*p);
+				int www = IRCVIEW_WCHARWIDTH(p);
 				m_pWrappedBlockSelectionInfo->part_1_width += www;
 				p++;
 			}
 			for(int i = 0; i < m_pWrappedBlockSelectionInfo->part_2_length; i++)
 			{
-				int www = IRCVIEW_WCHARWIDTH(*p);
+				int www = IRCVIEW_WCHARWIDTH(p);
 				m_pWrappedBlockSelectionInfo->part_2_width += www;
 				p++;
 			}
@@ -1939,7 +2174,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 			m_pWrappedBlockSelectionInfo->part_1_width = 0;
 			for(int i = 0; i < m_pWrappedBlockSelectionInfo->part_1_length; i++)
 			{
-				int www = IRCVIEW_WCHARWIDTH(*p);
+				int www = IRCVIEW_WCHARWIDTH(p);
 				m_pWrappedBlockSelectionInfo->part_1_width += www;
 				p++;
 			}
@@ -1956,7 +2191,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 			m_pWrappedBlockSelectionInfo->part_1_width = 0;
 			for(int i = 0; i < m_pWrappedBlockSelectionInfo->part_1_length; i++)
 			{
-				int www = IRCVIEW_WCHARWIDTH(*p);
+				int www = IRCVIEW_WCHARWIDTH(p);
 				m_pWrappedBlockSelectionInfo->part_1_width += www;
 				p++;
 			}
@@ -2000,7 +2235,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 			m_pWrappedBlockSelectionInfo->part_1_width = 0;
 			for(int i = 0; i < m_pWrappedBlockSelectionInfo->part_1_length; i++)
 			{
-				int www = IRCVIEW_WCHARWIDTH(*p);
+				int www = IRCVIEW_WCHARWIDTH(p);
 				m_pWrappedBlockSelectionInfo->part_1_width += www;
 				p++;
 			}
@@ -2045,7 +2280,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 			m_pWrappedBlockSelectionInfo->part_1_width = 0;
 			for(int i = 0; i < m_pWrappedBlockSelectionInfo->part_1_length; i++)
 			{
-				int www = IRCVIEW_WCHARWIDTH(*p);
+				int www = IRCVIEW_WCHARWIDTH(p);
 				m_pWrappedBlockSelectionInfo->part_1_width += www;
 				p++;
 			}
@@ -2069,6 +2304,10 @@ void KviIrcView::recalcFontVariables(const QFont & font, const QFontInfo & fi)
 
 	m_pFm = new QFontMetrics(font);
 
+	// the advances of the other characters are shared with the views using the same font
+	KviIrcViewGlyphCache::release(m_pGlyphCache);
+	m_pGlyphCache = KviIrcViewGlyphCache::acquire(font);
+
 	m_iFontLineSpacing = m_pFm->lineSpacing();
 
 	if((m_iFontLineSpacing < KVI_IRCVIEW_PIXMAP_SIZE) && KVI_OPTION_BOOL(KviOption_boolIrcViewShowImages))
@@ -2635,21 +2874,21 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 				}
 				// now, get the right character inside the block
 				int retValue = 0, oldIndex = 0, oldLeft = iLeft;
-				QChar curChar;
+				const QChar * p = l->szText.unicode() + l->pBlocks[i].block_start;
 				// add the width of each single character until we get the right one
 				while(iLeft < xPos && retValue < l->pBlocks[i].block_len)
 				{
 					oldIndex = retValue; oldLeft = iLeft;
 
-					curChar = l->szText.at(l->pBlocks[i].block_start + retValue);
-					if (curChar >= 0xD800 && curChar <= 0xDC00) // Surrogate pair
+					iLeft += IRCVIEW_WCHARWIDTH(p);
+					if(p->isHighSurrogate() && p[1].isLowSurrogate() && (retValue + 1 < l->pBlocks[i].block_len)) // Surrogate pair
 					{
-						iLeft += m_pFm->width(l->szText.mid(retValue), 2);
-						retValue+=2;
+						p += 2;
+						retValue += 2;
 					}
 					else
 					{
-						iLeft += (curChar < 0xff) ? m_iFontCharacterWidth[curChar.unicode()] : m_pFm->width(curChar);
+						p++;
 						retValue++;
 					}
 				}
@@ -37,7 +37,6 @@
 
 class QScrollBar;
 class QLineEdit;
-class QFile;
 class QFontMetrics;
 class QMenu;
 
@@ -46,7 +45,10 @@ class KviMainWindow;
 class KviConsoleWindow;
 class KviIrcViewToolWidget;
 class KviIrcViewToolTip;
+class KviIrcViewGlyphCache;
+class KviIrcViewLayoutIndex;
 class KviAnimatedPixmap;
+class KviLogWriterFile;
 
 typedef struct _KviIrcViewLineChunk KviIrcViewLineChunk;
 typedef struct _KviIrcViewWrappedBlock KviIrcViewWrappedBlock;
@@ -90,6 +92,14 @@ private:
 
 	int m_iNumLines;
 	int m_iMaxLines;
+	unsigned int m_uLineWrapsSinceSweep;
+
+	// Background relayout: the lines out of the view are wrapped in idle time slices
+	KviIrcViewLayoutIndex * m_pLayoutIndex; // the heights of the lines
+	int m_iRelayoutTimer;
+	int m_iRelayoutWidth;                   // the width the buffer is being (or has been) wrapped for
+	KviIrcViewLine * m_pRelayoutUp;         // next line to wrap going to the top of the buffer
+	KviIrcViewLine * m_pRelayoutDown;       // next line to wrap going to the bottom, once the top has been reached
 
 	unsigned int m_uNextLineIndex;
 
@@ -107,6 +117,7 @@ private:
 	int m_iFontLineWidth;
 	int m_iFontDescent;
 	int m_iFontCharacterWidth[256]; //1024 bytes fixed
+	KviIrcViewGlyphCache * m_pGlyphCache; // the characters above 0xff, shared
 	bool m_bUseRealBold;
 
 	int m_iWrapMargin;
@@ -130,7 +141,7 @@ private:
 	int m_iMouseTimer;
 	KviWindow * m_pKviWindow;
 	KviIrcViewWrappedBlockSelectionInfo * m_pWrappedBlockSelectionInfo;
-	QFile * m_pLogFile;
+	KviLogWriterFile * m_pLogFile;
 	KviMainWindow * m_pFrm;
 	bool m_bAcceptDrops;
 	int m_iUnprocessedPaintEventRequests;
@@ -237,6 +248,13 @@ private:
 	void fastScroll(int lines = 1);
 	const kvi_wchar_t * getTextLine(int msg_type, const kvi_wchar_t * data_ptr, KviIrcViewLine * line_ptr, bool bEnableTimeStamp = true, const QDateTime & datetime = QDateTime());
 	void calculateLineWraps(KviIrcViewLine * ptr, int maxWidth);
+	void releaseInvisibleLineWraps(KviIrcViewLine * pFirstHiddenLine);
+	void releaseLineWraps(KviIrcViewLine * pLine);
+	void splitLineInBlocks(KviIrcViewLine * ptr, int maxWidth);
+	void startRelayout(int iWidth, KviIrcViewLine * pFirstHiddenLine);
+	void relayoutSlice();
+	void invalidateLayout();
+	void rebuildLayoutIndex();
 	void recalcFontVariables(const QFont & font, const QFontInfo & fi);
 	bool checkSelectionBlock(KviIrcViewLine * line, int bufIndex);
 	KviIrcViewWrappedBlock * getLinkUnderMouse(int xPos, int yPos, QRect * pRect = 0, QString * linkCmd = 0, QString * linkText = 0);
@@ -258,6 +276,7 @@ public slots:
 	void resetBackground();
 protected slots:
 	virtual void scrollBarPositionChanged(int newValue);
+	void scrollBarActionTriggered(int iAction);
 	void masterDead();
 	void animatedIconChange();
 signals:
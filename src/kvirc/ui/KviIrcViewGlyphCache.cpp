@@ -0,0 +1,100 @@
+//=============================================================================
+//
+//   File : KviIrcViewGlyphCache.cpp
+//   Creation date : Sun Oct 18 2026 23:41:09 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcViewGlyphCache.h"
+
+QHash<QString, KviIrcViewGlyphCache *> KviIrcViewGlyphCache::m_hCaches;
+
+KviIrcViewGlyphCache::KviIrcViewGlyphCache(const QFont & font, const QString & szKey)
+    : m_szKey(szKey), m_fm(font)
+{
+	m_uRefs = 0;
+	for(auto & p : m_pPages)
+		p = nullptr;
+}
+
+KviIrcViewGlyphCache::~KviIrcViewGlyphCache()
+{
+	for(auto & p : m_pPages)
+		delete[] p;
+}
+
+KviIrcViewGlyphCache * KviIrcViewGlyphCache::acquire(const QFont & font)
+{
+	QString szKey = font.key();
+	KviIrcViewGlyphCache * pCache = m_hCaches.value(szKey, nullptr);
+	if(!pCache)
+	{
+		pCache = new KviIrcViewGlyphCache(font, szKey);
+		m_hCaches.insert(szKey, pCache);
+	}
+	pCache->m_uRefs++;
+	return pCache;
+}
+
+void KviIrcViewGlyphCache::release(KviIrcViewGlyphCache * pCache)
+{
+	if(!pCache)
+		return;
+	pCache->m_uRefs--;
+	if(pCache->m_uRefs > 0)
+		return;
+	m_hCaches.remove(pCache->m_szKey);
+	delete pCache;
+}
+
+int KviIrcViewGlyphCache::measure(ushort c)
+{
+	qint16 *& pPage = m_pPages[c >> 8];
+	if(!pPage)
+	{
+		pPage = new qint16[256];
+		for(int i = 0; i < 256; i++)
+			pPage[i] = Unknown;
+	}
+
+	int iWidth = m_fm.width(QChar(c));
+	// an advance that doesn't fit is simply measured every time
+	if((iWidth > Unknown) && (iWidth <= 32767))
+		pPage[c & 0xFF] = iWidth;
+	return iWidth;
+}
+
+int KviIrcViewGlyphCache::surrogateAdvance(const QChar * p)
+{
+	if(p->isLowSurrogate())
+		return 0; // accounted with the high surrogate
+
+	if(!p[1].isLowSurrogate())
+		return measure(p->unicode()); // unpaired
+
+	uint uCode = QChar::surrogateToUcs4(p[0], p[1]);
+	QHash<uint, int>::const_iterator it = m_hPairs.constFind(uCode);
+	if(it != m_hPairs.constEnd())
+		return it.value();
+
+	int iWidth = m_fm.width(QString(p, 2));
+	m_hPairs.insert(uCode, iWidth);
+	return iWidth;
+}
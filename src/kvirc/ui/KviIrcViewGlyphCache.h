@@ -0,0 +1,111 @@
+#ifndef _KVI_IRCVIEWGLYPHCACHE_H_
+#define _KVI_IRCVIEWGLYPHCACHE_H_
+//=============================================================================
+//
+//   File : KviIrcViewGlyphCache.h
+//   Creation date : Sun Oct 18 2026 23:41:09 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviIrcViewGlyphCache.h
+* \author The KVIrc Development Team
+* \brief Glyph advance cache shared by the views that use the same font
+*/
+
+#include "kvi_settings.h"
+
+#include <QChar>
+#include <QFont>
+#include <QFontMetrics>
+#include <QHash>
+#include <QString>
+
+/**
+* \class KviIrcViewGlyphCache
+* \brief The advances of the characters of a font, measured once
+*
+* The BMP is split in 256 pages of 256 characters, allocated and filled
+* lazily on the first lookup of each character. The surrogate pairs are
+* cached in a hash keyed by their code point.
+* There is one cache per font: the views get it with acquire() and give
+* it back with release(); the last release() destroys it.
+* The cache is meant to be used only by the GUI thread.
+*/
+class KviIrcViewGlyphCache
+{
+protected:
+	KviIrcViewGlyphCache(const QFont & font, const QString & szKey);
+	~KviIrcViewGlyphCache();
+
+private:
+	QString m_szKey;
+	QFontMetrics m_fm;
+	unsigned int m_uRefs;
+	qint16 * m_pPages[256]; // nullptr until one of the characters in the page is looked up
+	QHash<uint, int> m_hPairs; // the supplementary planes, keyed by code point
+
+	static QHash<QString, KviIrcViewGlyphCache *> m_hCaches;
+
+public:
+	/**
+	* \brief Returns the cache for the specified font, creating it if needed
+	* \param font The font
+	* \return KviIrcViewGlyphCache *
+	*/
+	static KviIrcViewGlyphCache * acquire(const QFont & font);
+
+	/**
+	* \brief Gives back a cache obtained by acquire()
+	* \param pCache The cache
+	* \return void
+	*/
+	static void release(KviIrcViewGlyphCache * pCache);
+
+	/**
+	* \brief Returns the advance of the character pointed by p
+	*
+	* A high surrogate followed by a low one gets the advance of the
+	* whole pair, the low surrogate gets 0: the sum over a string is
+	* its width. The string must be null terminated.
+	* \param p The character
+	* \return int
+	*/
+	inline int advance(const QChar * p)
+	{
+		ushort c = p->unicode();
+		if((c & 0xF800) == 0xD800)
+			return surrogateAdvance(p);
+		qint16 * pPage = m_pPages[c >> 8];
+		if(pPage && (pPage[c & 0xFF] != Unknown))
+			return pPage[c & 0xFF];
+		return measure(c);
+	}
+
+private:
+	enum
+	{
+		Unknown = -32768
+	};
+	int measure(ushort c);
+	int surrogateAdvance(const QChar * p);
+};
+
+#endif //_KVI_IRCVIEWGLYPHCACHE_H_
@@ -0,0 +1,135 @@
+//=============================================================================
+//
+//   File : KviIrcViewLayoutIndex.cpp
+//   Creation date : Sun Oct 18 2026 23:58:26 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcViewLayoutIndex.h"
+
+#include <QtGlobal>
+
+// The positions are never less than this, so small buffers aren't rebuilt too often
+#define KVI_IRCVIEW_LAYOUT_MIN_POSITIONS 1024
+
+#define LOWEST_BIT(i) ((i) & (~(i) + 1))
+
+KviIrcViewLayoutIndex::KviIrcViewLayoutIndex()
+{
+	m_uFirst = 0;
+	m_uEnd = 0;
+	m_bValid = false;
+}
+
+KviIrcViewLayoutIndex::~KviIrcViewLayoutIndex()
+    = default;
+
+void KviIrcViewLayoutIndex::reset(unsigned int uLines)
+{
+	// twice the buffer: the next rebuild happens after as many lines have been appended
+	unsigned int uPositions = uLines * 2;
+	if(uPositions < KVI_IRCVIEW_LAYOUT_MIN_POSITIONS)
+		uPositions = KVI_IRCVIEW_LAYOUT_MIN_POSITIONS;
+
+	m_Tree.assign(uPositions + 1, 0);
+	m_uFirst = 0;
+	m_uEnd = 0;
+	m_bValid = true;
+}
+
+bool KviIrcViewLayoutIndex::append(unsigned int uRows, unsigned int * puPosition)
+{
+	if(m_uEnd + 1 >= m_Tree.size())
+	{
+		m_bValid = false;
+		return false;
+	}
+
+	*puPosition = m_uEnd;
+	add(m_uEnd, uRows);
+	m_uEnd++;
+	return true;
+}
+
+void KviIrcViewLayoutIndex::removeFirst(unsigned int uRows)
+{
+	if(m_uFirst >= m_uEnd)
+		return;
+	add(m_uFirst, -(int)uRows);
+	m_uFirst++;
+}
+
+void KviIrcViewLayoutIndex::add(unsigned int uPosition, int iDelta)
+{
+	unsigned int uSize = m_Tree.size() - 1;
+	for(unsigned int i = uPosition + 1; i <= uSize; i += LOWEST_BIT(i))
+		m_Tree[i] += iDelta;
+}
+
+int KviIrcViewLayoutIndex::rowsBefore(unsigned int uPosition) const
+{
+	// the removed lines count 0 rows
+	int iRows = 0;
+	for(unsigned int i = uPosition; i > 0; i -= LOWEST_BIT(i))
+		iRows += m_Tree[i];
+	return iRows;
+}
+
+int KviIrcViewLayoutIndex::lineTop(unsigned int uPosition, int iLineSpacing, int iDescent) const
+{
+	return (rowsBefore(uPosition) * iLineSpacing) + ((uPosition - m_uFirst) * iDescent);
+}
+
+unsigned int KviIrcViewLayoutIndex::lineAt(int iY, int iLineSpacing, int iDescent) const
+{
+	if(iY <= 0)
+		return m_uFirst;
+
+	// Descend the tree looking for the last position whose top is not below iY.
+	// The removed lines count only their descent: skip it by moving the target.
+	qint64 iTarget = (qint64)iY + ((qint64)m_uFirst * iDescent);
+	qint64 iTop = 0;
+	unsigned int uSize = m_Tree.size() - 1;
+	unsigned int uPosition = 0;
+
+	unsigned int uStep = 1;
+	while((uStep << 1) <= uSize)
+		uStep <<= 1;
+
+	for(; uStep > 0; uStep >>= 1)
+	{
+		unsigned int uNext = uPosition + uStep;
+		if(uNext > uSize)
+			continue;
+		// the node uNext covers the positions [uPosition, uNext)
+		qint64 iHeight = ((qint64)m_Tree[uNext] * iLineSpacing) + ((qint64)uStep * iDescent);
+		if(iTop + iHeight <= iTarget)
+		{
+			uPosition = uNext;
+			iTop += iHeight;
+		}
+	}
+
+	if(uPosition < m_uFirst)
+		return m_uFirst;
+	if(uPosition >= m_uEnd)
+		return m_uEnd - 1;
+	return uPosition;
+}
@@ -0,0 +1,151 @@
+#ifndef _KVI_IRCVIEWLAYOUTINDEX_H_
+#define _KVI_IRCVIEWLAYOUTINDEX_H_
+//=============================================================================
+//
+//   File : KviIrcViewLayoutIndex.h
+//   Creation date : Sun Oct 18 2026 23:58:26 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviIrcViewLayoutIndex.h
+* \author The KVIrc Development Team
+* \brief Prefix sums of the heights of the lines of a KviIrcView
+*/
+
+#include "kvi_settings.h"
+
+#include <vector>
+
+/**
+* \class KviIrcViewLayoutIndex
+* \brief A Fenwick tree over the number of rows of each line of a buffer
+*
+* The lines get increasing positions when they are appended and
+* are removed from the front only: the positions of the removed lines
+* are not reused. When the positions run out the index must be
+* rebuilt from the buffer, which happens once every few thousands of
+* lines appended.
+* A line is (rows * line spacing + descent) pixels high, so the pixel
+* offsets are computed from the row sums without storing the font
+* metrics in the index.
+*/
+class KviIrcViewLayoutIndex
+{
+public:
+	/**
+	* \brief Constructs the index object
+	*
+	* The index is not valid until reset() is called
+	* \return KviIrcViewLayoutIndex
+	*/
+	KviIrcViewLayoutIndex();
+	~KviIrcViewLayoutIndex();
+
+private:
+	std::vector<int> m_Tree; // 1-based: m_Tree[p + 1] is the node of the position p
+	unsigned int m_uFirst;   // position of the first line
+	unsigned int m_uEnd;     // position after the last line
+	bool m_bValid;
+
+public:
+	/**
+	* \brief Returns true if the index is in sync with the buffer
+	* \return bool
+	*/
+	bool isValid() const { return m_bValid; }
+
+	/**
+	* \brief Marks the index as out of sync: it must be reset() and filled again
+	* \return void
+	*/
+	void invalidate() { m_bValid = false; }
+
+	/**
+	* \brief Empties the index and makes room for a buffer of the specified size
+	* \param uLines The number of lines that will be appended
+	* \return void
+	*/
+	void reset(unsigned int uLines);
+
+	/**
+	* \brief Appends a line
+	*
+	* When there are no positions left the index is invalidated
+	* \param uRows The number of rows of the line
+	* \param puPosition Will contain the position of the line
+	* \return bool
+	*/
+	bool append(unsigned int uRows, unsigned int * puPosition);
+
+	/**
+	* \brief Removes the first line
+	* \param uRows The number of rows the line was added with
+	* \return void
+	*/
+	void removeFirst(unsigned int uRows);
+
+	/**
+	* \brief Changes the number of rows of a line
+	* \param uPosition The position of the line
+	* \param iDelta The difference
+	* \return void
+	*/
+	void add(unsigned int uPosition, int iDelta);
+
+	/**
+	* \brief Returns the position of the first line
+	* \return unsigned int
+	*/
+	unsigned int first() const { return m_uFirst; }
+
+	/**
+	* \brief Returns the position after the last line
+	* \return unsigned int
+	*/
+	unsigned int end() const { return m_uEnd; }
+
+	/**
+	* \brief Returns the offset of the top of a line from the top of the first one
+	* \param uPosition The position of the line, between first() and end()
+	* \param iLineSpacing The height of a row
+	* \param iDescent The space added below each line
+	* \return int
+	*/
+	int lineTop(unsigned int uPosition, int iLineSpacing, int iDescent) const;
+
+	/**
+	* \brief Returns the position of the line that contains the specified offset
+	*
+	* The offset is measured from the top of the first line. The offsets
+	* out of the buffer give the first or the last line.
+	* The index must not be empty.
+	* \param iY The offset
+	* \param iLineSpacing The height of a row
+	* \param iDescent The space added below each line
+	* \return unsigned int
+	*/
+	unsigned int lineAt(int iY, int iLineSpacing, int iDescent) const;
+
+private:
+	int rowsBefore(unsigned int uPosition) const;
+};
+
+#endif //_KVI_IRCVIEWLAYOUTINDEX_H_
@@ -833,6 +833,12 @@ void KviIrcView::timerEvent(QTimerEvent * e)
 		flushLog();
 		return;
 	}
+
+	if(e->timerId() == m_iRelayoutTimer)
+	{
+		relayoutSlice();
+		return;
+	}
 }
 
 //not exactly events, but event-related
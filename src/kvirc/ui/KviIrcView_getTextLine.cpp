@@ -186,7 +186,7 @@ const kvi_wchar_t * KviIrcView::getTextLine(
 	line_ptr->pChunks[0].iTextStart = 0;
 	line_ptr->pChunks[0].colors.back = KVI_OPTION_MSGTYPE(iMsgType).back();
 	line_ptr->pChunks[0].colors.fore = KVI_OPTION_MSGTYPE(iMsgType).fore();
-	line_ptr->pChunks[0].customFore = QColor();
+	line_ptr->pChunks[0].customFore = 0;
 
 	// print a nice timestamp at the begin of the first line
 	if(bEnableTimeStamp && KVI_OPTION_BOOL(KviOption_boolIrcViewTimestamp))
@@ -221,7 +221,7 @@ const kvi_wchar_t * KviIrcView::getTextLine(
 			line_ptr->pChunks[2].iTextLen = 1;
 			line_ptr->pChunks[2].colors.back = KVI_OPTION_MSGTYPE(iMsgType).back();
 			line_ptr->pChunks[2].colors.fore = KVI_OPTION_MSGTYPE(iMsgType).fore();
-			line_ptr->pChunks[2].customFore = QColor();
+			line_ptr->pChunks[2].customFore = 0;
 			iCurChunk += 2;
 		}
 		else
@@ -295,7 +295,7 @@ const kvi_wchar_t * KviIrcView::getTextLine(
 	line_ptr->pChunks[iCurChunk].type = _chunk_type;                                            \
 	line_ptr->pChunks[iCurChunk].iTextStart = iTextIdx;                                         \
 	line_ptr->pChunks[iCurChunk].iTextLen = 0;                                                  \
-	line_ptr->pChunks[iCurChunk].customFore = iCurChunk ? line_ptr->pChunks[iCurChunk - 1].customFore : QColor();
+	line_ptr->pChunks[iCurChunk].customFore = iCurChunk ? line_ptr->pChunks[iCurChunk - 1].customFore : 0;
 
 	// EOF Macros
 
@@ -633,8 +633,10 @@ check_escape_switch:
 									KviUserListEntry * e = ((KviChannelWindow *)m_pKviWindow)->userListView()->findEntry(QString((QChar *)next_cr, term_cr - next_cr));
 									if(e)
 									{
+										QColor oNickColor;
+										e->color(oNickColor);
 										line_ptr->pChunks[iCurChunk].colors.fore = KVI_COLOR_CUSTOM;
-										e->color(line_ptr->pChunks[iCurChunk].customFore);
+										line_ptr->pChunks[iCurChunk].customFore = oNickColor.rgb();
 										bColorSet = true;
 									}
 								}
@@ -1270,6 +1272,7 @@ void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFla
 		line_ptr->iMaxLineWidth = -1;
 		line_ptr->iBlockCount = 0;
 		line_ptr->uLineWraps = 0;
+		line_ptr->uLayoutIndex = 0;
 
 		data_ptr = getTextLine(iMsgType, data_ptr, line_ptr, !(iFlags & NoTimestamp), datetime);
 
@@ -29,19 +29,13 @@
 #include "KviIrcView.h"
 #include "KviIrcView_private.h"
 #include "KviLocale.h"
+#include "KviLogWriter.h"
 #include "KviOptions.h"
 #include "kvi_out.h"
 #include "KviQString.h"
 #include "KviWindow.h"
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
-
-#include <QFileInfo>
-#include <QFile>
 #include <QDateTime>
-#include <QTextCodec>
 #include <QLocale>
 
 void KviIrcView::stopLogging()
@@ -51,32 +45,8 @@ void KviIrcView::stopLogging()
 		QDateTime date = QDateTime::currentDateTime();
 		QString szLogEnd = QString(__tr2qs("### Log session terminated ###"));
 		add2Log(szLogEnd, date, KVI_OUT_LOG, true);
-		m_pLogFile->close();
-#ifdef COMPILE_ZLIB_SUPPORT
-		if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		{
-			if(m_pLogFile->open(QIODevice::ReadOnly))
-			{
-				QByteArray bytes;
-				bytes = m_pLogFile->readAll();
-				m_pLogFile->close();
-				QFileInfo fi(*m_pLogFile);
-				QString szFname = fi.absolutePath() + QString("/") + fi.completeBaseName();
-				gzFile file = gzopen(QTextCodec::codecForLocale()->fromUnicode(szFname).data(), "ab9");
-				if(file)
-				{
-					gzwrite(file, bytes.data(), bytes.size());
-					gzclose(file);
-					m_pLogFile->remove();
-				}
-				else
-				{
-					qDebug("Can't open compressed stream");
-				}
-			}
-		}
-#endif
-		delete m_pLogFile;
+		// the writer thread flushes, finishes the compressed stream and deletes the file
+		KviLogWriter::instance()->close(m_pLogFile);
 		m_pLogFile = nullptr;
 	}
 }
@@ -103,36 +73,7 @@ void KviIrcView::getTextBuffer(QString & buffer)
 void KviIrcView::flushLog()
 {
 	if(m_pLogFile)
-	{
-#ifdef COMPILE_ZLIB_SUPPORT
-		if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		{
-			m_pLogFile->close();
-			if(m_pLogFile->open(QIODevice::ReadOnly))
-			{
-				QByteArray bytes;
-				bytes = m_pLogFile->readAll();
-				m_pLogFile->close();
-				QFileInfo fi(*m_pLogFile);
-				QString szFname = fi.absolutePath() + QString("/") + fi.completeBaseName();
-				gzFile file = gzopen(QTextCodec::codecForLocale()->fromUnicode(szFname).data(), "ab9");
-				if(file)
-				{
-					gzwrite(file, bytes.data(), bytes.size());
-					gzclose(file);
-					m_pLogFile->remove();
-				}
-				else
-				{
-					qDebug("Can't open compressed stream");
-				}
-			}
-			m_pLogFile->open(QIODevice::Append | QIODevice::WriteOnly);
-		}
-		else
-#endif
-			m_pLogFile->flush();
-	}
+		KviLogWriter::instance()->flush(m_pLogFile);
 	else if(m_pMasterView)
 		m_pMasterView->flushLog();
 }
@@ -193,31 +134,10 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 		m_pKviWindow->getDefaultLogFileName(szFname);
 	}
 
-#ifdef COMPILE_ZLIB_SUPPORT
-	if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		szFname += ".tmp";
-#endif
-
-	m_pLogFile = new QFile(szFname);
-
-	if(m_pLogFile->exists())
-	{
-		if(!m_pLogFile->open(QIODevice::Append | QIODevice::WriteOnly))
-		{
-			delete m_pLogFile;
-			m_pLogFile = nullptr;
-			return false;
-		}
-	}
-	else
-	{
-		if(!m_pLogFile->open(QIODevice::WriteOnly))
-		{
-			delete m_pLogFile;
-			m_pLogFile = nullptr;
-			return false;
-		}
-	}
+	// Gzipped logs are compressed on the fly by the writer thread
+	m_pLogFile = KviLogWriter::instance()->open(szFname, KVI_OPTION_BOOL(KviOption_boolGzipLogs));
+	if(!m_pLogFile)
+		return false;
 
 	QDateTime date = QDateTime::currentDateTime();
 	QString szLogStart = QString(__tr2qs("### Log session started ###"));
@@ -229,7 +149,7 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 		getTextBuffer(buffer);
 		add2Log(buffer, date, -1, false);
 		add2Log(__tr2qs("### End of existing data buffer."), date, KVI_OUT_LOG, true);
-		m_pLogFile->flush();
+		KviLogWriter::instance()->flush(m_pLogFile);
 	}
 
 	return true;
@@ -237,53 +157,43 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 
 void KviIrcView::add2Log(const QString & szBuffer, const QDateTime & aDate, int iMsgType, bool bPrependDate)
 {
-	QByteArray tmp;
+	// Build the whole line first: it is converted and queued to the writer thread at once
+	QString szLine;
 
 	if(iMsgType >= 0 && !KVI_OPTION_BOOL(KviOption_boolStripMsgTypeInLogs))
 	{
-		QString szMessageType = QString("%1 ").arg(iMsgType);
-
-		tmp = szMessageType.toUtf8();
-
-		if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-			qDebug("WARNING: can't write to the log file.");
+		szLine.setNum(iMsgType);
+		szLine.append(' ');
 	}
 
 	if(bPrependDate)
 	{
-		QString szDate;
 		QDateTime date = aDate.isValid() ? aDate : QDateTime::currentDateTime();
 		switch(KVI_OPTION_UINT(KviOption_uintOutputDatetimeFormat))
 		{
 			case 0:
-				szDate = date.toString("[hh:mm:ss] ");
+				szLine += date.toString("[hh:mm:ss] ");
 				break;
 			case 1:
-				szDate = date.toString(Qt::ISODate);
+				szLine += date.toString(Qt::ISODate);
 				if (date.timeSpec() == Qt::LocalTime)
 				{
 					// Log milliseconds. QDateTime.fromString can parse them already.
 					// However, the format is more complicated if a timezone is present,
 					// so only log them for local time.
-					szDate += date.toString(".zzz");
+					szLine += date.toString(".zzz");
 				}
-				szDate += " ";
+				szLine += " ";
 				break;
 			case 2:
-				szDate = date.toString(Qt::SystemLocaleShortDate);
-				szDate += " ";
+				szLine += date.toString(Qt::SystemLocaleShortDate);
+				szLine += " ";
 				break;
 		}
-
-		tmp = szDate.toUtf8();
-
-		if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-			qDebug("WARNING: can't write to the log file.");
 	}
 
-	tmp = szBuffer.toUtf8();
-	tmp.append('\n');
+	szLine += szBuffer;
+	szLine.append('\n');
 
-	if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-		qDebug("WARNING: can't write to the log file.");
+	KviLogWriter::instance()->write(m_pLogFile, szLine.toUtf8());
 }
@@ -26,6 +26,7 @@
 
 #include "kvi_settings.h"
 
+#include <QColor>
 #include <QString>
 
 //
@@ -79,18 +80,19 @@
 
 typedef struct _KviIrcViewLineChunk
 {
-	unsigned char type;      // chunk type
-	int iTextStart;          // index in the szText string of the beginning of the block
-	int iTextLen;            // length in chars of the block (excluding the terminator)
-	kvi_wchar_t * szPayload; // KVI_TEXT_ESCAPE attribute command buffer and KVI_TEXT_ICON icon name (non zeroed for other attributes!!!)
-	kvi_wchar_t * szSmileId;
+	// The members are ordered by size to keep the structure compact:
+	// there are several of these for each line in the buffer.
+	unsigned char type; // chunk type
 	struct
 	{
 		unsigned char back; // optional background color for KVI_TEXT_COLOR attribute
 		unsigned char fore; // optional foreground color for KVI_TEXT_COLOR attribute (used also for KVI_TEXT_ESCAPE!!!)
 	} _KVI_PACKED colors;   // anonymous
-	                        //	QColor customBack;
-	QColor customFore;
+	QRgb customFore;         // the real color when colors.fore is KVI_COLOR_CUSTOM
+	int iTextStart;          // index in the szText string of the beginning of the block
+	int iTextLen;            // length in chars of the block (excluding the terminator)
+	kvi_wchar_t * szPayload; // KVI_TEXT_ESCAPE attribute command buffer and KVI_TEXT_ICON icon name (non zeroed for other attributes!!!)
+	kvi_wchar_t * szSmileId;
 } /*_KVI_PACKED*/ KviIrcViewLineChunk;
 
 //
@@ -125,6 +127,7 @@ typedef struct _KviIrcViewLine
 	int iMaxLineWidth;                // width that the blocks were calculated for (lazy calculation)
 	int iBlockCount;                  // number of allocated paintable blocks
 	KviIrcViewWrappedBlock * pBlocks; // pointer to the re-splitted paintable blocks
+	unsigned int uLayoutIndex;        // position of the line in the layout index of the view
 
 	// next and previous line
 	struct _KviIrcViewLine * pPrev;
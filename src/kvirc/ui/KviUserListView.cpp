@@ -57,6 +57,9 @@
 #include <QScrollBar>
 #include <QRegExp>
 
+#include <algorithm>
+#include <vector>
+
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
 extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 #endif
@@ -71,6 +74,14 @@ extern QPixmap * g_pUserChanStatePixmap;
 #define KVI_USERLIST_ICON_STATE_WIDTH 8
 #define KVI_USERLIST_ICON_MARGIN 3
 
+// The sorting options the order index depends on (see KviUserListView::indexConfig())
+#define KVI_USERLIST_SORT_OWNERPREFIX 1
+#define KVI_USERLIST_SORT_ADMINPREFIX 2
+#define KVI_USERLIST_SORT_NONALPHAATEND 4
+
+// Seed of the order index priorities
+static unsigned int g_uUserListIndexSeed = 2463534242u;
+
 // FIXME: #warning "We want to be able to navigate the list with the keyboard!"
 
 KviUserListToolTip::KviUserListToolTip(KviUserListView * pView, KviUserListViewArea * pArea)
@@ -101,8 +112,19 @@ KviUserListEntry::KviUserListEntry(KviUserListView * pParent, const QString & sz
 	m_bSelected = false;
 	m_pAvatarPixmap = nullptr;
 
+	m_pIndexParent = nullptr;
+	m_pIndexLeft = nullptr;
+	m_pIndexRight = nullptr;
+	// xorshift: the priorities only need to be scattered
+	g_uUserListIndexSeed ^= g_uUserListIndexSeed << 13;
+	g_uUserListIndexSeed ^= g_uUserListIndexSeed >> 17;
+	g_uUserListIndexSeed ^= g_uUserListIndexSeed << 5;
+	m_uIndexPriority = g_uUserListIndexSeed;
+	m_iSortRank = 0;
+
 	updateAvatarData();
 	recalcSize();
+	m_iIndexHeight = m_iHeight;
 }
 
 KviUserListEntry::~KviUserListEntry()
@@ -245,6 +267,9 @@ KviUserListView::KviUserListView(QWidget * pParent, KviWindowToolPageButton * pB
 	m_ieEntries = 0;
 	m_iIEntries = 0;
 	m_iSelectedCount = 0;
+	m_pIndexRoot = nullptr;
+	m_iIndexConfig = 0;
+	m_bBulkJoin = false;
 
 	applyOptions();
 }
@@ -352,10 +377,6 @@ void KviUserListView::applyOptions()
 
 	KviUserListEntry * pEntry = m_pHeadItem;
 
-	//reset scrollarea position and scrollbar position
-	m_pTopItem = m_pHeadItem;
-	m_pViewArea->m_pScrollBar->setValue(0);
-
 	m_iTotalHeight = 0;
 	while(pEntry)
 	{
@@ -364,6 +385,17 @@ void KviUserListView::applyOptions()
 		m_iTotalHeight += pEntry->m_iHeight;
 		pEntry = pEntry->m_pNext;
 	}
+
+	// the heights have changed (and maybe the sorting options too)
+	rebuildIndex();
+
+	//reset scrollarea position and scrollbar position
+	m_pTopItem = m_pHeadItem;
+	m_pViewArea->m_iTopItemOffset = 0;
+	m_pViewArea->m_iLastScrollBarVal = 0;
+	m_pViewArea->m_bIgnoreScrollBar = true;
+	m_pViewArea->m_pScrollBar->setValue(0);
+	m_pViewArea->m_bIgnoreScrollBar = false;
 	updateScrollBarRange();
 	m_pUsersLabel->setFont(KVI_OPTION_FONT(KviOption_fontUserListView));
 	resizeEvent(nullptr); // this will call update() too
@@ -463,6 +495,8 @@ void KviUserListView::animatedAvatarUpdated(KviUserListEntry * e)
 
 void KviUserListView::completeNickBashLike(const QString & szBegin, std::vector<QString> & pList, bool bAppendMask)
 {
+	commitBulkJoin();
+
 	KviUserListEntry * pEntry = m_pHeadItem;
 	while(pEntry)
 	{
@@ -487,6 +521,8 @@ void KviUserListView::completeNickBashLike(const QString & szBegin, std::vector<
 
 bool KviUserListView::completeNickStandard(const QString & szBegin, const QString & szSkipAfter, QString & szBuffer, bool bAppendMask)
 {
+	commitBulkJoin();
+
 	KviUserListEntry * pEntry = m_pHeadItem;
 
 	if(!szSkipAfter.isEmpty())
@@ -542,56 +578,378 @@ bool KviUserListView::completeNickStandard(const QString & szBegin, const QStrin
 	return false;
 }
 
-void KviUserListView::insertUserEntry(const QString & szNnick, KviUserListEntry * pUserEntry)
+// The order index is a treap of the entries, keyed by their mode group and
+// nickname and augmented with the total height of each subtree.
+// It finds the place of a new entry in the list and maps the entries to their
+// vertical positions (and back) in logarithmic time.
+
+int KviUserListView::indexConfig()
 {
-	// Complex insertion task :)
-	m_pEntryDict->insert(szNnick, pUserEntry);
-	m_iTotalHeight += pUserEntry->m_iHeight;
+	int iConfig = 0;
+	if(m_pKviWindow->connection())
+	{
+		if(m_pKviWindow->connection()->serverInfo()->isSupportedModeFlag('q'))
+			iConfig |= KVI_USERLIST_SORT_OWNERPREFIX;
+		if(m_pKviWindow->connection()->serverInfo()->isSupportedModeFlag('a'))
+			iConfig |= KVI_USERLIST_SORT_ADMINPREFIX;
+	}
+	if(KVI_OPTION_BOOL(KviOption_boolPlaceNickWithNonAlphaCharsAtEnd))
+		iConfig |= KVI_USERLIST_SORT_NONALPHAATEND;
+	return iConfig;
+}
 
-	bool bGotTopItem = false;
-	bool bModeqHasPrefix = m_pKviWindow->connection()->serverInfo()->isSupportedModeFlag('q');
-	bool bModeaHasPrefix = m_pKviWindow->connection()->serverInfo()->isSupportedModeFlag('a');
+int KviUserListView::indexCompare(KviUserListEntry * pEntry1, KviUserListEntry * pEntry2)
+{
+	if(pEntry1->m_iSortRank != pEntry2->m_iSortRank)
+		return pEntry1->m_iSortRank - pEntry2->m_iSortRank;
+	return KviQString::cmpCI(pEntry1->m_szNick, pEntry2->m_szNick, m_iIndexConfig & KVI_USERLIST_SORT_NONALPHAATEND);
+}
 
-	int iFlag = 0;
-	if(pUserEntry->m_iFlags != 0)
+void KviUserListView::indexRotateUp(KviUserListEntry * pEntry)
+{
+	KviUserListEntry * pParent = pEntry->m_pIndexParent;
+	KviUserListEntry * pGrandParent = pParent->m_pIndexParent;
+
+	if(pParent->m_pIndexLeft == pEntry)
 	{
-		if(pUserEntry->m_iFlags & KviIrcUserEntry::UserOp)
+		pParent->m_pIndexLeft = pEntry->m_pIndexRight;
+		if(pParent->m_pIndexLeft)
+			pParent->m_pIndexLeft->m_pIndexParent = pParent;
+		pEntry->m_pIndexRight = pParent;
+	}
+	else
+	{
+		pParent->m_pIndexRight = pEntry->m_pIndexLeft;
+		if(pParent->m_pIndexRight)
+			pParent->m_pIndexRight->m_pIndexParent = pParent;
+		pEntry->m_pIndexLeft = pParent;
+	}
+
+	pParent->m_pIndexParent = pEntry;
+	pEntry->m_pIndexParent = pGrandParent;
+
+	if(!pGrandParent)
+		m_pIndexRoot = pEntry;
+	else if(pGrandParent->m_pIndexLeft == pParent)
+		pGrandParent->m_pIndexLeft = pEntry;
+	else
+		pGrandParent->m_pIndexRight = pEntry;
+
+	// the subtree of the grand parent has the same entries
+	pParent->m_iIndexHeight = pParent->m_iHeight
+	    + (pParent->m_pIndexLeft ? pParent->m_pIndexLeft->m_iIndexHeight : 0)
+	    + (pParent->m_pIndexRight ? pParent->m_pIndexRight->m_iIndexHeight : 0);
+	pEntry->m_iIndexHeight = pEntry->m_iHeight
+	    + (pEntry->m_pIndexLeft ? pEntry->m_pIndexLeft->m_iIndexHeight : 0)
+	    + (pEntry->m_pIndexRight ? pEntry->m_pIndexRight->m_iIndexHeight : 0);
+}
+
+void KviUserListView::indexUpdateRank(KviUserListEntry * pEntry)
+{
+	// the mode group: channel owners, admins, ops, halfops, voiced users, userops and the others
+	int iFlags = pEntry->m_iFlags;
+	if((iFlags & KviIrcUserEntry::ChanOwner) && (m_iIndexConfig & KVI_USERLIST_SORT_OWNERPREFIX))
+		pEntry->m_iSortRank = 0;
+	else if((iFlags & KviIrcUserEntry::ChanAdmin) && (m_iIndexConfig & KVI_USERLIST_SORT_ADMINPREFIX))
+		pEntry->m_iSortRank = 1;
+	else if(iFlags & KviIrcUserEntry::Op)
+		pEntry->m_iSortRank = 2;
+	else if(iFlags & KviIrcUserEntry::HalfOp)
+		pEntry->m_iSortRank = 3;
+	else if(iFlags & KviIrcUserEntry::Voice)
+		pEntry->m_iSortRank = 4;
+	else if(iFlags & KviIrcUserEntry::UserOp)
+		pEntry->m_iSortRank = 5;
+	else
+		pEntry->m_iSortRank = 6;
+}
+
+void KviUserListView::indexInsert(KviUserListEntry * pEntry)
+{
+	indexUpdateRank(pEntry);
+
+	pEntry->m_pIndexLeft = nullptr;
+	pEntry->m_pIndexRight = nullptr;
+	pEntry->m_iIndexHeight = pEntry->m_iHeight;
+
+	// find the leaf position: the entry goes before the equal ones
+	KviUserListEntry * pParent = nullptr;
+	KviUserListEntry * pNext = nullptr; // the first entry that follows the new one
+	KviUserListEntry * p = m_pIndexRoot;
+	while(p)
+	{
+		pParent = p;
+		p->m_iIndexHeight += pEntry->m_iHeight;
+		if(indexCompare(pEntry, p) <= 0)
 		{
-			iFlag = KviIrcUserEntry::UserOp;
-			m_iUserOpCount++;
+			pNext = p;
+			p = p->m_pIndexLeft;
 		}
+		else
+		{
+			p = p->m_pIndexRight;
+		}
+	}
 
-		if(pUserEntry->m_iFlags & KviIrcUserEntry::Voice)
+	pEntry->m_pIndexParent = pParent;
+	if(!pParent)
+		m_pIndexRoot = pEntry;
+	else if(pNext == pParent)
+		pParent->m_pIndexLeft = pEntry;
+	else
+		pParent->m_pIndexRight = pEntry;
+
+	while(pEntry->m_pIndexParent && (pEntry->m_pIndexParent->m_uIndexPriority < pEntry->m_uIndexPriority))
+		indexRotateUp(pEntry);
+
+	// and link it in the list
+	pEntry->m_pNext = pNext;
+	pEntry->m_pPrev = pNext ? pNext->m_pPrev : m_pTailItem;
+	if(pEntry->m_pPrev)
+		pEntry->m_pPrev->m_pNext = pEntry;
+	else
+		m_pHeadItem = pEntry;
+	if(pNext)
+		pNext->m_pPrev = pEntry;
+	else
+		m_pTailItem = pEntry;
+}
+
+void KviUserListView::indexRemove(KviUserListEntry * pEntry)
+{
+	// push the entry down to a leaf
+	while(pEntry->m_pIndexLeft || pEntry->m_pIndexRight)
+	{
+		if(!pEntry->m_pIndexRight || (pEntry->m_pIndexLeft && (pEntry->m_pIndexLeft->m_uIndexPriority > pEntry->m_pIndexRight->m_uIndexPriority)))
+			indexRotateUp(pEntry->m_pIndexLeft);
+		else
+			indexRotateUp(pEntry->m_pIndexRight);
+	}
+
+	KviUserListEntry * pParent = pEntry->m_pIndexParent;
+	if(!pParent)
+		m_pIndexRoot = nullptr;
+	else if(pParent->m_pIndexLeft == pEntry)
+		pParent->m_pIndexLeft = nullptr;
+	else
+		pParent->m_pIndexRight = nullptr;
+
+	for(; pParent; pParent = pParent->m_pIndexParent)
+		pParent->m_iIndexHeight -= pEntry->m_iHeight;
+
+	pEntry->m_pIndexParent = nullptr;
+}
+
+void KviUserListView::indexHeightChanged(KviUserListEntry * pEntry, int iDiff)
+{
+	for(; pEntry; pEntry = pEntry->m_pIndexParent)
+		pEntry->m_iIndexHeight += iDiff;
+}
+
+int KviUserListView::indexOffset(KviUserListEntry * pEntry)
+{
+	int iOffset = pEntry->m_pIndexLeft ? pEntry->m_pIndexLeft->m_iIndexHeight : 0;
+	for(KviUserListEntry * p = pEntry; p->m_pIndexParent; p = p->m_pIndexParent)
+	{
+		KviUserListEntry * pParent = p->m_pIndexParent;
+		if(pParent->m_pIndexRight == p)
+			iOffset += pParent->m_iHeight + (pParent->m_pIndexLeft ? pParent->m_pIndexLeft->m_iIndexHeight : 0);
+	}
+	return iOffset;
+}
+
+KviUserListEntry * KviUserListView::indexEntryAt(int iOffset, int * piEntryOffset)
+{
+	if(iOffset < 0)
+		iOffset = 0;
+
+	KviUserListEntry * p = m_pIndexRoot;
+	while(p)
+	{
+		int iLeft = p->m_pIndexLeft ? p->m_pIndexLeft->m_iIndexHeight : 0;
+		if(iOffset < iLeft)
 		{
-			iFlag = KviIrcUserEntry::Voice;
-			m_iVoiceCount++;
+			p = p->m_pIndexLeft;
+		}
+		else if(iOffset < iLeft + p->m_iHeight)
+		{
+			*piEntryOffset = iOffset - iLeft;
+			return p;
+		}
+		else
+		{
+			iOffset -= iLeft + p->m_iHeight;
+			p = p->m_pIndexRight;
 		}
+	}
 
-		if(pUserEntry->m_iFlags & KviIrcUserEntry::HalfOp)
+	// past the end
+	*piEntryOffset = m_pTailItem ? m_pTailItem->m_iHeight : 0;
+	return m_pTailItem;
+}
+
+static int index_update_heights(KviUserListEntry * p)
+{
+	if(!p)
+		return 0;
+	p->m_iIndexHeight = p->m_iHeight + index_update_heights(p->m_pIndexLeft) + index_update_heights(p->m_pIndexRight);
+	return p->m_iIndexHeight;
+}
+
+void KviUserListView::indexBuild(std::vector<KviUserListEntry *> & entries)
+{
+	m_pHeadItem = nullptr;
+	m_pTailItem = nullptr;
+
+	// Link the list and build the treap as a cartesian tree of the priorities:
+	// the stack holds the right spine of the tree built so far
+	std::vector<KviUserListEntry *> spine;
+	for(auto pEntry : entries)
+	{
+		pEntry->m_pPrev = m_pTailItem;
+		pEntry->m_pNext = nullptr;
+		if(m_pTailItem)
+			m_pTailItem->m_pNext = pEntry;
+		else
+			m_pHeadItem = pEntry;
+		m_pTailItem = pEntry;
+
+		KviUserListEntry * pLast = nullptr;
+		while(!spine.empty() && (spine.back()->m_uIndexPriority < pEntry->m_uIndexPriority))
 		{
-			iFlag = KviIrcUserEntry::HalfOp;
-			m_iHalfOpCount++;
+			pLast = spine.back();
+			spine.pop_back();
 		}
 
-		if(pUserEntry->m_iFlags & KviIrcUserEntry::Op)
+		pEntry->m_pIndexLeft = pLast;
+		pEntry->m_pIndexRight = nullptr;
+		if(pLast)
+			pLast->m_pIndexParent = pEntry;
+
+		if(spine.empty())
 		{
-			iFlag = KviIrcUserEntry::Op;
-			m_iOpCount++;
+			pEntry->m_pIndexParent = nullptr;
+		}
+		else
+		{
+			spine.back()->m_pIndexRight = pEntry;
+			pEntry->m_pIndexParent = spine.back();
 		}
 
-		if(pUserEntry->m_iFlags & KviIrcUserEntry::ChanAdmin)
+		spine.push_back(pEntry);
+	}
+
+	m_pIndexRoot = spine.empty() ? nullptr : spine.front();
+	index_update_heights(m_pIndexRoot);
+}
+
+void KviUserListView::indexSyncScrollBar()
+{
+	if(!m_pTopItem)
+		return;
+
+	m_pViewArea->m_iLastScrollBarVal = indexOffset(m_pTopItem) + m_pViewArea->m_iTopItemOffset;
+	m_pViewArea->m_bIgnoreScrollBar = true;
+	updateScrollBarRange();
+	m_pViewArea->m_pScrollBar->setValue(m_pViewArea->m_iLastScrollBarVal);
+	m_pViewArea->m_bIgnoreScrollBar = false;
+}
+
+void KviUserListView::rebuildIndex()
+{
+	m_iIndexConfig = indexConfig();
+
+	std::vector<KviUserListEntry *> entries;
+	for(KviUserListEntry * pEntry = m_pHeadItem; pEntry; pEntry = pEntry->m_pNext)
+	{
+		indexUpdateRank(pEntry);
+		entries.push_back(pEntry);
+	}
+
+	// the list is almost always still sorted
+	std::stable_sort(entries.begin(), entries.end(), [this](KviUserListEntry * a, KviUserListEntry * b) { return indexCompare(a, b) < 0; });
+	indexBuild(entries);
+
+	// the top item may have moved
+	indexSyncScrollBar();
+	m_pViewArea->update();
+}
+
+void KviUserListView::beginBulkJoin()
+{
+	m_bBulkJoin = true;
+}
+
+void KviUserListView::endBulkJoin()
+{
+	m_bBulkJoin = false;
+	commitBulkJoin();
+}
+
+void KviUserListView::commitBulkJoin()
+{
+	if(m_BulkEntries.empty())
+		return;
+
+	if(m_iIndexConfig != indexConfig())
+		rebuildIndex();
+
+	for(auto pEntry : m_BulkEntries)
+	{
+		indexUpdateRank(pEntry);
+		m_iTotalHeight += pEntry->m_iHeight;
+	}
+
+	auto lessThan = [this](KviUserListEntry * a, KviUserListEntry * b) { return indexCompare(a, b) < 0; };
+	std::sort(m_BulkEntries.begin(), m_BulkEntries.end(), lessThan);
+
+	// merge the new entries with the ones already in the list
+	std::vector<KviUserListEntry *> entries;
+	entries.reserve(m_BulkEntries.size() + m_pEntryDict->count());
+	KviUserListEntry * pEntry = m_pHeadItem;
+	for(auto pNew : m_BulkEntries)
+	{
+		while(pEntry && lessThan(pEntry, pNew))
 		{
-			if(bModeaHasPrefix)
-				iFlag = KviIrcUserEntry::ChanAdmin;
-			m_iChanAdminCount++;
+			entries.push_back(pEntry);
+			pEntry = pEntry->m_pNext;
 		}
+		entries.push_back(pNew);
+	}
+	for(; pEntry; pEntry = pEntry->m_pNext)
+		entries.push_back(pEntry);
+
+	m_BulkEntries.clear();
+
+	indexBuild(entries);
+
+	if(!m_pTopItem)
+		m_pTopItem = m_pHeadItem;
+	else
+		indexSyncScrollBar(); // some entries may have been inserted above the top item
 
+	triggerUpdate();
+}
+
+void KviUserListView::insertUserEntry(const QString & szNnick, KviUserListEntry * pUserEntry)
+{
+	// Complex insertion task :)
+	m_pEntryDict->insert(szNnick, pUserEntry);
+
+	if(pUserEntry->m_iFlags != 0)
+	{
+		if(pUserEntry->m_iFlags & KviIrcUserEntry::UserOp)
+			m_iUserOpCount++;
+		if(pUserEntry->m_iFlags & KviIrcUserEntry::Voice)
+			m_iVoiceCount++;
+		if(pUserEntry->m_iFlags & KviIrcUserEntry::HalfOp)
+			m_iHalfOpCount++;
+		if(pUserEntry->m_iFlags & KviIrcUserEntry::Op)
+			m_iOpCount++;
+		if(pUserEntry->m_iFlags & KviIrcUserEntry::ChanAdmin)
+			m_iChanAdminCount++;
 		if(pUserEntry->m_iFlags & KviIrcUserEntry::ChanOwner)
-		{
-			if(bModeqHasPrefix)
-				iFlag = KviIrcUserEntry::ChanOwner;
 			m_iChanOwnerCount++;
-		}
 	}
 
 	//FIXME this should probably be handled in a different way (place)
@@ -600,162 +958,60 @@ void KviUserListView::insertUserEntry(const QString & szNnick, KviUserListEntry
 		m_iIrcOpCount++;
 	}
 
-	if(m_pHeadItem)
+	if(pUserEntry->m_bSelected)
 	{
-		KviUserListEntry * pEntry = m_pHeadItem;
-
-		if(!(pUserEntry->m_iFlags & KviIrcUserEntry::ChanOwner) || !bModeqHasPrefix)
-		{
-			// the new user is not a channel owner...
-			// skip the channel owners
-			while(pEntry && (pEntry->m_iFlags & KviIrcUserEntry::ChanOwner) && bModeqHasPrefix)
-			{
-				if(pEntry == m_pTopItem)
-					bGotTopItem = true;
-				pEntry = pEntry->m_pNext;
-			}
-
-			if(!(pUserEntry->m_iFlags & KviIrcUserEntry::ChanAdmin) || !bModeaHasPrefix)
-			{
-				// the new user is not a channel admin...
-				// skip chan admins
-				while(pEntry && (pEntry->m_iFlags & KviIrcUserEntry::ChanAdmin) && bModeaHasPrefix)
-				{
-					if(pEntry == m_pTopItem)
-						bGotTopItem = true;
-					pEntry = pEntry->m_pNext;
-				}
+		m_iSelectedCount++;
+		if(m_iSelectedCount == 1)
+			g_pMainWindow->childWindowSelectionStateChange(m_pKviWindow, true);
+	}
 
-				// is operator ?
-				if(!(pUserEntry->m_iFlags & KviIrcUserEntry::Op))
-				{
-					// the new user is not an op...
-					// skip ops
-					while(pEntry && (pEntry->m_iFlags & KviIrcUserEntry::Op))
-					{
-						if(pEntry == m_pTopItem)
-							bGotTopItem = true;
-						pEntry = pEntry->m_pNext;
-					}
+	if(m_bBulkJoin)
+	{
+		// will be sorted and linked by commitBulkJoin()
+		m_BulkEntries.push_back(pUserEntry);
+		return;
+	}
 
-					// is half oped ?
-					if(!(pUserEntry->m_iFlags & KviIrcUserEntry::HalfOp))
-					{
-						// nope, skip halfops
-						while(pEntry && (pEntry->m_iFlags & KviIrcUserEntry::HalfOp))
-						{
-							if(pEntry == m_pTopItem)
-								bGotTopItem = true;
-							pEntry = pEntry->m_pNext;
-						}
+	m_iTotalHeight += pUserEntry->m_iHeight;
 
-						// is voiced ?
-						if(!(pUserEntry->m_iFlags & KviIrcUserEntry::Voice))
-						{
-							// nope, not voiced so skip voiced users
-							while(pEntry && (pEntry->m_iFlags & KviIrcUserEntry::Voice))
-							{
-								if(pEntry == m_pTopItem)
-									bGotTopItem = true;
-								pEntry = pEntry->m_pNext;
-							}
+	if(m_iIndexConfig != indexConfig())
+		rebuildIndex(); // the server has changed the prefixes or the user has changed the options
 
-							// is userop'd?
-							if(!(pUserEntry->m_iFlags & KviIrcUserEntry::UserOp))
-							{
-								// nope, skip userops
-								while(pEntry && (pEntry->m_iFlags & KviIrcUserEntry::UserOp))
-								{
-									if(pEntry == m_pTopItem)
-										bGotTopItem = true;
-									pEntry = pEntry->m_pNext;
-								}
-							} // else is userop, ops, halfops, and voiced are skipped
-						}         // else it is voiced, ops and halfops are skipped
-					}                 // else it is halfop,  ops are skipped
-				}                         // else it is op, chan admins are skipped
-			}                                 // else it is chan admin, chan owners are skipped
-		}                                         // else it is chan owner, so nothing to skip: they are first in the list
-
-		// now strcmp within the current user-flag group...
-		while(pEntry && (KviQString::cmpCI(pEntry->m_szNick, pUserEntry->m_szNick,
-		                     KVI_OPTION_BOOL(KviOption_boolPlaceNickWithNonAlphaCharsAtEnd))
-		                    < 0)
-		    && ((pEntry->m_iFlags & iFlag) || (iFlag == 0)))
-		{
-			if(pEntry == m_pTopItem)
-				bGotTopItem = true;
-			pEntry = pEntry->m_pNext;
-		}
+	// the index finds the place of the entry in the list
+	indexInsert(pUserEntry);
 
-		if(pEntry)
+	if(!m_pTopItem)
+	{
+		// There were no items (is rather visible)
+		m_pTopItem = pUserEntry;
+		triggerUpdate();
+	}
+	else if(indexCompare(pUserEntry, m_pTopItem) < 0)
+	{
+		// Inserting BEFORE the top item
+		if((pUserEntry == m_pHeadItem) && (m_pTopItem == pUserEntry->m_pNext) && (m_pViewArea->m_iTopItemOffset == 0))
 		{
-			// inserting
-			pUserEntry->m_pNext = pEntry;
-			pUserEntry->m_pPrev = pEntry->m_pPrev;
-			if(pUserEntry->m_pPrev == nullptr)
-				m_pHeadItem = pUserEntry;
-			else
-				pUserEntry->m_pPrev->m_pNext = pUserEntry;
-
-			pEntry->m_pPrev = pUserEntry;
-			// need to adjust the item offsets now...
-			// ok... if we're inserting something after
-			// the top item, we move everything down
-			// otherwise we only update the scrollbar values
-			if(!bGotTopItem)
-			{
-				// Inserting BEFORE the top item
-				if((pUserEntry == m_pHeadItem) && (m_pTopItem == pUserEntry->m_pNext) && (m_pViewArea->m_iTopItemOffset == 0))
-				{
-					// special case...the top item is the head one
-					// and it has zero offset...change the top item too
-					m_pTopItem = pUserEntry;
-					triggerUpdate();
-				}
-				else
-				{
-					// invisible insertion
-					m_pViewArea->m_bIgnoreScrollBar = true;
-					m_pViewArea->m_iLastScrollBarVal += pUserEntry->m_iHeight;
-					updateScrollBarRange();
-					m_pViewArea->m_pScrollBar->setValue(m_pViewArea->m_iLastScrollBarVal);
-					m_pViewArea->m_bIgnoreScrollBar = false;
-					updateUsersLabel();
-				}
-			}
-			else
-			{
-				triggerUpdate();
-			}
+			// special case...the top item is the head one
+			// and it has zero offset...change the top item too
+			m_pTopItem = pUserEntry;
+			triggerUpdate();
 		}
 		else
 		{
-			// appending to the end (may be visible)
-			m_pTailItem->m_pNext = pUserEntry;
-			pUserEntry->m_pNext = nullptr;
-			pUserEntry->m_pPrev = m_pTailItem;
-			m_pTailItem = pUserEntry;
-			triggerUpdate();
+			// invisible insertion
+			m_pViewArea->m_bIgnoreScrollBar = true;
+			m_pViewArea->m_iLastScrollBarVal += pUserEntry->m_iHeight;
+			updateScrollBarRange();
+			m_pViewArea->m_pScrollBar->setValue(m_pViewArea->m_iLastScrollBarVal);
+			m_pViewArea->m_bIgnoreScrollBar = false;
+			updateUsersLabel();
 		}
 	}
 	else
 	{
-		// There were no items (is rather visible)
-		m_pHeadItem = pUserEntry;
-		m_pTailItem = pUserEntry;
-		m_pTopItem = pUserEntry;
-		pUserEntry->m_pNext = nullptr;
-		pUserEntry->m_pPrev = nullptr;
+		// inserting after the top item (may be visible)
 		triggerUpdate();
 	}
-
-	if(pUserEntry->m_bSelected)
-	{
-		m_iSelectedCount++;
-		if(m_iSelectedCount == 1)
-			g_pMainWindow->childWindowSelectionStateChange(m_pKviWindow, true);
-	}
 }
 
 KviUserListEntry * KviUserListView::join(const QString & szNick, const QString & szUser, const QString & szHost, int iFlags)
@@ -819,27 +1075,17 @@ bool KviUserListView::avatarChanged(const QString & szNick)
 	if(!pUserEntry)
 		return false;
 
+	commitBulkJoin();
+
 	int iOldHeight = pUserEntry->m_iHeight;
 	m_iTotalHeight -= pUserEntry->m_iHeight;
 	pUserEntry->updateAvatarData();
 	pUserEntry->recalcSize();
 	m_iTotalHeight += pUserEntry->m_iHeight;
+	indexHeightChanged(pUserEntry, pUserEntry->m_iHeight - iOldHeight);
 	// if this was "over" the top item, we must adjust the scrollbar value
 	// otherwise scroll everything down
-	KviUserListEntry * pEntry = m_pHeadItem;
-	bool bGotTopItem = false;
-	while(pEntry != pUserEntry)
-	{
-		if(pEntry == m_pTopItem)
-		{
-			bGotTopItem = true;
-			pEntry = pUserEntry;
-		}
-		else
-			pEntry = pEntry->m_pNext;
-	}
-
-	if(!bGotTopItem && (m_pTopItem != pUserEntry))
+	if(m_pTopItem && (indexCompare(pUserEntry, m_pTopItem) < 0))
 	{
 		// we're "over" the top item, so over the
 		// upper side of the view...adjust the scroll bar value
@@ -1164,45 +1410,19 @@ void KviUserListView::ensureVisible(const QString & szNick)
 	if(!pUserEntry)
 		return;
 
-	// so, first of all..check if this item is over, or below the top item
-	KviUserListEntry * pEntry = m_pHeadItem;
-	bool bGotTopItem = false;
-	bool bGotUserEntry = false;
-	int iHeight = 0;
-	while(pEntry)
-	{
-		if(pEntry == pUserEntry)
-		{
-			if(bGotTopItem)
-			{
-				iHeight += pEntry->m_iHeight;
-				break;
-			}
-			else
-			{
-				bGotUserEntry = true;
-			}
-		}
+	commitBulkJoin();
 
-		if(pEntry == m_pTopItem)
-		{
-			if(bGotUserEntry)
-			{
-				iHeight -= pEntry->m_iHeight;
-				break;
-			}
-			else
-			{
-				bGotTopItem = true;
-			}
-		}
+	if(!m_pTopItem)
+		return;
 
-		if(bGotTopItem)
-			iHeight += pEntry->m_iHeight;
-		if(bGotUserEntry)
-			iHeight -= pEntry->m_iHeight;
-		pEntry = pEntry->m_pNext;
-	}
+	// so, first of all..check if this item is over, or below the top item
+	int iUserOffset = indexOffset(pUserEntry);
+	int iTopOffset = indexOffset(m_pTopItem);
+	int iHeight;
+	if(iUserOffset > iTopOffset)
+		iHeight = iUserOffset + pUserEntry->m_iHeight - iTopOffset; // from the top item to the bottom of the entry
+	else
+		iHeight = iUserOffset - iTopOffset - m_pTopItem->m_iHeight; // from the bottom of the top item to the entry
 
 	if(iHeight > m_pViewArea->height())
 	{
@@ -1225,19 +1445,11 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 	if(!pUserEntry)
 		return false; // not there
 
+	commitBulkJoin();
+
 	// so, first of all..check if this item is over, or below the top item
-	KviUserListEntry * pEntry = m_pHeadItem;
-	bool bGotTopItem = false;
-	while(pEntry != pUserEntry)
-	{
-		if(pEntry == m_pTopItem)
-		{
-			bGotTopItem = true;
-			pEntry = pUserEntry;
-		}
-		else
-			pEntry = pEntry->m_pNext;
-	}
+	bool bGotTopItem = m_pTopItem && (indexCompare(m_pTopItem, pUserEntry) < 0);
+	indexRemove(pUserEntry);
 
 	// decrease counts first
 	if(pUserEntry->m_pGlobalData->isIrcOp())
@@ -1412,8 +1624,12 @@ void KviUserListView::removeAllEntries()
 	}
 
 	m_pEntryDict->clear();
+	m_BulkEntries.clear(); // deleted by the dict
+	m_bBulkJoin = false;
 	m_pHeadItem = nullptr;
+	m_pTailItem = nullptr;
 	m_pTopItem = nullptr;
+	m_pIndexRoot = nullptr;
 	m_iVoiceCount = 0;
 	m_iHalfOpCount = 0;
 	m_iChanAdminCount = 0;
@@ -1679,63 +1895,9 @@ void KviUserListViewArea::scrollBarMoved(int iNewVal)
 {
 	if(m_bIgnoreScrollBar)
 		return;
-	int iDiff = iNewVal - m_iLastScrollBarVal;
+	// the scroll bar value is the vertical position of the top of the view
 	if(m_pListView->m_pTopItem)
-	{
-		while(iDiff > 0)
-		{
-			int iNextH = (m_pListView->m_pTopItem->m_iHeight - m_iTopItemOffset);
-			if(iDiff >= iNextH)
-			{
-				// the diff is greater than the top item visible part
-				iDiff -= iNextH;
-				if(m_pListView->m_pTopItem->m_pNext)
-				{
-					// There is a next item (offset to 0)
-					m_pListView->m_pTopItem = m_pListView->m_pTopItem->m_pNext;
-					m_iTopItemOffset = 0;
-				}
-				else
-				{
-					// No next item (rather a bug) (offset to the top item size)
-					m_iTopItemOffset = m_pListView->m_pTopItem->m_iHeight;
-					iDiff = 0;
-				}
-			}
-			else
-			{
-				// just offset the top item
-				m_iTopItemOffset += iDiff;
-				iDiff = 0;
-			}
-		}
-
-		while(iDiff < 0)
-		{
-			if((-iDiff) <= m_iTopItemOffset)
-			{
-				// just move the top item
-				m_iTopItemOffset += iDiff;
-				iDiff = 0;
-			}
-			else
-			{
-				iDiff += m_iTopItemOffset;
-				if(m_pListView->m_pTopItem->m_pPrev)
-				{
-					// There is a prev item (offset to 0)
-					m_pListView->m_pTopItem = m_pListView->m_pTopItem->m_pPrev;
-					m_iTopItemOffset = m_pListView->m_pTopItem->m_iHeight;
-				}
-				else
-				{
-					// No prev item (rather a bug) (offset to the top item size)
-					m_iTopItemOffset = 0;
-					iDiff = 0;
-				}
-			}
-		}
-	}
+		m_pListView->m_pTopItem = m_pListView->indexEntryAt(iNewVal, &m_iTopItemOffset);
 	m_iLastScrollBarVal = iNewVal;
 	update();
 }
@@ -168,6 +168,14 @@ protected:
 	KviUserListEntry * m_pPrev;
 	KviAnimatedPixmap * m_pAvatarPixmap;
 
+	// order index node: see KviUserListView::indexInsert()
+	KviUserListEntry * m_pIndexParent;
+	KviUserListEntry * m_pIndexLeft;
+	KviUserListEntry * m_pIndexRight;
+	unsigned int m_uIndexPriority;
+	int m_iIndexHeight; // sum of the heights of the entries in this subtree
+	int m_iSortRank;    // the mode group of the entry, 0 is the topmost
+
 public:
 	/**
 	* \brief Returns the flags of the user
@@ -275,6 +283,10 @@ protected:
 	int m_ieEntries;
 	int m_iIEntries;
 	KviWindow * m_pKviWindow;
+	KviUserListEntry * m_pIndexRoot;
+	int m_iIndexConfig;                            // the sorting options the index has been built with
+	bool m_bBulkJoin;                              // see beginBulkJoin()
+	std::vector<KviUserListEntry *> m_BulkEntries; // joined but not yet in the list
 
 public:
 	/**
@@ -313,7 +325,11 @@ public:
 	* \brief Returns the first item of the user list
 	* \return KviUserListEntry *
 	*/
-	KviUserListEntry * firstItem() { return m_pHeadItem; };
+	KviUserListEntry * firstItem()
+	{
+		commitBulkJoin();
+		return m_pHeadItem;
+	};
 
 	/**
 	* \brief Returns the item at the given position
@@ -673,6 +689,28 @@ public:
 	*/
 	KviUserListEntry * join(const QString & szNick, const QString & szUser = QString(), const QString & szHost = QString(), int iFlags = 0);
 
+	/**
+	* \brief Starts joining users in bulk
+	*
+	* The users joined from now on are added to the list only by endBulkJoin()
+	* (or when the list needs to be complete): they are sorted once and the
+	* list is repainted once. Used for the NAMES burst of a channel join.
+	* \return void
+	*/
+	void beginBulkJoin();
+
+	/**
+	* \brief Adds the users joined in bulk to the list and ends the bulk mode
+	* \return void
+	*/
+	void endBulkJoin();
+
+	/**
+	* \brief Returns true if the users are being joined in bulk
+	* \return bool
+	*/
+	bool bulkJoinInProgress() { return m_bBulkJoin; };
+
 	/**
 	* \brief Returns true if the avatar of a user is changed
 	* \param szNick The nickname of the user
@@ -788,6 +826,100 @@ protected:
 	*/
 	bool partInternal(const QString & szNick, bool bRemove = true);
 
+	/**
+	* \brief Returns the sorting options currently in effect
+	* \return int
+	*/
+	int indexConfig();
+
+	/**
+	* \brief Compares two entries in the order they are shown in the list
+	* \param pEntry1 The first entry
+	* \param pEntry2 The second entry
+	* \return int
+	*/
+	int indexCompare(KviUserListEntry * pEntry1, KviUserListEntry * pEntry2);
+
+	/**
+	* \brief Inserts the entry in the order index and links it in the list
+	* \param pEntry The entry
+	* \return void
+	*/
+	void indexInsert(KviUserListEntry * pEntry);
+
+	/**
+	* \brief Removes the entry from the order index (but not from the list)
+	* \param pEntry The entry
+	* \return void
+	*/
+	void indexRemove(KviUserListEntry * pEntry);
+
+	/**
+	* \brief Rotates the entry above its parent in the order index
+	* \param pEntry The entry
+	* \return void
+	*/
+	void indexRotateUp(KviUserListEntry * pEntry);
+
+	/**
+	* \brief Updates the index after the height of an entry has changed
+	* \param pEntry The entry
+	* \param iDiff The height difference
+	* \return void
+	*/
+	void indexHeightChanged(KviUserListEntry * pEntry, int iDiff);
+
+	/**
+	* \brief Returns the vertical position of the entry in the list
+	* \param pEntry The entry
+	* \return int
+	*/
+	int indexOffset(KviUserListEntry * pEntry);
+
+	/**
+	* \brief Returns the entry at the given vertical position in the list
+	* \param iOffset The position
+	* \param piEntryOffset Will contain the position relative to the top of the entry
+	* \return KviUserListEntry *
+	*/
+	KviUserListEntry * indexEntryAt(int iOffset, int * piEntryOffset);
+
+	/**
+	* \brief Sorts the list again and rebuilds the order index
+	*
+	* Called when the sorting options change
+	* \return void
+	*/
+	void rebuildIndex();
+
+	/**
+	* \brief Links the entries sorted by indexCompare() in the list and builds the order index
+	* \param entries The entries
+	* \return void
+	*/
+	void indexBuild(std::vector<KviUserListEntry *> & entries);
+
+	/**
+	* \brief Computes the mode group of the entry for the current sorting options
+	* \param pEntry The entry
+	* \return void
+	*/
+	void indexUpdateRank(KviUserListEntry * pEntry);
+
+	/**
+	* \brief Moves the scroll bar to the top item after the list has been rebuilt
+	* \return void
+	*/
+	void indexSyncScrollBar();
+
+	/**
+	* \brief Inserts the entries joined in bulk mode in the list
+	*
+	* The entries are sorted once and merged with the list in linear time
+	* \return void
+	*/
+	void commitBulkJoin();
+
 	/**
 	* \brief Sets the user database
 	* \param pDb The source user database
@@ -593,6 +593,64 @@ static bool context_kvs_fnc_queueSize(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: context.readStatistics
+	@type:
+		function
+	@title:
+		$context.readStatistics
+	@short:
+		Returns the incoming data statistics of an IRC context
+	@syntax:
+		<hash> $context.readStatistics
+		<hash> $context.readStatistics(<irc_context_id:uint>)
+	@description:
+		Returns a hash with the statistics about the data received
+		on the socket of the specified IRC context.
+		The hash contains the following keys:[br]
+		[b]bytes[/b]: the number of bytes received[br]
+		[b]lines[/b]: the number of lines received[br]
+		[b]notifications[/b]: the number of times the socket became readable[br]
+		[b]reads[/b]: the number of successful read calls[br]
+		[b]namesBursts[/b]: the number of channel NAMES bursts processed[br]
+		[b]namesUsers[/b]: the number of users received in the NAMES bursts[br]
+		[b]namesTime[/b]: the time spent building the channel user lists from the NAMES bursts, in microseconds[br]
+		Each time the socket becomes readable KVIrc reads as much data as it can
+		(up to the limits set by the [b]uintIrcSocketReadBudget[/b] (bytes) and
+		[b]uintIrcSocketReadTimeBudget[/b] (milliseconds) options) and then processes
+		all the received lines at once: on busy connections the number of notifications
+		should be much smaller than the number of lines.[br]
+		If no irc_context_id is specified then the current irc_context is used.
+		If the irc_context_id specification is not valid or the context is not
+		connected then this function returns nothing.
+	@seealso:
+		[fnc]$context.queueSize[/fnc]
+*/
+
+static bool context_kvs_fnc_readStatistics(KviKvsModuleFunctionCall * c)
+{
+	GET_CONNECTION_FROM_STANDARD_PARAMS;
+
+	if(!pConnection || !pConnection->link()->socket())
+	{
+		c->returnValue()->setNothing();
+		return true;
+	}
+
+	KviIrcSocket * pSocket = pConnection->link()->socket();
+
+	KviKvsHash * pHash = new KviKvsHash();
+	pHash->set("bytes", new KviKvsVariant((kvs_int_t)pSocket->readBytes()));
+	pHash->set("lines", new KviKvsVariant((kvs_int_t)pConnection->link()->readPackets()));
+	pHash->set("notifications", new KviKvsVariant((kvs_int_t)pSocket->readNotifications()));
+	pHash->set("reads", new KviKvsVariant((kvs_int_t)pSocket->readCalls()));
+	pHash->set("namesBursts", new KviKvsVariant((kvs_int_t)pConnection->statistics()->namesBursts()));
+	pHash->set("namesUsers", new KviKvsVariant((kvs_int_t)pConnection->statistics()->namesUsers()));
+	pHash->set("namesTime", new KviKvsVariant((kvs_int_t)pConnection->statistics()->namesTime()));
+	c->returnValue()->setHash(pHash);
+	return true;
+}
+
 /*
 	@doc: context.getSSLCertInfo
 	@type:
@@ -772,6 +830,7 @@ static bool context_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "connectionStartTime", context_kvs_fnc_connectionStartTime);
 	KVSM_REGISTER_FUNCTION(m, "lastMessageTime", context_kvs_fnc_lastMessageTime);
 	KVSM_REGISTER_FUNCTION(m, "queueSize", context_kvs_fnc_queueSize);
+	KVSM_REGISTER_FUNCTION(m, "readStatistics", context_kvs_fnc_readStatistics);
 	KVSM_REGISTER_FUNCTION(m, "getSSLCertInfo", context_kvs_fnc_getSSLCertInfo);
 
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "clearQueue", context_kvs_cmd_clearQueue);
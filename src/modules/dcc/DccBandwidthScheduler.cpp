@@ -0,0 +1,426 @@
+//=============================================================================
+//
+//   File : DccBandwidthScheduler.cpp
+//   Creation date : Sun Oct 18 2026 23:05:14 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "DccBandwidthScheduler.h"
+
+// The measured rates are updated this often
+#define KVI_DCC_BANDWIDTH_RATE_INTERVAL_IN_MSECS 1000
+
+// A transfer that hasn't asked for bandwidth for this long leaves the rounds.
+// The waiting transfers ask at least every KVI_DCC_THREAD_MAX_WAIT_MSECS
+#define KVI_DCC_BANDWIDTH_BACKLOG_MSECS (3 * KVI_DCC_THREAD_MAX_WAIT_MSECS)
+
+DccBandwidthScheduler * g_pDccBandwidthScheduler = nullptr;
+
+DccBandwidthScheduler::DccBandwidthScheduler()
+{
+	for(auto & n : m_global)
+		initNode(&n, 0);
+	m_rateTimer.start();
+	m_iLastRateUpdate = 0;
+}
+
+DccBandwidthScheduler::~DccBandwidthScheduler()
+{
+	for(auto & h : m_hNicks)
+	{
+		qDeleteAll(h);
+		h.clear();
+	}
+}
+
+void DccBandwidthScheduler::initNode(Node * n, int iSlot)
+{
+	n->iSlot = iSlot;
+	n->uTransfers = 0;
+	n->uBytes = 0;
+	n->uRate = 0;
+}
+
+DccBandwidthScheduler::Node * DccBandwidthScheduler::nickNode(int iDirection, const QString & szNick, bool bCreate)
+{
+	// m_mutex must be locked
+	Node * n = m_hNicks[iDirection].value(szNick, nullptr);
+	if(n || !bCreate)
+		return n;
+
+	n = new Node;
+	initNode(n, 1);
+	m_hNicks[iDirection].insert(szNick, n);
+	return n;
+}
+
+void DccBandwidthScheduler::releaseNickNode(int iDirection, const QString & szNick)
+{
+	// m_mutex must be locked
+	// the nodes are kept only while they are used or have a limit
+	Node * n = m_hNicks[iDirection].value(szNick, nullptr);
+	if(!n || (n->uTransfers > 0) || !n->bucket.unlimited())
+		return;
+	m_hNicks[iDirection].remove(szNick);
+	delete n;
+}
+
+void DccBandwidthScheduler::attach(DccBandwidthShare * s)
+{
+	m_mutex.lock();
+	if(!s->bAttached)
+	{
+		if(s->uWeight < 1)
+			s->uWeight = KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT;
+
+		s->uReserved = 0;
+		for(auto & slot : s->slots)
+		{
+			slot.iDeficit = 0;
+			slot.iLastRequest = 0;
+			slot.bBacklogged = false;
+		}
+
+		Node * g = &m_global[s->iDirection];
+		g->uTransfers++;
+		g->shares.append(s);
+
+		Node * n = nickNode(s->iDirection, s->szNick, true);
+		n->uTransfers++;
+		n->shares.append(s);
+
+		s->bAttached = true;
+	}
+	m_mutex.unlock();
+}
+
+void DccBandwidthScheduler::detach(DccBandwidthShare * s)
+{
+	m_mutex.lock();
+	if(s->bAttached)
+	{
+		Node * g = &m_global[s->iDirection];
+		Node * n = nickNode(s->iDirection, s->szNick, false);
+
+		// a transfer that died between reserve() and commit()
+		if(s->uReserved > 0)
+		{
+			g->bucket.refund(s->uReserved);
+			if(n)
+				n->bucket.refund(s->uReserved);
+			s->uReserved = 0;
+		}
+
+		g->uTransfers--;
+		g->shares.removeOne(s);
+
+		if(n)
+		{
+			n->uTransfers--;
+			n->shares.removeOne(s);
+			releaseNickNode(s->iDirection, s->szNick);
+		}
+
+		s->bAttached = false;
+	}
+	m_mutex.unlock();
+}
+
+void DccBandwidthScheduler::setWeight(DccBandwidthShare * s, unsigned int uWeight)
+{
+	if(uWeight < 1)
+		uWeight = KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT;
+
+	// used from the next round
+	m_mutex.lock();
+	s->uWeight = uWeight;
+	m_mutex.unlock();
+}
+
+void DccBandwidthScheduler::updateBacklog(Node * n, qint64 iNow)
+{
+	// m_mutex must be locked
+	for(auto s : n->shares)
+	{
+		DccBandwidthShare::Slot & slot = s->slots[n->iSlot];
+		if(slot.bBacklogged && ((iNow - slot.iLastRequest) > KVI_DCC_BANDWIDTH_BACKLOG_MSECS))
+		{
+			// no saving of the unused deficit for later
+			slot.bBacklogged = false;
+			slot.iDeficit = 0;
+		}
+	}
+}
+
+void DccBandwidthScheduler::startRound(Node * n)
+{
+	// m_mutex must be locked
+	// a new round starts only when no transfer can go on with what's left of the current one
+	unsigned int uTotalWeight = 0;
+	for(auto s : n->shares)
+	{
+		DccBandwidthShare::Slot & slot = s->slots[n->iSlot];
+		if(!slot.bBacklogged)
+			continue;
+		if(slot.iDeficit >= KVI_DCC_BUCKET_MIN_CHUNK)
+			return;
+		uTotalWeight += s->uWeight;
+	}
+	if(uTotalWeight == 0)
+		return;
+
+	// a round moves about one bucket of data
+	qint64 iQuantum = n->bucket.capacity() / uTotalWeight;
+	if(iQuantum < KVI_DCC_BUCKET_MIN_CHUNK)
+		iQuantum = KVI_DCC_BUCKET_MIN_CHUNK;
+
+	for(auto s : n->shares)
+	{
+		DccBandwidthShare::Slot & slot = s->slots[n->iSlot];
+		if(slot.bBacklogged)
+			slot.iDeficit += iQuantum * s->uWeight;
+	}
+}
+
+unsigned int DccBandwidthScheduler::grant(Node * n, DccBandwidthShare * s, unsigned int uMax, qint64 iNow)
+{
+	// m_mutex must be locked
+	if(n->bucket.unlimited() || (uMax == 0))
+		return uMax;
+
+	DccBandwidthShare::Slot & slot = s->slots[n->iSlot];
+	slot.iLastRequest = iNow;
+	if(!slot.bBacklogged)
+	{
+		// joins from the next round
+		slot.bBacklogged = true;
+		slot.iDeficit = 0;
+	}
+	updateBacklog(n, iNow);
+	startRound(n);
+
+	if(slot.iDeficit <= 0)
+		return 0; // the others go first
+
+	unsigned int uAvailable = n->bucket.available(uMax);
+	return (slot.iDeficit < uAvailable) ? (unsigned int)slot.iDeficit : uAvailable;
+}
+
+void DccBandwidthScheduler::charge(Node * n, DccBandwidthShare * s, qint64 iBytes)
+{
+	// m_mutex must be locked
+	DccBandwidthShare::Slot & slot = s->slots[n->iSlot];
+	if(slot.bBacklogged)
+		slot.iDeficit -= iBytes;
+}
+
+int DccBandwidthScheduler::turnWait(Node * n, DccBandwidthShare * s, qint64 iNow)
+{
+	// m_mutex must be locked
+	if(n->bucket.unlimited())
+		return 0;
+
+	DccBandwidthShare::Slot & slot = s->slots[n->iSlot];
+	if(!slot.bBacklogged)
+		return 0;
+
+	// still waiting for its turn: stays in the rounds
+	slot.iLastRequest = iNow;
+	updateBacklog(n, iNow);
+	startRound(n);
+	if(slot.iDeficit > 0)
+		return 0;
+
+	// the time the bucket takes to serve the deficits of the others
+	qint64 iOthers = 0;
+	for(auto o : n->shares)
+	{
+		DccBandwidthShare::Slot & os = o->slots[n->iSlot];
+		if(os.bBacklogged && (os.iDeficit > 0))
+			iOthers += os.iDeficit;
+	}
+	qint64 iWait = (n->bucket.rate() > 0) ? (iOthers * 1000) / n->bucket.rate() : KVI_DCC_THREAD_MAX_WAIT_MSECS;
+	if(iWait < 1)
+		iWait = 1;
+	if(iWait > KVI_DCC_THREAD_MAX_WAIT_MSECS)
+		iWait = KVI_DCC_THREAD_MAX_WAIT_MSECS;
+	return (int)iWait;
+}
+
+unsigned int DccBandwidthScheduler::reserve(DccBandwidthShare * s, unsigned int uMax)
+{
+	m_mutex.lock();
+
+	qint64 iNow = m_rateTimer.elapsed();
+	Node * g = &m_global[s->iDirection];
+	Node * n = nickNode(s->iDirection, s->szNick, false);
+
+	unsigned int uGranted = grant(g, s, uMax, iNow);
+	if(n)
+		uGranted = grant(n, s, uGranted, iNow);
+
+	if(uGranted > 0)
+	{
+		g->bucket.consume(uGranted);
+		charge(g, s, uGranted);
+		if(n)
+		{
+			n->bucket.consume(uGranted);
+			charge(n, s, uGranted);
+		}
+		s->uReserved += uGranted;
+	}
+
+	m_mutex.unlock();
+	return uGranted;
+}
+
+void DccBandwidthScheduler::commit(DccBandwidthShare * s, unsigned int uReserved, unsigned int uUsed)
+{
+	m_mutex.lock();
+
+	Node * g = &m_global[s->iDirection];
+	Node * n = nickNode(s->iDirection, s->szNick, false);
+
+	// a detach() in the middle has already given everything back
+	if(uReserved > s->uReserved)
+		uReserved = s->uReserved;
+	if(uUsed > uReserved)
+		uUsed = uReserved;
+	s->uReserved -= uReserved;
+
+	if(uUsed < uReserved)
+	{
+		g->bucket.refund(uReserved - uUsed);
+		charge(g, s, -(qint64)(uReserved - uUsed));
+		if(n)
+		{
+			n->bucket.refund(uReserved - uUsed);
+			charge(n, s, -(qint64)(uReserved - uUsed));
+		}
+	}
+
+	g->uBytes += uUsed;
+	if(n)
+		n->uBytes += uUsed;
+
+	updateRates();
+	m_mutex.unlock();
+}
+
+int DccBandwidthScheduler::msecsUntilAvailable(DccBandwidthShare * s)
+{
+	m_mutex.lock();
+
+	qint64 iNow = m_rateTimer.elapsed();
+	Node * g = &m_global[s->iDirection];
+	int iWait = g->bucket.msecsUntilAvailable();
+	int iTurnWait = turnWait(g, s, iNow);
+	if(iTurnWait > iWait)
+		iWait = iTurnWait;
+
+	Node * n = nickNode(s->iDirection, s->szNick, false);
+	if(n)
+	{
+		int iNickWait = n->bucket.msecsUntilAvailable();
+		if(iNickWait > iWait)
+			iWait = iNickWait;
+		iTurnWait = turnWait(n, s, iNow);
+		if(iTurnWait > iWait)
+			iWait = iTurnWait;
+	}
+
+	m_mutex.unlock();
+	return iWait;
+}
+
+void DccBandwidthScheduler::updateRates()
+{
+	// m_mutex must be locked
+	qint64 iNow = m_rateTimer.elapsed();
+	qint64 iElapsed = iNow - m_iLastRateUpdate;
+	if(iElapsed < KVI_DCC_BANDWIDTH_RATE_INTERVAL_IN_MSECS)
+		return;
+	m_iLastRateUpdate = iNow;
+
+	for(int i = 0; i < 2; i++)
+	{
+		m_global[i].uRate = (m_global[i].uBytes * 1000) / iElapsed;
+		m_global[i].uBytes = 0;
+		for(auto n : m_hNicks[i])
+		{
+			n->uRate = (n->uBytes * 1000) / iElapsed;
+			n->uBytes = 0;
+		}
+	}
+}
+
+void DccBandwidthScheduler::setGlobalLimit(Direction d, unsigned int uLimit)
+{
+	m_mutex.lock();
+	m_global[d].bucket.setRate(uLimit);
+	m_mutex.unlock();
+}
+
+unsigned int DccBandwidthScheduler::globalLimit(Direction d)
+{
+	m_mutex.lock();
+	unsigned int uLimit = m_global[d].bucket.rate();
+	m_mutex.unlock();
+	return uLimit;
+}
+
+void DccBandwidthScheduler::setNickLimit(Direction d, const QString & szNick, unsigned int uLimit)
+{
+	QString szKey = szNick.toLower();
+	m_mutex.lock();
+	nickNode(d, szKey, true)->bucket.setRate(uLimit);
+	releaseNickNode(d, szKey);
+	m_mutex.unlock();
+}
+
+unsigned int DccBandwidthScheduler::nickLimit(Direction d, const QString & szNick)
+{
+	m_mutex.lock();
+	Node * n = nickNode(d, szNick.toLower(), false);
+	unsigned int uLimit = n ? n->bucket.rate() : MAX_DCC_BANDWIDTH_LIMIT;
+	m_mutex.unlock();
+	return uLimit;
+}
+
+unsigned int DccBandwidthScheduler::globalRate(Direction d)
+{
+	m_mutex.lock();
+	updateRates();
+	// no transfers left: don't report the rate of their last interval
+	unsigned int uRate = (m_global[d].uTransfers > 0) ? m_global[d].uRate : 0;
+	m_mutex.unlock();
+	return uRate;
+}
+
+unsigned int DccBandwidthScheduler::nickRate(Direction d, const QString & szNick)
+{
+	m_mutex.lock();
+	updateRates();
+	Node * n = nickNode(d, szNick.toLower(), false);
+	unsigned int uRate = (n && (n->uTransfers > 0)) ? n->uRate : 0;
+	m_mutex.unlock();
+	return uRate;
+}
@@ -0,0 +1,141 @@
+#ifndef _DCCBANDWIDTHSCHEDULER_H_
+#define _DCCBANDWIDTHSCHEDULER_H_
+//=============================================================================
+//
+//   File : DccBandwidthScheduler.h
+//   Creation date : Sun Oct 18 2026 23:05:14 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "DccThread.h"
+
+#include "KviThread.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#define KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT 1
+
+//
+// DccBandwidthShare
+//
+//    The part of a file transfer that is managed by the scheduler.
+//    Filled by the transfer before attaching it, then changed only by the scheduler.
+//
+
+struct DccBandwidthShare
+{
+	int iDirection;        // DccBandwidthScheduler::Direction
+	QString szNick;        // the remote nickname, lowercase
+	unsigned int uWeight;  // relative share of the bandwidth
+	bool bAttached;
+	// managed by the scheduler
+	unsigned int uReserved; // reserved and not committed yet
+	struct Slot
+	{
+		qint64 iDeficit;     // bytes that can still be taken in this round
+		qint64 iLastRequest; // on the scheduler clock
+		bool bBacklogged;    // taking part in the rounds
+	} slots[2];             // in the global node and in the nick node
+};
+
+//
+// DccBandwidthScheduler
+//
+//    A hierarchical token bucket shared by all the file transfers.
+//    The data moved by a transfer must fit in its own bucket (the per
+//    transfer limit, owned by the thread), in the bucket of the remote
+//    nickname and in the global bucket of its direction.
+//    The transfers competing for a limited bucket share it with a deficit
+//    round robin: each round gives them a quantum proportional to their
+//    weight and they can't take more until all of them have spent theirs.
+//    A transfer that stops asking (blocked by the network or by its own
+//    limit) leaves the rounds, so the others get its bandwidth.
+//
+//    All the methods are thread safe.
+//
+
+class DccBandwidthScheduler
+{
+public:
+	DccBandwidthScheduler();
+	~DccBandwidthScheduler();
+
+	enum Direction
+	{
+		Upload = 0,
+		Download = 1
+	};
+
+private:
+	struct Node
+	{
+		DccBandwidthBucket bucket;
+		int iSlot;                          // of the shares: 0 global, 1 nick
+		QList<DccBandwidthShare *> shares; // attached
+		unsigned int uTransfers;            // attached
+		quint64 uBytes;            // transferred since the last rate update
+		unsigned int uRate;        // measured, bytes per second
+	};
+
+	KviMutex m_mutex;
+	Node m_global[2];
+	QHash<QString, Node *> m_hNicks[2]; // owned, keys are lowercase
+	QElapsedTimer m_rateTimer; // also the clock of the rounds
+	qint64 m_iLastRateUpdate;
+
+public:
+	// the transfers
+	void attach(DccBandwidthShare * s);
+	void detach(DccBandwidthShare * s);
+	void setWeight(DccBandwidthShare * s, unsigned int uWeight);
+	// returns the number of bytes (at most uMax) that the transfer can move now, 0 if it must wait
+	unsigned int reserve(DccBandwidthShare * s, unsigned int uMax);
+	// accounts the bytes actually transferred after a reserve() and gives back the unused ones.
+	// What is still reserved when the share is detached is given back too
+	void commit(DccBandwidthShare * s, unsigned int uReserved, unsigned int uUsed);
+	// the time to wait before reserve() can return something
+	int msecsUntilAvailable(DccBandwidthShare * s);
+
+	// configuration: MAX_DCC_BANDWIDTH_LIMIT means no limit
+	void setGlobalLimit(Direction d, unsigned int uLimit);
+	unsigned int globalLimit(Direction d);
+	void setNickLimit(Direction d, const QString & szNick, unsigned int uLimit);
+	unsigned int nickLimit(Direction d, const QString & szNick);
+
+	// the measured rates
+	unsigned int globalRate(Direction d);
+	unsigned int nickRate(Direction d, const QString & szNick);
+
+protected:
+	Node * nickNode(int iDirection, const QString & szNick, bool bCreate);
+	void releaseNickNode(int iDirection, const QString & szNick);
+	void initNode(Node * n, int iSlot);
+	void updateBacklog(Node * n, qint64 iNow);
+	void startRound(Node * n);
+	unsigned int grant(Node * n, DccBandwidthShare * s, unsigned int uMax, qint64 iNow);
+	void charge(Node * n, DccBandwidthShare * s, qint64 iBytes);
+	int turnWait(Node * n, DccBandwidthShare * s, qint64 iNow);
+	void updateRates();
+};
+
+#endif //_DCCBANDWIDTHSCHEDULER_H_
@@ -0,0 +1,309 @@
+//=============================================================================
+//
+//   File : DccBenchmark.cpp
+//   Creation date : Sun Oct 18 2026 19:12:37 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "DccBenchmark.h"
+#include "DccFileTransfer.h"
+#include "DccReactor.h"
+#include "DccThread.h"
+
+#include "KviApplication.h"
+#include "KviWindow.h"
+#include "KviLocale.h"
+#include "KviError.h"
+#include "KviOptions.h"
+#include "KviThread.h"
+#include "KviPointerList.h"
+#include "kvi_out.h"
+#include "kvi_socket.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <string.h>
+
+// The source file is written in blocks of this size
+#define KVI_DCC_BENCHMARK_BLOCK_SIZE 65536
+
+extern DccReactor * g_pDccReactor;
+
+static KviPointerList<DccBenchmark> * g_pDccBenchmarks = nullptr;
+
+DccBenchmark::DccBenchmark(KviWindow * pWnd, unsigned int uTransfers, quint64 uSize)
+    : QObject()
+{
+	m_pWindow = pWnd;
+	m_uTransfers = uTransfers;
+	m_uSize = uSize;
+	m_uRunning = 0;
+	m_uFailures = 0;
+
+	if(!g_pDccBenchmarks)
+	{
+		g_pDccBenchmarks = new KviPointerList<DccBenchmark>;
+		g_pDccBenchmarks->setAutoDelete(false);
+	}
+	g_pDccBenchmarks->append(this);
+}
+
+DccBenchmark::~DccBenchmark()
+{
+	stop();
+	KviThreadManager::killPendingEvents(this);
+
+	g_pDccBenchmarks->removeRef(this);
+	if(g_pDccBenchmarks->isEmpty())
+	{
+		delete g_pDccBenchmarks;
+		g_pDccBenchmarks = nullptr;
+	}
+}
+
+void DccBenchmark::abortAll()
+{
+	while(g_pDccBenchmarks)
+		delete g_pDccBenchmarks->first(); // the last one deletes the list
+}
+
+bool DccBenchmark::createSourceFile()
+{
+	QFile f(m_szSourceFileName);
+	if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	// not all zeros: a compressing filesystem would make the reads free
+	char buffer[KVI_DCC_BENCHMARK_BLOCK_SIZE];
+	for(int i = 0; i < KVI_DCC_BENCHMARK_BLOCK_SIZE; i++)
+		buffer[i] = (char)((i * 31) ^ (i >> 8));
+
+	quint64 uLeft = m_uSize;
+	while(uLeft > 0)
+	{
+		qint64 iBlock = (uLeft > KVI_DCC_BENCHMARK_BLOCK_SIZE) ? KVI_DCC_BENCHMARK_BLOCK_SIZE : uLeft;
+		if(f.write(buffer, iBlock) != iBlock)
+			return false;
+		uLeft -= iBlock;
+	}
+	return true;
+}
+
+bool DccBenchmark::createSocketPair(kvi_socket_t & fdSend, kvi_socket_t & fdRecv)
+{
+	kvi_socket_t fdListen = kvi_socket_create(KVI_SOCKET_PF_INET, KVI_SOCKET_TYPE_STREAM, KVI_SOCKET_PROTO_TCP);
+	if(fdListen == KVI_INVALID_SOCKET)
+		return false;
+
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sa.sin_port = 0; // any free port
+
+	int iLen = sizeof(sa);
+	if(!(kvi_socket_bind(fdListen, (struct sockaddr *)&sa, sizeof(sa)) && kvi_socket_listen(fdListen, 1) && kvi_socket_getsockname(fdListen, (struct sockaddr *)&sa, &iLen)))
+	{
+		kvi_socket_close(fdListen);
+		return false;
+	}
+
+	// the loopback connection completes at once: no need for non blocking connect() here
+	fdSend = kvi_socket_create(KVI_SOCKET_PF_INET, KVI_SOCKET_TYPE_STREAM, KVI_SOCKET_PROTO_TCP);
+	if((fdSend == KVI_INVALID_SOCKET) || !kvi_socket_connect(fdSend, (struct sockaddr *)&sa, sizeof(sa)))
+	{
+		if(fdSend != KVI_INVALID_SOCKET)
+			kvi_socket_close(fdSend);
+		kvi_socket_close(fdListen);
+		return false;
+	}
+
+	iLen = sizeof(sa);
+	fdRecv = kvi_socket_accept(fdListen, (struct sockaddr *)&sa, &iLen);
+	kvi_socket_close(fdListen);
+	if(fdRecv == KVI_INVALID_SOCKET)
+	{
+		kvi_socket_close(fdSend);
+		return false;
+	}
+
+	kvi_socket_setNonBlocking(fdSend);
+	kvi_socket_setNonBlocking(fdRecv);
+	return true;
+}
+
+bool DccBenchmark::start(QString & szError)
+{
+	QString szBase = QString("%1/kvirc_dccbenchmark_%2_%3").arg(QDir::tempPath()).arg(QCoreApplication::applicationPid()).arg((quintptr)this);
+
+	m_szSourceFileName = szBase + QString("_source");
+	if(!createSourceFile())
+	{
+		szError = __tr2qs_ctx("Can't write the source file %1", "dcc").arg(m_szSourceFileName);
+		return false;
+	}
+
+	// the transfers run as fast as the global limits allow
+	std::vector<kvi_socket_t> sockets;
+	for(unsigned int i = 0; i < m_uTransfers; i++)
+	{
+		kvi_socket_t fdSend;
+		kvi_socket_t fdRecv;
+		if(!createSocketPair(fdSend, fdRecv))
+		{
+			szError = __tr2qs_ctx("Can't connect a pair of loopback sockets: %1", "dcc").arg(KviError::getDescription(KviError::translateSystemError(kvi_socket_error())));
+			for(auto fd : sockets)
+				kvi_socket_close(fd);
+			return false;
+		}
+		sockets.push_back(fdSend);
+		sockets.push_back(fdRecv);
+	}
+
+	m_timer.start();
+
+	for(unsigned int i = 0; i < m_uTransfers; i++)
+	{
+		QString szTarget = szBase + QString("_target_%1").arg(i);
+		m_TargetFileNames.append(szTarget);
+
+		KviDccSendThreadOptions * so = new KviDccSendThreadOptions;
+		so->szFileName = m_szSourceFileName.toUtf8().data();
+		so->uStartPosition = 0;
+		so->iPacketSize = KVI_OPTION_UINT(KviOption_uintDccSendPacketSize);
+		so->iIdleStepLengthInMSec = 0;
+		so->bFastSend = true;
+		so->bNoAcks = false;
+		so->bIsTdcc = false;
+		so->uMaxBandwidth = MAX_DCC_BANDWIDTH_LIMIT;
+		so->szNick = QString("benchmark");
+		so->uBandwidthWeight = KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT;
+
+		KviDccRecvThreadOptions * ro = new KviDccRecvThreadOptions;
+		ro->bResume = false;
+		ro->szFileName = szTarget.toUtf8().data();
+		ro->uTotalFileSize = m_uSize;
+		ro->iIdleStepLengthInMSec = 0;
+		ro->bSendZeroAck = false;
+		ro->bSend64BitAck = false;
+		ro->bNoAcks = false;
+		ro->bIsTdcc = false;
+		ro->uMaxBandwidth = MAX_DCC_BANDWIDTH_LIMIT;
+		ro->szNick = QString("benchmark");
+		ro->uBandwidthWeight = KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT;
+
+		m_Handlers.push_back(new DccSendHandler(this, sockets[2 * i], so));
+		m_Handlers.push_back(new DccRecvHandler(this, sockets[2 * i + 1], ro));
+	}
+
+	m_uRunning = m_Handlers.size();
+	for(auto h : m_Handlers)
+		g_pDccReactor->add(h);
+
+	output(__tr2qs_ctx("DCC benchmark: started %1 transfers of %2 bytes on loopback sockets", "dcc").arg(m_uTransfers).arg(m_uSize));
+	return true;
+}
+
+void DccBenchmark::stop()
+{
+	for(auto h : m_Handlers)
+	{
+		g_pDccReactor->remove(h);
+		delete h;
+	}
+	m_Handlers.clear();
+
+	if(!m_szSourceFileName.isEmpty())
+	{
+		QFile::remove(m_szSourceFileName);
+		m_szSourceFileName = QString();
+	}
+	for(auto & szTarget : m_TargetFileNames)
+		QFile::remove(szTarget);
+	m_TargetFileNames.clear();
+}
+
+void DccBenchmark::output(const QString & szText)
+{
+	if(g_pApp->windowExists(m_pWindow))
+		m_pWindow->outputNoFmt(KVI_OUT_DCCMSG, szText);
+}
+
+void DccBenchmark::report()
+{
+	qint64 iMSecs = m_timer.elapsed();
+	if(iMSecs < 1)
+		iMSecs = 1;
+
+	// a transfer that claims success must have produced the whole file
+	for(auto & szTarget : m_TargetFileNames)
+	{
+		if((quint64)QFileInfo(szTarget).size() != m_uSize)
+			m_uFailures++;
+	}
+
+	double dMBytesPerSec = ((double)m_uSize * m_uTransfers * 1000.0) / ((double)iMSecs * 1024.0 * 1024.0);
+	output(__tr2qs_ctx("DCC benchmark: %1 transfers of %2 bytes in %3 msecs: %4 MiB/s with the %5 reactor", "dcc")
+	           .arg(m_uTransfers)
+	           .arg(m_uSize)
+	           .arg(iMSecs)
+	           .arg(dMBytesPerSec, 0, 'f', 2)
+	           .arg(QString(g_pDccReactor->backendName())));
+	if(m_uFailures > 0)
+		output(__tr2qs_ctx("DCC benchmark: %1 failures", "dcc").arg(m_uFailures));
+}
+
+bool DccBenchmark::event(QEvent * e)
+{
+	if(e->type() != KVI_THREAD_EVENT)
+		return QObject::event(e);
+	if(m_Handlers.empty())
+		return true; // already over: waiting for deleteLater()
+
+	switch(((KviThreadEvent *)e)->id())
+	{
+		case KVI_DCC_THREAD_EVENT_ERROR:
+		{
+			int * pError = ((KviThreadDataEvent<int> *)e)->getData();
+			output(__tr2qs_ctx("DCC benchmark: transfer failed: %1", "dcc").arg(KviError::getDescription((KviError::Code)*pError)));
+			delete pError;
+			m_uFailures++;
+			m_uRunning--;
+		}
+		break;
+		case KVI_DCC_THREAD_EVENT_SUCCESS:
+			m_uRunning--;
+			break;
+		default:
+			// the messages are not interesting here
+			break;
+	}
+
+	if(m_uRunning == 0)
+	{
+		report();
+		stop();
+		deleteLater();
+	}
+	return true;
+}
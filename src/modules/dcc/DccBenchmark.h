@@ -0,0 +1,87 @@
+#ifndef _DCCBENCHMARK_H_
+#define _DCCBENCHMARK_H_
+//=============================================================================
+//
+//   File : DccBenchmark.h
+//   Creation date : Sun Oct 18 2026 19:12:37 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+#include "kvi_sockettype.h"
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+// The defaults of dcc.benchmark
+#define KVI_DCC_BENCHMARK_DEFAULT_TRANSFERS 4
+#define KVI_DCC_BENCHMARK_DEFAULT_SIZE (64 * 1024 * 1024)
+// More than this is not a benchmark anymore
+#define KVI_DCC_BENCHMARK_MAX_TRANSFERS 256
+
+class KviWindow;
+class DccReactorHandler;
+
+//
+// DccBenchmark
+//
+//    Runs file transfers between pairs of loopback sockets in the DCC reactor
+//    and reports the throughput: this measures the transfer machinery alone,
+//    without the network. Deletes itself when done.
+//
+
+class DccBenchmark : public QObject
+{
+	Q_OBJECT
+public:
+	DccBenchmark(KviWindow * pWnd, unsigned int uTransfers, quint64 uSize);
+	~DccBenchmark();
+
+private:
+	KviWindow * m_pWindow; // the output goes here, if it still exists
+	unsigned int m_uTransfers;
+	quint64 m_uSize;
+	QString m_szSourceFileName;
+	QStringList m_TargetFileNames;
+	std::vector<DccReactorHandler *> m_Handlers; // owned
+	unsigned int m_uRunning;
+	unsigned int m_uFailures;
+	QElapsedTimer m_timer;
+
+public:
+	// returns false (and the reason) if the transfers can't be started
+	bool start(QString & szError);
+	// stops the benchmarks still running: called before the reactor goes away
+	static void abortAll();
+
+protected:
+	virtual bool event(QEvent * e);
+	bool createSourceFile();
+	bool createSocketPair(kvi_socket_t & fdSend, kvi_socket_t & fdRecv);
+	void report();
+	void stop();
+	void output(const QString & szText);
+};
+
+#endif //_DCCBENCHMARK_H_
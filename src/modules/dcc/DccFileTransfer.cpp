@@ -68,16 +68,18 @@
 #include <QTimer>
 #include <QtEndian>
 
+#ifdef Q_OS_LINUX
+#include <sys/sendfile.h>
+#endif
+
 #define INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_MSECS 3000
 #define INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS 3
 
-// This limit, when multiplied by INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS
-// must fit in 31 bits (0x7fffffff)! (because of data size limits)
-#define MAX_DCC_BANDWIDTH_LIMIT 0x1fffffff
-
 // FIXME: The events OnDCCConnect etc are in wrong places here...!
 
 extern DccBroker * g_pDccBroker;
+extern DccBandwidthScheduler * g_pDccBandwidthScheduler;
+extern DccReactor * g_pDccReactor;
 
 extern KVIRC_API KviMediaManager * g_pMediaManager; // KviApplication.cpp
 
@@ -87,8 +89,14 @@ static QPixmap * g_pDccFileTransferIcon = nullptr;
 //#warning "The events that have a KviCString data pointer should become real classes, that take care of deleting the data pointer!"
 //#warning "Otherwise, when left undispatched we will be leaking memory (event class destroyed but not the data ptr)"
 
-DccRecvThread::DccRecvThread(QObject * par, kvi_socket_t fd, KviDccRecvThreadOptions * opt)
-    : DccThread(par, fd)
+// The transfers refresh their statistics at least this often while they wait
+#define KVI_DCC_TRANSFER_IDLE_MSECS 500
+
+// The read() calls are large: the kernel hands us what it has, up to this size
+#define KVI_DCC_RECV_BLOCK_SIZE 65536
+
+DccRecvHandler::DccRecvHandler(QObject * par, kvi_socket_t fd, KviDccRecvThreadOptions * opt)
+    : DccReactorHandler(par, fd)
 {
 	m_pOpt = opt;
 	m_uAverageSpeed = 0;
@@ -98,21 +106,31 @@ DccRecvThread::DccRecvThread(QObject * par, kvi_socket_t fd, KviDccRecvThreadOpt
 	m_uTotalReceivedBytes = 0;
 	m_uInstantReceivedBytes = 0;
 	m_pFile = nullptr;
+	m_pBuffer = nullptr;
 	m_pTimeInterval = new KviMSecTimeInterval();
 	m_uStartTime = 0;
 	m_uInstantSpeedInterval = 0;
+	m_bSend64BitAck = false;
+	m_iPendingAckBytes = 0;
+	m_bReading = false;
+	m_bIdleStep = false;
+	m_iProbableTerminationTime = 0;
+
+	m_share.iDirection = DccBandwidthScheduler::Download;
+	m_share.szNick = opt->szNick.toLower();
+	m_share.uWeight = opt->uBandwidthWeight;
+	m_share.bAttached = false;
 }
 
-DccRecvThread::~DccRecvThread()
+DccRecvHandler::~DccRecvHandler()
 {
+	DccRecvHandler::finish();
 	if(m_pOpt)
 		delete m_pOpt;
-	if(m_pFile)
-		delete m_pFile;
 	delete m_pTimeInterval;
 }
 
-bool DccRecvThread::sendAck(qint64 filePos, bool bUse64BitAck)
+bool DccRecvHandler::sendAck(qint64 filePos, bool bUse64BitAck)
 {
 	quint32 ack32 = htonl(filePos & 0xffffffff);
 	quint64 ack64 = qToBigEndian(filePos);
@@ -194,22 +212,60 @@ bool DccRecvThread::sendAck(qint64 filePos, bool bUse64BitAck)
 		return true; // no data sent: same as iRet == 0 above.
 	}
 
-	// Sent something but not everything.
-	// How likely is it to get in here ?!
-	// Sleep for a short while and try to send the missing part.
-	// This will probably throttle the bandwidth usage a bit too.
-	msleep(10);
-
-	int iMissingPart = ackSize - iRet;
+	// Sent something but not everything: the rest is sent as soon
+	// as the socket is writable and no data is read until then
+	m_iPendingAckBytes = ackSize - iRet;
+	memcpy(m_cPendingAck, ack + iRet, m_iPendingAckBytes);
+	return true;
+}
 
+bool DccRecvHandler::flushPendingAck()
+{
+	int iRet;
 #ifdef COMPILE_SSL_SUPPORT
 	if(m_pSSL)
-		iRet = m_pSSL->write(ack + iRet, iMissingPart);
+		iRet = m_pSSL->write(m_cPendingAck, m_iPendingAckBytes);
 	else
 #endif //COMPILE_SSL_SUPPORT
-		iRet = kvi_socket_send(m_fd, (void *)(ack + iRet), iMissingPart);
+		iRet = kvi_socket_send(m_fd, (void *)m_cPendingAck, m_iPendingAckBytes);
+
+	if(iRet == m_iPendingAckBytes)
+	{
+		m_iPendingAckBytes = 0;
+		return true;
+	}
+
+	if(iRet > 0)
+	{
+		m_iPendingAckBytes -= iRet;
+		memmove(m_cPendingAck, m_cPendingAck + iRet, m_iPendingAckBytes);
+		return true;
+	}
+
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
+	{
+		switch(m_pSSL->getProtocolError(iRet))
+		{
+			case KviSSL::Success:
+			case KviSSL::WantRead:
+			case KviSSL::WantWrite:
+				return true; // try again
+				break;
+			default:
+				postErrorEvent(KviError::AcknowledgeError);
+				return false;
+				break;
+		}
+	}
+#endif //COMPILE_SSL_SUPPORT
 
-	if(iRet != iMissingPart)
+	int err = kvi_socket_error();
+#if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
+	if((iRet == 0) || ((err != EAGAIN) && (err != EINTR) && (err != WSAEWOULDBLOCK)))
+#else  //!(defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW))
+	if((iRet == 0) || ((err != EAGAIN) && (err != EINTR)))
+#endif //!(defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW))
 	{
 		// Crap.. couldn't send the missing part of the ack :/
 		postErrorEvent(KviError::AcknowledgeError);
@@ -218,7 +274,7 @@ bool DccRecvThread::sendAck(qint64 filePos, bool bUse64BitAck)
 	return true;
 }
 
-void DccRecvThread::updateStats()
+void DccRecvHandler::updateStats()
 {
 	m_uInstantSpeedInterval += m_pTimeInterval->mark();
 	unsigned long uCurTime = m_pTimeInterval->secondsCounter();
@@ -248,329 +304,300 @@ void DccRecvThread::updateStats()
 	m_pMutex->unlock();
 }
 
-void DccRecvThread::postMessageEvent(const char * m)
+bool DccRecvHandler::start()
 {
-	KviThreadDataEvent<KviCString> * e = new KviThreadDataEvent<KviCString>(KVI_DCC_THREAD_EVENT_MESSAGE);
-	e->setData(new KviCString(m));
-	postEvent(parent(), e);
-}
-
-// FIXME: This stuff should be somewhat related to the 1448 bytes TCP basic packet size
-//#define KVI_DCC_RECV_BLOCK_SIZE 8192
-//#define KVI_DCC_RECV_75PERCENTOF_BLOCK_SIZE 6150
-#define KVI_DCC_RECV_BLOCK_SIZE 16384
-#define KVI_DCC_RECV_75PERCENTOF_BLOCK_SIZE 12280
-
-void DccRecvThread::run()
-{
-	// take care of sleeping a bit if we can't read stuff
-	// so we don't hog the CPU too much...
-	int iFailedSelects = 0;
-	// take care of sleeping a bit if we get a lot of short reads
-	// so we don't hog the CPU too much...
-	int iShortReadQuantifier = 0;
-	// the algorithm is as follows:
-	//    attempt to read KVI_DCC_RECV_BLOCK_SIZE bytes
-	//    iShortReadQuantifier += ((KVI_DCC_RECV_75PERCENT_OF_BLOCK_SIZE - realReadedBytes) / 42);
-	// thus we gain points if we read less than 75% of the requested size
-	// and we loose points otherwise
-	// there are nearly 24 points per KB
-	//    if(iShortReadQuantifier > 10)
-	//       msleep(iShortReadQuantifier);
-	// also never sleep more than 500 msecs since it will
-	// rise our exit latency too much
+	g_pDccBandwidthScheduler->attach(&m_share);
 
 	m_pTimeInterval->mark();
 	m_pMutex->lock();
 	m_uStartTime = m_pTimeInterval->secondsCounter();
 	m_pMutex->unlock();
 
-	int iProbableTerminationTime = 0;
+	m_pBuffer = (char *)KviMemory::allocate(KVI_DCC_RECV_BLOCK_SIZE);
 
 	m_pFile = new QFile(QString::fromUtf8(m_pOpt->szFileName.ptr()));
 
-	bool bSend64BitAck = m_pOpt->bSend64BitAck && (m_pOpt->uTotalFileSize >> 32);
+	m_bSend64BitAck = m_pOpt->bSend64BitAck && (m_pOpt->uTotalFileSize >> 32);
 
+	// we write large blocks: QFile buffering would only add a copy
 	if(m_pOpt->bResume)
 	{
-		if(!m_pFile->open(QIODevice::WriteOnly | QIODevice::Append))
+		if(!m_pFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered))
 		{
 			postErrorEvent(KviError::CantOpenFileForAppending);
-			goto exit_dcc;
+			return false;
 		} // else pFile is already at end
 	}
 	else
 	{
-		if(!m_pFile->open(QIODevice::WriteOnly))
+		if(!m_pFile->open(QIODevice::WriteOnly | QIODevice::Unbuffered))
 		{
 			postErrorEvent(KviError::CantOpenFileForWriting);
-			goto exit_dcc;
+			return false;
 		}
 	}
 
 	if(m_pOpt->bSendZeroAck && (!m_pOpt->bNoAcks))
 	{
-		if(!sendAck(m_pFile->pos(), bSend64BitAck))
-			goto exit_dcc;
+		if(!sendAck(m_pFile->pos(), m_bSend64BitAck))
+			return false;
 	}
 
-	for(;;)
-	{
-		// Dequeue events
-		while(KviThreadEvent * e = dequeueEvent())
-		{
-			if(e->id() == KVI_THREAD_EVENT_TERMINATE)
-			{
-				delete e;
-				goto exit_dcc;
-			}
-			else
-			{
-				// Other events are senseless to us
-				delete e;
-			}
-		}
-
-		bool bCanRead;
-		bool bDummy;
+	prepareNextStep();
+	return true;
+}
 
-		if(kvi_select(m_fd, &bCanRead, &bDummy, 15000))
-		{
-			// reset sleep time
+bool DccRecvHandler::process(bool bCanRead, bool bCanWrite)
+{
+	if(m_iPendingAckBytes > 0)
+	{
+		if(bCanWrite && !flushPendingAck())
+			return false;
+	}
+	else if(bCanRead)
+	{
+		if(!receiveData())
+			return false;
+	}
+	else if(m_bReading)
+	{
+		// Nothing arrived while we were waiting for data
+		updateStats();
+		if(!checkTermination())
+			return false;
+	}
 
-			if(bCanRead)
-			{
-				iFailedSelects = 0;
+	prepareNextStep();
+	return true;
+}
 
-				// Read a data block
-				char buffer[KVI_DCC_RECV_BLOCK_SIZE];
+void DccRecvHandler::prepareNextStep()
+{
+	m_bReading = false;
 
-				m_pMutex->lock(); // FIXME: how to remove this lock ?
-				unsigned int uMaxPossible = (m_pOpt->uMaxBandwidth < MAX_DCC_BANDWIDTH_LIMIT) ? m_pOpt->uMaxBandwidth * INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS : MAX_DCC_BANDWIDTH_LIMIT * INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS;
-				m_pMutex->unlock();
-				unsigned int uToRead = uMaxPossible > m_uInstantReceivedBytes ? uMaxPossible - m_uInstantReceivedBytes : 0;
-				if(uToRead > KVI_DCC_RECV_BLOCK_SIZE)
-					uToRead = KVI_DCC_RECV_BLOCK_SIZE;
+	if(m_iPendingAckBytes > 0)
+	{
+		// the peer waits for the ack anyway: don't read until it's gone
+		watch(false, true, KVI_DCC_TRANSFER_IDLE_MSECS);
+		return;
+	}
 
-				if(uToRead > 0)
-				{
-					int readLen;
-#ifdef COMPILE_SSL_SUPPORT
-					if(m_pSSL)
-					{
-						readLen = m_pSSL->read(buffer, uToRead);
-					}
-					else
-					{
-#endif
-						readLen = kvi_socket_recv(m_fd, buffer, uToRead);
-#ifdef COMPILE_SSL_SUPPORT
-					}
-#endif
+	m_pMutex->lock();
+	m_bandwidth.setRate(m_pOpt->uMaxBandwidth);
+	m_pMutex->unlock();
 
-					if(readLen > 0)
-					{
-						// Readed something useful...write back
-						if(((uint)(readLen + m_pFile->pos())) > m_pOpt->uTotalFileSize)
-						{
-							postMessageEvent(__tr_no_lookup_ctx("WARNING: the peer is sending garbage data past the end of the file", "dcc"));
-							postMessageEvent(__tr_no_lookup_ctx("WARNING: ignoring data past the declared end of file and closing the connection", "dcc"));
+	int iWaitTime = m_bandwidth.msecsUntilAvailable();
+	int iSharedWaitTime = g_pDccBandwidthScheduler->msecsUntilAvailable(&m_share);
+	if(iSharedWaitTime > iWaitTime)
+		iWaitTime = iSharedWaitTime;
 
-							readLen = m_pOpt->uTotalFileSize - m_pFile->pos();
-							if(readLen > 0)
-							{
-								if(m_pFile->write(buffer, readLen) != readLen)
-									postErrorEvent(KviError::FileIOError);
-							}
-							break;
-						}
-						else
-						{
-							if(m_pFile->write(buffer, readLen) != readLen)
-							{
-								postErrorEvent(KviError::FileIOError);
-								break;
-							}
-						}
+	if(iWaitTime > 0)
+	{
+		// reached a bandwidth limit: leave the data in the socket until the buckets refill
+		updateStats();
+		watch(false, false, iWaitTime);
+		return;
+	}
 
-						// Update stats
-						m_uTotalReceivedBytes += readLen;
-						m_uInstantReceivedBytes += readLen;
+	if(m_bIdleStep)
+	{
+		// include the artificial delay
+		m_bIdleStep = false;
+		watch(false, false, m_pOpt->iIdleStepLengthInMSec);
+		return;
+	}
 
-						updateStats();
-						// Now send the ack
-						if(m_pOpt->bNoAcks)
-						{
-							// No acks...
-							// Interrupt if the whole file has been received
-							if(m_pOpt->uTotalFileSize > 0)
-							{
-								if((quint64)m_pFile->pos() == m_pOpt->uTotalFileSize)
-								{
-									// Received the whole file...die
-									KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-									postEvent(parent(), e);
-									break;
-								}
-							}
-						}
-						else
-						{
-							// Must send the ack... the peer must close the connection
+	m_bReading = true;
+	watch(true, false, KVI_DCC_TRANSFER_IDLE_MSECS);
+}
 
-							if(!sendAck(m_pFile->pos(), bSend64BitAck))
-								break;
-						}
+bool DccRecvHandler::receiveData()
+{
+	if(m_pOpt->iIdleStepLengthInMSec > 0)
+		m_bIdleStep = true;
 
-						// now take care of short reads
-						iShortReadQuantifier += ((KVI_DCC_RECV_75PERCENTOF_BLOCK_SIZE - readLen) / 42);
-						if(iShortReadQuantifier > 10)
-						{
-							// we're having short reads.. sleep a while
-							// but don't allow it to go too high: 0.45 sec is really a lot
-							if(iShortReadQuantifier > 500)
-								iShortReadQuantifier = 500;
-							msleep(iShortReadQuantifier);
-						}
-						else
-						{
-							// don't allow it to go too low
-							if(iShortReadQuantifier < -500)
-								iShortReadQuantifier = -500;
-						}
-					}
-					else
-					{
-						updateStats();
-// Read problem...
+	unsigned int uToRead = m_bandwidth.available(KVI_DCC_RECV_BLOCK_SIZE);
+	if(uToRead > 0)
+		uToRead = g_pDccBandwidthScheduler->reserve(&m_share, uToRead);
+	if(uToRead == 0)
+		return true; // the shared bandwidth has been taken by the other transfers
 
+	int readLen;
 #ifdef COMPILE_SSL_SUPPORT
-						if(m_pSSL)
-						{
-							// ssl error....?
-							switch(m_pSSL->getProtocolError(readLen))
-							{
-								case KviSSL::ZeroReturn:
-									//check again not necessary a connection closure!
-									//if (!handleInvalidSocketRead(readLen)
-									// break;
-									readLen = 0;
-									break;
-								case KviSSL::Success:
-								case KviSSL::WantRead:
-								case KviSSL::WantWrite:
-									// hmmm... DO NOT CALL handleInvalidSocketRead
-									break;
-								case KviSSL::SyscallError:
-								{
-									int iE = m_pSSL->getLastError(true);
-									if(iE != 0)
-									{
-										raiseSSLError();
-										postErrorEvent(KviError::SSLError);
-										goto exit_dcc;
-									}
-								}
-								break;
-								case KviSSL::SSLError:
-								{
-									raiseSSLError();
-									postErrorEvent(KviError::SSLError);
-									goto exit_dcc;
-								}
-								break;
-								default:
-									// Raise unknown SSL ERROR
-									postErrorEvent(KviError::SSLError);
-									goto exit_dcc;
-									break;
-							}
-						}
+	if(m_pSSL)
+	{
+		readLen = m_pSSL->read(m_pBuffer, uToRead);
+	}
+	else
+	{
 #endif
-
-						if(readLen == 0)
-						{
-							// read EOF..
-							if(((quint64)m_pFile->pos() == m_pOpt->uTotalFileSize) || (m_pOpt->uTotalFileSize == 0))
-							{
-								// success if we got the whole file or if we don't know the file size (we trust the peer)
-								KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-								postEvent(parent(), e);
-								break;
-							}
-						}
+		readLen = kvi_socket_recv(m_fd, m_pBuffer, uToRead);
 #ifdef COMPILE_SSL_SUPPORT
-						if(!m_pSSL && !handleInvalidSocketRead(readLen))
-							break;
-#else
-						if(!handleInvalidSocketRead(readLen))
-							break;
+	}
 #endif
-					}
-				}
-				else
-				{
-					updateStats();
 
-					// reached the bandwidth limit: slow down a bit
-					if(m_uInstantSpeedInterval < (INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_MSECS - 100))
-						msleep(100);
-					else if(m_uInstantSpeedInterval < (INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_MSECS - 20))
-						msleep(20);
-				}
+	g_pDccBandwidthScheduler->commit(&m_share, uToRead, readLen > 0 ? readLen : 0);
+
+	if(readLen > 0)
+	{
+		m_bandwidth.consume(readLen);
+
+		// Readed something useful...write back
+		if(((uint)(readLen + m_pFile->pos())) > m_pOpt->uTotalFileSize)
+		{
+			postMessageEvent(__tr_no_lookup_ctx("WARNING: the peer is sending garbage data past the end of the file", "dcc"));
+			postMessageEvent(__tr_no_lookup_ctx("WARNING: ignoring data past the declared end of file and closing the connection", "dcc"));
+
+			readLen = m_pOpt->uTotalFileSize - m_pFile->pos();
+			if(readLen > 0)
+			{
+				if(m_pFile->write(m_pBuffer, readLen) != readLen)
+					postErrorEvent(KviError::FileIOError);
 			}
-			else
+			return false;
+		}
+		else
+		{
+			if(m_pFile->write(m_pBuffer, readLen) != readLen)
 			{
-				// Can't read stuff (can just write)
-				updateStats();
+				postErrorEvent(KviError::FileIOError);
+				return false;
+			}
+		}
 
-				// sleep up to 300 msecs (if data arrives...we want low exit latency here)
-				if(iFailedSelects < 100)
-					iFailedSelects++;
-				updateStats();
-				if(iFailedSelects > 3)
-					msleep(3 * iFailedSelects);
+		// Update stats
+		m_uTotalReceivedBytes += readLen;
+		m_uInstantReceivedBytes += readLen;
 
+		updateStats();
+		// Now send the ack
+		if(m_pOpt->bNoAcks)
+		{
+			// No acks...
+			// Interrupt if the whole file has been received
+			if(m_pOpt->uTotalFileSize > 0)
+			{
 				if((quint64)m_pFile->pos() == m_pOpt->uTotalFileSize)
 				{
-					// Wait for the peer to close the connection
-					if(iProbableTerminationTime == 0)
-					{
-						iProbableTerminationTime = (int)kvi_unixTime();
-						m_pFile->flush();
-						postMessageEvent(__tr_no_lookup_ctx("Data transfer terminated, waiting 30 seconds for the peer to close the connection...", "dcc"));
-						// FIXME: Close the file ?
-					}
-					else
-					{
-						int iDiff = (((int)kvi_unixTime()) - iProbableTerminationTime);
-						if(iDiff > 30)
-						{
-							// success if we got the whole file or if we don't know the file size (we trust the peer)
-							postMessageEvent(__tr_no_lookup_ctx("Data transfer was terminated 30 seconds ago, closing the connection", "dcc"));
-							KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-							postEvent(parent(), e);
-							break;
-						}
-					}
+					// Received the whole file...die
+					postEvent(new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS));
+					return false;
 				}
 			}
-			// include the artificial delay if needed
-			if(m_pOpt->iIdleStepLengthInMSec > 0)
-				msleep(m_pOpt->iIdleStepLengthInMSec);
 		}
 		else
 		{
-			// sleep up to 200 msecs (if data arrives...we want low exit latency here)
-			if(iFailedSelects < 100)
-				iFailedSelects++;
-			updateStats();
-			if(iFailedSelects > 3)
-				msleep(2 * iFailedSelects);
+			// Must send the ack... the peer must close the connection
+			if(!sendAck(m_pFile->pos(), m_bSend64BitAck))
+				return false;
 		}
+		return true;
+	}
+
+	updateStats();
+// Read problem...
+
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
+	{
+		// ssl error....?
+		switch(m_pSSL->getProtocolError(readLen))
+		{
+			case KviSSL::ZeroReturn:
+				//check again not necessary a connection closure!
+				//if (!handleInvalidSocketRead(readLen)
+				// break;
+				readLen = 0;
+				break;
+			case KviSSL::Success:
+			case KviSSL::WantRead:
+			case KviSSL::WantWrite:
+				// hmmm... DO NOT CALL handleInvalidSocketRead
+				break;
+			case KviSSL::SyscallError:
+			{
+				int iE = m_pSSL->getLastError(true);
+				if(iE != 0)
+				{
+					raiseSSLError();
+					postErrorEvent(KviError::SSLError);
+					return false;
+				}
+			}
+			break;
+			case KviSSL::SSLError:
+			{
+				raiseSSLError();
+				postErrorEvent(KviError::SSLError);
+				return false;
+			}
+			break;
+			default:
+				// Raise unknown SSL ERROR
+				postErrorEvent(KviError::SSLError);
+				return false;
+				break;
+		}
+	}
+#endif
+
+	if(readLen == 0)
+	{
+		// read EOF..
+		if(((quint64)m_pFile->pos() == m_pOpt->uTotalFileSize) || (m_pOpt->uTotalFileSize == 0))
+		{
+			// success if we got the whole file or if we don't know the file size (we trust the peer)
+			postEvent(new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS));
+			return false;
+		}
+	}
+#ifdef COMPILE_SSL_SUPPORT
+	if(!m_pSSL && !handleInvalidSocketRead(readLen))
+		return false;
+#else
+	if(!handleInvalidSocketRead(readLen))
+		return false;
+#endif
+	return true;
+}
+
+bool DccRecvHandler::checkTermination()
+{
+	if((quint64)m_pFile->pos() != m_pOpt->uTotalFileSize)
+		return true;
+
+	// Wait for the peer to close the connection
+	if(m_iProbableTerminationTime == 0)
+	{
+		m_iProbableTerminationTime = (int)kvi_unixTime();
+		m_pFile->flush();
+		postMessageEvent(__tr_no_lookup_ctx("Data transfer terminated, waiting 30 seconds for the peer to close the connection...", "dcc"));
+		// FIXME: Close the file ?
+	}
+	else
+	{
+		int iDiff = (((int)kvi_unixTime()) - m_iProbableTerminationTime);
+		if(iDiff > 30)
+		{
+			// success if we got the whole file or if we don't know the file size (we trust the peer)
+			postMessageEvent(__tr_no_lookup_ctx("Data transfer was terminated 30 seconds ago, closing the connection", "dcc"));
+			postEvent(new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS));
+			return false;
+		}
+	}
+	return true;
+}
+
+void DccRecvHandler::finish()
+{
+	g_pDccBandwidthScheduler->detach(&m_share);
+
+	if(m_pBuffer)
+	{
+		KviMemory::free(m_pBuffer);
+		m_pBuffer = nullptr;
 	}
 
-exit_dcc:
 	if(m_pFile)
 	{
 		m_pFile->close();
@@ -578,50 +605,64 @@ exit_dcc:
 		m_pFile = nullptr;
 	}
 
-#ifdef COMPILE_SSL_SUPPORT
-	if(m_pSSL)
-	{
-		KviSSLMaster::freeSSL(m_pSSL);
-		m_pSSL = nullptr;
-	}
-#endif
+	DccReactorHandler::finish();
+}
 
-	kvi_socket_close(m_fd);
-	m_fd = KVI_INVALID_SOCKET;
+void DccRecvHandler::setBandwidthWeight(unsigned int uWeight)
+{
+	g_pDccBandwidthScheduler->setWeight(&m_share, uWeight);
 }
 
-void DccRecvThread::initGetInfo()
+void DccRecvHandler::initGetInfo()
 {
 	m_pMutex->lock();
 }
 
-void DccRecvThread::doneGetInfo()
+void DccRecvHandler::doneGetInfo()
 {
 	m_pMutex->unlock();
 }
 
-DccSendThread::DccSendThread(QObject * par, kvi_socket_t fd, KviDccSendThreadOptions * opt)
-    : DccThread(par, fd)
+DccSendHandler::DccSendHandler(QObject * par, kvi_socket_t fd, KviDccSendThreadOptions * opt)
+    : DccReactorHandler(par, fd)
 {
 	m_pOpt = opt;
 	// stats
 	m_uAverageSpeed = 0;
 	m_uInstantSpeed = 0;
 	m_uFilePosition = 0;
+	m_uAckedBytes = 0;
 	m_uTotalSentBytes = 0;
+	m_uInstantSentBytes = 0;
 	m_pTimeInterval = new KviMSecTimeInterval();
 	m_uStartTime = 0;
 	m_uInstantSpeedInterval = 0;
+	m_pFile = nullptr;
+	m_pBuffer = nullptr;
+	m_iBytesInAckBuffer = 0;
+	m_uLastAck = 0;
+	m_uTotLastAck = 0;
+	m_bAckHack = false;
+	m_uAckHackRounds = 0;
+	m_bUseSendFile = false;
+	m_bIdleStep = false;
+	m_uReserved = 0;
+
+	m_share.iDirection = DccBandwidthScheduler::Upload;
+	m_share.szNick = opt->szNick.toLower();
+	m_share.uWeight = opt->uBandwidthWeight;
+	m_share.bAttached = false;
 }
 
-DccSendThread::~DccSendThread()
+DccSendHandler::~DccSendHandler()
 {
+	DccSendHandler::finish();
 	if(m_pOpt)
 		delete m_pOpt;
 	delete m_pTimeInterval;
 }
 
-void DccSendThread::updateStats()
+void DccSendHandler::updateStats()
 {
 	m_uInstantSpeedInterval += m_pTimeInterval->mark();
 
@@ -670,517 +711,538 @@ void DccSendThread::updateStats()
 	m_pMutex->unlock();
 }
 
-union _ack_buffer {
-	char cAckBuffer[4];
-	quint32 i32AckBuffer;
-};
+void DccSendHandler::settleReservation(unsigned int uUsed)
+{
+	// gives back to the other transfers what the last write didn't use
+	if(m_uReserved == 0)
+		return;
+	g_pDccBandwidthScheduler->commit(&m_share, m_uReserved, uUsed);
+	m_uReserved = 0;
+}
+
+bool DccSendHandler::start()
+{
+	g_pDccBandwidthScheduler->attach(&m_share);
+
+	m_pTimeInterval->mark();
+	m_pMutex->lock();
+	m_uStartTime = m_pTimeInterval->secondsCounter();
+	m_pMutex->unlock();
+
+	if(m_pOpt->iPacketSize < 32)
+		m_pOpt->iPacketSize = 32;
+	m_pBuffer = (char *)KviMemory::allocate(m_pOpt->iPacketSize * sizeof(char));
+
+#ifdef Q_OS_LINUX
+	// sendfile() can't be used when the data has to be encrypted
+	m_bUseSendFile = true;
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
+		m_bUseSendFile = false;
+#endif
+#endif //Q_OS_LINUX
+
+	m_pFile = new QFile(QString::fromUtf8(m_pOpt->szFileName.ptr()));
+
+	// the blocks are read exactly when sent: QFile buffering would only add a copy
+	if(!m_pFile->open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+	{
+		postErrorEvent(KviError::CantOpenFileForReading);
+		return false;
+	}
+
+	if(m_pFile->size() < 1)
+	{
+		postErrorEvent(KviError::CantSendAZeroSizeFile);
+		return false;
+	}
+
+	if(m_pFile->size() >= 0xffffffff)
+	{
+		//dcc acks support only files up to 4GiB
+		m_bAckHack = true;
+	}
+
+	if(m_pOpt->uStartPosition > 0)
+	{
+		// seek
+		if(!(m_pFile->seek(m_pOpt->uStartPosition)))
+		{
+			postErrorEvent(KviError::FileIOError);
+			return false;
+		}
+	}
+
+	m_uLastAck = m_pOpt->uStartPosition;
+
+	return prepareNextStep();
+}
+
+bool DccSendHandler::process(bool bCanRead, bool bCanWrite)
+{
+	if(bCanRead)
+	{
+		if(!receiveData())
+			return false;
+	}
+
+	if(bCanWrite)
+	{
+		if(!sendData())
+			return false;
+	}
+
+	if(!(bCanRead || bCanWrite))
+	{
+		// timed out: the artificial delay (if any) is over
+		m_bIdleStep = false;
+		updateStats();
+	}
+
+	return prepareNextStep();
+}
+
+bool DccSendHandler::prepareNextStep()
+{
+	if(m_pFile->atEnd() && m_pOpt->bNoAcks && !m_pOpt->bIsTdcc)
+	{
+		// at end of the file in a blind dcc send...
+		// not in a tdcc: we can close the file...
+		updateStats();
+		postEvent(new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS));
+		return false;
+	}
+
+	// Watch the socket only for what we're actually waiting for: it's
+	// almost always writable and polling it would just spin the CPU.
+	// Write when there is data that can be sent and read the acks
+	// (or the connection close at the end of a TDCC)
+	bool bWantWrite = (!m_pFile->atEnd()) && (m_pOpt->bFastSend || m_pOpt->bNoAcks || (m_uLastAck == (quint64)m_pFile->pos()));
+	bool bWantRead = (!m_pOpt->bNoAcks) || (m_pOpt->bIsTdcc && m_pFile->atEnd());
+	int iWaitTime = KVI_DCC_TRANSFER_IDLE_MSECS;
+
+	if(bWantWrite && m_bIdleStep)
+	{
+		// include the artificial delay
+		bWantWrite = false;
+		iWaitTime = m_pOpt->iIdleStepLengthInMSec;
+	}
+	else if(bWantWrite)
+	{
+		m_pMutex->lock();
+		m_bandwidth.setRate(m_pOpt->uMaxBandwidth);
+		m_pMutex->unlock();
+
+		int iBandwidthWaitTime = m_bandwidth.msecsUntilAvailable();
+		int iSharedWaitTime = g_pDccBandwidthScheduler->msecsUntilAvailable(&m_share);
+		if(iSharedWaitTime > iBandwidthWaitTime)
+			iBandwidthWaitTime = iSharedWaitTime;
+
+		if(iBandwidthWaitTime > 0)
+		{
+			// reached a bandwidth limit: wait until the buckets refill
+			bWantWrite = false;
+			iWaitTime = iBandwidthWaitTime;
+		}
+	}
+
+	watch(bWantRead, bWantWrite, iWaitTime);
+	return true;
+}
+
+bool DccSendHandler::receiveData()
+{
+	if(!m_pOpt->bNoAcks)
+	{
+		int iAckBytesToRead = 4 - m_iBytesInAckBuffer;
+
+		int readLen;
+#ifdef COMPILE_SSL_SUPPORT
+		if(m_pSSL)
+		{
+			readLen = m_pSSL->read((m_ackBuffer.cAckBuffer + m_iBytesInAckBuffer), iAckBytesToRead);
+		}
+		else
+		{
+#endif
+			readLen = kvi_socket_recv(m_fd, (m_ackBuffer.cAckBuffer + m_iBytesInAckBuffer), iAckBytesToRead);
+#ifdef COMPILE_SSL_SUPPORT
+		}
+#endif
+
+		if(readLen > 0)
+		{
+			m_iBytesInAckBuffer += readLen;
+			if(m_iBytesInAckBuffer == 4)
+			{
+				quint32 iNewAck = ntohl(m_ackBuffer.i32AckBuffer);
+				if(iNewAck > m_pFile->pos())
+				{
+					// the peer is drunk or is trying to fool us
+					postErrorEvent(KviError::AcknowledgeError);
+					return false;
+				}
+				if(iNewAck < m_uLastAck)
+				{
+					if(m_bAckHack)
+					{
+						//we reached the 4gb ack limit
+						m_uAckHackRounds++;
+					}
+					else
+					{
+						// the peer is drunk or is trying to fool us
+						postErrorEvent(KviError::AcknowledgeError);
+						return false;
+					}
+				}
+				m_uLastAck = iNewAck;
+				if(m_bAckHack)
+				{
+					m_uTotLastAck = (m_uAckHackRounds << 32) + iNewAck;
+				}
+				else
+				{
+
+					m_uTotLastAck = iNewAck;
+				}
+				m_iBytesInAckBuffer = 0;
+			}
+		}
+		else
+		{
+#ifdef COMPILE_SSL_SUPPORT
+			if(m_pSSL)
+			{
+				// ssl error....?
+				switch(m_pSSL->getProtocolError(readLen))
+				{
+
+					case KviSSL::ZeroReturn:
+						//if (!handleInvalidSocketRead(readLen)
+						// break;
+						readLen = 0;
+						break;
+					case KviSSL::Success:
+					case KviSSL::WantRead:
+					case KviSSL::WantWrite:
+						// hmmm...
+						break;
+					case KviSSL::SyscallError:
+					{
+						int iE = m_pSSL->getLastError(true);
+						if(iE != 0)
+						{
+							raiseSSLError();
+							postErrorEvent(KviError::SSLError);
+							return false;
+						}
+					}
+					break;
+					case KviSSL::SSLError:
+					{
+						raiseSSLError();
+						postErrorEvent(KviError::SSLError);
+						return false;
+					}
+					break;
+					default:
+						// Raise unknown SSL ERROR
+						postErrorEvent(KviError::SSLError);
+						return false;
+						break;
+				}
+			}
 
-void DccSendThread::run()
-{
-	m_pTimeInterval->mark();
-	m_pMutex->lock();
-	m_uStartTime = m_pTimeInterval->secondsCounter();
-	m_pMutex->unlock();
+			if(!m_pSSL && !handleInvalidSocketRead(readLen))
+				return false;
+#else
+			if(!handleInvalidSocketRead(readLen))
+				return false;
+#endif
+		}
 
-	m_uTotalSentBytes = 0;
-	m_uInstantSentBytes = 0;
-	int iFailedSelects = 0;
-	_ack_buffer ackbuffer;
-	int iBytesInAckBuffer = 0;
-	quint32 uLastAck = 0;
-	quint64 uTotLastAck = 0;
-	bool bAckHack = false;
-	quint64 iAckHackRounds = 0;
+		// update stats
+		m_pMutex->lock(); // is this really necessary ?
+		m_uAckedBytes = m_uTotLastAck;
+		m_pMutex->unlock();
 
-	if(m_pOpt->iPacketSize < 32)
-		m_pOpt->iPacketSize = 32;
-	char * buffer = (char *)KviMemory::allocate(m_pOpt->iPacketSize * sizeof(char));
+		if(m_uLastAck >= (quint64)m_pFile->size())
+		{
+			postEvent(new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS));
+			return false;
+		}
+		return true;
+	}
 
-	QFile * pFile = new QFile(QString::fromUtf8(m_pOpt->szFileName.ptr()));
+	// No acknowledges
+	if(!(m_pOpt->bIsTdcc && m_pFile->atEnd()))
+		return true;
 
-	if(!pFile->open(QIODevice::ReadOnly))
+	// We expect the remote end to close the connection when the whole file has been sent
+	int iAck;
+	int readLen;
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
 	{
-		postErrorEvent(KviError::CantOpenFileForReading);
-		goto exit_dcc;
+		readLen = m_pSSL->read((char *)&iAck, 4);
 	}
-
-	if(pFile->size() < 1)
+	else
 	{
-		postErrorEvent(KviError::CantSendAZeroSizeFile);
-		goto exit_dcc;
+#endif
+		readLen = kvi_socket_recv(m_fd, (char *)&iAck, 4);
+#ifdef COMPILE_SSL_SUPPORT
 	}
-
-	if(pFile->size() >= 0xffffffff)
+#endif
+	if(readLen == 0)
 	{
-		//dcc acks support only files up to 4GiB
-		bAckHack = true;
+		// done...success
+		updateStats();
+		postEvent(new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS));
+		return false;
 	}
 
-	if(m_pOpt->uStartPosition > 0)
+	if(readLen > 0)
 	{
-		// seek
-		if(!(pFile->seek(m_pOpt->uStartPosition)))
-		{
-			postErrorEvent(KviError::FileIOError);
-			goto exit_dcc;
-		}
+		postMessageEvent(__tr_no_lookup_ctx("WARNING: received data in a DCC TSEND, there should be no acknowledges", "dcc"));
+		return true;
 	}
 
-	uLastAck = m_pOpt->uStartPosition;
-
-	for(;;)
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
 	{
-		// Dequeue events
-		while(KviThreadEvent * e = dequeueEvent())
+		// ssl error....?
+		switch(m_pSSL->getProtocolError(readLen))
 		{
-			if(e->id() == KVI_THREAD_EVENT_TERMINATE)
+
+			case KviSSL::ZeroReturn:
+				readLen = 0;
+				break;
+			case KviSSL::Success:
+			case KviSSL::WantRead:
+			case KviSSL::WantWrite:
+				// hmmm...
+				break;
+			case KviSSL::SyscallError:
 			{
-				delete e;
-				goto exit_dcc;
+				int iE = m_pSSL->getLastError(true);
+				if(iE != 0)
+				{
+					raiseSSLError();
+					postErrorEvent(KviError::SSLError);
+					return false;
+				}
 			}
-			else
+			break;
+			case KviSSL::SSLError:
 			{
-				// Other events are senseless to us
-				delete e;
+				raiseSSLError();
+				postErrorEvent(KviError::SSLError);
+				return false;
 			}
+			break;
+			default:
+				// Raise unknown SSL ERROR
+				postErrorEvent(KviError::SSLError);
+				return false;
+				break;
 		}
+	}
 
-		bool bCanRead;
-		bool bCanWrite;
+	if(!m_pSSL && !handleInvalidSocketRead(readLen))
+		return false;
+#else
+	if(!handleInvalidSocketRead(readLen))
+		return false;
+#endif
+	return true;
+}
 
-		if(kvi_select(m_fd, &bCanRead, &bCanWrite, 15000))
+bool DccSendHandler::sendData()
+{
+	unsigned int uCanSend = m_bandwidth.available(m_pOpt->iPacketSize);
+	if(uCanSend > 0)
+		uCanSend = g_pDccBandwidthScheduler->reserve(&m_share, uCanSend);
+	if(uCanSend == 0)
+		return true; // the shared bandwidth has been taken by the other transfers
+	m_uReserved = uCanSend;
+
+	// maximum readable size, limited by the bandwidth and the packet size
+	qint64 toRead = m_pFile->size() - m_pFile->pos();
+	if(toRead > uCanSend)
+		toRead = uCanSend;
+
+	int written = 0;
+#ifdef Q_OS_LINUX
+	if(m_bUseSendFile)
+	{
+		// plain connection: let the kernel copy the file to the socket
+		off_t offset = m_pFile->pos();
+		written = sendfile(m_fd, m_pFile->handle(), &offset, toRead);
+		if(written > 0)
 		{
-			// reset the sleep time
-			iFailedSelects = 0;
-			if(bCanRead)
-			{
-				if(!m_pOpt->bNoAcks)
-				{
-					int iAckBytesToRead = 4 - iBytesInAckBuffer;
+			m_pFile->seek(offset);
+		}
+		else if(written == 0)
+		{
+			// the file has been truncated while sending it
+			postErrorEvent(KviError::FileIOError);
+			return false;
+		}
+		else if((errno == EINVAL) || (errno == ENOSYS))
+		{
+			// not supported for this file: fall back to read() and send()
+			m_bUseSendFile = false;
+			settleReservation(0);
+			return true;
+		}
+		else if(!handleInvalidSocketRead(written))
+		{
+			return false;
+		}
+	}
+	else
+#endif //Q_OS_LINUX
+	{
+		// read data
+		int readed = m_pFile->read(m_pBuffer, toRead);
+		if(readed < toRead)
+		{
+			postErrorEvent(KviError::FileIOError);
+			return false;
+		}
+// send it out
 
-					int readLen;
 #ifdef COMPILE_SSL_SUPPORT
-					if(m_pSSL)
-					{
-						readLen = m_pSSL->read((ackbuffer.cAckBuffer + iBytesInAckBuffer), iAckBytesToRead);
-					}
-					else
-					{
+		if(m_pSSL)
+		{
+			written = m_pSSL->write(m_pBuffer, toRead);
+		}
+		else
+		{
 #endif
-						readLen = kvi_socket_recv(m_fd, (ackbuffer.cAckBuffer + iBytesInAckBuffer), iAckBytesToRead);
+			written = kvi_socket_send(m_fd, m_pBuffer, toRead);
 #ifdef COMPILE_SSL_SUPPORT
-					}
+		}
 #endif
 
-					if(readLen > 0)
-					{
-						iBytesInAckBuffer += readLen;
-						if(iBytesInAckBuffer == 4)
-						{
-							quint32 iNewAck = ntohl(ackbuffer.i32AckBuffer);
-							if(iNewAck > pFile->pos())
-							{
-								// the peer is drunk or is trying to fool us
-								postErrorEvent(KviError::AcknowledgeError);
-								break;
-							}
-							if(iNewAck < uLastAck)
-							{
-								if(bAckHack)
-								{
-									//we reached the 4gb ack limit
-									iAckHackRounds++;
-								}
-								else
-								{
-									// the peer is drunk or is trying to fool us
-									postErrorEvent(KviError::AcknowledgeError);
-									break;
-								}
-							}
-							uLastAck = iNewAck;
-							if(bAckHack)
-							{
-								uTotLastAck = (iAckHackRounds << 32) + iNewAck;
-							}
-							else
-							{
-
-								uTotLastAck = iNewAck;
-							}
-							iBytesInAckBuffer = 0;
-						}
-					}
-					else
-					{
+		if(written < toRead)
+		{
+			if(written < 0)
+			{
 #ifdef COMPILE_SSL_SUPPORT
-						if(m_pSSL)
+				if(m_pSSL)
+				{
+					// ops...might be an SSL error
+					switch(m_pSSL->getProtocolError(written))
+					{
+						case KviSSL::Success:
+						case KviSSL::WantWrite:
+						case KviSSL::WantRead:
+							// Async continue...
+							break;
+						case KviSSL::SyscallError:
 						{
-							// ssl error....?
-							switch(m_pSSL->getProtocolError(readLen))
+							int iSSLErr = m_pSSL->getLastError(true);
+							if(iSSLErr != 0)
 							{
-
-								case KviSSL::ZeroReturn:
-									//if (!handleInvalidSocketRead(readLen)
-									// break;
-									readLen = 0;
-									break;
-								case KviSSL::Success:
-								case KviSSL::WantRead:
-								case KviSSL::WantWrite:
-									// hmmm...
-									break;
-								case KviSSL::SyscallError:
-								{
-									int iE = m_pSSL->getLastError(true);
-									if(iE != 0)
-									{
-										raiseSSLError();
-										postErrorEvent(KviError::SSLError);
-										goto exit_dcc;
-									}
-								}
-								break;
-								case KviSSL::SSLError:
-								{
-									raiseSSLError();
-									postErrorEvent(KviError::SSLError);
-									goto exit_dcc;
-								}
-								break;
-								default:
-									// Raise unknown SSL ERROR
-									postErrorEvent(KviError::SSLError);
-									goto exit_dcc;
-									break;
+								raiseSSLError();
+								postErrorEvent(KviError::SSLError);
+								return false;
 							}
 						}
-
-						if(!m_pSSL && !handleInvalidSocketRead(readLen))
+						break;
+						case KviSSL::SSLError:
+							raiseSSLError();
+							postErrorEvent(KviError::SSLError);
+							return false;
 							break;
-#else
-						if(!handleInvalidSocketRead(readLen))
+						default:
+							postErrorEvent(KviError::SSLError);
+							return false;
 							break;
-#endif
-					}
-
-					// update stats
-					m_pMutex->lock(); // is this really necessary ?
-					m_uAckedBytes = uTotLastAck;
-					m_pMutex->unlock();
-
-					if(uLastAck >= (quint64)pFile->size())
-					{
-						KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-						postEvent(parent(), e);
-						break;
 					}
 				}
-				else
+				else if(!handleInvalidSocketRead(written))
 				{
-					// No acknowledges
-					if(m_pOpt->bIsTdcc)
-					{
-						// We expect the remote end to close the connection when the whole file has been sent
-						if(pFile->atEnd())
-						{
-							int iAck;
-							int readLen;
-#ifdef COMPILE_SSL_SUPPORT
-							if(m_pSSL)
-							{
-								readLen = m_pSSL->read((char *)&iAck, 4);
-							}
-							else
-							{
-#endif
-								readLen = kvi_socket_recv(m_fd, (char *)&iAck, 4);
-#ifdef COMPILE_SSL_SUPPORT
-							}
-#endif
-							if(readLen == 0)
-							{
-								// done...success
-								updateStats();
-								KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-								postEvent(parent(), e);
-								break;
-							}
-							else
-							{
-								if(readLen < 0)
-								{
-#ifdef COMPILE_SSL_SUPPORT
-									if(m_pSSL)
-									{
-										// ssl error....?
-										switch(m_pSSL->getProtocolError(readLen))
-										{
-
-											case KviSSL::ZeroReturn:
-												readLen = 0;
-												break;
-											case KviSSL::Success:
-											case KviSSL::WantRead:
-											case KviSSL::WantWrite:
-												// hmmm...
-												break;
-											case KviSSL::SyscallError:
-											{
-												int iE = m_pSSL->getLastError(true);
-												if(iE != 0)
-												{
-													raiseSSLError();
-													postErrorEvent(KviError::SSLError);
-													goto exit_dcc;
-												}
-											}
-											break;
-											case KviSSL::SSLError:
-											{
-												raiseSSLError();
-												postErrorEvent(KviError::SSLError);
-												goto exit_dcc;
-											}
-											break;
-											default:
-												// Raise unknown SSL ERROR
-												postErrorEvent(KviError::SSLError);
-												goto exit_dcc;
-												break;
-										}
-									}
-
-									if(!m_pSSL && !handleInvalidSocketRead(readLen))
-										break;
-#else
-									if(!handleInvalidSocketRead(readLen))
-										break;
-#endif
-								}
-								else
-								{
-									KviThreadDataEvent<KviCString> * e = new KviThreadDataEvent<KviCString>(KVI_DCC_THREAD_EVENT_MESSAGE);
-									e->setData(new KviCString(__tr2qs_ctx("WARNING: received data in a DCC TSEND, there should be no acknowledges", "dcc")));
-									postEvent(parent(), e);
-								}
-							}
-						}
-					}
+					return false;
 				}
-			}
-			if(bCanWrite)
-			{
-				if(!pFile->atEnd())
-				{
-					if(m_pOpt->bFastSend || m_pOpt->bNoAcks || (uLastAck == (quint64)pFile->pos()))
-					{
-						// maximum readable size
-						qint64 toRead = pFile->size() - pFile->pos();
-						// the max number of bytes we can send in this interval (bandwidth limit)
-						m_pMutex->lock(); // FIXME: how to remove this lock ?
-						uint uMaxPossible = m_pOpt->uMaxBandwidth < MAX_DCC_BANDWIDTH_LIMIT ? m_pOpt->uMaxBandwidth * INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS : MAX_DCC_BANDWIDTH_LIMIT * INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS;
-						m_pMutex->unlock();
-						if(uMaxPossible < m_uInstantSentBytes)
-							toRead = 0; // already sent too much!
-						else
-						{
-							uMaxPossible -= m_uInstantSentBytes;
-							if(toRead > uMaxPossible)
-								toRead = uMaxPossible;
-						}
-						// limit to packet size
-						if(toRead > m_pOpt->iPacketSize)
-							toRead = m_pOpt->iPacketSize;
-
-						int written = 0;
-						if(toRead > 0)
-						{
-							// read data
-							int readed = pFile->read(buffer, toRead);
-							if(readed < toRead)
-							{
-								postErrorEvent(KviError::FileIOError);
-								break;
-							}
-// send it out
-
-#ifdef COMPILE_SSL_SUPPORT
-							if(m_pSSL)
-							{
-								written = m_pSSL->write(buffer, toRead);
-							}
-							else
-							{
-#endif
-								written = kvi_socket_send(m_fd, buffer, toRead);
-#ifdef COMPILE_SSL_SUPPORT
-							}
-#endif
-
-							if(written < toRead)
-							{
-								if(written < 0)
-								{
-#ifdef COMPILE_SSL_SUPPORT
-									if(m_pSSL)
-									{
-										// ops...might be an SSL error
-										switch(m_pSSL->getProtocolError(written))
-										{
-											case KviSSL::Success:
-											case KviSSL::WantWrite:
-											case KviSSL::WantRead:
-												// Async continue...
-												goto handle_system_error;
-												break;
-											case KviSSL::SyscallError:
-												if(written == 0)
-												{
-													raiseSSLError();
-													postErrorEvent(KviError::RemoteEndClosedConnection);
-													goto exit_dcc;
-												}
-												else
-												{
-													int iSSLErr = m_pSSL->getLastError(true);
-													if(iSSLErr != 0)
-													{
-														raiseSSLError();
-														postErrorEvent(KviError::SSLError);
-														goto exit_dcc;
-													}
-													else
-													{
-														goto handle_system_error;
-													}
-												}
-												break;
-											case KviSSL::SSLError:
-												raiseSSLError();
-												postErrorEvent(KviError::SSLError);
-												goto exit_dcc;
-												break;
-											default:
-												postErrorEvent(KviError::SSLError);
-												goto exit_dcc;
-												break;
-										}
-									}
-
-									if(!m_pSSL && !handleInvalidSocketRead(written))
-										break;
-
 #else
-									if(!handleInvalidSocketRead(written))
-										break;
+				if(!handleInvalidSocketRead(written))
+					return false;
 #endif
 
-								handle_system_error:
-									int err = kvi_socket_error();
+				int err = kvi_socket_error();
 #if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
-									if((err != EAGAIN) && (err != EINTR) && (err != WSAEWOULDBLOCK))
+				if((err != EAGAIN) && (err != EINTR) && (err != WSAEWOULDBLOCK))
 #else
-									if((err != EAGAIN) && (err != EINTR))
+				if((err != EAGAIN) && (err != EINTR))
 #endif
-									{
-										postErrorEvent(KviError::translateSystemError(err));
-										goto exit_dcc;
-									}
-								}
-								else
-								{
-									// seek back to the right position
-									pFile->seek(pFile->pos() - (toRead - written));
-								}
-							}
-						}
-						else
-						{
-							// just nothing to send out in this interval
-							// sleep a while
-							if(m_uInstantSpeedInterval < (INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_MSECS - 100))
-							{
-								msleep(100);
-							}
-							else if(m_uInstantSpeedInterval < (INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_MSECS - 20))
-							{
-								msleep(20);
-							}
-						}
-
-						m_uTotalSentBytes += written;
-						m_uInstantSentBytes += written;
-						m_uFilePosition = pFile->pos();
-						updateStats();
-					}
-				}
-				else
 				{
-					if(m_pOpt->bNoAcks && !m_pOpt->bIsTdcc)
-					{
-						// at end of the file in a blind dcc send...
-						// not in a tdcc: we can close the file...
-						updateStats();
-						KviThreadEvent * e = new KviThreadEvent(KVI_DCC_THREAD_EVENT_SUCCESS);
-						postEvent(parent(), e);
-						break;
-					}
-					else
-					{
-						// upload finished but we're waiting for the last ack
-						// sleep a bit: don't lag the kernie too much while waiting
-						msleep(100);
-					}
+					postErrorEvent(KviError::translateSystemError(err));
+					return false;
 				}
-			}
-		}
-		else
-		{
-			// after 2 failed selects start to sleep
-			if(iFailedSelects > 3)
-			{
-				// sleep up to 200 msecs
-				if(iFailedSelects < 100)
-					iFailedSelects++;
-				msleep(3 * iFailedSelects);
+				// nothing has been sent: rewind the whole block
+				m_pFile->seek(m_pFile->pos() - toRead);
 			}
 			else
 			{
-				iFailedSelects++;
+				// seek back to the right position
+				m_pFile->seek(m_pFile->pos() - (toRead - written));
 			}
 		}
+	}
 
-		// include the artificial delay if needed
-		if(m_pOpt->iIdleStepLengthInMSec > 0)
-		{
-			msleep(m_pOpt->iIdleStepLengthInMSec);
-		}
+	settleReservation(written > 0 ? written : 0);
+
+	if(written > 0)
+	{
+		m_bandwidth.consume(written);
+		m_uTotalSentBytes += written;
+		m_uInstantSentBytes += written;
 	}
+	m_uFilePosition = m_pFile->pos();
+	updateStats();
 
-exit_dcc:
-	KviMemory::free(buffer);
-	pFile->close();
-	delete pFile;
-	pFile = nullptr;
+	// include the artificial delay if needed
+	if(m_pOpt->iIdleStepLengthInMSec > 0)
+		m_bIdleStep = true;
+	return true;
+}
 
-#ifdef COMPILE_SSL_SUPPORT
-	if(m_pSSL)
+void DccSendHandler::finish()
+{
+	// a write interrupted by an error or by remove() gives back its reservation
+	settleReservation(0);
+	g_pDccBandwidthScheduler->detach(&m_share);
+
+	if(m_pBuffer)
 	{
-		KviSSLMaster::freeSSL(m_pSSL);
-		m_pSSL = nullptr;
+		KviMemory::free(m_pBuffer);
+		m_pBuffer = nullptr;
 	}
-#endif
-	kvi_socket_close(m_fd);
-	m_fd = KVI_INVALID_SOCKET;
+
+	if(m_pFile)
+	{
+		m_pFile->close();
+		delete m_pFile;
+		m_pFile = nullptr;
+	}
+
+	DccReactorHandler::finish();
 }
 
-void DccSendThread::initGetInfo()
+void DccSendHandler::setBandwidthWeight(unsigned int uWeight)
+{
+	g_pDccBandwidthScheduler->setWeight(&m_share, uWeight);
+}
+
+void DccSendHandler::initGetInfo()
 {
 	m_pMutex->lock();
 }
 
-void DccSendThread::doneGetInfo()
+void DccSendHandler::doneGetInfo()
 {
 	m_pMutex->unlock();
 }
@@ -1216,8 +1278,8 @@ DccFileTransfer::DccFileTransfer(DccDescriptor * dcc)
 	if(dcc->bIsSSL)
 		m_szDccType.prepend("S");
 #endif
-	m_pSlaveRecvThread = nullptr;
-	m_pSlaveSendThread = nullptr;
+	m_pSlaveRecvHandler = nullptr;
+	m_pSlaveSendHandler = nullptr;
 
 	m_tTransferStartTime = 0;
 	m_tTransferEndTime = 0;
@@ -1235,6 +1297,8 @@ DccFileTransfer::DccFileTransfer(DccDescriptor * dcc)
 	else
 		m_uMaxBandwidth = KVI_OPTION_BOOL(KviOption_boolLimitDccSendSpeed) ? KVI_OPTION_UINT(KviOption_uintMaxDccSendSpeed) : MAX_DCC_BANDWIDTH_LIMIT;
 
+	m_uBandwidthWeight = KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT;
+
 	startConnection();
 }
 
@@ -1247,18 +1311,18 @@ DccFileTransfer::~DccFileTransfer()
 	if(m_pBandwidthDialog)
 		delete m_pBandwidthDialog;
 
-	if(m_pSlaveRecvThread)
+	if(m_pSlaveRecvHandler)
 	{
-		m_pSlaveRecvThread->terminate();
-		delete m_pSlaveRecvThread;
-		m_pSlaveRecvThread = nullptr;
+		g_pDccReactor->remove(m_pSlaveRecvHandler);
+		delete m_pSlaveRecvHandler;
+		m_pSlaveRecvHandler = nullptr;
 	}
 
-	if(m_pSlaveSendThread)
+	if(m_pSlaveSendHandler)
 	{
-		m_pSlaveSendThread->terminate();
-		delete m_pSlaveSendThread;
-		m_pSlaveSendThread = nullptr;
+		g_pDccReactor->remove(m_pSlaveSendHandler);
+		delete m_pSlaveSendHandler;
+		m_pSlaveSendHandler = nullptr;
 	}
 
 	KviThreadManager::killPendingEvents(this);
@@ -1395,10 +1459,10 @@ QString DccFileTransfer::localFileName()
 
 void DccFileTransfer::abort()
 {
-	if(m_pSlaveRecvThread)
-		m_pSlaveRecvThread->terminate();
-	if(m_pSlaveSendThread)
-		m_pSlaveSendThread->terminate();
+	if(m_pSlaveRecvHandler)
+		g_pDccReactor->remove(m_pSlaveRecvHandler);
+	if(m_pSlaveSendHandler)
+		g_pDccReactor->remove(m_pSlaveSendHandler);
 	if(m_pMarshal)
 		m_pMarshal->abort();
 
@@ -1407,10 +1471,10 @@ void DccFileTransfer::abort()
 
 	QString tmp;
 
-	if(m_pSlaveRecvThread)
-		tmp.setNum(m_pSlaveRecvThread->receivedBytes());
-	else if(m_pSlaveSendThread)
-		tmp.setNum(m_pSlaveSendThread->sentBytes());
+	if(m_pSlaveRecvHandler)
+		tmp.setNum(m_pSlaveRecvHandler->receivedBytes());
+	else if(m_pSlaveSendHandler)
+		tmp.setNum(m_pSlaveSendHandler->sentBytes());
 	else
 		tmp = '0';
 
@@ -1518,22 +1582,22 @@ int DccFileTransfer::bandwidthLimit()
 	int iLimit = m_uMaxBandwidth; // we have the cached value anyway...
 	if(m_pDescriptor->bRecvFile)
 	{
-		if(m_pSlaveRecvThread)
+		if(m_pSlaveRecvHandler)
 		{
-			m_pSlaveRecvThread->initGetInfo();
-			iLimit = (int)m_pSlaveRecvThread->bandwidthLimit();
-			m_pSlaveRecvThread->doneGetInfo();
+			m_pSlaveRecvHandler->initGetInfo();
+			iLimit = (int)m_pSlaveRecvHandler->bandwidthLimit();
+			m_pSlaveRecvHandler->doneGetInfo();
 			if(iLimit < 0)
 				iLimit = MAX_DCC_BANDWIDTH_LIMIT;
 		}
 	}
 	else
 	{
-		if(m_pSlaveSendThread)
+		if(m_pSlaveSendHandler)
 		{
-			m_pSlaveSendThread->initGetInfo();
-			iLimit = (int)m_pSlaveSendThread->bandwidthLimit();
-			m_pSlaveSendThread->doneGetInfo();
+			m_pSlaveSendHandler->initGetInfo();
+			iLimit = (int)m_pSlaveSendHandler->bandwidthLimit();
+			m_pSlaveSendHandler->doneGetInfo();
 			if(iLimit < 0)
 				iLimit = MAX_DCC_BANDWIDTH_LIMIT;
 		}
@@ -1550,43 +1614,60 @@ void DccFileTransfer::setBandwidthLimit(int iVal)
 	m_uMaxBandwidth = iVal;
 	if(m_pDescriptor->bRecvFile)
 	{
-		if(m_pSlaveRecvThread)
+		if(m_pSlaveRecvHandler)
 		{
-			m_pSlaveRecvThread->initGetInfo();
-			m_pSlaveRecvThread->setBandwidthLimit(iVal);
-			m_pSlaveRecvThread->doneGetInfo();
+			m_pSlaveRecvHandler->initGetInfo();
+			m_pSlaveRecvHandler->setBandwidthLimit(iVal);
+			m_pSlaveRecvHandler->doneGetInfo();
 		}
 	}
 	else
 	{
-		if(m_pSlaveSendThread)
+		if(m_pSlaveSendHandler)
 		{
-			m_pSlaveSendThread->initGetInfo();
-			m_pSlaveSendThread->setBandwidthLimit(iVal);
-			m_pSlaveSendThread->doneGetInfo();
+			m_pSlaveSendHandler->initGetInfo();
+			m_pSlaveSendHandler->setBandwidthLimit(iVal);
+			m_pSlaveSendHandler->doneGetInfo();
 		}
 	}
 }
 
+void DccFileTransfer::setBandwidthWeight(unsigned int uWeight)
+{
+	if(uWeight < 1)
+		uWeight = KVI_DCC_BANDWIDTH_DEFAULT_WEIGHT;
+	m_uBandwidthWeight = uWeight;
+	if(m_pDescriptor->bRecvFile)
+	{
+		if(m_pSlaveRecvHandler)
+			m_pSlaveRecvHandler->setBandwidthWeight(uWeight);
+	}
+	else
+	{
+		if(m_pSlaveSendHandler)
+			m_pSlaveSendHandler->setBandwidthWeight(uWeight);
+	}
+}
+
 unsigned int DccFileTransfer::averageSpeed()
 {
 	unsigned int uAvgBandwidth = 0;
 	if(m_pDescriptor->bRecvFile)
 	{
-		if(m_pSlaveRecvThread)
+		if(m_pSlaveRecvHandler)
 		{
-			m_pSlaveRecvThread->initGetInfo();
-			uAvgBandwidth = m_pSlaveRecvThread->averageSpeed();
-			m_pSlaveRecvThread->doneGetInfo();
+			m_pSlaveRecvHandler->initGetInfo();
+			uAvgBandwidth = m_pSlaveRecvHandler->averageSpeed();
+			m_pSlaveRecvHandler->doneGetInfo();
 		}
 	}
 	else
 	{
-		if(m_pSlaveSendThread)
+		if(m_pSlaveSendHandler)
 		{
-			m_pSlaveSendThread->initGetInfo();
-			uAvgBandwidth = m_pSlaveSendThread->averageSpeed();
-			m_pSlaveSendThread->doneGetInfo();
+			m_pSlaveSendHandler->initGetInfo();
+			uAvgBandwidth = m_pSlaveSendHandler->averageSpeed();
+			m_pSlaveSendHandler->doneGetInfo();
 		}
 	}
 	return uAvgBandwidth;
@@ -1597,20 +1678,20 @@ unsigned int DccFileTransfer::instantSpeed()
 	unsigned int uInstBandwidth = 0;
 	if(m_pDescriptor->bRecvFile)
 	{
-		if(m_pSlaveRecvThread)
+		if(m_pSlaveRecvHandler)
 		{
-			m_pSlaveRecvThread->initGetInfo();
-			uInstBandwidth = m_pSlaveRecvThread->instantSpeed();
-			m_pSlaveRecvThread->doneGetInfo();
+			m_pSlaveRecvHandler->initGetInfo();
+			uInstBandwidth = m_pSlaveRecvHandler->instantSpeed();
+			m_pSlaveRecvHandler->doneGetInfo();
 		}
 	}
 	else
 	{
-		if(m_pSlaveSendThread)
+		if(m_pSlaveSendHandler)
 		{
-			m_pSlaveSendThread->initGetInfo();
-			uInstBandwidth = m_pSlaveSendThread->instantSpeed();
-			m_pSlaveSendThread->doneGetInfo();
+			m_pSlaveSendHandler->initGetInfo();
+			uInstBandwidth = m_pSlaveSendHandler->instantSpeed();
+			m_pSlaveSendHandler->doneGetInfo();
 		}
 	}
 	return uInstBandwidth;
@@ -1621,20 +1702,20 @@ unsigned int DccFileTransfer::transferredBytes()
 	unsigned int uTransferred = 0;
 	if(m_pDescriptor->bRecvFile)
 	{
-		if(m_pSlaveRecvThread)
+		if(m_pSlaveRecvHandler)
 		{
-			m_pSlaveRecvThread->initGetInfo();
-			uTransferred = m_pSlaveRecvThread->filePosition();
-			m_pSlaveRecvThread->doneGetInfo();
+			m_pSlaveRecvHandler->initGetInfo();
+			uTransferred = m_pSlaveRecvHandler->filePosition();
+			m_pSlaveRecvHandler->doneGetInfo();
 		}
 	}
 	else
 	{
-		if(m_pSlaveSendThread)
+		if(m_pSlaveSendHandler)
 		{
-			m_pSlaveSendThread->initGetInfo();
-			uTransferred = m_pSlaveSendThread->filePosition();
-			m_pSlaveSendThread->doneGetInfo();
+			m_pSlaveSendHandler->initGetInfo();
+			uTransferred = m_pSlaveSendHandler->filePosition();
+			m_pSlaveSendHandler->doneGetInfo();
 		}
 	}
 	return uTransferred;
@@ -1735,25 +1816,25 @@ void DccFileTransfer::displayPaint(QPainter * p, int column, QRect rect)
 
 			if(m_pDescriptor->bRecvFile)
 			{
-				if(m_pSlaveRecvThread)
+				if(m_pSlaveRecvHandler)
 				{
-					m_pSlaveRecvThread->initGetInfo();
-					uAvgBandwidth = m_pSlaveRecvThread->averageSpeed();
-					uInstantSpeed = m_pSlaveRecvThread->instantSpeed();
-					uTransferred = m_pSlaveRecvThread->filePosition();
-					m_pSlaveRecvThread->doneGetInfo();
+					m_pSlaveRecvHandler->initGetInfo();
+					uAvgBandwidth = m_pSlaveRecvHandler->averageSpeed();
+					uInstantSpeed = m_pSlaveRecvHandler->instantSpeed();
+					uTransferred = m_pSlaveRecvHandler->filePosition();
+					m_pSlaveRecvHandler->doneGetInfo();
 				}
 			}
 			else
 			{
-				if(m_pSlaveSendThread)
+				if(m_pSlaveSendHandler)
 				{
-					m_pSlaveSendThread->initGetInfo();
-					uAvgBandwidth = m_pSlaveSendThread->averageSpeed();
-					uInstantSpeed = m_pSlaveSendThread->instantSpeed();
-					uTransferred = m_pSlaveSendThread->filePosition();
-					uAckedBytes = m_pSlaveSendThread->ackedBytes();
-					m_pSlaveSendThread->doneGetInfo();
+					m_pSlaveSendHandler->initGetInfo();
+					uAvgBandwidth = m_pSlaveSendHandler->averageSpeed();
+					uInstantSpeed = m_pSlaveSendHandler->instantSpeed();
+					uTransferred = m_pSlaveSendHandler->filePosition();
+					uAckedBytes = m_pSlaveSendHandler->ackedBytes();
+					m_pSlaveSendHandler->doneGetInfo();
 				}
 			}
 
@@ -1897,6 +1978,49 @@ QString DccFileTransfer::tipText()
 	s += "<tr><td bgcolor=\"#C0C0C0\">";
 	s += m_szTransferLog;
 	s += "</td></tr>";
+
+	if(m_eGeneralStatus == Transferring)
+	{
+		// the live rates of the shared bandwidth
+		DccBandwidthScheduler::Direction d = m_pDescriptor->bRecvFile ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+		QString szRate, szLimit;
+
+		s += "<tr><td bgcolor=\"#404040\"><font color=\"#FFFFFF\">";
+		s += __tr2qs_ctx("Bandwidth", "dcc");
+		s += "</font></td></tr>";
+		s += "<tr><td bgcolor=\"#C0C0C0\">";
+
+		KviNetUtils::formatNetworkBandwidthString(szRate, instantSpeed());
+		s += __tr2qs_ctx("This transfer: %1 (weight %2)", "dcc").arg(szRate).arg(m_uBandwidthWeight);
+		s += "<br>";
+
+		KviNetUtils::formatNetworkBandwidthString(szRate, g_pDccBandwidthScheduler->nickRate(d, m_pDescriptor->szNick));
+		unsigned int uLimit = g_pDccBandwidthScheduler->nickLimit(d, m_pDescriptor->szNick);
+		if(uLimit < MAX_DCC_BANDWIDTH_LIMIT)
+		{
+			KviNetUtils::formatNetworkBandwidthString(szLimit, uLimit);
+			s += __tr2qs_ctx("All the transfers with %1: %2 (limit %3)", "dcc").arg(m_pDescriptor->szNick, szRate, szLimit);
+		}
+		else
+		{
+			s += __tr2qs_ctx("All the transfers with %1: %2", "dcc").arg(m_pDescriptor->szNick, szRate);
+		}
+		s += "<br>";
+
+		KviNetUtils::formatNetworkBandwidthString(szRate, g_pDccBandwidthScheduler->globalRate(d));
+		uLimit = g_pDccBandwidthScheduler->globalLimit(d);
+		if(uLimit < MAX_DCC_BANDWIDTH_LIMIT)
+		{
+			KviNetUtils::formatNetworkBandwidthString(szLimit, uLimit);
+			s += __tr2qs_ctx("All the transfers: %1 (limit %2)", "dcc").arg(szRate, szLimit);
+		}
+		else
+		{
+			s += __tr2qs_ctx("All the transfers: %1", "dcc").arg(szRate);
+		}
+		s += "</td></tr>";
+	}
+
 	s += "<table>";
 
 	return s;
@@ -2180,7 +2304,7 @@ bool DccFileTransfer::event(QEvent * e)
 				KVS_TRIGGER_EVENT_3(KviEvent_OnDCCFileTransferFailed,
 				    eventWindow(),
 				    szErrorString,
-				    (kvs_int_t)(m_pSlaveRecvThread ? m_pSlaveRecvThread->receivedBytes() : m_pSlaveSendThread->sentBytes()),
+				    (kvs_int_t)(m_pSlaveRecvHandler ? m_pSlaveRecvHandler->receivedBytes() : m_pSlaveSendHandler->sentBytes()),
 				    m_pDescriptor->idString());
 
 				outputAndLog(KVI_OUT_DCCERROR, m_szStatusString);
@@ -2217,7 +2341,7 @@ bool DccFileTransfer::event(QEvent * e)
 
 				KVS_TRIGGER_EVENT_2(KviEvent_OnDCCFileTransferSuccess,
 				    eventWindow(),
-				    (kvs_int_t)(m_pSlaveRecvThread ? m_pSlaveRecvThread->receivedBytes() : m_pSlaveSendThread->sentBytes()),
+				    (kvs_int_t)(m_pSlaveRecvHandler ? m_pSlaveRecvHandler->receivedBytes() : m_pSlaveSendHandler->sentBytes()),
 				    m_pDescriptor->idString());
 
 				displayUpdate();
@@ -2283,16 +2407,18 @@ void DccFileTransfer::connected()
 		o->bSend64BitAck = KVI_OPTION_BOOL(KviOption_boolSend64BitAckInDccRecv);
 		o->bNoAcks = m_pDescriptor->bNoAcks;
 		o->uMaxBandwidth = m_uMaxBandwidth;
-		m_pSlaveRecvThread = new DccRecvThread(this, m_pMarshal->releaseSocket(), o);
+		o->szNick = m_pDescriptor->szNick;
+		o->uBandwidthWeight = m_uBandwidthWeight;
+		m_pSlaveRecvHandler = new DccRecvHandler(this, m_pMarshal->releaseSocket(), o);
 
 #ifdef COMPILE_SSL_SUPPORT
 		KviSSL * s = m_pMarshal->releaseSSL();
 		if(s)
 		{
-			m_pSlaveRecvThread->setSSL(s);
+			m_pSlaveRecvHandler->setSSL(s);
 		}
 #endif
-		m_pSlaveRecvThread->start();
+		g_pDccReactor->add(m_pSlaveRecvHandler);
 	}
 	else
 	{
@@ -2309,16 +2435,18 @@ void DccFileTransfer::connected()
 		if(o->iPacketSize < 32)
 			o->iPacketSize = 32;
 		o->uMaxBandwidth = m_uMaxBandwidth;
+		o->szNick = m_pDescriptor->szNick;
+		o->uBandwidthWeight = m_uBandwidthWeight;
 		o->bNoAcks = m_pDescriptor->bNoAcks;
-		m_pSlaveSendThread = new DccSendThread(this, m_pMarshal->releaseSocket(), o);
+		m_pSlaveSendHandler = new DccSendHandler(this, m_pMarshal->releaseSocket(), o);
 #ifdef COMPILE_SSL_SUPPORT
 		KviSSL * s = m_pMarshal->releaseSSL();
 		if(s)
 		{
-			m_pSlaveSendThread->setSSL(s);
+			m_pSlaveSendHandler->setSSL(s);
 		}
 #endif
-		m_pSlaveSendThread->start();
+		g_pDccReactor->add(m_pSlaveSendHandler);
 	}
 
 	m_eGeneralStatus = Transferring;
@@ -2335,7 +2463,7 @@ bool DccFileTransfer::resumeAccepted(const char * filename, const char * port, c
 	if(!(kvi_strEqualCI(filename, m_pDescriptor->szFileName.toUtf8().data()) || KVI_OPTION_BOOL(KviOption_boolAcceptBrokenFileNameDccResumeRequests)))
 		return false;
 
-	if(!(kvi_strEqualCI(port, m_pDescriptor->szPort.toUtf8().data()) && (!m_pSlaveRecvThread) && m_pDescriptor->bResume && m_pDescriptor->bRecvFile && m_pResumeTimer))
+	if(!(kvi_strEqualCI(port, m_pDescriptor->szPort.toUtf8().data()) && (!m_pSlaveRecvHandler) && m_pDescriptor->bResume && m_pDescriptor->bRecvFile && m_pResumeTimer))
 		return false;
 
 	if(kvi_strEqualCI(port, "0"))
@@ -2356,9 +2484,9 @@ bool DccFileTransfer::resumeAccepted(const char * filename, const char * port, c
 
 bool DccFileTransfer::doResume(const char * filename, const char * port, quint64 filePos)
 {
-	if(m_pSlaveRecvThread)
+	if(m_pSlaveRecvHandler)
 		return false; // we're already receiving stuff...
-	if(m_pSlaveSendThread)
+	if(m_pSlaveSendHandler)
 		return false; // we're already sending stuff...
 
 	if(m_pDescriptor->bRecvFile)
@@ -2441,15 +2569,15 @@ bool DccFileTransfer::doResume(const char * filename, const char * port, quint64
 	return true;
 }
 
-DccThread * DccFileTransfer::getSlaveThread()
+DccReactorHandler * DccFileTransfer::getSlaveHandler()
 {
 	if(m_pDescriptor->bRecvFile)
 	{
-		return m_pSlaveRecvThread;
+		return m_pSlaveRecvHandler;
 	}
 	else
 	{
-		return m_pSlaveSendThread;
+		return m_pSlaveSendHandler;
 	}
 }
 
@@ -27,6 +27,8 @@
 #include "DccDescriptor.h"
 #include "DccWindow.h"
 #include "DccThread.h"
+#include "DccReactor.h"
+#include "DccBandwidthScheduler.h"
 
 #include "KviWindow.h"
 #include "KviCString.h"
@@ -61,13 +63,21 @@ typedef struct _KviDccSendThreadOptions
 	bool bNoAcks;
 	bool bIsTdcc;
 	unsigned int uMaxBandwidth;
+	QString szNick;
+	unsigned int uBandwidthWeight;
 } KviDccSendThreadOptions;
 
-class DccSendThread : public DccThread
+//
+// DccSendHandler
+//
+//    The sending side of a file transfer, run by the DCC reactor
+//
+
+class DccSendHandler : public DccReactorHandler
 {
 public:
-	DccSendThread(QObject * par, kvi_socket_t fd, KviDccSendThreadOptions * opt);
-	~DccSendThread();
+	DccSendHandler(QObject * par, kvi_socket_t fd, KviDccSendThreadOptions * opt);
+	~DccSendHandler();
 
 private:
 	// stats: SHARED!!!
@@ -80,8 +90,26 @@ private:
 	unsigned long m_uStartTime;
 	unsigned long m_uInstantSpeedInterval;
 	quint64 m_uInstantSentBytes;
+	DccBandwidthBucket m_bandwidth;
+	DccBandwidthShare m_share;  // in the global scheduler
+	unsigned int m_uReserved;   // reserved in the scheduler and not committed yet
 	KviDccSendThreadOptions * m_pOpt;
 	KviMSecTimeInterval * m_pTimeInterval; // used for computing the instant bandwidth but not only
+	QFile * m_pFile;
+	char * m_pBuffer;
+	union
+	{
+		char cAckBuffer[4];
+		quint32 i32AckBuffer;
+	} m_ackBuffer;
+	int m_iBytesInAckBuffer;
+	quint32 m_uLastAck;
+	quint64 m_uTotLastAck;
+	bool m_bAckHack;
+	quint64 m_uAckHackRounds;
+	bool m_bUseSendFile;
+	bool m_bIdleStep; // the artificial delay is due before the next write
+
 public:
 	void initGetInfo();
 	uint averageSpeed() { return m_uAverageSpeed; };
@@ -93,10 +121,20 @@ public:
 	unsigned int bandwidthLimit() { return m_pOpt->uMaxBandwidth; };
 	void setBandwidthLimit(unsigned int uMaxBandwidth) { m_pOpt->uMaxBandwidth = uMaxBandwidth; };
 	void doneGetInfo();
+	// thread safe, no need to call initGetInfo()
+	void setBandwidthWeight(unsigned int uWeight);
 
 protected:
 	void updateStats();
-	virtual void run();
+	virtual bool start();
+	virtual bool process(bool bCanRead, bool bCanWrite);
+	virtual void finish();
+	// reads the acks (or the connection close at the end of a TDCC)
+	bool receiveData();
+	bool sendData();
+	// checks for the end of a blind send and watches what's needed next
+	bool prepareNextStep();
+	void settleReservation(unsigned int uUsed);
 };
 
 typedef struct _KviDccRecvThreadOptions
@@ -110,13 +148,21 @@ typedef struct _KviDccRecvThreadOptions
 	bool bNoAcks;
 	bool bIsTdcc;
 	unsigned int uMaxBandwidth;
+	QString szNick;
+	unsigned int uBandwidthWeight;
 } KviDccRecvThreadOptions;
 
-class DccRecvThread : public DccThread
+//
+// DccRecvHandler
+//
+//    The receiving side of a file transfer, run by the DCC reactor
+//
+
+class DccRecvHandler : public DccReactorHandler
 {
 public:
-	DccRecvThread(QObject * par, kvi_socket_t fd, KviDccRecvThreadOptions * opt);
-	~DccRecvThread();
+	DccRecvHandler(QObject * par, kvi_socket_t fd, KviDccRecvThreadOptions * opt);
+	~DccRecvHandler();
 
 protected:
 	KviDccRecvThreadOptions * m_pOpt;
@@ -132,7 +178,16 @@ protected:
 	KviMSecTimeInterval * m_pTimeInterval; // used for computing the instant bandwidth
 	quint64 m_uInstantReceivedBytes;
 	quint64 m_uInstantSpeedInterval;
+	DccBandwidthBucket m_bandwidth;
+	DccBandwidthShare m_share; // in the global scheduler
 	QFile * m_pFile;
+	char * m_pBuffer;
+	bool m_bSend64BitAck;
+	char m_cPendingAck[8]; // the part of an ack that the socket didn't take
+	int m_iPendingAckBytes;
+	bool m_bReading;  // the last wait was for data, not for the bandwidth
+	bool m_bIdleStep; // the artificial delay is due before the next read
+	int m_iProbableTerminationTime;
 
 public:
 	void initGetInfo();
@@ -144,12 +199,20 @@ public:
 	unsigned int bandwidthLimit() { return m_pOpt->uMaxBandwidth; };
 	void setBandwidthLimit(unsigned int uMaxBandwidth) { m_pOpt->uMaxBandwidth = uMaxBandwidth; };
 	void doneGetInfo();
+	// thread safe, no need to call initGetInfo()
+	void setBandwidthWeight(unsigned int uWeight);
 
 protected:
-	void postMessageEvent(const char * msg);
 	void updateStats();
 	bool sendAck(qint64 filePos, bool bUse64BitAck = false);
-	virtual void run();
+	bool flushPendingAck();
+	virtual bool start();
+	virtual bool process(bool bCanRead, bool bCanWrite);
+	virtual void finish();
+	bool receiveData();
+	// waits for the peer to close the connection after the whole file
+	bool checkTermination();
+	void prepareNextStep();
 };
 
 class DccFileTransferBandwidthDialog : public QDialog
@@ -186,8 +249,8 @@ public:
 	~DccFileTransfer();
 
 private:
-	DccSendThread * m_pSlaveSendThread;
-	DccRecvThread * m_pSlaveRecvThread;
+	DccSendHandler * m_pSlaveSendHandler;
+	DccRecvHandler * m_pSlaveRecvHandler;
 	DccDescriptor * m_pDescriptor;
 	DccMarshal * m_pMarshal;
 
@@ -206,6 +269,7 @@ private:
 	quint64 m_uTotalFileSize; // total file size to transfer
 
 	unsigned int m_uMaxBandwidth;
+	unsigned int m_uBandwidthWeight;
 	DccFileTransferBandwidthDialog * m_pBandwidthDialog;
 
 	QTimer * m_pResumeTimer; // used to signal resume timeout
@@ -242,7 +306,9 @@ public:
 
 	int bandwidthLimit();
 	void setBandwidthLimit(int iVal);
-	virtual DccThread * getSlaveThread();
+	unsigned int bandwidthWeight() { return m_uBandwidthWeight; };
+	void setBandwidthWeight(unsigned int uWeight);
+	DccReactorHandler * getSlaveHandler();
 
 protected:
 	void startConnection();
@@ -0,0 +1,561 @@
+//=============================================================================
+//
+//   File : DccReactor.cpp
+//   Creation date : Sun Oct 18 2026 17:40:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "DccReactor.h"
+#include "DccThread.h"
+
+#include "kvi_debug.h"
+#include "KviError.h"
+#include "KviCString.h"
+#include "kvi_socket.h"
+
+#ifdef COMPILE_SSL_SUPPORT
+#include "KviSSLMaster.h"
+#endif
+
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+DccReactor * g_pDccReactor = nullptr;
+
+DccReactorHandler::DccReactorHandler(QObject * par, kvi_socket_t fd)
+{
+	m_pParent = par;
+	m_fd = fd;
+	m_pMutex = new KviMutex();
+#ifdef COMPILE_SSL_SUPPORT
+	m_pSSL = nullptr;
+#endif
+	m_uId = 0;
+	m_bWantRead = false;
+	m_bWantWrite = false;
+	m_iTimeout = -1;
+	m_bWatchingRead = false;
+	m_bWatchingWrite = false;
+	m_iWakeUpTime = -1;
+}
+
+DccReactorHandler::~DccReactorHandler()
+{
+	// must have been removed from the reactor
+	KVI_ASSERT(m_uId == 0);
+	DccReactorHandler::finish();
+	KVI_ASSERT(!m_pMutex->locked());
+	delete m_pMutex;
+}
+
+void DccReactorHandler::finish()
+{
+#ifdef COMPILE_SSL_SUPPORT
+	if(m_pSSL)
+	{
+		KviSSLMaster::freeSSL(m_pSSL);
+		m_pSSL = nullptr;
+	}
+#endif
+	if(m_fd != KVI_INVALID_SOCKET)
+	{
+		kvi_socket_close(m_fd);
+		m_fd = KVI_INVALID_SOCKET;
+	}
+}
+
+#ifdef COMPILE_SSL_SUPPORT
+void DccReactorHandler::setSSL(KviSSL * s)
+{
+	if(m_pSSL)
+		KviSSLMaster::freeSSL(m_pSSL);
+	m_pSSL = s;
+}
+
+void DccReactorHandler::raiseSSLError()
+{
+	KviCString buffer;
+	while(m_pSSL->getLastErrorString(buffer))
+	{
+		KviCString msg(KviCString::Format, "[SSL ERROR]: %s", buffer.ptr());
+		postMessageEvent(msg.ptr());
+	}
+}
+#endif
+
+void DccReactorHandler::watch(bool bRead, bool bWrite, int iTimeoutMSecs)
+{
+	m_bWantRead = bRead;
+	m_bWantWrite = bWrite;
+	m_iTimeout = iTimeoutMSecs;
+#ifdef COMPILE_SSL_SUPPORT
+	// the SSL layer may already hold decrypted data that the socket doesn't show
+	if(bRead && m_pSSL && (m_pSSL->pending() > 0))
+		m_iTimeout = 0;
+#endif
+}
+
+bool DccReactorHandler::handleInvalidSocketRead(int readLen)
+{
+	KVI_ASSERT(readLen < 1);
+	if(readLen == 0)
+	{
+		// connection closed
+		postErrorEvent(KviError::RemoteEndClosedConnection);
+		return false;
+	}
+	else
+	{
+		// error ?
+		int err = kvi_socket_error();
+		if((err != EINTR) && (err != EAGAIN))
+		{
+			postErrorEvent(KviError::translateSystemError(err));
+			return false;
+		}
+	}
+	return true; // continue
+}
+
+void DccReactorHandler::postEvent(QEvent * e)
+{
+	g_pDccReactor->post(m_pParent, e);
+}
+
+void DccReactorHandler::postErrorEvent(int err)
+{
+	KviThreadDataEvent<int> * e = new KviThreadDataEvent<int>(KVI_DCC_THREAD_EVENT_ERROR);
+	e->setData(new int(err));
+	postEvent(e);
+}
+
+void DccReactorHandler::postMessageEvent(const char * message)
+{
+	KviThreadDataEvent<KviCString> * e = new KviThreadDataEvent<KviCString>(KVI_DCC_THREAD_EVENT_MESSAGE);
+	e->setData(new KviCString(message));
+	postEvent(e);
+}
+
+DccReactor::DccReactor()
+    : KviSensitiveThread()
+{
+	m_pNewHandlers = new KviPointerList<DccReactorHandler>;
+	m_pNewHandlers->setAutoDelete(false);
+	m_uNextId = 1;
+	m_clock.start();
+
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+	// if this fails we fall back to select()
+	m_iEpoll = epoll_create1(EPOLL_CLOEXEC);
+#endif
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	// The wake up pipe: the reactor sleeps until something happens
+	// on the sockets, the GUI thread writes here to interrupt the wait
+	if(pipe(m_fdWakeUp) == 0)
+	{
+		for(auto fd : m_fdWakeUp)
+		{
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+		if(m_iEpoll >= 0)
+		{
+			struct epoll_event ev;
+			ev.events = EPOLLIN;
+			ev.data.u64 = 0; // no handler has id 0
+			epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, m_fdWakeUp[0], &ev);
+		}
+#endif
+	}
+	else
+	{
+		m_fdWakeUp[0] = -1;
+		m_fdWakeUp[1] = -1;
+	}
+#endif
+}
+
+DccReactor::~DccReactor()
+{
+	shutdown();
+
+	// the owners of the handlers must have removed them
+	KVI_ASSERT(m_hHandlers.isEmpty());
+	KVI_ASSERT(m_pNewHandlers->isEmpty());
+	delete m_pNewHandlers;
+
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+	if(m_iEpoll >= 0)
+		close(m_iEpoll);
+#endif
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	if(m_fdWakeUp[0] >= 0)
+	{
+		close(m_fdWakeUp[0]);
+		close(m_fdWakeUp[1]);
+	}
+#endif
+}
+
+const char * DccReactor::backendName() const
+{
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+	if(m_iEpoll >= 0)
+		return "epoll";
+#endif
+	return "select";
+}
+
+void DccReactor::shutdown()
+{
+	enqueueEvent(new KviThreadEvent(KVI_THREAD_EVENT_TERMINATE));
+	wakeUp();
+	wait();
+}
+
+void DccReactor::wakeUp()
+{
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	if(m_fdWakeUp[1] >= 0)
+	{
+		char c = 0;
+		// if the pipe is full the reactor is going to wake up anyway
+		if(write(m_fdWakeUp[1], &c, 1) < 1)
+			return;
+	}
+#endif
+}
+
+void DccReactor::add(DccReactorHandler * h)
+{
+	m_mutex.lock();
+	m_pNewHandlers->append(h);
+	m_mutex.unlock();
+
+	// the thread runs only once there is something to do
+	if(!(isRunning() || isStartingUp()))
+		start();
+	wakeUp();
+}
+
+void DccReactor::remove(DccReactorHandler * h)
+{
+	// m_mutex is held by the reactor while the handlers run:
+	// when we get it the handler is not in the middle of process()
+	m_mutex.lock();
+	if(m_pNewHandlers->removeRef(h))
+		h->finish();
+	else if(h->m_uId != 0)
+		retire(h);
+	m_mutex.unlock();
+}
+
+void DccReactor::updateWatch(DccReactorHandler * h)
+{
+	// m_mutex must be locked
+	bool bRead = h->m_bWantRead;
+	bool bWrite = h->m_bWantWrite;
+	if((bRead == h->m_bWatchingRead) && (bWrite == h->m_bWatchingWrite))
+		return;
+
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+	if(m_iEpoll >= 0)
+	{
+		// A socket that nobody watches is removed from the set: the level
+		// triggered EPOLLHUP would be reported even with no events requested
+		int iOp;
+		if(!(bRead || bWrite))
+			iOp = EPOLL_CTL_DEL;
+		else if(h->m_bWatchingRead || h->m_bWatchingWrite)
+			iOp = EPOLL_CTL_MOD;
+		else
+			iOp = EPOLL_CTL_ADD;
+
+		struct epoll_event ev;
+		ev.events = (bRead ? EPOLLIN : 0) | (bWrite ? EPOLLOUT : 0);
+		ev.data.u64 = h->m_uId;
+		if((epoll_ctl(m_iEpoll, iOp, h->m_fd, &ev) != 0) && (iOp != EPOLL_CTL_DEL))
+		{
+			// a broken socket: let the handler find out the error by itself
+			h->m_iWakeUpTime = m_clock.elapsed();
+		}
+	}
+#endif
+
+	h->m_bWatchingRead = bRead;
+	h->m_bWatchingWrite = bWrite;
+}
+
+void DccReactor::rearm(DccReactorHandler * h)
+{
+	// m_mutex must be locked
+	h->m_iWakeUpTime = (h->m_iTimeout >= 0) ? m_clock.elapsed() + h->m_iTimeout : -1;
+	updateWatch(h);
+}
+
+void DccReactor::retire(DccReactorHandler * h)
+{
+	// m_mutex must be locked
+	h->m_bWantRead = false;
+	h->m_bWantWrite = false;
+	updateWatch(h); // before the socket is closed
+	m_hHandlers.remove(h->m_uId);
+	h->m_uId = 0;
+	h->m_iWakeUpTime = -1;
+	h->finish();
+}
+
+void DccReactor::dispatch(DccReactorHandler * h, bool bCanRead, bool bCanWrite)
+{
+	// m_mutex must be locked
+#ifdef COMPILE_SSL_SUPPORT
+	if(h->m_bWantRead && h->m_pSSL && (h->m_pSSL->pending() > 0))
+		bCanRead = true;
+#endif
+	h->m_iTimeout = -1;
+	if(!h->process(bCanRead, bCanWrite))
+	{
+		retire(h);
+		return;
+	}
+	rearm(h);
+}
+
+void DccReactor::startNewHandlers()
+{
+	// m_mutex must be locked
+	while(DccReactorHandler * h = m_pNewHandlers->first())
+	{
+		m_pNewHandlers->removeFirst();
+
+		while((m_uNextId == 0) || m_hHandlers.contains(m_uNextId))
+			m_uNextId++;
+		h->m_uId = m_uNextId++;
+		m_hHandlers.insert(h->m_uId, h);
+
+		h->m_iTimeout = -1;
+		if(!h->start())
+		{
+			retire(h);
+			continue;
+		}
+		rearm(h);
+	}
+}
+
+void DccReactor::processTimeouts()
+{
+	// m_mutex must be locked
+	qint64 iNow = m_clock.elapsed();
+
+	// the handlers may retire while we run them: collect the ids first
+	std::vector<unsigned int> expired;
+	for(auto h : m_hHandlers)
+	{
+		if((h->m_iWakeUpTime >= 0) && (h->m_iWakeUpTime <= iNow))
+			expired.push_back(h->m_uId);
+	}
+
+	for(auto uId : expired)
+	{
+		DccReactorHandler * h = m_hHandlers.value(uId, nullptr);
+		if(h)
+			dispatch(h, false, false);
+	}
+}
+
+int DccReactor::nextTimeout()
+{
+	// m_mutex must be locked
+	qint64 iNow = m_clock.elapsed();
+	qint64 iTimeout = -1;
+	for(auto h : m_hHandlers)
+	{
+		if(h->m_iWakeUpTime < 0)
+			continue;
+		qint64 iLeft = h->m_iWakeUpTime - iNow;
+		if(iLeft < 0)
+			iLeft = 0;
+		if((iTimeout < 0) || (iLeft < iTimeout))
+			iTimeout = iLeft;
+	}
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	if(m_fdWakeUp[0] >= 0)
+		return (int)iTimeout; // may wait forever: wakeUp() interrupts the wait
+#endif
+	// no way to interrupt the wait: poll for the new handlers and the termination
+	if((iTimeout < 0) || (iTimeout > KVI_DCC_REACTOR_MAX_WAIT_MSECS))
+		iTimeout = KVI_DCC_REACTOR_MAX_WAIT_MSECS;
+	return (int)iTimeout;
+}
+
+void DccReactor::waitForEvents(int iTimeoutMSecs)
+{
+	m_Ready.clear();
+
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+	if(m_iEpoll >= 0)
+	{
+		// the kernel keeps the interest set: nothing to lock here
+		struct epoll_event events[KVI_DCC_REACTOR_MAX_EVENTS];
+		int iCount = epoll_wait(m_iEpoll, events, KVI_DCC_REACTOR_MAX_EVENTS, iTimeoutMSecs);
+		bool bWokenUp = false;
+		for(int i = 0; i < iCount; i++)
+		{
+			if(events[i].data.u64 == 0)
+			{
+				bWokenUp = true;
+				continue;
+			}
+			// errors and hangups are found out by the next read or write
+			bool bError = events[i].events & (EPOLLERR | EPOLLHUP);
+			ReadyHandler r;
+			r.uId = (unsigned int)events[i].data.u64;
+			r.bCanRead = (events[i].events & EPOLLIN) || bError;
+			r.bCanWrite = (events[i].events & EPOLLOUT) || bError;
+			m_Ready.push_back(r);
+		}
+		if(bWokenUp)
+		{
+			char buffer[64];
+			while(read(m_fdWakeUp[0], buffer, sizeof(buffer)) > 0)
+			{
+			}
+		}
+		return;
+	}
+#endif
+
+	fd_set rs;
+	fd_set ws;
+	FD_ZERO(&rs);
+	FD_ZERO(&ws);
+	int iMaxFd = -1;
+
+	// select() needs the interest set each time
+	m_Selected.clear();
+	m_mutex.lock();
+	for(auto h : m_hHandlers)
+	{
+		if(!(h->m_bWatchingRead || h->m_bWatchingWrite))
+			continue;
+		if(h->m_bWatchingRead)
+			FD_SET(h->m_fd, &rs);
+		if(h->m_bWatchingWrite)
+			FD_SET(h->m_fd, &ws);
+		if((int)h->m_fd > iMaxFd)
+			iMaxFd = (int)h->m_fd;
+		SelectedHandler s;
+		s.uId = h->m_uId;
+		s.fd = h->m_fd;
+		m_Selected.push_back(s);
+	}
+	m_mutex.unlock();
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	if(m_fdWakeUp[0] >= 0)
+	{
+		FD_SET(m_fdWakeUp[0], &rs);
+		if(m_fdWakeUp[0] > iMaxFd)
+			iMaxFd = m_fdWakeUp[0];
+	}
+#endif
+
+	if(iMaxFd < 0)
+	{
+		// nothing to watch (and no wake up pipe)
+		if(iTimeoutMSecs > 0)
+			msleep(iTimeoutMSecs);
+		return;
+	}
+
+	struct timeval tv;
+	tv.tv_sec = iTimeoutMSecs / 1000;
+	tv.tv_usec = (iTimeoutMSecs % 1000) * 1000;
+
+	// a socket closed by remove() while we wait makes this fail: just retry
+	if(kvi_socket_select(iMaxFd + 1, &rs, &ws, nullptr, (iTimeoutMSecs < 0) ? nullptr : &tv) < 1)
+		return;
+
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	if((m_fdWakeUp[0] >= 0) && FD_ISSET(m_fdWakeUp[0], &rs))
+	{
+		char buffer[64];
+		while(read(m_fdWakeUp[0], buffer, sizeof(buffer)) > 0)
+		{
+		}
+	}
+#endif
+
+	for(auto & s : m_Selected)
+	{
+		ReadyHandler r;
+		r.uId = s.uId;
+		r.bCanRead = FD_ISSET(s.fd, &rs);
+		r.bCanWrite = FD_ISSET(s.fd, &ws);
+		if(r.bCanRead || r.bCanWrite)
+			m_Ready.push_back(r);
+	}
+}
+
+void DccReactor::run()
+{
+	for(;;)
+	{
+		while(KviThreadEvent * e = dequeueEvent())
+		{
+			int iId = e->id();
+			delete e;
+			if(iId == KVI_THREAD_EVENT_TERMINATE)
+				return; // the handlers left are removed by their owners
+		}
+
+		m_mutex.lock();
+		startNewHandlers();
+		processTimeouts();
+		int iTimeout = nextTimeout();
+		m_mutex.unlock();
+
+		waitForEvents(iTimeout);
+
+		m_mutex.lock();
+		for(auto & r : m_Ready)
+		{
+			// the handler may have been removed (and the id forgotten) during the wait
+			DccReactorHandler * h = m_hHandlers.value(r.uId, nullptr);
+			if(!h)
+				continue;
+			bool bCanRead = r.bCanRead && h->m_bWatchingRead;
+			bool bCanWrite = r.bCanWrite && h->m_bWatchingWrite;
+			if(bCanRead || bCanWrite)
+				dispatch(h, bCanRead, bCanWrite);
+		}
+		m_mutex.unlock();
+	}
+}
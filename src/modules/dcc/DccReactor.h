@@ -0,0 +1,186 @@
+#ifndef _DCCREACTOR_H_
+#define _DCCREACTOR_H_
+//=============================================================================
+//
+//   File : DccReactor.h
+//   Creation date : Sun Oct 18 2026 17:40:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "kvi_settings.h"
+#include "KviThread.h"
+#include "kvi_sockettype.h"
+#include "KviPointerList.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <vector>
+
+#ifdef COMPILE_SSL_SUPPORT
+#include "KviSSL.h"
+#endif
+
+#ifdef Q_OS_LINUX
+#define KVI_DCC_REACTOR_USE_EPOLL
+#endif
+
+// The longest wait of the reactor: where the wake up pipe is missing
+// (Windows) this is also the latency of the new handlers and of the shutdown
+#define KVI_DCC_REACTOR_MAX_WAIT_MSECS 100
+
+// The events returned by a single epoll_wait() call
+#define KVI_DCC_REACTOR_MAX_EVENTS 64
+
+class QEvent;
+class QObject;
+
+//
+// DccReactorHandler
+//
+//    A job driven by the reactor: a non blocking state machine on a socket.
+//    The reactor calls process() when the socket is ready for what the
+//    handler watches or when its timeout expires. process() must not block
+//    and should end with a watch() call telling what the next call waits for.
+//    The handlers talk to their parent QObject with the DccThread events.
+//
+
+class DccReactorHandler
+{
+	friend class DccReactor;
+
+public:
+	DccReactorHandler(QObject * par, kvi_socket_t fd);
+	virtual ~DccReactorHandler();
+
+protected:
+	KviMutex * m_pMutex; // OWNED! Protects the data shared with the GUI thread
+	kvi_socket_t m_fd;
+	QObject * m_pParent; // READ ONLY!
+#ifdef COMPILE_SSL_SUPPORT
+	KviSSL * m_pSSL;
+#endif
+private:
+	// managed by the reactor
+	unsigned int m_uId; // 0 when not running
+	bool m_bWantRead;
+	bool m_bWantWrite;
+	int m_iTimeout; // requested by the last watch(), -1 for none
+	bool m_bWatchingRead;
+	bool m_bWatchingWrite;
+	qint64 m_iWakeUpTime; // on the reactor clock, -1 for none
+
+public:
+	QObject * parent() { return m_pParent; };
+#ifdef COMPILE_SSL_SUPPORT
+	void setSSL(KviSSL * s);
+	KviSSL * getSSL() const { return m_pSSL; };
+#endif
+
+protected:
+	// reactor thread: called once, before the first process(). Returns false if the job is already over
+	virtual bool start() = 0;
+	// reactor thread: returns false when the job is over
+	virtual bool process(bool bCanRead, bool bCanWrite) = 0;
+	// releases the socket and the other resources. Called in the reactor
+	// thread when the job is over or by DccReactor::remove() in the GUI thread
+	virtual void finish();
+	// the next process() call happens when the socket is ready for the
+	// requested operations or after iTimeoutMSecs (-1 for no timeout)
+	void watch(bool bRead, bool bWrite, int iTimeoutMSecs = -1);
+
+	bool handleInvalidSocketRead(int readLen);
+	void postEvent(QEvent * e);
+	void postErrorEvent(int err);
+	// Warning!..newer call __tr() here!...use __tr_no_lookup()
+	void postMessageEvent(const char * message);
+#ifdef COMPILE_SSL_SUPPORT
+	void raiseSSLError();
+#endif
+};
+
+//
+// DccReactor
+//
+//    A single thread that runs all the DCC file transfers.
+//    It waits for the readiness of their sockets with epoll() on Linux and
+//    with select() elsewhere, then runs the handlers of the ready ones.
+//    The handlers are added and removed by the GUI thread: remove() is
+//    synchronous, so the handler can be deleted as soon as it returns.
+//
+
+class DccReactor : public KviSensitiveThread
+{
+public:
+	DccReactor();
+	~DccReactor();
+
+private:
+	KviMutex m_mutex; // held while the handlers run: protects everything below
+	QHash<unsigned int, DccReactorHandler *> m_hHandlers; // the running ones, by id
+	KviPointerList<DccReactorHandler> * m_pNewHandlers;   // waiting for start(), not owned
+	unsigned int m_uNextId;
+	QElapsedTimer m_clock;
+#ifdef KVI_DCC_REACTOR_USE_EPOLL
+	int m_iEpoll;
+#endif
+#if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
+	int m_fdWakeUp[2];
+#endif
+	struct ReadyHandler
+	{
+		unsigned int uId;
+		bool bCanRead;
+		bool bCanWrite;
+	};
+	std::vector<ReadyHandler> m_Ready; // reactor thread only
+	struct SelectedHandler
+	{
+		unsigned int uId;
+		kvi_socket_t fd;
+	};
+	std::vector<SelectedHandler> m_Selected; // the select() interest set, reactor thread only
+
+public:
+	// GUI thread: the handler starts running in the reactor thread. It's not owned
+	void add(DccReactorHandler * h);
+	// GUI thread: stops the handler (if not over yet) and calls its finish()
+	void remove(DccReactorHandler * h);
+	// the handlers post their events through this
+	void post(QObject * o, QEvent * e) { postEvent(o, e); };
+	// "epoll" or "select"
+	const char * backendName() const;
+
+protected:
+	virtual void run();
+	void shutdown();
+	void wakeUp();
+	void waitForEvents(int iTimeoutMSecs);
+	void dispatch(DccReactorHandler * h, bool bCanRead, bool bCanWrite);
+	void startNewHandlers();
+	void processTimeouts();
+	int nextTimeout();
+	// m_mutex must be locked
+	void updateWatch(DccReactorHandler * h);
+	void rearm(DccReactorHandler * h);
+	void retire(DccReactorHandler * h);
+};
+
+#endif //_DCCREACTOR_H_
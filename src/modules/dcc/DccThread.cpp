@@ -35,6 +35,106 @@
 #include "KviSSLMaster.h"
 #endif
 
+DccBandwidthBucket::DccBandwidthBucket()
+{
+	m_uRate = MAX_DCC_BANDWIDTH_LIMIT;
+	m_iTokens = 0;
+	m_timer.start();
+	m_iLastRefill = 0;
+}
+
+qint64 DccBandwidthBucket::capacity() const
+{
+	qint64 iCapacity = m_uRate / 4;
+	return iCapacity < KVI_DCC_BUCKET_MIN_CHUNK ? KVI_DCC_BUCKET_MIN_CHUNK : iCapacity;
+}
+
+void DccBandwidthBucket::setRate(unsigned int uRate)
+{
+	if(uRate == m_uRate)
+		return;
+	if(unlimited())
+	{
+		// start with a full bucket
+		m_uRate = uRate;
+		m_iTokens = capacity();
+		m_iLastRefill = m_timer.nsecsElapsed();
+		return;
+	}
+	refill(); // account the time spent at the old rate
+	m_uRate = uRate;
+	if(m_iTokens > capacity())
+		m_iTokens = capacity();
+}
+
+void DccBandwidthBucket::refill()
+{
+	qint64 iNow = m_timer.nsecsElapsed();
+	qint64 iElapsed = iNow - m_iLastRefill;
+
+	if((m_uRate == 0) || (iElapsed >= 1000000000))
+	{
+		// nothing to add or anything fills the bucket
+		if(m_uRate > 0)
+			m_iTokens = capacity();
+		m_iLastRefill = iNow;
+		return;
+	}
+
+	qint64 iAdd = (iElapsed * m_uRate) / 1000000000;
+	if(iAdd < 1)
+		return; // keep the elapsed time for the next call
+
+	m_iTokens += iAdd;
+	// advance only by the time actually converted to tokens: no rounding losses
+	m_iLastRefill += (iAdd * 1000000000) / m_uRate;
+
+	if(m_iTokens >= capacity())
+	{
+		m_iTokens = capacity();
+		m_iLastRefill = iNow;
+	}
+}
+
+unsigned int DccBandwidthBucket::available(unsigned int uMax)
+{
+	if(unlimited())
+		return uMax;
+	refill();
+	if(m_iTokens < KVI_DCC_BUCKET_MIN_CHUNK)
+		return 0; // don't waste syscalls for a handful of bytes
+	return m_iTokens < uMax ? (unsigned int)m_iTokens : uMax;
+}
+
+void DccBandwidthBucket::consume(unsigned int uBytes)
+{
+	if(!unlimited())
+		m_iTokens -= uBytes;
+}
+
+void DccBandwidthBucket::refund(unsigned int uBytes)
+{
+	if(unlimited())
+		return;
+	m_iTokens += uBytes;
+	if(m_iTokens > capacity())
+		m_iTokens = capacity();
+}
+
+int DccBandwidthBucket::msecsUntilAvailable()
+{
+	if(unlimited())
+		return 0;
+	if(m_uRate == 0)
+		return KVI_DCC_THREAD_MAX_WAIT_MSECS; // paused
+	refill();
+	qint64 iMissing = KVI_DCC_BUCKET_MIN_CHUNK - m_iTokens;
+	if(iMissing <= 0)
+		return 0;
+	qint64 iMSecs = ((iMissing * 1000) / m_uRate) + 1;
+	return iMSecs > KVI_DCC_THREAD_MAX_WAIT_MSECS ? KVI_DCC_THREAD_MAX_WAIT_MSECS : (int)iMSecs;
+}
+
 DccThread::DccThread(QObject * par, kvi_socket_t fd)
     : KviSensitiveThread()
 {
@@ -91,6 +191,56 @@ bool DccThread::handleInvalidSocketRead(int readLen)
 	return true; // continue
 }
 
+bool DccThread::waitForSocket(bool bRead, bool bWrite, int iTimeoutMSecs, bool * pbCanRead, bool * pbCanWrite)
+{
+	*pbCanRead = false;
+	*pbCanWrite = false;
+
+	// don't wait too long: the termination requests are checked between the waits
+	if(iTimeoutMSecs > KVI_DCC_THREAD_MAX_WAIT_MSECS)
+		iTimeoutMSecs = KVI_DCC_THREAD_MAX_WAIT_MSECS;
+	if(iTimeoutMSecs < 0)
+		iTimeoutMSecs = 0;
+
+#ifdef COMPILE_SSL_SUPPORT
+	// the SSL layer may already hold decrypted data that select() can't see
+	if(bRead && m_pSSL && (m_pSSL->pending() > 0))
+	{
+		*pbCanRead = true;
+		return true;
+	}
+#endif
+
+	if(!(bRead || bWrite))
+	{
+		// nothing to watch: just wait
+		if(iTimeoutMSecs > 0)
+			msleep(iTimeoutMSecs);
+		return false;
+	}
+
+	fd_set rs;
+	fd_set ws;
+	FD_ZERO(&rs);
+	FD_ZERO(&ws);
+	if(bRead)
+		FD_SET(m_fd, &rs);
+	if(bWrite)
+		FD_SET(m_fd, &ws);
+
+	struct timeval tv;
+	tv.tv_sec = iTimeoutMSecs / 1000;
+	tv.tv_usec = (iTimeoutMSecs % 1000) * 1000;
+
+	int iRet = select(m_fd + 1, bRead ? &rs : nullptr, bWrite ? &ws : nullptr, nullptr, &tv);
+	if(iRet < 1)
+		return false; // timeout or EINTR
+
+	*pbCanRead = bRead && FD_ISSET(m_fd, &rs);
+	*pbCanWrite = bWrite && FD_ISSET(m_fd, &ws);
+	return true;
+}
+
 #ifdef COMPILE_SSL_SUPPORT
 void DccThread::raiseSSLError()
 {
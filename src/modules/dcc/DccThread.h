@@ -29,6 +29,7 @@
 #include "kvi_sockettype.h"
 #include "KviPointerList.h"
 
+#include <QElapsedTimer>
 #include <QObject>
 
 #ifdef COMPILE_SSL_SUPPORT
@@ -46,12 +47,60 @@
 // KviThreadDataEvent<int>
 #define KVI_DCC_THREAD_EVENT_ACTION (KVI_THREAD_USER_EVENT_BASE + 5)
 
+// A bandwidth limit equal or greater than this means "no limit".
+// This limit, when multiplied by INSTANT_BANDWIDTH_CHECK_INTERVAL_IN_SECS
+// must fit in 31 bits (0x7fffffff)! (because of data size limits)
+#define MAX_DCC_BANDWIDTH_LIMIT 0x1fffffff
+
+// The transfer threads check for the termination requests at least this often
+#define KVI_DCC_THREAD_MAX_WAIT_MSECS 100
+
+// The smallest amount of data worth a read or a write when the bandwidth is limited
+#define KVI_DCC_BUCKET_MIN_CHUNK 512
+
 typedef struct _KviDccThreadIncomingData
 {
 	int iLen;
 	char * buffer;
 } KviDccThreadIncomingData;
 
+//
+// DccBandwidthBucket
+//
+//    A token bucket that enforces the bandwidth limit of a transfer.
+//    The bucket refills continuously at the limit rate and holds at most
+//    a quarter of second of data: the thread transfers what the bucket
+//    allows and, when it is empty, waits exactly until it refills.
+//
+
+class DccBandwidthBucket
+{
+public:
+	DccBandwidthBucket();
+
+private:
+	unsigned int m_uRate; // bytes per second
+	qint64 m_iTokens;
+	qint64 m_iLastRefill; // nsecs
+	QElapsedTimer m_timer;
+
+public:
+	void setRate(unsigned int uRate);
+	unsigned int rate() const { return m_uRate; };
+	bool unlimited() const { return m_uRate >= MAX_DCC_BANDWIDTH_LIMIT; };
+	// returns the number of bytes that can be transferred now (at most uMax), 0 if the caller must wait
+	unsigned int available(unsigned int uMax);
+	void consume(unsigned int uBytes);
+	// gives back tokens that have been consumed but not used
+	void refund(unsigned int uBytes);
+	// the time to wait before available() returns something
+	int msecsUntilAvailable();
+	qint64 capacity() const;
+
+protected:
+	void refill();
+};
+
 class DccThread : public KviSensitiveThread
 {
 public:
@@ -67,6 +116,9 @@ protected:
 #endif
 protected:
 	bool handleInvalidSocketRead(int readLen);
+	// Waits until the socket is ready for the requested operations (or the timeout expires).
+	// The timeout is capped to KVI_DCC_THREAD_MAX_WAIT_MSECS. Returns false on timeout.
+	bool waitForSocket(bool bRead, bool bWrite, int iTimeoutMSecs, bool * pbCanRead, bool * pbCanWrite);
 
 public:
 	QObject * parent() { return m_pParent; };
@@ -30,6 +30,9 @@
 #endif
 #include "DccUtils.h"
 #include "DccFileTransfer.h"
+#include "DccBandwidthScheduler.h"
+#include "DccReactor.h"
+#include "DccBenchmark.h"
 #include "DccWindow.h"
 
 #include "kvi_debug.h"
@@ -61,6 +64,8 @@
 //extern KVIRC_API KviSharedFilesManager * g_pSharedFilesManager;
 
 DccBroker * g_pDccBroker = nullptr;
+extern DccBandwidthScheduler * g_pDccBandwidthScheduler;
+extern DccReactor * g_pDccReactor;
 
 static void dcc_module_set_dcc_type(DccDescriptor * d, const char * szBaseType)
 {
@@ -1720,6 +1725,312 @@ static bool dcc_kvs_cmd_setBandwidthLimit(KviKvsModuleCommandCall * c)
 	return true;
 }
 
+/*
+	@doc: dcc.setBandwidthWeight
+	@type:
+		command
+	@title:
+		dcc.setBandwidthWeight
+	@short:
+		Sets the share of the bandwidth of a DCC file transfer
+	@syntax:
+		dcc.setBandwidthWeight [-q] <weight:uint> [dcc_id:uint]
+	@description:
+		Sets the weight of the DCC file transfer specified by <dcc_id>.[br]
+		The file transfers that are limited by the same [cmd]dcc.setGlobalBandwidthLimit[/cmd]
+		or [cmd]dcc.setNickBandwidthLimit[/cmd] limit share the bandwidth in proportion
+		to their weights: a transfer with weight 2 gets twice the bandwidth of a transfer with weight 1.
+		The default weight is 1.[br]
+		If <dcc_id> is omitted then the DCC Session associated
+		with the current window is assumed.[br]
+		If <dcc_id> is not a valid DCC session identifier (or it is omitted
+		and the current window has no associated DCC session) then
+		this function prints a warning unless the -q switch is used.[br]
+		If <dcc_id> does not refer to a file transfer a warning will be printed unless the -q switch is used.[br]
+		See the [module:dcc]dcc module[/module] documentation for more information.[br]
+	@seealso:
+		[cmd]dcc.setBandwidthLimit[/cmd], [cmd]dcc.setGlobalBandwidthLimit[/cmd]
+*/
+static bool dcc_kvs_cmd_setBandwidthWeight(KviKvsModuleCommandCall * c)
+{
+	kvs_uint_t uDccId, uWeight;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("weight", KVS_PT_UINT, 0, uWeight)
+	KVSM_PARAMETER("dcc_id", KVS_PT_UINT, KVS_PF_OPTIONAL, uDccId)
+	KVSM_PARAMETERS_END(c)
+
+	DccDescriptor * dcc = dcc_kvs_find_dcc_descriptor(uDccId, c, !c->switches()->find('q', "quiet"));
+	if(dcc)
+	{
+		if(dcc->transfer())
+			dcc->transfer()->setBandwidthWeight(uWeight);
+		else if(!c->switches()->find('q', "quiet"))
+			c->warning(__tr2qs_ctx("This DCC session is not a DCC transfer session", "dcc"));
+	}
+	return true;
+}
+
+// 0 means "no limit" in the scripting interface
+static unsigned int dcc_kvs_bandwidth_limit(kvs_uint_t uLimit)
+{
+	return ((uLimit == 0) || (uLimit >= MAX_DCC_BANDWIDTH_LIMIT)) ? MAX_DCC_BANDWIDTH_LIMIT : (unsigned int)uLimit;
+}
+
+static kvs_uint_t dcc_kvs_bandwidth_limit_value(unsigned int uLimit)
+{
+	return uLimit >= MAX_DCC_BANDWIDTH_LIMIT ? 0 : uLimit;
+}
+
+/*
+	@doc: dcc.setGlobalBandwidthLimit
+	@type:
+		command
+	@title:
+		dcc.setGlobalBandwidthLimit
+	@short:
+		Limits the total bandwidth used by the DCC file transfers
+	@syntax:
+		dcc.setGlobalBandwidthLimit [-d] <limit_value:uint>
+	@switches:
+		!sw: -d | --download
+		Sets the limit of the incoming transfers instead of the outgoing ones
+	@description:
+		Limits the total bandwidth (in bytes per second) used by all the outgoing
+		DCC file transfers, or by all the incoming ones if the -d switch is used.[br]
+		The transfers share the bandwidth according to their weights (see [cmd]dcc.setBandwidthWeight[/cmd]).
+		The limit of each single transfer set by [cmd]dcc.setBandwidthLimit[/cmd] still applies.[br]
+		A limit of 0 removes the limit.[br]
+		The change is applied immediately to the running transfers.[br]
+	@examples:
+		[example]
+			[comment]# keep some upload bandwidth for IRC[/comment]
+			dcc.setGlobalBandwidthLimit 40000
+		[/example]
+	@seealso:
+		[cmd]dcc.setNickBandwidthLimit[/cmd], [fnc]$dcc.globalBandwidthLimit[/fnc], [fnc]$dcc.globalSpeed[/fnc]
+*/
+static bool dcc_kvs_cmd_setGlobalBandwidthLimit(KviKvsModuleCommandCall * c)
+{
+	kvs_uint_t uVal;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("limit_value", KVS_PT_UINT, 0, uVal)
+	KVSM_PARAMETERS_END(c)
+
+	DccBandwidthScheduler::Direction d = c->switches()->find('d', "download") ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+	g_pDccBandwidthScheduler->setGlobalLimit(d, dcc_kvs_bandwidth_limit(uVal));
+	return true;
+}
+
+/*
+	@doc: dcc.setNickBandwidthLimit
+	@type:
+		command
+	@title:
+		dcc.setNickBandwidthLimit
+	@short:
+		Limits the bandwidth used by the DCC file transfers with a nickname
+	@syntax:
+		dcc.setNickBandwidthLimit [-d] <nickname:string> <limit_value:uint>
+	@switches:
+		!sw: -d | --download
+		Sets the limit of the incoming transfers instead of the outgoing ones
+	@description:
+		Limits the total bandwidth (in bytes per second) used by all the outgoing
+		DCC file transfers with <nickname>, or by all the incoming ones if the -d switch is used.[br]
+		It applies to the current and to the future transfers with <nickname>
+		and works inside the global limit set by [cmd]dcc.setGlobalBandwidthLimit[/cmd].[br]
+		A limit of 0 removes the limit.[br]
+	@seealso:
+		[cmd]dcc.setGlobalBandwidthLimit[/cmd], [fnc]$dcc.nickBandwidthLimit[/fnc], [fnc]$dcc.nickSpeed[/fnc]
+*/
+static bool dcc_kvs_cmd_setNickBandwidthLimit(KviKvsModuleCommandCall * c)
+{
+	QString szNick;
+	kvs_uint_t uVal;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("nickname", KVS_PT_NONEMPTYSTRING, 0, szNick)
+	KVSM_PARAMETER("limit_value", KVS_PT_UINT, 0, uVal)
+	KVSM_PARAMETERS_END(c)
+
+	DccBandwidthScheduler::Direction d = c->switches()->find('d', "download") ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+	g_pDccBandwidthScheduler->setNickLimit(d, szNick, dcc_kvs_bandwidth_limit(uVal));
+	return true;
+}
+
+/*
+	@doc: dcc.benchmark
+	@type:
+		command
+	@title:
+		dcc.benchmark
+	@short:
+		Measures the speed of the DCC file transfers on loopback sockets
+	@syntax:
+		dcc.benchmark [transfers:uint] [size:uint]
+	@description:
+		Runs <transfers> file transfers (4 by default) of <size> bytes each
+		(64 MiB by default) at the same time between pairs of local sockets,
+		then prints the time taken and the total throughput in the current window.[br]
+		The network is not involved: this measures the cost of the transfers themselves,
+		that all run in a single thread waiting on the sockets with epoll on Linux
+		and with select elsewhere.[br]
+		The transfers use the current packet size and the global bandwidth limits
+		(see [cmd]dcc.setGlobalBandwidthLimit[/cmd]): remove the limits to measure the raw speed.[br]
+		The files are written in the temporary directory and removed at the end.[br]
+	@examples:
+		[example]
+			[comment]# 64 transfers of 16 MiB[/comment]
+			dcc.benchmark 64 16777216
+		[/example]
+	@seealso:
+		[cmd]dcc.setGlobalBandwidthLimit[/cmd]
+*/
+static bool dcc_kvs_cmd_benchmark(KviKvsModuleCommandCall * c)
+{
+	kvs_uint_t uTransfers;
+	kvs_uint_t uSize;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("transfers", KVS_PT_UINT, KVS_PF_OPTIONAL, uTransfers)
+	KVSM_PARAMETER("size", KVS_PT_UINT, KVS_PF_OPTIONAL, uSize)
+	KVSM_PARAMETERS_END(c)
+
+	if(uTransfers == 0)
+		uTransfers = KVI_DCC_BENCHMARK_DEFAULT_TRANSFERS;
+	if(uTransfers > KVI_DCC_BENCHMARK_MAX_TRANSFERS)
+	{
+		c->warning(__tr2qs_ctx("Too many transfers: the maximum is %1", "dcc").arg(KVI_DCC_BENCHMARK_MAX_TRANSFERS));
+		uTransfers = KVI_DCC_BENCHMARK_MAX_TRANSFERS;
+	}
+	if(uSize == 0)
+		uSize = KVI_DCC_BENCHMARK_DEFAULT_SIZE;
+
+	DccBenchmark * b = new DccBenchmark(c->window(), uTransfers, uSize);
+	QString szError;
+	if(!b->start(szError))
+	{
+		delete b;
+		c->warning(szError);
+	}
+	return true;
+}
+
+/*
+	@doc: dcc.globalBandwidthLimit
+	@type:
+		function
+	@title:
+		$dcc.globalBandwidthLimit
+	@short:
+		Returns the limit of the total bandwidth of the DCC file transfers
+	@syntax:
+		<uint> $dcc.globalBandwidthLimit([flags:string])
+	@description:
+		Returns the limit (in bytes per second) of the total bandwidth used by the outgoing
+		DCC file transfers, or by the incoming ones if <flags> contains the letter [b]d[/b].[br]
+		Returns 0 if there is no limit.[br]
+	@seealso:
+		[cmd]dcc.setGlobalBandwidthLimit[/cmd]
+*/
+static bool dcc_kvs_fnc_globalBandwidthLimit(KviKvsModuleFunctionCall * c)
+{
+	QString szFlags;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("flags", KVS_PT_STRING, KVS_PF_OPTIONAL, szFlags)
+	KVSM_PARAMETERS_END(c)
+
+	DccBandwidthScheduler::Direction d = szFlags.contains('d', Qt::CaseInsensitive) ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+	c->returnValue()->setInteger(dcc_kvs_bandwidth_limit_value(g_pDccBandwidthScheduler->globalLimit(d)));
+	return true;
+}
+
+/*
+	@doc: dcc.nickBandwidthLimit
+	@type:
+		function
+	@title:
+		$dcc.nickBandwidthLimit
+	@short:
+		Returns the limit of the bandwidth of the DCC file transfers with a nickname
+	@syntax:
+		<uint> $dcc.nickBandwidthLimit(<nickname:string>[,flags:string])
+	@description:
+		Returns the limit (in bytes per second) of the total bandwidth used by the outgoing
+		DCC file transfers with <nickname>, or by the incoming ones if <flags> contains the letter [b]d[/b].[br]
+		Returns 0 if there is no limit.[br]
+	@seealso:
+		[cmd]dcc.setNickBandwidthLimit[/cmd]
+*/
+static bool dcc_kvs_fnc_nickBandwidthLimit(KviKvsModuleFunctionCall * c)
+{
+	QString szNick, szFlags;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("nickname", KVS_PT_NONEMPTYSTRING, 0, szNick)
+	KVSM_PARAMETER("flags", KVS_PT_STRING, KVS_PF_OPTIONAL, szFlags)
+	KVSM_PARAMETERS_END(c)
+
+	DccBandwidthScheduler::Direction d = szFlags.contains('d', Qt::CaseInsensitive) ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+	c->returnValue()->setInteger(dcc_kvs_bandwidth_limit_value(g_pDccBandwidthScheduler->nickLimit(d, szNick)));
+	return true;
+}
+
+/*
+	@doc: dcc.globalSpeed
+	@type:
+		function
+	@title:
+		$dcc.globalSpeed
+	@short:
+		Returns the total speed of the DCC file transfers
+	@syntax:
+		<uint> $dcc.globalSpeed([flags:string])
+	@description:
+		Returns the total speed (in bytes per second, measured over the last second)
+		of the outgoing DCC file transfers, or of the incoming ones if <flags> contains the letter [b]d[/b].[br]
+	@seealso:
+		[fnc]$dcc.nickSpeed[/fnc], [fnc]$dcc.currentSpeed[/fnc]
+*/
+static bool dcc_kvs_fnc_globalSpeed(KviKvsModuleFunctionCall * c)
+{
+	QString szFlags;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("flags", KVS_PT_STRING, KVS_PF_OPTIONAL, szFlags)
+	KVSM_PARAMETERS_END(c)
+
+	DccBandwidthScheduler::Direction d = szFlags.contains('d', Qt::CaseInsensitive) ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+	c->returnValue()->setInteger(g_pDccBandwidthScheduler->globalRate(d));
+	return true;
+}
+
+/*
+	@doc: dcc.nickSpeed
+	@type:
+		function
+	@title:
+		$dcc.nickSpeed
+	@short:
+		Returns the total speed of the DCC file transfers with a nickname
+	@syntax:
+		<uint> $dcc.nickSpeed(<nickname:string>[,flags:string])
+	@description:
+		Returns the total speed (in bytes per second, measured over the last second)
+		of the outgoing DCC file transfers with <nickname>, or of the incoming ones
+		if <flags> contains the letter [b]d[/b].[br]
+	@seealso:
+		[fnc]$dcc.globalSpeed[/fnc], [fnc]$dcc.currentSpeed[/fnc]
+*/
+static bool dcc_kvs_fnc_nickSpeed(KviKvsModuleFunctionCall * c)
+{
+	QString szNick, szFlags;
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("nickname", KVS_PT_NONEMPTYSTRING, 0, szNick)
+	KVSM_PARAMETER("flags", KVS_PT_STRING, KVS_PF_OPTIONAL, szFlags)
+	KVSM_PARAMETERS_END(c)
+
+	DccBandwidthScheduler::Direction d = szFlags.contains('d', Qt::CaseInsensitive) ? DccBandwidthScheduler::Download : DccBandwidthScheduler::Upload;
+	c->returnValue()->setInteger(g_pDccBandwidthScheduler->nickRate(d, szNick));
+	return true;
+}
+
 /*
 	@doc: dcc.protocol
 	@type:
@@ -2853,20 +3164,35 @@ static bool dcc_kvs_fnc_getSSLCertInfo(KviKvsModuleFunctionCall * c)
 			return true;
 		}
 
-		DccThread * pSlaveThread = nullptr;
+		// the chats run in their own thread, the file transfers in the reactor
+		KviSSL * pSSL = nullptr;
+		bool bInitialized = false;
 		if(dcc->window())
-			pSlaveThread = dcc->window()->getSlaveThread();
+		{
+			DccThread * pSlaveThread = dcc->window()->getSlaveThread();
+			if(pSlaveThread)
+			{
+				bInitialized = true;
+				pSSL = pSlaveThread->getSSL();
+			}
+		}
 		else if(dcc->transfer())
-			pSlaveThread = dcc->transfer()->getSlaveThread();
+		{
+			DccReactorHandler * pSlaveHandler = dcc->transfer()->getSlaveHandler();
+			if(pSlaveHandler)
+			{
+				bInitialized = true;
+				pSSL = pSlaveHandler->getSSL();
+			}
+		}
 
-		if(!pSlaveThread)
+		if(!bInitialized)
 		{
 			c->warning(__tr2qs_ctx("Unable to get SSL information: DCC session not initialized yet", "dcc"));
 			c->returnValue()->setString("");
 			return true;
 		}
 
-		KviSSL * pSSL = pSlaveThread->getSSL();
 		if(!pSSL)
 		{
 			c->warning(__tr2qs_ctx("Unable to get SSL information: SSL non initialized yet in DCC session", "dcc"));
@@ -2955,6 +3281,8 @@ static bool dcc_kvs_fnc_getSSLCertInfo(KviKvsModuleFunctionCall * c)
 static bool dcc_module_init(KviModule * m)
 {
 	g_pDccBroker = new DccBroker();
+	g_pDccBandwidthScheduler = new DccBandwidthScheduler();
+	g_pDccReactor = new DccReactor();
 
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "send", dcc_kvs_cmd_send);
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "chat", dcc_kvs_cmd_chat);
@@ -2965,6 +3293,10 @@ static bool dcc_module_init(KviModule * m)
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "get", dcc_kvs_cmd_get);
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "abort", dcc_kvs_cmd_abort);
 	KVSM_REGISTER_SIMPLE_COMMAND(m, "setBandwidthLimit", dcc_kvs_cmd_setBandwidthLimit);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "setBandwidthWeight", dcc_kvs_cmd_setBandwidthWeight);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "setGlobalBandwidthLimit", dcc_kvs_cmd_setGlobalBandwidthLimit);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "setNickBandwidthLimit", dcc_kvs_cmd_setNickBandwidthLimit);
+	KVSM_REGISTER_SIMPLE_COMMAND(m, "benchmark", dcc_kvs_cmd_benchmark);
 
 	// FIXME: file upload / download state ?
 
@@ -2990,6 +3322,10 @@ static bool dcc_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "remoteFileSize", dcc_kvs_fnc_remoteFileSize);
 	KVSM_REGISTER_FUNCTION(m, "averageSpeed", dcc_kvs_fnc_averageSpeed);
 	KVSM_REGISTER_FUNCTION(m, "currentSpeed", dcc_kvs_fnc_currentSpeed);
+	KVSM_REGISTER_FUNCTION(m, "globalBandwidthLimit", dcc_kvs_fnc_globalBandwidthLimit);
+	KVSM_REGISTER_FUNCTION(m, "globalSpeed", dcc_kvs_fnc_globalSpeed);
+	KVSM_REGISTER_FUNCTION(m, "nickBandwidthLimit", dcc_kvs_fnc_nickBandwidthLimit);
+	KVSM_REGISTER_FUNCTION(m, "nickSpeed", dcc_kvs_fnc_nickSpeed);
 	KVSM_REGISTER_FUNCTION(m, "transferredBytes", dcc_kvs_fnc_transferredBytes);
 	KVSM_REGISTER_FUNCTION(m, "ircContext", dcc_kvs_fnc_ircContext);
 	KVSM_REGISTER_FUNCTION(m, "session", dcc_kvs_fnc_session);
@@ -3003,6 +3339,12 @@ static bool dcc_module_cleanup(KviModule *)
 {
 	delete g_pDccBroker;
 	g_pDccBroker = nullptr;
+	DccBenchmark::abortAll();
+	// after the broker and the benchmarks: the transfers have been removed
+	delete g_pDccReactor;
+	g_pDccReactor = nullptr;
+	delete g_pDccBandwidthScheduler;
+	g_pDccBandwidthScheduler = nullptr;
 #ifdef COMPILE_USE_GSM
 	kvi_gsm_codec_done();
 #endif
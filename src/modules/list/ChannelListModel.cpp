@@ -0,0 +1,350 @@
+//=============================================================================
+//
+//   File : ChannelListModel.cpp
+//   Creation date : Sun Oct 18 2026 00:34:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ChannelListModel.h"
+
+#include "KviControlCodes.h"
+#include "KviHtmlGenerator.h"
+#include "KviLocale.h"
+#include "KviQString.h"
+
+#include <QStringRef>
+
+#include <algorithm>
+#include <vector>
+
+//
+// Orders the channel ids by the sort column of the model, then by id.
+// The channels and the topics are compared in lowercase, using the index.
+//
+class ChannelListLessThan
+{
+public:
+	ChannelListLessThan(const ChannelListModel * pModel)
+	    : m_pModel(pModel) {}
+
+private:
+	const ChannelListModel * m_pModel;
+
+	int compareFields(quint32 uField1, quint32 uField2) const
+	{
+		const ChannelListIndex & idx = m_pModel->m_Index;
+		QStringRef s1(&(idx.szText), idx.offsets.at(uField1), idx.offsets.at(uField1 + 1) - idx.offsets.at(uField1));
+		QStringRef s2(&(idx.szText), idx.offsets.at(uField2), idx.offsets.at(uField2 + 1) - idx.offsets.at(uField2));
+		return QStringRef::compare(s1, s2, Qt::CaseSensitive);
+	}
+
+public:
+	bool operator()(quint32 a, quint32 b) const
+	{
+		if(m_pModel->m_eSortOrder == Qt::DescendingOrder)
+			std::swap(a, b);
+
+		int iCmp = 0;
+		switch(m_pModel->m_iSortColumn)
+		{
+			case ChannelListModel::Channel:
+				iCmp = compareFields(2 * a, 2 * b);
+				break;
+			case ChannelListModel::Users:
+				iCmp = (m_pModel->m_Users.at(a) < m_pModel->m_Users.at(b)) ? -1 : (m_pModel->m_Users.at(a) > m_pModel->m_Users.at(b) ? 1 : 0);
+				break;
+			case ChannelListModel::Topic:
+				iCmp = compareFields((2 * a) + 1, (2 * b) + 1);
+				break;
+			default:
+				// not sorted: the order of arrival
+				break;
+		}
+		if(iCmp != 0)
+			return iCmp < 0;
+		return a < b;
+	}
+};
+
+ChannelListModel::ChannelListModel(QObject * pParent)
+    : QAbstractTableModel(pParent)
+{
+	m_TextOffsets.append(0);
+	m_Index.offsets.append(0);
+	m_uCommitted = 0;
+	m_bFiltered = false;
+	m_iSortColumn = Channel;
+	m_eSortOrder = Qt::AscendingOrder;
+}
+
+ChannelListModel::~ChannelListModel()
+    = default;
+
+void ChannelListModel::append(const QString & szChan, int iUsers, const QString & szTopic)
+{
+	m_szText.append(szChan);
+	m_TextOffsets.append(m_szText.size());
+	m_szText.append(szTopic);
+	m_TextOffsets.append(m_szText.size());
+
+	m_Users.append(iUsers);
+
+	// While the search thread holds a snapshot the first append copies the
+	// index: the snapshots are taken only when the list is flushed.
+	m_Index.szText.append(szChan.toLower());
+	m_Index.offsets.append(m_Index.szText.size());
+	m_Index.szText.append(KviControlCodes::stripControlBytes(szTopic).toLower());
+	m_Index.offsets.append(m_Index.szText.size());
+}
+
+unsigned int ChannelListModel::commit()
+{
+	unsigned int uFirst = m_uCommitted;
+	unsigned int uRows = m_Users.count();
+	if(uRows == uFirst)
+		return 0;
+
+	m_uCommitted = uRows;
+	m_Index.uRows = uRows;
+
+	if(!m_bFiltered)
+	{
+		QVector<quint32> ids;
+		ids.reserve(uRows - uFirst);
+		for(unsigned int u = uFirst; u < uRows; u++)
+			ids.append(u);
+		insertVisible(ids);
+	}
+
+	return uRows - uFirst;
+}
+
+void ChannelListModel::clear()
+{
+	beginResetModel();
+	m_szText.clear();
+	m_TextOffsets.clear();
+	m_TextOffsets.append(0);
+	m_Users.clear();
+
+	unsigned int uSerial = m_Index.uSerial + 1;
+	m_Index = ChannelListIndex();
+	m_Index.offsets.append(0);
+	m_Index.uSerial = uSerial;
+
+	m_uCommitted = 0;
+	m_Visible.clear();
+	endResetModel();
+}
+
+void ChannelListModel::showAll()
+{
+	QVector<quint32> ids;
+	ids.reserve(m_uCommitted);
+	for(unsigned int u = 0; u < m_uCommitted; u++)
+		ids.append(u);
+	m_bFiltered = false;
+	setVisible(ids);
+}
+
+void ChannelListModel::showOnly(const QVector<quint32> & ids)
+{
+	m_bFiltered = true;
+	setVisible(ids);
+}
+
+void ChannelListModel::setVisible(const QVector<quint32> & ids)
+{
+	// If the rows are only added (a shorter filter or more results for the
+	// same one) they are inserted, so the view keeps the selection and the
+	// scroll position. Otherwise the model is reset.
+	std::vector<bool> bShown(m_uCommitted, false);
+	for(auto u : m_Visible)
+		bShown[u] = true;
+
+	int iKept = 0;
+	QVector<quint32> added;
+	for(auto u : ids)
+	{
+		if(u >= m_uCommitted)
+			continue;
+		if(bShown[u])
+			iKept++;
+		else
+			added.append(u);
+	}
+
+	if(iKept == m_Visible.count())
+	{
+		insertVisible(added);
+		return;
+	}
+
+	beginResetModel();
+	m_Visible = ids;
+	if(!m_Visible.isEmpty() && (m_Visible.last() >= m_uCommitted))
+		m_Visible.erase(std::lower_bound(m_Visible.begin(), m_Visible.end(), m_uCommitted), m_Visible.end());
+	sortRange(0, m_Visible.count());
+	endResetModel();
+}
+
+ChannelListIndex ChannelListModel::searchIndex() const
+{
+	return m_Index;
+}
+
+QString ChannelListModel::textField(unsigned int uField) const
+{
+	return m_szText.mid(m_TextOffsets.at(uField), m_TextOffsets.at(uField + 1) - m_TextOffsets.at(uField));
+}
+
+void ChannelListModel::sortRange(int iBegin, int iEnd)
+{
+	std::sort(m_Visible.begin() + iBegin, m_Visible.begin() + iEnd, ChannelListLessThan(this));
+}
+
+void ChannelListModel::insertVisible(const QVector<quint32> & ids)
+{
+	if(ids.isEmpty())
+		return;
+
+	int iFirst = m_Visible.count();
+	beginInsertRows(QModelIndex(), iFirst, iFirst + ids.count() - 1);
+	m_Visible += ids;
+	endInsertRows();
+
+	// now move them in place
+	emit layoutAboutToBeChanged();
+	QModelIndexList lOld = persistentIndexList();
+	QVector<quint32> lIds;
+	for(auto & i : lOld)
+		lIds.append(m_Visible.at(i.row()));
+
+	sortRange(iFirst, m_Visible.count());
+	std::inplace_merge(m_Visible.begin(), m_Visible.begin() + iFirst, m_Visible.end(), ChannelListLessThan(this));
+
+	remapPersistentIndexes(lOld, lIds);
+	emit layoutChanged();
+}
+
+void ChannelListModel::remapPersistentIndexes(const QModelIndexList & lOld, const QVector<quint32> & lIds)
+{
+	if(lOld.isEmpty())
+		return;
+
+	QVector<int> rows(m_uCommitted, -1);
+	for(int i = 0; i < m_Visible.count(); i++)
+		rows[m_Visible.at(i)] = i;
+
+	QModelIndexList lNew;
+	for(int i = 0; i < lOld.count(); i++)
+	{
+		int iRow = rows.at(lIds.at(i));
+		lNew.append(iRow < 0 ? QModelIndex() : createIndex(iRow, lOld.at(i).column()));
+	}
+	changePersistentIndexList(lOld, lNew);
+}
+
+int ChannelListModel::rowCount(const QModelIndex & parent) const
+{
+	if(parent.isValid())
+		return 0;
+	return m_Visible.count();
+}
+
+int ChannelListModel::columnCount(const QModelIndex & parent) const
+{
+	if(parent.isValid())
+		return 0;
+	return 3;
+}
+
+QVariant ChannelListModel::data(const QModelIndex & index, int iRole) const
+{
+	if(!index.isValid() || (index.row() >= m_Visible.count()))
+		return QVariant();
+
+	unsigned int uId = m_Visible.at(index.row());
+	switch(iRole)
+	{
+		case Qt::DisplayRole:
+			switch(index.column())
+			{
+				case Channel:
+					return channel(uId);
+				case Users:
+					return QString::number(users(uId));
+				case Topic:
+					return KviControlCodes::stripControlBytes(topic(uId));
+			}
+			break;
+		case ColoredTopicRole:
+			return topic(uId);
+		case Qt::ToolTipRole:
+			switch(index.column())
+			{
+				case Channel:
+					return KviQString::toHtmlEscaped(channel(uId));
+				case Users:
+					return QString::number(users(uId));
+				case Topic:
+					return KviHtmlGenerator::convertToHtml(KviQString::toHtmlEscaped(topic(uId)));
+			}
+			break;
+		case Qt::TextAlignmentRole:
+			if(index.column() == Users)
+				return (int)Qt::AlignHCenter;
+			break;
+	}
+	return QVariant();
+}
+
+QVariant ChannelListModel::headerData(int iSection, Qt::Orientation eOrientation, int iRole) const
+{
+	if((eOrientation != Qt::Horizontal) || (iRole != Qt::DisplayRole))
+		return QVariant();
+
+	switch(iSection)
+	{
+		case Channel:
+			return __tr2qs("Channel");
+		case Users:
+			return __tr2qs("Users");
+		case Topic:
+			return __tr2qs("Topic");
+	}
+	return QVariant();
+}
+
+void ChannelListModel::sort(int iColumn, Qt::SortOrder eOrder)
+{
+	emit layoutAboutToBeChanged();
+	QModelIndexList lOld = persistentIndexList();
+	QVector<quint32> lIds;
+	for(auto & i : lOld)
+		lIds.append(m_Visible.at(i.row()));
+
+	m_iSortColumn = iColumn;
+	m_eSortOrder = eOrder;
+	sortRange(0, m_Visible.count());
+
+	remapPersistentIndexes(lOld, lIds);
+	emit layoutChanged();
+}
@@ -0,0 +1,156 @@
+#ifndef _CHANNELLISTMODEL_H_
+#define _CHANNELLISTMODEL_H_
+//=============================================================================
+//
+//   File : ChannelListModel.h
+//   Creation date : Sun Oct 18 2026 00:34:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <QVector>
+
+//
+// The searchable part of the list: the lowercase channel names and the
+// lowercase topics without control codes, stored one after the other.
+// The channel of the row i is [offsets[2i], offsets[2i + 1]) and its topic is
+// [offsets[2i + 1], offsets[2i + 2]).
+// The containers are implicitly shared, so a copy is a cheap snapshot that
+// the search thread can read while the model keeps growing.
+//
+class ChannelListIndex
+{
+public:
+	ChannelListIndex()
+	    : uRows(0), uSerial(0) {}
+
+	QString szText;
+	QVector<quint32> offsets;
+	unsigned int uRows;   // the rows in the snapshot
+	unsigned int uSerial; // changes when the model is cleared
+};
+
+class ChannelListModel : public QAbstractTableModel
+{
+	Q_OBJECT
+public:
+	ChannelListModel(QObject * pParent);
+	~ChannelListModel();
+
+	enum Column
+	{
+		Channel = 0,
+		Users = 1,
+		Topic = 2
+	};
+
+	enum Role
+	{
+		ColoredTopicRole = Qt::UserRole // the topic with the control codes
+	};
+
+protected:
+	// The columns: each row is stored as offsets in the text pools
+	QString m_szText;               // the channel names and the topics, as received
+	QVector<quint32> m_TextOffsets; // same layout as ChannelListIndex::offsets
+	QVector<int> m_Users;
+	ChannelListIndex m_Index;
+
+	unsigned int m_uCommitted;  // the rows before this are shown or searchable
+	QVector<quint32> m_Visible; // the rows shown, in the view order
+	bool m_bFiltered;
+
+	int m_iSortColumn; // -1 if not sorted
+	Qt::SortOrder m_eSortOrder;
+
+public:
+	/**
+	* \brief Adds a channel to the list
+	*
+	* The channel is not visible nor searchable until commit() is called
+	* \param szChan The channel name
+	* \param iUsers The number of users
+	* \param szTopic The topic
+	* \return void
+	*/
+	void append(const QString & szChan, int iUsers, const QString & szTopic);
+
+	/**
+	* \brief Makes the channels appended since the last call searchable
+	*
+	* If there is no filter they are shown too
+	* \return unsigned int The number of channels committed
+	*/
+	unsigned int commit();
+
+	/**
+	* \brief Removes all the channels
+	* \return void
+	*/
+	void clear();
+
+	/**
+	* \brief Removes the filter: all the committed channels are shown
+	* \return void
+	*/
+	void showAll();
+
+	/**
+	* \brief Shows only the specified channels
+	* \param ids The ids of the channels, in ascending order
+	* \return void
+	*/
+	void showOnly(const QVector<quint32> & ids);
+
+	/**
+	* \brief Returns a snapshot of the search index of the committed channels
+	* \return ChannelListIndex
+	*/
+	ChannelListIndex searchIndex() const;
+
+	unsigned int channelCount() const { return m_uCommitted; };
+	QString channel(unsigned int uId) const { return textField(2 * uId); };
+	int users(unsigned int uId) const { return m_Users.at(uId); };
+	QString topic(unsigned int uId) const { return textField((2 * uId) + 1); };
+
+	/**
+	* \brief Returns the id of the channel shown in the specified row
+	* \param iRow The row
+	* \return unsigned int
+	*/
+	unsigned int idAt(int iRow) const { return m_Visible.at(iRow); };
+
+	virtual int rowCount(const QModelIndex & parent = QModelIndex()) const;
+	virtual int columnCount(const QModelIndex & parent = QModelIndex()) const;
+	virtual QVariant data(const QModelIndex & index, int iRole = Qt::DisplayRole) const;
+	virtual QVariant headerData(int iSection, Qt::Orientation eOrientation, int iRole = Qt::DisplayRole) const;
+	virtual void sort(int iColumn, Qt::SortOrder eOrder = Qt::AscendingOrder);
+
+protected:
+	QString textField(unsigned int uField) const;
+	void setVisible(const QVector<quint32> & ids);
+	void sortRange(int iBegin, int iEnd);
+	void insertVisible(const QVector<quint32> & ids);
+	void remapPersistentIndexes(const QModelIndexList & lOld, const QVector<quint32> & lIds);
+	friend class ChannelListLessThan;
+};
+
+#endif //_CHANNELLISTMODEL_H_
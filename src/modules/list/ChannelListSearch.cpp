@@ -0,0 +1,262 @@
+//=============================================================================
+//
+//   File : ChannelListSearch.cpp
+//   Creation date : Sun Oct 18 2026 01:02:48 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ChannelListSearch.h"
+
+#include <QStringList>
+
+// The search checks if it has been replaced once every this many channels
+#define KVI_LIST_SEARCH_CHECK_INTERVAL 4096
+// The number of results kept for the refined patterns
+#define KVI_LIST_SEARCH_CACHE_SIZE 8
+
+//
+// A wildcard pattern that matches anywhere in the text: the parts between
+// the stars are looked up in order, each one after the end of the previous.
+//
+class ChannelListPattern
+{
+public:
+	ChannelListPattern(const QString & szPattern)
+	{
+		m_lSegments = szPattern.split(QChar('*'), QString::SkipEmptyParts);
+	}
+
+private:
+	QStringList m_lSegments;
+
+	static int find(const QString & szSegment, const QChar * p, int iLen, int iFrom)
+	{
+		const QChar * s = szSegment.constData();
+		int iSegLen = szSegment.size();
+		for(int i = iFrom; (i + iSegLen) <= iLen; i++)
+		{
+			int j = 0;
+			while((j < iSegLen) && ((s[j] == p[i + j]) || (s[j] == QChar('?'))))
+				j++;
+			if(j == iSegLen)
+				return i;
+		}
+		return -1;
+	}
+
+public:
+	bool matches(const QChar * p, int iLen) const
+	{
+		int iPos = 0;
+		for(auto & s : m_lSegments)
+		{
+			int iFound = find(s, p, iLen, iPos);
+			if(iFound < 0)
+				return false;
+			iPos = iFound + s.size();
+		}
+		return true;
+	}
+};
+
+ChannelListSearch::ChannelListSearch(QObject * pParent)
+    : QThread(pParent)
+{
+	m_job.uGeneration = 0;
+	m_bJobPending = false;
+	m_bTerminate = false;
+	m_uGeneration = 0;
+	m_bResultReady = false;
+	m_uResultGeneration = 0;
+	m_uCacheSerial = 0;
+}
+
+ChannelListSearch::~ChannelListSearch()
+{
+	m_mutex.lock();
+	m_bTerminate = true;
+	m_uGeneration++; // stop the running search
+	m_jobAvailable.wakeOne();
+	m_mutex.unlock();
+	wait();
+}
+
+unsigned int ChannelListSearch::search(const QString & szPattern, const ChannelListIndex & index)
+{
+	m_mutex.lock();
+	unsigned int uGeneration = ++m_uGeneration;
+	m_job.szPattern = szPattern.toLower();
+	m_job.index = index;
+	m_job.uGeneration = uGeneration;
+	m_bJobPending = true;
+	m_bResultReady = false;
+	m_Result.clear();
+	m_jobAvailable.wakeOne();
+	m_mutex.unlock();
+
+	if(!isRunning())
+		start(QThread::LowPriority);
+	return uGeneration;
+}
+
+void ChannelListSearch::cancel()
+{
+	m_mutex.lock();
+	m_uGeneration++;
+	m_bJobPending = false;
+	m_job.index = ChannelListIndex();
+	m_bResultReady = false;
+	m_Result.clear();
+	m_mutex.unlock();
+}
+
+bool ChannelListSearch::takeResult(unsigned int uGeneration, QVector<quint32> & ids)
+{
+	m_mutex.lock();
+	if(!m_bResultReady || (m_uResultGeneration != uGeneration))
+	{
+		m_mutex.unlock();
+		return false;
+	}
+	ids = m_Result;
+	m_Result.clear();
+	m_bResultReady = false;
+	m_mutex.unlock();
+	return true;
+}
+
+void ChannelListSearch::run()
+{
+	for(;;)
+	{
+		m_mutex.lock();
+		while(!m_bJobPending && !m_bTerminate)
+			m_jobAvailable.wait(&m_mutex);
+		if(m_bTerminate)
+		{
+			m_mutex.unlock();
+			return;
+		}
+		Job job = m_job;
+		// don't keep the snapshot alive longer than needed: while it is
+		// shared the model copies it on the next append
+		m_job.index = ChannelListIndex();
+		m_bJobPending = false;
+		m_mutex.unlock();
+
+		QVector<quint32> ids;
+		if(!execute(job, ids))
+			continue; // replaced
+
+		m_mutex.lock();
+		bool bCurrent = (job.uGeneration == m_uGeneration);
+		if(bCurrent)
+		{
+			m_Result = ids;
+			m_uResultGeneration = job.uGeneration;
+			m_bResultReady = true;
+		}
+		m_mutex.unlock();
+
+		if(bCurrent)
+			emit searchFinished();
+	}
+}
+
+bool ChannelListSearch::execute(const Job & job, QVector<quint32> & ids)
+{
+	if(job.index.uSerial != m_uCacheSerial)
+	{
+		// a new list: the cached ids refer to the old one
+		m_lCache.clear();
+		m_uCacheSerial = job.index.uSerial;
+	}
+
+	// Start from the longest cached pattern contained in this one:
+	// whatever this pattern matches, that one matches too.
+	int iBase = -1;
+	for(int i = 0; i < m_lCache.count(); i++)
+	{
+		const CachedResult & r = m_lCache.at(i);
+		if((r.uRows > job.index.uRows) || !job.szPattern.contains(r.szPattern))
+			continue;
+		if((iBase < 0) || (r.szPattern.size() > m_lCache.at(iBase).szPattern.size()) || ((r.szPattern.size() == m_lCache.at(iBase).szPattern.size()) && (r.uRows > m_lCache.at(iBase).uRows)))
+			iBase = i;
+	}
+
+	ChannelListPattern pattern(job.szPattern);
+	const QChar * pText = job.index.szText.constData();
+	const quint32 * pOffsets = job.index.offsets.constData();
+	unsigned int uChecked = 0;
+	unsigned int uFirstNew = 0;
+
+#define CHANNEL_MATCHES(_u) \
+	(pattern.matches(pText + pOffsets[2 * (_u)], pOffsets[(2 * (_u)) + 1] - pOffsets[2 * (_u)]) || pattern.matches(pText + pOffsets[(2 * (_u)) + 1], pOffsets[(2 * (_u)) + 2] - pOffsets[(2 * (_u)) + 1]))
+
+	if(iBase >= 0)
+	{
+		const CachedResult & base = m_lCache.at(iBase);
+		if(base.szPattern == job.szPattern)
+		{
+			ids = base.ids; // only the new channels have to be checked
+		}
+		else
+		{
+			ids.reserve(base.ids.count());
+			for(auto u : base.ids)
+			{
+				if(((++uChecked % KVI_LIST_SEARCH_CHECK_INTERVAL) == 0) && (m_uGeneration != job.uGeneration))
+					return false;
+				if(CHANNEL_MATCHES(u))
+					ids.append(u);
+			}
+		}
+		uFirstNew = base.uRows;
+	}
+
+	for(unsigned int u = uFirstNew; u < job.index.uRows; u++)
+	{
+		if(((++uChecked % KVI_LIST_SEARCH_CHECK_INTERVAL) == 0) && (m_uGeneration != job.uGeneration))
+			return false;
+		if(CHANNEL_MATCHES(u))
+			ids.append(u);
+	}
+
+#undef CHANNEL_MATCHES
+
+	for(int i = 0; i < m_lCache.count(); i++)
+	{
+		if(m_lCache.at(i).szPattern == job.szPattern)
+		{
+			m_lCache.removeAt(i);
+			break;
+		}
+	}
+
+	CachedResult r;
+	r.szPattern = job.szPattern;
+	r.uRows = job.index.uRows;
+	r.ids = ids;
+	m_lCache.prepend(r);
+	while(m_lCache.count() > KVI_LIST_SEARCH_CACHE_SIZE)
+		m_lCache.removeLast();
+
+	return true;
+}
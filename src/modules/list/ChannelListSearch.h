@@ -0,0 +1,119 @@
+#ifndef _CHANNELLISTSEARCH_H_
+#define _CHANNELLISTSEARCH_H_
+//=============================================================================
+//
+//   File : ChannelListSearch.h
+//   Creation date : Sun Oct 18 2026 01:02:48 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "ChannelListModel.h"
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+
+/**
+* \class ChannelListSearch
+* \brief The live search of the channel list window, run off the GUI thread
+*
+* The pattern is a case insensitive wildcard (* and ?) that matches anywhere
+* in the channel name or in the topic. Only the last search requested
+* matters: a new request makes the running one stop at its next check.
+* The recent results are cached: when the new pattern contains a cached one
+* only the channels matched by it are checked again, plus the channels that
+* arrived after it was computed.
+*/
+class ChannelListSearch : public QThread
+{
+	Q_OBJECT
+public:
+	ChannelListSearch(QObject * pParent);
+	~ChannelListSearch();
+
+protected:
+	class Job
+	{
+	public:
+		QString szPattern; // lowercase
+		ChannelListIndex index;
+		unsigned int uGeneration;
+	};
+
+	class CachedResult
+	{
+	public:
+		QString szPattern;
+		unsigned int uRows; // the channels that were checked
+		QVector<quint32> ids;
+	};
+
+	QMutex m_mutex;
+	QWaitCondition m_jobAvailable;
+	Job m_job; // the request waiting for the search thread
+	bool m_bJobPending;
+	bool m_bTerminate;
+	std::atomic<unsigned int> m_uGeneration; // of the last request
+
+	bool m_bResultReady;
+	unsigned int m_uResultGeneration;
+	QVector<quint32> m_Result;
+
+	// Used only by the search thread
+	QList<CachedResult> m_lCache; // the most recently used first
+	unsigned int m_uCacheSerial;
+
+public:
+	/**
+	* \brief Starts a search, replacing the running one
+	* \param szPattern The pattern
+	* \param index The snapshot of the channels
+	* \return unsigned int The generation of the search
+	*/
+	unsigned int search(const QString & szPattern, const ChannelListIndex & index);
+
+	/**
+	* \brief Stops the running search: its result will be dropped
+	* \return void
+	*/
+	void cancel();
+
+	/**
+	* \brief Takes the result of the specified search
+	* \param uGeneration The generation returned by search()
+	* \param ids Will contain the matching channels, in ascending order
+	* \return bool false if the search is not finished or was replaced
+	*/
+	bool takeResult(unsigned int uGeneration, QVector<quint32> & ids);
+
+signals:
+	void searchFinished();
+
+protected:
+	virtual void run();
+	bool execute(const Job & job, QVector<quint32> & ids);
+};
+
+#endif //_CHANNELLISTSEARCH_H_
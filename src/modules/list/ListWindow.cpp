@@ -23,6 +23,7 @@
 //=============================================================================
 
 #include "ListWindow.h"
+#include "ChannelListSearch.h"
 
 #include "kvi_debug.h"
 #include "KviIconManager.h"
@@ -53,95 +54,32 @@
 
 extern KviPointerList<ListWindow> * g_pListWindowList;
 
-ChannelTreeWidgetItemData::ChannelTreeWidgetItemData(const QString & szChan, const QString & szUsers, const QString & szTopic)
-{
-	m_szChan = szChan;
-	m_szUsers = szUsers;
-	m_szTopic = szTopic;
-}
-
-ChannelTreeWidgetItemData::~ChannelTreeWidgetItemData()
-    = default;
-
-ChannelTreeWidgetItem::ChannelTreeWidgetItem(ChannelTreeWidgetItemData * pData)
-    : QTreeWidgetItem(), m_pData(pData)
-{
-	setToolTip(0, KviQString::toHtmlEscaped(m_pData->m_szChan));
-	setToolTip(1, KviQString::toHtmlEscaped(m_pData->m_szUsers));
-	setToolTip(2, KviHtmlGenerator::convertToHtml(KviQString::toHtmlEscaped(m_pData->m_szTopic)));
-}
-
-ChannelTreeWidgetItem::~ChannelTreeWidgetItem()
-    = default;
-
-bool ChannelTreeWidgetItem::operator<(const QTreeWidgetItem & other) const
-{
-	switch(treeWidget()->sortColumn())
-	{
-		case 0:
-			//channel
-			return m_pData->m_szChan.toUpper() < ((ChannelTreeWidgetItem *)&other)->itemData()->m_szChan.toUpper();
-			break;
-		case 1:
-			//users
-			return m_pData->m_szUsers.toInt() < ((ChannelTreeWidgetItem *)&other)->itemData()->m_szUsers.toInt();
-			break;
-		case 2:
-		default:
-			//topic
-			return KviControlCodes::stripControlBytes(m_pData->m_szTopic.toUpper()) < KviControlCodes::stripControlBytes(((ChannelTreeWidgetItem *)&other)->itemData()->m_szTopic.toUpper());
-			break;
-	}
-}
-
-ChannelTreeWidgetItemDelegate::ChannelTreeWidgetItemDelegate(QTreeWidget * pWidget)
+ChannelListItemDelegate::ChannelListItemDelegate(QTreeView * pWidget)
     : QItemDelegate(pWidget)
 {
 }
 
-ChannelTreeWidgetItemDelegate::~ChannelTreeWidgetItemDelegate()
+ChannelListItemDelegate::~ChannelListItemDelegate()
     = default;
 
 #define BORDER 2
 
-QSize ChannelTreeWidgetItemDelegate::sizeHint(const QStyleOptionViewItem & sovItem, const QModelIndex & index) const
+QSize ChannelListItemDelegate::sizeHint(const QStyleOptionViewItem & sovItem, const QModelIndex & index) const
 {
-	ChannelTreeWidget * treeWidget = (ChannelTreeWidget *)parent();
-
-	int iHeight = treeWidget->fontMetrics().lineSpacing() + BORDER + BORDER;
+	QTreeView * pTreeView = (QTreeView *)parent();
 
-	ChannelTreeWidgetItem * item = dynamic_cast<ChannelTreeWidgetItem *>(treeWidget->itemFromIndex(index));
+	int iHeight = pTreeView->fontMetrics().lineSpacing() + BORDER + BORDER;
 
-	if(!item)
+	if(!index.isValid())
 		return QSize(100, iHeight);
 
+	// the display text of the topic has no control codes
 	QFontMetrics fm(sovItem.font);
-	switch(index.column())
-	{
-		case 0:
-			//channel
-			return QSize(fm.width(item->itemData()->m_szChan), iHeight);
-			break;
-		case 1:
-			//users
-			return QSize(fm.width(item->itemData()->m_szUsers.toInt()), iHeight);
-			break;
-		case 2:
-		default:
-			//topic
-			if(item->itemData()->m_szStrippedTopic.isEmpty())
-				item->itemData()->m_szStrippedTopic = KviControlCodes::stripControlBytes(item->itemData()->m_szTopic);
-			return QSize(fm.width(item->itemData()->m_szStrippedTopic), iHeight);
-			break;
-	}
-	//make gcc happy
-	return QSize();
+	return QSize(fm.width(index.data(Qt::DisplayRole).toString()), iHeight);
 }
 
-void ChannelTreeWidgetItemDelegate::paint(QPainter * p, const QStyleOptionViewItem & option, const QModelIndex & index) const
+void ChannelListItemDelegate::paint(QPainter * p, const QStyleOptionViewItem & option, const QModelIndex & index) const
 {
-	ChannelTreeWidgetItem * obj = static_cast<ChannelTreeWidgetItem *>(index.internalPointer());
-
 	if(option.state & QStyle::State_Selected)
 		p->fillRect(option.rect, option.palette.brush(QPalette::Highlight));
 
@@ -150,18 +88,15 @@ void ChannelTreeWidgetItemDelegate::paint(QPainter * p, const QStyleOptionViewIt
 
 	switch(index.column())
 	{
-		case 0:
-			//channel
-			p->drawText(option.rect, obj->itemData()->m_szChan);
+		case ChannelListModel::Channel:
+			p->drawText(option.rect, index.data(Qt::DisplayRole).toString());
 			break;
-		case 1:
-			//users
-			p->drawText(option.rect, Qt::AlignHCenter, obj->itemData()->m_szUsers);
+		case ChannelListModel::Users:
+			p->drawText(option.rect, Qt::AlignHCenter, index.data(Qt::DisplayRole).toString());
 			break;
-		case 2:
+		case ChannelListModel::Topic:
 		default:
-			//topic
-			KviTopicWidget::paintColoredText(p, obj->itemData()->m_szTopic, option.palette, option.rect);
+			KviTopicWidget::paintColoredText(p, index.data(ChannelListModel::ColoredTopicRole).toString(), option.palette, option.rect);
 			break;
 	}
 }
@@ -173,8 +108,8 @@ ListWindow::ListWindow(KviConsoleWindow * lpConsole)
 
 	m_pFlushTimer = nullptr;
 
-	m_pItemList = new KviPointerList<ChannelTreeWidgetItemData>;
-	m_pItemList->setAutoDelete(false);
+	m_pSearch = nullptr;
+	m_uSearchGeneration = 0;
 
 	m_pSplitter = new KviTalSplitter(Qt::Horizontal, this);
 	m_pSplitter->setObjectName("splitter");
@@ -229,30 +164,28 @@ ListWindow::ListWindow(KviConsoleWindow * lpConsole)
 
 	m_pInfoLabel = new KviThemedLabel(m_pTopSplitter, this, "info_label");
 
-	m_pTreeWidget = new ChannelTreeWidget(m_pVertSplitter, this, "list_treewidget");
-	m_pTreeWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
-	m_pTreeWidget->setSelectionMode(QAbstractItemView::SingleSelection);
-	m_pTreeWidget->setItemDelegate(new ChannelTreeWidgetItemDelegate(m_pTreeWidget));
-	QStringList columnLabels;
-	columnLabels.append(__tr2qs("Channel"));
-	columnLabels.append(__tr2qs("Users"));
-	columnLabels.append(__tr2qs("Topic"));
-	m_pTreeWidget->setColumnCount(3);
-	m_pTreeWidget->setHeaderLabels(columnLabels);
-	m_pTreeWidget->setAllColumnsShowFocus(true);
-	m_pTreeWidget->setSortingEnabled(true);
-	m_pTreeWidget->sortItems(0, Qt::AscendingOrder);
-	m_pTreeWidget->setUniformRowHeights(true);
-
-	m_pTreeWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-	m_pTreeWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-	m_pTreeWidget->header()->setStretchLastSection(false);
-	m_pTreeWidget->header()->resizeSection(0, 150);
-	m_pTreeWidget->header()->resizeSection(1, 80);
-	m_pTreeWidget->header()->resizeSection(2, 450);
-	//m_pTreeWidget->header()->setResizeMode(QHeaderView::ResizeToContents); <-- this is too heavy for single-core machines...
-
-	connect(m_pTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem *, int)), this, SLOT(itemDoubleClicked(QTreeWidgetItem *, int)));
+	m_pModel = new ChannelListModel(this);
+
+	m_pTreeView = new KviThemedTreeView(m_pVertSplitter, this, "list_treewidget");
+	m_pTreeView->setModel(m_pModel);
+	m_pTreeView->setRootIsDecorated(false);
+	m_pTreeView->setSelectionBehavior(QAbstractItemView::SelectRows);
+	m_pTreeView->setSelectionMode(QAbstractItemView::SingleSelection);
+	m_pTreeView->setItemDelegate(new ChannelListItemDelegate(m_pTreeView));
+	m_pTreeView->setAllColumnsShowFocus(true);
+	m_pTreeView->setSortingEnabled(true);
+	m_pTreeView->sortByColumn(ChannelListModel::Channel, Qt::AscendingOrder);
+	m_pTreeView->setUniformRowHeights(true);
+
+	m_pTreeView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	m_pTreeView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	m_pTreeView->header()->setStretchLastSection(false);
+	m_pTreeView->header()->resizeSection(0, 150);
+	m_pTreeView->header()->resizeSection(1, 80);
+	m_pTreeView->header()->resizeSection(2, 450);
+	//m_pTreeView->header()->setResizeMode(QHeaderView::ResizeToContents); <-- this is too heavy for single-core machines...
+
+	connect(m_pTreeView, SIGNAL(doubleClicked(const QModelIndex &)), this, SLOT(itemDoubleClicked(const QModelIndex &)));
 
 	m_pIrcView = new KviIrcView(m_pVertSplitter, this);
 
@@ -269,8 +202,8 @@ ListWindow::~ListWindow()
 
 	if(m_pFlushTimer)
 		delete m_pFlushTimer;
-	m_pItemList->setAutoDelete(true);
-	delete m_pItemList;
+	if(m_pSearch)
+		delete m_pSearch;
 }
 
 void ListWindow::getBaseLogFileName(QString & szBuffer)
@@ -288,6 +221,7 @@ void ListWindow::requestList()
 		else
 		{
 			m_pParamsEdit->setText("");
+			liveSearch(QString());
 			m_pConsole->connection()->sendFmtData("list %s", m_pConsole->connection()->encodeText(parms.ptr()).data());
 		}
 
@@ -359,7 +293,7 @@ void ListWindow::die()
 
 void ListWindow::exportList()
 {
-	if(!m_pTreeWidget->topLevelItemCount())
+	if(!m_pModel->channelCount())
 	{
 		QMessageBox::warning(nullptr, __tr2qs("Warning While Exporting - KVIrc"), __tr2qs("You can't export an empty list!"));
 		return;
@@ -400,14 +334,12 @@ void ListWindow::exportList()
 		KviConfigurationFile cfg(szFile, KviConfigurationFile::Write);
 		cfg.clear();
 
-		ChannelTreeWidgetItem * it;
-		for(int i = 0; i < m_pTreeWidget->topLevelItemCount(); i++)
+		for(unsigned int u = 0; u < m_pModel->channelCount(); u++)
 		{
-			it = (ChannelTreeWidgetItem *)m_pTreeWidget->topLevelItem(i);
-			cfg.setGroup(it->itemData()->m_szChan);
+			cfg.setGroup(m_pModel->channel(u));
 			// Write properties
-			cfg.writeEntry("topic", it->itemData()->m_szTopic);
-			cfg.writeEntry("users", it->itemData()->m_szUsers);
+			cfg.writeEntry("topic", m_pModel->topic(u));
+			cfg.writeEntry("users", QString::number(m_pModel->users(u)));
 		}
 	}
 }
@@ -419,22 +351,19 @@ void ListWindow::importList()
 	if(KviFileDialog::askForOpenFileName(szFile, __tr2qs("Select a File - KVIrc"), QString(), KVI_FILTER_CONFIG, false, false, this))
 	{
 
-		m_pItemList->setAutoDelete(true);
-		m_pItemList->clear();
-		m_pItemList->setAutoDelete(false);
-
-		m_pTreeWidget->clear();
+		if(m_pSearch)
+			m_pSearch->cancel();
+		m_pModel->clear();
 
 		KviConfigurationFile cfg(szFile, KviConfigurationFile::Read);
 		KviConfigurationFileIterator it(*cfg.dict());
 		while(it.current())
 		{
 			cfg.setGroup(it.currentKey());
-			m_pItemList->append(
-			    new ChannelTreeWidgetItemData(
-			        it.currentKey(),
-			        cfg.readEntry("users", "0"),
-			        cfg.readEntry("topic", "")));
+			m_pModel->append(
+			    it.currentKey(),
+			    cfg.readEntry("users", "0").toInt(),
+			    cfg.readEntry("topic", ""));
 			++it;
 		}
 		flush();
@@ -476,32 +405,53 @@ void ListWindow::endOfList()
 
 void ListWindow::startOfList()
 {
-	m_pItemList->setAutoDelete(true);
-	m_pItemList->clear();
-	m_pItemList->setAutoDelete(false);
-
-	m_pTreeWidget->clear();
+	if(m_pSearch)
+		m_pSearch->cancel();
+	m_pModel->clear();
 
 	m_pRequestButton->setEnabled(false);
 }
 
+void ListWindow::setParamsFilter(const QString & szParams)
+{
+	// compiled once, not for each entry of the list
+	if(szParams == m_paramsFilter.pattern())
+		return;
+	m_paramsFilter = QRegExp(szParams, Qt::CaseInsensitive, QRegExp::Wildcard);
+}
+
 void ListWindow::liveSearch(const QString & szText)
 {
-	QRegExp res(szText, Qt::CaseInsensitive, QRegExp::Wildcard);
+	setParamsFilter(szText);
 
-	ChannelTreeWidgetItem * pItem = nullptr;
-	for(int i = 0; i < m_pTreeWidget->topLevelItemCount(); i++)
+	m_szSearch = szText;
+	if(m_szSearch.isEmpty())
 	{
-		pItem = (ChannelTreeWidgetItem *)m_pTreeWidget->topLevelItem(i);
-		if(pItem->itemData()->m_szChan.contains(res) || pItem->itemData()->m_szTopic.contains(res))
-		{
-			pItem->setHidden(false);
-		}
-		else
-		{
-			pItem->setHidden(true);
-		}
+		if(m_pSearch)
+			m_pSearch->cancel();
+		m_pModel->showAll();
+		return;
+	}
+
+	startSearch();
+}
+
+void ListWindow::startSearch()
+{
+	if(!m_pSearch)
+	{
+		m_pSearch = new ChannelListSearch(this);
+		connect(m_pSearch, SIGNAL(searchFinished()), this, SLOT(searchFinished()));
 	}
+	m_uSearchGeneration = m_pSearch->search(m_szSearch, m_pModel->searchIndex());
+}
+
+void ListWindow::searchFinished()
+{
+	QVector<quint32> ids;
+	if(!m_pSearch->takeResult(m_uSearchGeneration, ids))
+		return; // a newer search is running
+	m_pModel->showOnly(ids);
 }
 
 void ListWindow::processData(KviIrcMessage * pMsg)
@@ -514,59 +464,38 @@ void ListWindow::processData(KviIrcMessage * pMsg)
 		m_pRequestButton->setEnabled(false);
 	}
 
-	if(m_pParamsEdit->text().isEmpty())
-	{
-		m_pItemList->append(
-		    new ChannelTreeWidgetItemData(
-		        pMsg->connection()->decodeText(pMsg->safeParam(1)),
-		        pMsg->connection()->decodeText(pMsg->safeParam(2)),
-		        pMsg->connection()->decodeText(pMsg->safeTrailing())));
-	}
-	else
-	{
-		//rfc2812 permits wildcards here (section 3.2.6)
-		QRegExp res(m_pParamsEdit->text(), Qt::CaseInsensitive, QRegExp::Wildcard);
-		if(
-		    res.exactMatch(pMsg->connection()->decodeText(pMsg->safeParam(1))) || res.exactMatch(pMsg->connection()->decodeText(pMsg->safeTrailing())))
-		{
-			m_pItemList->append(
-			    new ChannelTreeWidgetItemData(
-			        pMsg->connection()->decodeText(pMsg->safeParam(1)),
-			        pMsg->connection()->decodeText(pMsg->safeParam(2)),
-			        pMsg->connection()->decodeText(pMsg->safeTrailing())));
-		}
-	}
+	QString szChan = pMsg->decodedParam(1);
+	QString szTopic = pMsg->decodedTrailing();
+
+	//rfc2812 permits wildcards here (section 3.2.6)
+	if(m_paramsFilter.isEmpty() || m_paramsFilter.exactMatch(szChan) || m_paramsFilter.exactMatch(szTopic))
+		m_pModel->append(szChan, pMsg->decodedParam(2).toInt(), szTopic);
 
 	if(_OUTPUT_VERBOSE)
 	{
-		QString szTmp = pMsg->connection()->decodeText(pMsg->allParams());
+		QString szTmp = pMsg->decodedAllParams();
 		output(KVI_OUT_LIST, __tr2qs("Processing list: %Q"), &szTmp);
 	}
 }
 
 void ListWindow::flush()
 {
-	m_pTreeWidget->setUpdatesEnabled(false); /* for v_scroolbar */
-	while(ChannelTreeWidgetItemData * d = m_pItemList->first())
-	{
-		// Model-View-Delegate-Crappiness...
-		//
-		// Don't use the constructor that takes QTreeWidget as parent
-		// as it will insert the item and call the delegate's sizeHint()
-		// function when the item is not yet fully constructed.
+	if(!m_pModel->commit())
+		return;
 
-		m_pTreeWidget->addTopLevelItem(new ChannelTreeWidgetItem(d));
+	// the new channels are shown by the model, or by the search if there is a filter
+	if(!m_szSearch.isEmpty())
+		startSearch();
 
-		m_pItemList->removeFirst();
-	}
-	m_pTreeWidget->setUpdatesEnabled(true);
-	m_pTreeWidget->resizeColumnToContents(2);
-	m_pTreeWidget->viewport()->update();
+	m_pTreeView->resizeColumnToContents(ChannelListModel::Topic);
 }
 
-void ListWindow::itemDoubleClicked(QTreeWidgetItem * it, int)
+void ListWindow::itemDoubleClicked(const QModelIndex & index)
 {
-	QString szText = ((ChannelTreeWidgetItem *)it)->itemData()->m_szChan;
+	if(!index.isValid())
+		return;
+
+	QString szText = m_pModel->channel(m_pModel->idAt(index.row()));
 
 	if(szText.isEmpty())
 		return;
@@ -582,7 +511,7 @@ void ListWindow::itemDoubleClicked(QTreeWidgetItem * it, int)
 
 void ListWindow::applyOptions()
 {
-	m_pTreeWidget->applyOptions();
+	m_pTreeView->applyOptions();
 	m_pIrcView->applyOptions();
 	m_pParamsEdit->applyOptions();
 	m_pInfoLabel->applyOptions();
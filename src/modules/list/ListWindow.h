@@ -31,69 +31,28 @@
 #include "KviIrcServerParser.h"
 #include "KviConsoleWindow.h"
 #include "KviIrcContext.h"
-#include "KviThemedTreeWidget.h"
+#include "KviThemedTreeView.h"
+#include "ChannelListModel.h"
 
 #include <QToolButton>
 #include <QLineEdit>
 #include <QItemDelegate>
 #include <QMenu>
+#include <QRegExp>
 
 class KviThemedLabel;
 class KviThemedLineEdit;
+class ChannelListSearch;
 
-class ChannelTreeWidgetItemDelegate : public QItemDelegate
+class ChannelListItemDelegate : public QItemDelegate
 {
 public:
-	ChannelTreeWidgetItemDelegate(QTreeWidget * pWidget = 0);
-	~ChannelTreeWidgetItemDelegate();
+	ChannelListItemDelegate(QTreeView * pWidget = 0);
+	~ChannelListItemDelegate();
 	void paint(QPainter * pPainter, const QStyleOptionViewItem & option, const QModelIndex & index) const;
 	QSize sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const;
 };
 
-class ChannelTreeWidgetItemData
-{
-	friend class ChannelTreeWidgetItem;
-	friend class ListWindow;
-	friend class ChannelTreeWidgetItemDelegate;
-
-public:
-	ChannelTreeWidgetItemData(const QString & szChan, const QString & szUsers, const QString & szTopic);
-	~ChannelTreeWidgetItemData();
-
-protected:
-	QString m_szChan;
-	QString m_szUsers;
-	QString m_szTopic;
-	QString m_szStrippedTopic;
-};
-
-class ChannelTreeWidgetItem : public QTreeWidgetItem
-{
-	friend class ListWindow;
-
-public:
-	ChannelTreeWidgetItem(ChannelTreeWidgetItemData * pData);
-	~ChannelTreeWidgetItem();
-
-private:
-	ChannelTreeWidgetItemData * m_pData;
-
-public:
-	bool operator<(const QTreeWidgetItem & other) const;
-	inline ChannelTreeWidgetItemData * itemData() { return m_pData; };
-};
-
-class ChannelTreeWidget : public KviThemedTreeWidget
-{
-	friend class ChannelTreeWidgetItem;
-	friend class ChannelTreeWidgetItemData;
-	Q_OBJECT
-public:
-	ChannelTreeWidget(QWidget * par, KviWindow * pWindow, const char * name) : KviThemedTreeWidget(par, pWindow, name){};
-	~ChannelTreeWidget(){};
-	ChannelTreeWidgetItem * itemFromIndex(const QModelIndex & index) const { return (ChannelTreeWidgetItem *)KviThemedTreeWidget::itemFromIndex(index); };
-};
-
 class ListWindow : public KviWindow, public KviExternalServerDataParser
 {
 	Q_OBJECT
@@ -104,7 +63,8 @@ public:
 protected:
 	QSplitter * m_pVertSplitter;
 	QSplitter * m_pTopSplitter;
-	ChannelTreeWidget * m_pTreeWidget;
+	KviThemedTreeView * m_pTreeView;
+	ChannelListModel * m_pModel;
 	KviThemedLineEdit * m_pParamsEdit;
 	QToolButton * m_pRequestButton;
 	QToolButton * m_pStopListDownloadButton;
@@ -112,7 +72,10 @@ protected:
 	QToolButton * m_pSaveButton;
 	KviThemedLabel * m_pInfoLabel;
 	QTimer * m_pFlushTimer;
-	KviPointerList<ChannelTreeWidgetItemData> * m_pItemList;
+	ChannelListSearch * m_pSearch;
+	QString m_szSearch;               // the live search pattern
+	unsigned int m_uSearchGeneration; // of the search we are waiting for
+	QRegExp m_paramsFilter;           // the /LIST parameters, checked on each entry
 
 public: // Methods
 	virtual void control(int iMsg);
@@ -128,18 +91,21 @@ protected:
 	virtual void getBaseLogFileName(QString & szBuffer);
 protected slots:
 	void flush();
-	void itemDoubleClicked(QTreeWidgetItem * it, int);
+	void itemDoubleClicked(const QModelIndex & index);
 	void requestList();
 	void stoplistdownload();
 	void connectionStateChange();
 	void exportList();
 	void importList();
 	void liveSearch(const QString & szText);
+	void searchFinished();
 
 private:
 	void reset();
 	void endOfList();
 	void startOfList();
+	void setParamsFilter(const QString & szParams);
+	void startSearch();
 };
 
 #endif //_KVI_LISTWINDOW_H_
@@ -29,6 +29,7 @@
 #include "KviOptions.h"
 #include "KviFileUtils.h"
 
+#include <QFile>
 #include <QFileInfo>
 
 #ifdef COMPILE_ZLIB_SUPPORT
@@ -143,48 +144,90 @@ LogFile::LogFile(const QString & szName)
 	}
 }
 
+#define LOGFILE_READ_CHUNK_SIZE 65536
+
 void LogFile::getText(QString & szText)
 {
-	QString szLogName = fileName();
-	QFile logFile;
+	LogFileReader reader(this);
+	if(!reader.open())
+		return;
+
+	QByteArray data;
+	int iLen;
+	do
+	{
+		int iOffset = data.size();
+		data.resize(iOffset + LOGFILE_READ_CHUNK_SIZE);
+		iLen = reader.read(data.data() + iOffset, LOGFILE_READ_CHUNK_SIZE);
+		data.resize(iOffset + qMax(iLen, 0));
+	} while(iLen > 0);
+
+	reader.close();
+	szText = QString::fromUtf8(data.data(), data.size());
+}
+
+LogFileReader::LogFileReader(const LogFile * pLog)
+{
+	m_szFileName = pLog->fileName();
+	m_bCompressed = pLog->isCompressed();
+	m_pGzFile = nullptr;
+	m_pFile = nullptr;
+}
+
+LogFileReader::~LogFileReader()
+{
+	close();
+}
+
+bool LogFileReader::open()
+{
 #ifdef COMPILE_ZLIB_SUPPORT
 	if(m_bCompressed)
 	{
-		gzFile file = gzopen(szLogName.toLocal8Bit().data(), "rb");
-		if(file)
-		{
-			char cBuff[1025];
-			int iLen;
-			QByteArray data;
-			//QCString data;
-			iLen = gzread(file, cBuff, 1024);
-			while(iLen > 0)
-			{
-				cBuff[iLen] = 0;
-				data.append(cBuff);
-				iLen = gzread(file, cBuff, 1024);
-			}
-			gzclose(file);
-			szText = QString::fromUtf8(data);
-		}
-		else
+		gzFile file = gzopen(m_szFileName.toLocal8Bit().data(), "rb");
+		if(!file)
 		{
-			qDebug("Can't open compressed file %s", szLogName.toLocal8Bit().data());
+			qDebug("Can't open compressed file %s", m_szFileName.toLocal8Bit().data());
+			return false;
 		}
+		gzbuffer(file, LOGFILE_READ_CHUNK_SIZE);
+		m_pGzFile = file;
+		return true;
 	}
-	else
-	{
 #endif
-		logFile.setFileName(szLogName);
+	m_pFile = new QFile(m_szFileName);
+	if(!m_pFile->open(QIODevice::ReadOnly))
+	{
+		delete m_pFile;
+		m_pFile = nullptr;
+		return false;
+	}
+	return true;
+}
 
-		if(!logFile.open(QIODevice::ReadOnly))
-			return;
+int LogFileReader::read(char * pcBuffer, int iSize)
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(m_pGzFile)
+		return gzread((gzFile)m_pGzFile, pcBuffer, iSize);
+#endif
+	if(m_pFile)
+		return m_pFile->read(pcBuffer, iSize);
+	return -1;
+}
 
-		QByteArray bytes;
-		bytes = logFile.readAll();
-		szText = QString::fromUtf8(bytes.data(), bytes.size());
-		logFile.close();
+void LogFileReader::close()
+{
 #ifdef COMPILE_ZLIB_SUPPORT
+	if(m_pGzFile)
+	{
+		gzclose((gzFile)m_pGzFile);
+		m_pGzFile = nullptr;
 	}
 #endif
+	if(m_pFile)
+	{
+		delete m_pFile;
+		m_pFile = nullptr;
+	}
 }
@@ -33,8 +33,9 @@
 */
 
 #include <QDate>
+#include <QString>
 
-class QString;
+class QFile;
 
 /**
 * \typedef LogFileData
@@ -145,6 +146,57 @@ public:
 	* \return void
 	*/
 	void getText(QString & szText);
+
+	/**
+	* \brief Returns true if the log is gzip-compressed
+	* \return bool
+	*/
+	bool isCompressed() const { return m_bCompressed; };
+};
+
+/**
+* \class LogFileReader
+* \brief Reads the raw (decompressed) contents of a log file in chunks
+*
+* The reader doesn't keep any reference to the LogFile it was created from.
+*/
+class LogFileReader
+{
+public:
+	/**
+	* \brief Constructs the reader object
+	* \param pLog The log file to read
+	* \return LogFileReader
+	*/
+	LogFileReader(const LogFile * pLog);
+	~LogFileReader();
+
+private:
+	QString m_szFileName;
+	bool m_bCompressed;
+	void * m_pGzFile;
+	QFile * m_pFile;
+
+public:
+	/**
+	* \brief Opens the file for reading
+	* \return bool
+	*/
+	bool open();
+
+	/**
+	* \brief Reads the next chunk of data
+	* \param pcBuffer The buffer where to store the data
+	* \param iSize The size of the buffer
+	* \return int The number of bytes read, 0 on end of file and -1 on error
+	*/
+	int read(char * pcBuffer, int iSize);
+
+	/**
+	* \brief Closes the file
+	* \return void
+	*/
+	void close();
 };
 
 #endif // _LOGFILE_H_
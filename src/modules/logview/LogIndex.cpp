@@ -0,0 +1,258 @@
+//=============================================================================
+//
+//   File : LogIndex.cpp
+//   Creation date : Sun Oct 18 2026 18:40:52 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "LogIndex.h"
+#include "LogFile.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+
+#define LOGINDEX_MAGIC 0x4b4c4958 // "KLIX"
+#define LOGINDEX_VERSION 2
+
+// The bloom filters are sized from the number of distinct trigrams of the log,
+// for a false positive rate of about 1% per trigram, within these bounds (in bytes).
+// With 4 probes the optimal size is about 10 bits per trigram: the size is
+// rounded up to a power of two, so it is between 10 and 20 bits.
+#define LOGINDEX_MIN_BLOOM_SIZE 1024
+#define LOGINDEX_MAX_BLOOM_SIZE (1024 * 1024)
+#define LOGINDEX_BLOOM_BITS_PER_TRIGRAM 10
+#define LOGINDEX_BLOOM_PROBES 4
+
+static inline quint32 trigram_hash(ushort a, ushort b, ushort c)
+{
+	quint32 h = ((quint32)a * 0x9E3779B1u) ^ ((quint32)b * 0x85EBCA77u) ^ ((quint32)c * 0xC2B2AE3Du);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+// the probes are h + i * step (double hashing), the step is odd so they are all distinct
+static inline quint32 bloom_step(quint32 h)
+{
+	return (((h >> 16) | (h << 16)) * 0x27D4EB2Fu) | 1;
+}
+
+static inline bool bloom_test(const QByteArray & bloom, quint32 h)
+{
+	const unsigned char * p = (const unsigned char *)bloom.constData();
+	quint32 uMask = (bloom.size() * 8) - 1;
+	quint32 uStep = bloom_step(h);
+	for(int i = 0; i < LOGINDEX_BLOOM_PROBES; i++)
+	{
+		quint32 b = h & uMask;
+		if(!(p[b >> 3] & (1 << (b & 7))))
+			return false;
+		h += uStep;
+	}
+	return true;
+}
+
+static inline void bloom_set(QByteArray & bloom, quint32 h)
+{
+	unsigned char * p = (unsigned char *)bloom.data();
+	quint32 uMask = (bloom.size() * 8) - 1;
+	quint32 uStep = bloom_step(h);
+	for(int i = 0; i < LOGINDEX_BLOOM_PROBES; i++)
+	{
+		quint32 b = h & uMask;
+		p[b >> 3] |= (1 << (b & 7));
+		h += uStep;
+	}
+}
+
+LogIndex::LogIndex(const QString & szFileName)
+    : m_szFileName(szFileName)
+{
+	m_bLoaded = false;
+	m_bDirty = false;
+}
+
+LogIndex::~LogIndex()
+{
+	save();
+}
+
+void LogIndex::load()
+{
+	m_bLoaded = true;
+
+	QFile f(m_szFileName);
+	if(!f.open(QIODevice::ReadOnly))
+		return;
+
+	QDataStream stream(&f);
+	stream.setVersion(QDataStream::Qt_5_0);
+
+	quint32 uMagic, uVersion, uCount;
+	stream >> uMagic >> uVersion >> uCount;
+	if((uMagic != LOGINDEX_MAGIC) || (uVersion != LOGINDEX_VERSION))
+		return; // will be rebuilt
+
+	for(quint32 u = 0; u < uCount; u++)
+	{
+		QString szPath;
+		Entry e;
+		stream >> szPath >> e.iSize >> e.iModified >> e.bloom;
+		if(stream.status() != QDataStream::Ok)
+		{
+			// truncated or corrupted: forget everything
+			m_hEntries.clear();
+			return;
+		}
+		m_hEntries.insert(szPath, e);
+	}
+}
+
+void LogIndex::save()
+{
+	if(!m_bDirty)
+		return;
+
+	QSaveFile f(m_szFileName);
+	if(!f.open(QIODevice::WriteOnly))
+		return;
+
+	// forget the logs that have been deleted
+	for(auto it = m_hEntries.begin(); it != m_hEntries.end();)
+	{
+		if(QFile::exists(it.key()))
+			++it;
+		else
+			it = m_hEntries.erase(it);
+	}
+
+	QDataStream stream(&f);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << (quint32)LOGINDEX_MAGIC << (quint32)LOGINDEX_VERSION << (quint32)m_hEntries.count();
+
+	for(auto it = m_hEntries.constBegin(); it != m_hEntries.constEnd(); ++it)
+		stream << it.key() << it.value().iSize << it.value().iModified << it.value().bloom;
+
+	if(f.commit())
+		m_bDirty = false;
+}
+
+bool LogIndex::stat(LogFile * pLog, qint64 * piSize, qint64 * piModified)
+{
+	QFileInfo fi(pLog->fileName());
+	if(!fi.exists())
+		return false;
+	*piSize = fi.size();
+	*piModified = fi.lastModified().toMSecsSinceEpoch();
+	return true;
+}
+
+LogIndex::Result LogIndex::lookup(LogFile * pLog, const std::vector<quint32> & trigrams)
+{
+	if(!m_bLoaded)
+		load();
+
+	auto it = m_hEntries.constFind(pLog->fileName());
+	if(it == m_hEntries.constEnd())
+		return Unknown;
+
+	qint64 iSize, iModified;
+	if(!stat(pLog, &iSize, &iModified))
+		return Unknown;
+	if((iSize != it.value().iSize) || (iModified != it.value().iModified))
+		return Unknown; // the log has grown since it was indexed
+
+	for(auto h : trigrams)
+	{
+		if(!bloom_test(it.value().bloom, h))
+			return NoMatch;
+	}
+	return MayMatch;
+}
+
+void LogIndex::update(LogFile * pLog, const QString & szText)
+{
+	if(!m_bLoaded)
+		load();
+
+	Entry e;
+	if(!stat(pLog, &e.iSize, &e.iModified))
+		return;
+
+	QString szFolded = szText.toCaseFolded();
+	const ushort * p = szFolded.utf16();
+	int iLen = szFolded.length();
+
+	// a log repeats the same trigrams a lot: size the filter on the distinct ones
+	std::vector<quint32> trigrams;
+	if(iLen > 2)
+		trigrams.reserve(iLen - 2);
+	for(int i = 2; i < iLen; i++)
+		trigrams.push_back(trigram_hash(p[i - 2], p[i - 1], p[i]));
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+	qint64 iBits = (qint64)trigrams.size() * LOGINDEX_BLOOM_BITS_PER_TRIGRAM;
+	int iSize = LOGINDEX_MIN_BLOOM_SIZE;
+	while((iSize < LOGINDEX_MAX_BLOOM_SIZE) && (((qint64)iSize * 8) < iBits))
+		iSize *= 2;
+	e.bloom.fill(0, iSize);
+
+	for(auto h : trigrams)
+		bloom_set(e.bloom, h);
+
+	m_hEntries.insert(pLog->fileName(), e);
+	m_bDirty = true;
+}
+
+std::vector<quint32> LogIndex::maskTrigrams(const QString & szMask)
+{
+	std::vector<quint32> trigrams;
+
+	// The literal runs between the wildcards must appear in any matching text
+	QString szFolded = szMask.toCaseFolded();
+	const ushort * p = szFolded.utf16();
+	int iLen = szFolded.length();
+	int iRun = 0;
+
+	for(int i = 0; i < iLen; i++)
+	{
+		if((p[i] == '*') || (p[i] == '?') || (p[i] == '\\'))
+		{
+			iRun = 0;
+			continue;
+		}
+		iRun++;
+		if(iRun >= 3)
+			trigrams.push_back(trigram_hash(p[i - 2], p[i - 1], p[i]));
+	}
+
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	return trigrams;
+}
@@ -0,0 +1,126 @@
+#ifndef _LOGINDEX_H_
+#define _LOGINDEX_H_
+//=============================================================================
+//
+//   File : LogIndex.h
+//   Creation date : Sun Oct 18 2026 18:40:52 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 The KVIrc Development Team
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file LogIndex.h
+* \author The KVIrc Development Team
+* \brief Persistent content index of the log directory
+*/
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include <vector>
+
+class LogFile;
+
+/**
+* \class LogIndex
+* \brief A persistent index used to skip the logs that can't match a content search
+*
+* For each log the index keeps a bloom filter of the (case folded)
+* character trigrams of its text, sized from the number of distinct
+* trigrams so that big logs are still filtered. A content mask can match a log only if
+* all the trigrams of its literal parts are in the filter: all the other
+* logs are rejected without decompressing them.
+*
+* The entries are keyed by the file path and are invalidated when the
+* size or the modification time of the file change, so the index is
+* refreshed incrementally: only the new or grown logs are read again.
+* The index is saved in the log directory.
+*/
+class LogIndex
+{
+public:
+	/**
+	* \brief Constructs the index object
+	* \param szFileName The file where the index is stored
+	* \return LogIndex
+	*/
+	LogIndex(const QString & szFileName);
+	~LogIndex();
+
+	/**
+	* \enum Result
+	* \brief The result of an index lookup
+	*/
+	enum Result
+	{
+		NoMatch,  /**< the log surely doesn't match */
+		MayMatch, /**< the log may match: its text must be checked */
+		Unknown   /**< the log is not indexed (or it has changed) */
+	};
+
+private:
+	struct Entry
+	{
+		qint64 iSize;
+		qint64 iModified;
+		QByteArray bloom;
+	};
+
+	QString m_szFileName;
+	QHash<QString, Entry> m_hEntries;
+	bool m_bLoaded;
+	bool m_bDirty;
+
+public:
+	/**
+	* \brief Checks whether the log can contain the literal parts of a wildcard mask
+	* \param pLog The log file
+	* \param trigrams The trigrams returned by maskTrigrams()
+	* \return Result
+	*/
+	Result lookup(LogFile * pLog, const std::vector<quint32> & trigrams);
+
+	/**
+	* \brief Indexes the text of a log, replacing any previous entry
+	* \param pLog The log file
+	* \param szText The full text of the log
+	* \return void
+	*/
+	void update(LogFile * pLog, const QString & szText);
+
+	/**
+	* \brief Saves the index if it has been changed
+	* \return void
+	*/
+	void save();
+
+	/**
+	* \brief Returns the trigrams that any text matching the wildcard mask contains
+	* \param szMask The wildcard mask
+	* \return std::vector<quint32>
+	*/
+	static std::vector<quint32> maskTrigrams(const QString & szMask);
+
+private:
+	void load();
+	bool stat(LogFile * pLog, qint64 * piSize, qint64 * piModified);
+};
+
+#endif // _LOGINDEX_H_
@@ -59,6 +59,7 @@
 #include <QMenu>
 
 #include <limits.h> //for INT_MAX
+#include <string.h> //for memchr
 
 extern LogViewWindow * g_pLogViewWindow;
 
@@ -89,6 +90,8 @@ LogViewWindow::LogViewWindow()
     : KviWindow(KviWindow::LogView, "log")
 {
 	g_pLogViewWindow = this;
+	m_pIndex = nullptr;
+	m_pLoadReader = nullptr;
 	//m_pLogViewWidget = new KviLogViewWidget(this);
 
 	m_pSplitter = new KviTalSplitter(Qt::Horizontal, this);
@@ -204,6 +207,11 @@ LogViewWindow::LogViewWindow()
 	m_pTimer->setSingleShot(true);
 	m_pTimer->setInterval(0);
 	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(filterNext()));
+
+	m_pLoadTimer = new QTimer(this);
+	m_pLoadTimer->setSingleShot(true);
+	m_pLoadTimer->setInterval(0);
+	connect(m_pLoadTimer, SIGNAL(timeout()), this, SLOT(loadNext()));
 	//avoid to execute the long time-consuming procedure of log indexing here:
 	//we could still be inside the context of the "Browse log files" QAction
 	QTimer::singleShot(0, this, SLOT(cacheFileList()));
@@ -212,6 +220,9 @@ LogViewWindow::LogViewWindow()
 LogViewWindow::~LogViewWindow()
 {
 	g_pLogViewWindow = nullptr;
+	stopLoading();
+	if(m_pIndex)
+		delete m_pIndex;
 }
 
 void LogViewWindow::keyPressEvent(QKeyEvent * pEvent)
@@ -286,6 +297,8 @@ void LogViewWindow::setupItemList()
 	m_pProgressBar->setRange(0, m_logList.count());
 	m_pProgressBar->setValue(0);
 
+	m_contentsTrigrams = LogIndex::maskTrigrams(m_pContentsMask->text());
+
 	m_pLastCategory = nullptr;
 	m_pLastGroupItem = nullptr;
 	m_logList.first();
@@ -334,8 +347,15 @@ void LogViewWindow::filterNext()
 
 	if(!m_pContentsMask->text().isEmpty())
 	{
+		// most of the logs are rejected by the index without reading them
+		LogIndex::Result eIndexed = m_pIndex->lookup(pFile, m_contentsTrigrams);
+		if(eIndexed == LogIndex::NoMatch)
+			goto filter_next;
+
 		QString szBuffer;
 		pFile->getText(szBuffer);
+		if(eIndexed == LogIndex::Unknown)
+			m_pIndex->update(pFile, szBuffer);
 		if(!KviQString::matchString(m_pContentsMask->text(), szBuffer))
 			goto filter_next;
 	}
@@ -396,6 +416,7 @@ filter_last:
 	}
 	else
 	{
+		m_pIndex->save();
 		m_pBottomLayout->setVisible(false);
 		m_pListView->sortItems(0, Qt::AscendingOrder);
 		m_pProgressBar->setValue(0);
@@ -409,36 +430,116 @@ void LogViewWindow::cacheFileList()
 	g_pApp->getLocalKvircDirectory(szLogPath, KviApplication::Log);
 	recurseDirectory(szLogPath);
 
+	KviQString::ensureLastCharIs(szLogPath, KVI_PATH_SEPARATOR_CHAR);
+	m_pIndex = new LogIndex(szLogPath + "logview.idx");
+
 	setupItemList();
 }
 
+// The log is read in chunks of this size, one chunk per event loop iteration
+#define LOGVIEW_LOAD_CHUNK_SIZE 262144
+
 void LogViewWindow::itemSelected(QTreeWidgetItem * it, QTreeWidgetItem *)
 {
 	//A parent node
+	stopLoading();
 	m_pIrcView->clearBuffer();
 	if(!it || !it->parent() || !(((LogListViewItem *)it)->m_pFileData))
 		return;
 
-	QString szText;
-	((LogListViewItem *)it)->m_pFileData->getText(szText);
+	m_pLoadReader = new LogFileReader(((LogListViewItem *)it)->m_pFileData);
+	if(!m_pLoadReader->open())
+	{
+		stopLoading();
+		return;
+	}
+
+	m_pLoadTimer->start(); //singleshot
+}
 
-	QStringList lines = szText.split('\n');
-	bool bOk;
-	int iMsgType;
-	for(auto & line : lines)
+void LogViewWindow::stopLoading()
+{
+	m_pLoadTimer->stop();
+	if(m_pLoadReader)
 	{
-		QString szNum = line.section(' ', 0, 0);
-		iMsgType = szNum.toInt(&bOk);
-		if(iMsgType < 0 || iMsgType > (KVI_NUM_MSGTYPE_OPTIONS - 1))
-			iMsgType = 0;
-		if(bOk)
-			outputNoFmt(iMsgType, line.section(' ', 1), KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
-		else
-			outputNoFmt(0, line, KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
+		delete m_pLoadReader;
+		m_pLoadReader = nullptr;
+	}
+	m_loadPartialLine.clear();
+	m_loadLines.clear();
+}
+
+void LogViewWindow::loadNext()
+{
+	if(!m_pLoadReader)
+		return;
+
+	// The view keeps only its last maxBufferSize() lines: there is no need
+	// to keep (and format) more than that while the file is being read
+	size_t uMaxLines = qMax(m_pIrcView->maxBufferSize(), 1);
+
+	int iOffset = m_loadPartialLine.size();
+	m_loadPartialLine.resize(iOffset + LOGVIEW_LOAD_CHUNK_SIZE);
+	int iLen = m_pLoadReader->read(m_loadPartialLine.data() + iOffset, LOGVIEW_LOAD_CHUNK_SIZE);
+	m_loadPartialLine.resize(iOffset + qMax(iLen, 0));
+
+	const char * pcBegin = m_loadPartialLine.constData();
+	const char * pcEnd = pcBegin + m_loadPartialLine.size();
+	const char * pcLine = pcBegin;
+	while(const char * pcNewLine = (const char *)memchr(pcLine, '\n', pcEnd - pcLine))
+	{
+		m_loadLines.push_back(QByteArray(pcLine, pcNewLine - pcLine));
+		if(m_loadLines.size() > uMaxLines)
+			m_loadLines.pop_front();
+		pcLine = pcNewLine + 1;
+	}
+	m_loadPartialLine.remove(0, pcLine - pcBegin);
+
+	if(iLen > 0)
+	{
+		m_pLoadTimer->start(); //singleshot
+		return;
 	}
+
+	// end of file (or a read error): show what we have
+	if(!m_loadPartialLine.isEmpty())
+		m_loadLines.push_back(m_loadPartialLine);
+
+	for(auto & line : m_loadLines)
+		outputLogLine(line);
+
+	stopLoading();
 	m_pIrcView->repaint();
 }
 
+void LogViewWindow::outputLogLine(const QByteArray & line)
+{
+	// The lines start with the message type, unless it was stripped
+	const char * pcData = line.constData();
+	int iLen = line.size();
+	int iMsgType = 0;
+	int i = 0;
+	while((i < iLen) && (pcData[i] >= '0') && (pcData[i] <= '9'))
+	{
+		if(iMsgType < KVI_NUM_MSGTYPE_OPTIONS) // saturate: it's out of range anyway
+			iMsgType = (iMsgType * 10) + (pcData[i] - '0');
+		i++;
+	}
+
+	if((i > 0) && ((i == iLen) || (pcData[i] == ' ')))
+	{
+		if(iMsgType > (KVI_NUM_MSGTYPE_OPTIONS - 1))
+			iMsgType = 0;
+		if(i < iLen)
+			i++; // skip the space
+		outputNoFmt(iMsgType, QString::fromUtf8(pcData + i, iLen - i), KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
+	}
+	else
+	{
+		outputNoFmt(0, QString::fromUtf8(pcData, iLen), KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
+	}
+}
+
 void LogViewWindow::rightButtonClicked(QTreeWidgetItem * pItem, const QPoint &)
 {
 	if(!pItem)
@@ -466,6 +567,9 @@ void LogViewWindow::deleteCurrent()
 	if(!pItem)
 		return;
 
+	// don't keep the files open while removing them
+	stopLoading();
+
 	if(!pItem->childCount())
 	{
 		if(!pItem->fileName().isNull())
@@ -28,6 +28,7 @@
 //=============================================================================
 
 #include "LogFile.h"
+#include "LogIndex.h"
 
 #include "kvi_settings.h"
 #include "KviWindow.h"
@@ -37,6 +38,9 @@
 
 #include <QTreeWidget>
 
+#include <deque>
+#include <vector>
+
 class KviLogViewWidget;
 class LogListViewItem;
 class LogListViewItemFolder;
@@ -69,6 +73,8 @@ public:
 
 protected:
 	KviPointerList<LogFile> m_logList;
+	LogIndex * m_pIndex;
+	std::vector<quint32> m_contentsTrigrams; // trigrams of the current contents mask
 
 	LogViewListView * m_pListView;
 
@@ -105,6 +111,12 @@ protected:
 	QTimer * m_pTimer;
 	QMenu * m_pExportLogPopup;
 
+	// Incremental loading of the selected log
+	LogFileReader * m_pLoadReader;
+	QTimer * m_pLoadTimer;
+	QByteArray m_loadPartialLine;
+	std::deque<QByteArray> m_loadLines; // the last lines read: only these fit in the view
+
 public:
 	/**
 	* \brief Exports the log and creates the file in the selected format
@@ -119,6 +131,8 @@ protected:
 	void exportLog(int iId);
 	void recurseDirectory(const QString & szDir);
 	void setupItemList();
+	void stopLoading();
+	void outputLogLine(const QByteArray & line);
 
 	virtual QPixmap * myIconPtr();
 	virtual void resizeEvent(QResizeEvent * pEvent);
@@ -134,6 +148,7 @@ protected slots:
 	void abortFilter();
 	void cacheFileList();
 	void filterNext();
+	void loadNext();
 	void exportLog(QAction * pAction);
 };
 
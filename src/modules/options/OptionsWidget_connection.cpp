@@ -161,8 +161,14 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	u->setSuffix(__tr2qs_ctx(" usec", "options"));
 	mergeTip(u, __tr2qs_ctx("Minimum value: <b>10000 usec</b><br>Maximum value: <b>10000000 usec</b>", "options"));
 	connect(b, SIGNAL(toggled(bool)), u, SLOT(setEnabled(bool)));
+	u = addUIntSelector(0, 3, 0, 3, __tr2qs_ctx("Allow bursts of up to:", "options"),
+	    KviOption_uintOutgoingTrafficBurst, 1, 20, 5, KVI_OPTION_BOOL(KviOption_boolLimitOutgoingTraffic));
+	u->setSuffix(__tr2qs_ctx(" messages", "options"));
+	mergeTip(u, __tr2qs_ctx("After a pause up to this many messages are sent at once, "
+	                        "then the limit above applies. This is how most servers count the flood.", "options"));
+	connect(b, SIGNAL(toggled(bool)), u, SLOT(setEnabled(bool)));
 
-	g = addGroupBox(0, 3, 0, 3, Qt::Horizontal, __tr2qs_ctx("Network Interfaces", "options"));
+	g = addGroupBox(0, 4, 0, 4, Qt::Horizontal, __tr2qs_ctx("Network Interfaces", "options"));
 
 	b = addBoolSelector(g, __tr2qs_ctx("Bind IPv4 connections to:", "options"), KviOption_boolBindIrcIPv4ConnectionsToSpecifiedAddress);
 	s = addStringSelector(g, "", KviOption_stringIPv4ConnectionBindAddress, KVI_OPTION_BOOL(KviOption_boolBindIrcIPv4ConnectionsToSpecifiedAddress));
@@ -173,7 +179,7 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	connect(b, SIGNAL(toggled(bool)), s, SLOT(setEnabled(bool)));
 #endif //!COMPILE_IPV6_SUPPORT
 
-	b = addBoolSelector(0, 4, 0, 4, __tr2qs_ctx("Pick random IP address for round-robin servers", "options"), KviOption_boolPickRandomIpAddressForRoundRobinServers);
+	b = addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Pick random IP address for round-robin servers", "options"), KviOption_boolPickRandomIpAddressForRoundRobinServers);
 	mergeTip(b, __tr2qs_ctx("This option will cause the KVIrc networking stack to pick up "
 	                        "a random entry when multiple IP address are retrieved for a server "
 	                        "DNS lookup. This is harmless and can fix some problems with caching "
@@ -182,7 +188,7 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	                        "you want to rely on the DNS server to provide the best choice.",
 	                "options"));
 
-	addRowSpacer(0, 5, 0, 5);
+	addRowSpacer(0, 6, 0, 6);
 }
 
 OptionsWidget_connectionSocket::~OptionsWidget_connectionSocket()
@@ -395,6 +395,65 @@ static bool system_kvs_fnc_hostname(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: system.threadEventStatistics
+	@keyterms:
+		Thread events, performance
+	@type:
+		function
+	@title:
+		$system.threadEventStatistics
+	@short:
+		Returns the counters of the events sent by the threads to the user interface
+	@syntax:
+		<hash> $system.threadEventStatistics([reset:boolean])
+	@description:
+		The threads of KVIrc (DCC transfers, DNS lookups, ident service, sound...) deliver
+		their results to the user interface through a single event queue.
+		This function returns a hash with the counters of that queue:[br]
+		[b]posted[/b]: the events posted by the threads[br]
+		[b]delivered[/b]: the events passed to the event queue of the user interface[br]
+		[b]pending[/b]: the events waiting for delivery now[br]
+		[b]maxpending[/b]: the highest number of events that have been waiting for delivery[br]
+		[b]batches[/b]: the number of times the user interface has been woken up to deliver events[br]
+		[b]throttled[/b]: the number of times a thread had to wait because the queue was full[br]
+		[b]overflowed[/b]: the events that didn't fit in the queue while the user interface was waiting for a thread[br]
+		[b]averagelatency[/b]: the average time between the post and the delivery of an event, in microseconds[br]
+		[b]maxlatency[/b]: the highest time between the post and the delivery of an event, in microseconds[br]
+		If [i]reset[/i] is true the counters are zeroed after being read.[br]
+		On Windows the events are delivered directly by Qt and all the counters are zero.
+	@examples:
+		[example]
+			%s = $system.threadEventStatistics()
+			echo "Pending thread events: "%s{"pending"}", average latency: "%s{"averagelatency"}" usecs"
+		[/example]
+*/
+
+static bool system_kvs_fnc_threadEventStatistics(KviKvsModuleFunctionCall * c)
+{
+	bool bReset;
+
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("reset", KVS_PT_BOOL, KVS_PF_OPTIONAL, bReset)
+	KVSM_PARAMETERS_END(c)
+
+	KviThreadEventStatistics s;
+	KviThreadManager::statistics(&s, bReset);
+
+	KviKvsHash * pHash = new KviKvsHash();
+	pHash->set("posted", new KviKvsVariant((kvs_int_t)s.uPosted));
+	pHash->set("delivered", new KviKvsVariant((kvs_int_t)s.uDelivered));
+	pHash->set("pending", new KviKvsVariant((kvs_int_t)s.uPending));
+	pHash->set("maxpending", new KviKvsVariant((kvs_int_t)s.uMaxPending));
+	pHash->set("batches", new KviKvsVariant((kvs_int_t)s.uBatches));
+	pHash->set("throttled", new KviKvsVariant((kvs_int_t)s.uThrottled));
+	pHash->set("overflowed", new KviKvsVariant((kvs_int_t)s.uOverflowed));
+	pHash->set("averagelatency", new KviKvsVariant((kvs_int_t)s.iAverageLatency));
+	pHash->set("maxlatency", new KviKvsVariant((kvs_int_t)s.iMaxLatency));
+	c->returnValue()->setHash(pHash);
+	return true;
+}
+
 /*
 	@doc: system.dbus
 	@keyterms:
@@ -927,6 +986,7 @@ static bool system_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "osnodename", system_kvs_fnc_osnodename);
 	KVSM_REGISTER_FUNCTION(m, "getenv", system_kvs_fnc_getenv);
 	KVSM_REGISTER_FUNCTION(m, "hostname", system_kvs_fnc_hostname);
+	KVSM_REGISTER_FUNCTION(m, "threadEventStatistics", system_kvs_fnc_threadEventStatistics);
 	KVSM_REGISTER_FUNCTION(m, "dbus", system_kvs_fnc_dbus);
 	KVSM_REGISTER_FUNCTION(m, "htoni", system_kvs_fnc_htoni);
 	KVSM_REGISTER_FUNCTION(m, "ntohi", system_kvs_fnc_ntohi);